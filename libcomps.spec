@@ -16,6 +16,8 @@ BuildRequires:  libxml2-devel
 BuildRequires:  check-devel
 BuildRequires:  expat-devel
 BuildRequires:  zlib-devel
+BuildRequires:  xz-devel
+BuildRequires:  libzstd-devel
 
 %description
 Libcomps is library for structure-like manipulation with content of
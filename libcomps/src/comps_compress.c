@@ -0,0 +1,251 @@
+/* libcomps - C alternative to yum.comps library
+ * Copyright (C) 2013 Jindrich Luza
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to  Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA
+ */
+
+#include "comps_compress.h"
+
+#include <stdlib.h>
+#include <zlib.h>
+#ifdef COMPS_WITH_XZ
+#include <lzma.h>
+#endif
+#ifdef COMPS_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+/* size of output buffer, input is fed to compression library in pieces of
+ * at most this size too */
+#define COMPS_COMPRESS_CHUNK 65536
+
+struct COMPS_Compressor {
+    COMPS_CompressType type;
+    COMPS_CompressWriteCallback write_cb;
+    void *ctx;
+    union {
+        z_stream gzip;
+        #ifdef COMPS_WITH_XZ
+        lzma_stream xz;
+        #endif
+        #ifdef COMPS_WITH_ZSTD
+        ZSTD_CCtx *zstd;
+        #endif
+    } stream;
+    char out[COMPS_COMPRESS_CHUNK];
+};
+
+int comps_compress_supported(COMPS_CompressType type) {
+    switch (type) {
+        case COMPS_COMPRESS_NONE:
+        case COMPS_COMPRESS_GZIP:
+            return 1;
+        #ifdef COMPS_WITH_XZ
+        case COMPS_COMPRESS_XZ:
+            return 1;
+        #endif
+        #ifdef COMPS_WITH_ZSTD
+        case COMPS_COMPRESS_ZSTD:
+            return 1;
+        #endif
+        default:
+            return 0;
+    }
+}
+
+const char* comps_compress_suffix(COMPS_CompressType type) {
+    switch (type) {
+        case COMPS_COMPRESS_GZIP:
+            return ".gz";
+        case COMPS_COMPRESS_XZ:
+            return ".xz";
+        case COMPS_COMPRESS_ZSTD:
+            return ".zst";
+        default:
+            return "";
+    }
+}
+
+static int __comps_compress_emit(COMPS_Compressor *comp, const char *data,
+                                 size_t len) {
+    if (len == 0)
+        return 0;
+    return comp->write_cb(comp->ctx, data, (int)len) < 0 ? -1 : 0;
+}
+
+static int __comps_compress_gzip(COMPS_Compressor *comp, const char *data,
+                                 size_t len, int finish) {
+    z_stream *zs = &comp->stream.gzip;
+    int ret;
+
+    zs->next_in = (Bytef*)data;
+    zs->avail_in = (uInt)len;
+    do {
+        zs->next_out = (Bytef*)comp->out;
+        zs->avail_out = COMPS_COMPRESS_CHUNK;
+        ret = deflate(zs, finish ? Z_FINISH : Z_NO_FLUSH);
+        if (ret == Z_STREAM_ERROR)
+            return -1;
+        if (__comps_compress_emit(comp, comp->out,
+                                  COMPS_COMPRESS_CHUNK - zs->avail_out) < 0)
+            return -1;
+    } while (zs->avail_out == 0 || (finish && ret != Z_STREAM_END));
+    return 0;
+}
+
+#ifdef COMPS_WITH_XZ
+static int __comps_compress_xz(COMPS_Compressor *comp, const char *data,
+                               size_t len, int finish) {
+    lzma_stream *xs = &comp->stream.xz;
+    lzma_ret ret;
+
+    xs->next_in = (const uint8_t*)data;
+    xs->avail_in = len;
+    do {
+        xs->next_out = (uint8_t*)comp->out;
+        xs->avail_out = COMPS_COMPRESS_CHUNK;
+        ret = lzma_code(xs, finish ? LZMA_FINISH : LZMA_RUN);
+        if (ret != LZMA_OK && ret != LZMA_STREAM_END)
+            return -1;
+        if (__comps_compress_emit(comp, comp->out,
+                                  COMPS_COMPRESS_CHUNK - xs->avail_out) < 0)
+            return -1;
+    } while (xs->avail_out == 0 || (finish && ret != LZMA_STREAM_END));
+    return 0;
+}
+#endif
+
+#ifdef COMPS_WITH_ZSTD
+static int __comps_compress_zstd(COMPS_Compressor *comp, const char *data,
+                                 size_t len, int finish) {
+    ZSTD_inBuffer in = {data, len, 0};
+    ZSTD_outBuffer out;
+    size_t remaining;
+
+    do {
+        out.dst = comp->out;
+        out.size = COMPS_COMPRESS_CHUNK;
+        out.pos = 0;
+        remaining = ZSTD_compressStream2(comp->stream.zstd, &out, &in,
+                                         finish ? ZSTD_e_end
+                                                : ZSTD_e_continue);
+        if (ZSTD_isError(remaining))
+            return -1;
+        if (__comps_compress_emit(comp, comp->out, out.pos) < 0)
+            return -1;
+    } while (finish ? remaining != 0 : in.pos < in.size);
+    return 0;
+}
+#endif
+
+static int __comps_compress_run(COMPS_Compressor *comp, const char *data,
+                                size_t len, int finish) {
+    switch (comp->type) {
+        case COMPS_COMPRESS_GZIP:
+            return __comps_compress_gzip(comp, data, len, finish);
+        #ifdef COMPS_WITH_XZ
+        case COMPS_COMPRESS_XZ:
+            return __comps_compress_xz(comp, data, len, finish);
+        #endif
+        #ifdef COMPS_WITH_ZSTD
+        case COMPS_COMPRESS_ZSTD:
+            return __comps_compress_zstd(comp, data, len, finish);
+        #endif
+        default:
+            return __comps_compress_emit(comp, data, len);
+    }
+}
+
+COMPS_Compressor* comps_compressor_create(COMPS_CompressType type, int level,
+                                          COMPS_CompressWriteCallback write_cb,
+                                          void *ctx) {
+    COMPS_Compressor *comp;
+    int ok = 1;
+
+    if (!comps_compress_supported(type))
+        return NULL;
+    if ((comp = malloc(sizeof(*comp))) == NULL)
+        return NULL;
+    comp->type = type;
+    comp->write_cb = write_cb;
+    comp->ctx = ctx;
+    if (type == COMPS_COMPRESS_GZIP) {
+        comp->stream.gzip.zalloc = Z_NULL;
+        comp->stream.gzip.zfree = Z_NULL;
+        comp->stream.gzip.opaque = Z_NULL;
+        /* window bits over 15 select gzip header instead of zlib one */
+        ok = deflateInit2(&comp->stream.gzip,
+                          level ? level : Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                          15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+    }
+    #ifdef COMPS_WITH_XZ
+    if (type == COMPS_COMPRESS_XZ) {
+        lzma_stream init = LZMA_STREAM_INIT;
+        comp->stream.xz = init;
+        ok = lzma_easy_encoder(&comp->stream.xz,
+                               level ? (uint32_t)level : LZMA_PRESET_DEFAULT,
+                               LZMA_CHECK_CRC64) == LZMA_OK;
+    }
+    #endif
+    #ifdef COMPS_WITH_ZSTD
+    if (type == COMPS_COMPRESS_ZSTD) {
+        comp->stream.zstd = ZSTD_createCCtx();
+        ok = comp->stream.zstd != NULL
+             && !ZSTD_isError(ZSTD_CCtx_setParameter(comp->stream.zstd,
+                                   ZSTD_c_compressionLevel,
+                                   level ? level : ZSTD_CLEVEL_DEFAULT));
+        if (!ok)
+            ZSTD_freeCCtx(comp->stream.zstd);
+    }
+    #endif
+    if (!ok) {
+        free(comp);
+        return NULL;
+    }
+    return comp;
+}
+
+int comps_compressor_write(COMPS_Compressor *comp, const char *data,
+                           size_t len) {
+    size_t piece;
+
+    for (; len; data += piece, len -= piece) {
+        piece = len < COMPS_COMPRESS_CHUNK ? len : COMPS_COMPRESS_CHUNK;
+        if (__comps_compress_run(comp, data, piece, 0) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+int comps_compressor_finish(COMPS_Compressor *comp) {
+    return __comps_compress_run(comp, NULL, 0, 1);
+}
+
+void comps_compressor_destroy(COMPS_Compressor *comp) {
+    if (comp == NULL)
+        return;
+    if (comp->type == COMPS_COMPRESS_GZIP)
+        deflateEnd(&comp->stream.gzip);
+    #ifdef COMPS_WITH_XZ
+    if (comp->type == COMPS_COMPRESS_XZ)
+        lzma_end(&comp->stream.xz);
+    #endif
+    #ifdef COMPS_WITH_ZSTD
+    if (comp->type == COMPS_COMPRESS_ZSTD)
+        ZSTD_freeCCtx(comp->stream.zstd);
+    #endif
+    free(comp);
+}
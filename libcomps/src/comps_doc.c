@@ -18,15 +18,56 @@
  */
 
 #include "comps_doc.h"
+#include "comps_docindex.h"
 #include "comps_set.h"
+#include "comps_radix.h"
 //#include "comps_types.h"
 #include "comps_utils.h"
 #include "comps_default.h"
 
 #include <stdio.h>
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
 #include <libxml/parser.h>
+static COMPS_Object* __comps_doc_by_id(COMPS_Doc *doc,
+                                       COMPS_ObjList* (*list_f)(COMPS_Doc*),
+                                       COMPS_Object* (*id_f)(COMPS_Object*),
+                                       COMPS_Object* (*props_f)(COMPS_Object*),
+                                       const char *id) {
+    COMPS_ObjList *list;
+    COMPS_Object *ret;
+
+    list = list_f(doc);
+    ret = comps_object_incref(comps_objlist_find_by_x(list, id_f, props_f,
+                                                      id));
+    COMPS_OBJECT_DESTROY(list);
+    return ret;
+}
+
+COMPS_DocGroup* comps_doc_group_by_id(COMPS_Doc *doc, const char *id) {
+    return (COMPS_DocGroup*)__comps_doc_by_id(doc, &comps_doc_groups,
+                                              &__comps_docgroup_id_x,
+                                              &__comps_docgroup_props_x, id);
+}
+
+COMPS_DocCategory* comps_doc_category_by_id(COMPS_Doc *doc, const char *id) {
+    return (COMPS_DocCategory*)__comps_doc_by_id(doc, &comps_doc_categories,
+                                                 &__comps_doccategory_id_x,
+                                                 &__comps_doccategory_props_x,
+                                                 id);
+}
+
+COMPS_DocEnv* comps_doc_env_by_id(COMPS_Doc *doc, const char *id) {
+    return (COMPS_DocEnv*)__comps_doc_by_id(doc, &comps_doc_environments,
+                                            &__comps_docenv_id_x,
+                                            &__comps_docenv_props_x, id);
+}
+
 static signed char comps_doc_xml(COMPS_Doc *doc, xmlTextWriterPtr writer,
+                                 const COMPS_XMLSelection *selection,
                                  COMPS_XMLOptions *xml_options,
                                  COMPS_DefaultsOptions *def_options);
 
@@ -43,6 +84,7 @@ void comps_doc_create(COMPS_Doc* doc, COMPS_Object **args) {
     doc->doctype_sysid = comps_str(comps_default_doctype_sysid);
     doc->doctype_pubid = comps_str(comps_default_doctype_pubid);
     doc->lang = NULL;
+    doc->index = NULL;
 }
 COMPS_CREATE_u(doc, COMPS_Doc)
 
@@ -52,6 +94,9 @@ void comps_doc_copy(COMPS_Doc *doc_dst, COMPS_Doc *doc_src) {
     doc_dst->doctype_sysid = (COMPS_Str*) COMPS_OBJECT_COPY(doc_src->doctype_sysid);
     doc_dst->doctype_pubid = (COMPS_Str*) COMPS_OBJECT_COPY(doc_src->doctype_pubid);
     doc_dst->objects = (COMPS_ObjDict*) COMPS_OBJECT_COPY(doc_src->objects);
+    doc_dst->log = COMPS_OBJECT_CREATE(COMPS_Log, NULL);
+    doc_dst->lang = NULL;
+    doc_dst->index = NULL;
 }
 COMPS_COPY_u(doc, COMPS_Doc)
 
@@ -63,6 +108,7 @@ void comps_doc_destroy(COMPS_Doc *doc) {
         COMPS_OBJECT_DESTROY(doc->doctype_name);
         COMPS_OBJECT_DESTROY(doc->doctype_sysid);
         COMPS_OBJECT_DESTROY(doc->doctype_pubid);
+        comps_docindex_destroy(doc->index);
     }
 }
 COMPS_DESTROY_u(doc, COMPS_Doc)
@@ -147,6 +193,56 @@ signed char comps_doc_cmp_u(COMPS_Object *obj1, COMPS_Object *obj2) {
     return ret;
 }
 
+/* Sections in fixed order. Getters of document create missing section on
+ * first access, so missing and empty section must have the same digest */
+static const char *__comps_doc_digest_sections[] = {
+    "groups", "categories", "environments", "langpacks", "blacklist",
+    "whiteout", NULL
+};
+
+/* len of dictionaries isn't decreased by unset, their top level nodes are
+ * checked instead */
+static int __comps_doc_section_empty(COMPS_Object *section) {
+    if (section == NULL)
+        return 1;
+    if (section->obj_info == &COMPS_ObjList_ObjInfo)
+        return ((COMPS_ObjList*)section)->len == 0;
+    if (section->obj_info == &COMPS_ObjDict_ObjInfo)
+        return ((COMPS_ObjDict*)section)->subnodes->len == 0;
+    if (section->obj_info == &COMPS_ObjMDict_ObjInfo)
+        return ((COMPS_ObjMDict*)section)->subnodes->len == 0;
+    return 0;
+}
+
+COMPS_Digest comps_doc_digest(COMPS_Doc *doc) {
+    COMPS_Object *section;
+    COMPS_Digest ret;
+    int i;
+
+    ret = comps_digest_str(COMPS_DIGEST_INIT, "doc");
+    ret = comps_digest_u64(ret, comps_object_digest((COMPS_Object*)
+                                                    doc->encoding));
+    ret = comps_digest_u64(ret, comps_object_digest((COMPS_Object*)
+                                                    doc->doctype_name));
+    ret = comps_digest_u64(ret, comps_object_digest((COMPS_Object*)
+                                                    doc->doctype_sysid));
+    ret = comps_digest_u64(ret, comps_object_digest((COMPS_Object*)
+                                                    doc->doctype_pubid));
+    for (i = 0; __comps_doc_digest_sections[i]; i++) {
+        section = comps_objdict_get_x(doc->objects,
+                                      __comps_doc_digest_sections[i]);
+        if (__comps_doc_section_empty(section))
+            continue;
+        ret = comps_digest_str(ret, __comps_doc_digest_sections[i]);
+        ret = comps_digest_u64(ret, comps_object_digest(section));
+    }
+    return comps_digest_finish(ret);
+}
+
+static COMPS_Digest comps_doc_digest_u(COMPS_Object *doc) {
+    return comps_doc_digest((COMPS_Doc*)doc);
+}
+
 inline void comps_doc_clear(COMPS_Doc *doc) {
     if (doc == NULL) return;
     //comps_objdict_clear(doc->objects);
@@ -174,16 +270,27 @@ COMPS_DOC_ADDOBJMDICT(whiteout,  whiteout) /*comps_doc.h macro*/
 COMPS_DOC_SETPROP(lang,  COMPS_Str) /*comps_doc.h macro*/
 
 
-signed char comps2xml_f(COMPS_Doc * doc, char *filename, char stdoutredirect,
-                        COMPS_XMLOptions *xml_options,
-                        COMPS_DefaultsOptions *def_options) {
-    xmlDocPtr xmldoc;
+/* Stream document through text writer straight into out, so neither DOM
+ * tree nor copy of the whole output is built. Writer owns out and closes it.
+ * Indentation matches former formatted save of DOM tree */
+static signed char __comps2xml_out(COMPS_Doc *doc, xmlOutputBufferPtr out,
+                                   const COMPS_XMLSelection *selection,
+                                   COMPS_XMLOptions *xml_options,
+                                   COMPS_DefaultsOptions *def_options) {
+    xmlTextWriterPtr writer;
     int retc;
     char *str;
     signed char genret;
 
-    doc->log->std_out = stdoutredirect;
-    xmlTextWriterPtr writer = xmlNewTextWriterDoc(&xmldoc, 0);
+    if (out == NULL)
+        return -1;
+    writer = xmlNewTextWriter(out);
+    if (writer == NULL) {
+        xmlOutputBufferClose(out);
+        return -1;
+    }
+    xmlTextWriterSetIndent(writer, 1);
+    xmlTextWriterSetIndentString(writer, BAD_CAST "  ");
 
     if ((COMPS_Object*)doc->encoding) {
         str = comps_object_tostr((COMPS_Object*)doc->encoding);
@@ -199,188 +306,581 @@ signed char comps2xml_f(COMPS_Doc * doc, char *filename, char stdoutredirect,
         xml_options = &COMPS_XMLDefaultOptions;
     if (!def_options)
         def_options = &COMPS_DDefaultsOptions;
-    genret = comps_doc_xml(doc, writer, xml_options, def_options);
+    genret = comps_doc_xml(doc, writer, selection, xml_options, def_options);
     retc = xmlTextWriterEndDocument(writer);
     if (retc<0)
         comps_log_error(doc->log, COMPS_ERR_XMLGEN, 0);
-
-    retc = xmlSaveFormatFileEnc(filename, xmldoc, NULL, 1);
-    if (retc<0)
-        comps_log_error_x(doc->log, COMPS_ERR_WRITEF,
-                          1, comps_str(filename));
+    /* errors of sink show up here at latest, closing output loses them */
+    if (xmlTextWriterFlush(writer) < 0)
+        genret = -1;
 
     xmlFreeTextWriter(writer);
-    xmlFreeDoc(xmldoc);
-    xmlCleanupParser();
-    xmlMemoryDump();
     return genret;
 }
 
-char* comps2xml_str(COMPS_Doc *doc, COMPS_XMLOptions *xml_options,
-                    COMPS_DefaultsOptions *def_options) {
-    xmlDocPtr xmldoc;
-    const char *xmlstr;
+signed char comps2xml_f(COMPS_Doc * doc, char *filename, char stdoutredirect,
+                        COMPS_XMLOptions *xml_options,
+                        COMPS_DefaultsOptions *def_options) {
+    xmlOutputBufferPtr out;
     signed char genret;
-    char *str, *ret;
-    int retc;
 
-    xmlBuffer *xmlbuff = xmlBufferCreate();
-    xmlOutputBuffer *xmlobuff = xmlOutputBufferCreateBuffer(xmlbuff, 0);
-    xmlTextWriterPtr writer = xmlNewTextWriterDoc(&xmldoc, 0);
+    doc->log->std_out = stdoutredirect;
+    out = xmlOutputBufferCreateFilename(filename, NULL, 0);
+    genret = __comps2xml_out(doc, out, NULL, xml_options, def_options);
+    if (out == NULL || genret == -1)
+        comps_log_error_x(doc->log, COMPS_ERR_WRITEF,
+                          1, comps_str(filename));
+    return genret;
+}
+
+static int __comps2xml_fd_write(void *ctx, const char *buffer, int len) {
+    int fd = *(int*)ctx;
+    ssize_t written;
+    int done;
 
-    if ((COMPS_Object*)doc->encoding) {
-        str = comps_object_tostr((COMPS_Object*)doc->encoding);
-        retc = xmlTextWriterStartDocument(writer, NULL, str, NULL);
-        free(str);
-    } else {
-        retc = xmlTextWriterStartDocument(writer, NULL, "UTF-8", NULL);
+    for (done = 0; done < len; done += written) {
+        written = write(fd, buffer + done, len - done);
+        if (written < 0 && errno == EINTR)
+            written = 0;
+        else if (written < 0)
+            return -1;
     }
-    if (retc<0) comps_log_error(doc->log, COMPS_ERR_XMLGEN, 0);
+    return len;
+}
 
-    if (!xml_options)
-        xml_options = &COMPS_XMLDefaultOptions;
-    if (!def_options)
-        def_options = &COMPS_DDefaultsOptions;
-    genret = comps_doc_xml(doc, writer, xml_options, def_options);
-    if (genret)
+signed char comps2xml_fd(COMPS_Doc *doc, int fd,
+                         COMPS_XMLOptions *xml_options,
+                         COMPS_DefaultsOptions *def_options) {
+    signed char genret;
+
+    genret = comps2xml_cb(doc, &__comps2xml_fd_write, &fd, xml_options,
+                          def_options);
+    if (genret == -1)
         comps_log_error(doc->log, COMPS_ERR_XMLGEN, 0);
-    if (retc<0)
+    return genret;
+}
+
+signed char comps2xml_cb(COMPS_Doc *doc, COMPS_XMLWriteCallback write_cb,
+                         void *ctx, COMPS_XMLOptions *xml_options,
+                         COMPS_DefaultsOptions *def_options) {
+    return __comps2xml_out(doc, xmlOutputBufferCreateIO(write_cb, NULL, ctx,
+                                                        NULL),
+                           NULL, xml_options, def_options);
+}
+
+signed char comps2xml_selected_cb(COMPS_Doc *doc,
+                                  const COMPS_XMLSelection *selection,
+                                  COMPS_XMLWriteCallback write_cb, void *ctx,
+                                  COMPS_XMLOptions *xml_options,
+                                  COMPS_DefaultsOptions *def_options) {
+    return __comps2xml_out(doc, xmlOutputBufferCreateIO(write_cb, NULL, ctx,
+                                                        NULL),
+                           selection, xml_options, def_options);
+}
+
+signed char comps2xml_selected_f(COMPS_Doc *doc, char *filename,
+                                 const COMPS_XMLSelection *selection,
+                                 COMPS_XMLOptions *xml_options,
+                                 COMPS_DefaultsOptions *def_options) {
+    xmlOutputBufferPtr out;
+    signed char genret;
+
+    out = xmlOutputBufferCreateFilename(filename, NULL, 0);
+    genret = __comps2xml_out(doc, out, selection, xml_options, def_options);
+    if (out == NULL || genret == -1)
+        comps_log_error_x(doc->log, COMPS_ERR_WRITEF,
+                          1, comps_str(filename));
+    return genret;
+}
+
+typedef struct {
+    COMPS_XMLCompressOptions *options;
+    COMPS_Compressor *comp;
+    COMPS_SHA256 open_sha256;
+    COMPS_SHA256 sha256;
+    COMPS_XMLWriteCallback write_cb;
+    void *ctx;
+} COMPS_XMLCompressSink;
+
+/* Uncompressed side, XML chunks from text writer */
+static int __comps2xml_compress_in(void *ctx, const char *buffer, int len) {
+    COMPS_XMLCompressSink *sink = ctx;
+
+    sink->options->open_size += len;
+    if (sink->options->checksums)
+        comps_sha256_update(&sink->open_sha256, buffer, len);
+    return comps_compressor_write(sink->comp, buffer, len) < 0 ? -1 : len;
+}
+
+/* Compressed side, chunks from compressor */
+static int __comps2xml_compress_out(void *ctx, const char *buffer, int len) {
+    COMPS_XMLCompressSink *sink = ctx;
+
+    sink->options->size += len;
+    if (sink->options->checksums)
+        comps_sha256_update(&sink->sha256, buffer, len);
+    return sink->write_cb(sink->ctx, buffer, len);
+}
+
+signed char comps2xml_compressed_cb(COMPS_Doc *doc,
+                                    COMPS_XMLCompressOptions *comp_options,
+                                    COMPS_XMLWriteCallback write_cb,
+                                    void *ctx,
+                                    COMPS_XMLOptions *xml_options,
+                                    COMPS_DefaultsOptions *def_options) {
+    COMPS_XMLCompressSink sink;
+    signed char genret;
+
+    comp_options->open_size = 0;
+    comp_options->size = 0;
+    comp_options->open_sha256[0] = 0;
+    comp_options->sha256[0] = 0;
+    sink.options = comp_options;
+    sink.write_cb = write_cb;
+    sink.ctx = ctx;
+    comps_sha256_init(&sink.open_sha256);
+    comps_sha256_init(&sink.sha256);
+    sink.comp = comps_compressor_create(comp_options->type,
+                                        comp_options->level,
+                                        &__comps2xml_compress_out, &sink);
+    if (sink.comp == NULL) {
         comps_log_error(doc->log, COMPS_ERR_XMLGEN, 0);
-    retc = xmlTextWriterEndDocument(writer);
-    if (retc<0) comps_log_error(doc->log, COMPS_ERR_XMLGEN, 0);
-    xmlSaveFormatFileTo(xmlobuff, xmldoc, NULL, 1);
+        return -1;
+    }
+    genret = comps2xml_cb(doc, &__comps2xml_compress_in, &sink, xml_options,
+                          def_options);
+    if (genret != -1 && comps_compressor_finish(sink.comp) < 0)
+        genret = -1;
+    comps_compressor_destroy(sink.comp);
+    if (genret != -1 && comp_options->checksums) {
+        comps_sha256_final_hex(&sink.open_sha256, comp_options->open_sha256);
+        comps_sha256_final_hex(&sink.sha256, comp_options->sha256);
+    }
+    return genret;
+}
 
-    xmlFreeTextWriter(writer);
-    xmlFreeDoc(xmldoc);
-
-    xmlstr =(char*) xmlBufferContent(xmlbuff);
-    ret =  malloc(sizeof(char) * (strlen(xmlstr)+1));
-    if (ret == NULL) {
-        xmlBufferFree(xmlbuff);
-        xmlCleanupParser();
-        xmlMemoryDump();
-        return NULL;
-    } else {
-        memcpy(ret, xmlstr, sizeof(char)*(strlen(xmlstr)+1));
+signed char comps2xml_compressed_f(COMPS_Doc *doc, char *filename,
+                                   COMPS_XMLCompressOptions *comp_options,
+                                   COMPS_XMLOptions *xml_options,
+                                   COMPS_DefaultsOptions *def_options) {
+    signed char genret = -1;
+    int fd;
+
+    fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd >= 0) {
+        genret = comps2xml_compressed_cb(doc, comp_options,
+                                         &__comps2xml_fd_write, &fd,
+                                         xml_options, def_options);
+        if (close(fd) < 0)
+            genret = -1;
     }
-    xmlBufferFree(xmlbuff);
+    if (genret == -1)
+        comps_log_error_x(doc->log, COMPS_ERR_WRITEF,
+                          1, comps_str(filename));
+    return genret;
+}
 
-    xmlCleanupParser();
-    xmlMemoryDump();
-    return ret;
+typedef struct {
+    char *str;
+    size_t len;
+    size_t size;
+} COMPS_XMLStrSink;
+
+/* Output is accumulated directly in returned string, growing it
+ * geometrically */
+static int __comps2xml_str_write(void *ctx, const char *buffer, int len) {
+    COMPS_XMLStrSink *sink = ctx;
+    size_t size;
+    char *tmp;
+
+    if (sink->len + len + 1 > sink->size) {
+        for (size = sink->size ? sink->size : 4096;
+             size < sink->len + len + 1; size *= 2);
+        if ((tmp = realloc(sink->str, size)) == NULL)
+            return -1;
+        sink->str = tmp;
+        sink->size = size;
+    }
+    memcpy(sink->str + sink->len, buffer, len);
+    sink->len += len;
+    sink->str[sink->len] = 0;
+    return len;
 }
 
-COMPS_Doc* comps_doc_union(COMPS_Doc *c1, COMPS_Doc *c2) {
-    COMPS_ObjListIt *it;
-    COMPS_Set *set;
-    COMPS_Doc *res;
-    COMPS_DocGroup *tmpgroup;
-    COMPS_DocCategory *tmpcat;
-    COMPS_DocEnv *tmpenv;
-    COMPS_HSListItem *hsit;
-    COMPS_ObjList *groups = comps_doc_groups(c1);
-    COMPS_ObjList *categories = comps_doc_categories(c1);
-    COMPS_ObjList *envs = comps_doc_environments(c1);
-    COMPS_ObjDict *langpacks, *d1, *d2;
+char* comps2xml_str(COMPS_Doc *doc, COMPS_XMLOptions *xml_options,
+                    COMPS_DefaultsOptions *def_options) {
+    return comps2xml_selected_str(doc, NULL, xml_options, def_options);
+}
 
-    void *tmpdata;
-    res = COMPS_OBJECT_CREATE(COMPS_Doc, (COMPS_Object*[]){(COMPS_Object*)
-                                                           c1->encoding});
+char* comps2xml_selected_str(COMPS_Doc *doc,
+                             const COMPS_XMLSelection *selection,
+                             COMPS_XMLOptions *xml_options,
+                             COMPS_DefaultsOptions *def_options) {
+    COMPS_XMLStrSink sink = {NULL, 0, 0};
+    signed char genret;
 
-    set = comps_set_create();
-    comps_set_init(set, NULL, NULL, NULL, &__comps_docgroup_idcmp);
+    genret = comps2xml_selected_cb(doc, selection, &__comps2xml_str_write,
+                                   &sink, xml_options, def_options);
+    if (genret)
+        comps_log_error(doc->log, COMPS_ERR_XMLGEN, 0);
+    if (sink.str == NULL || genret == -1) {
+        free(sink.str);
+        return NULL;
+    }
+    return sink.str;
+}
 
-    for (it = groups ? groups->first : NULL; it != NULL; it = it->next) {
-        comps_set_add(set, comps_object_copy(it->comps_obj));
+static COMPS_Object* __comps_docgroup_union_obj(COMPS_Object *o1,
+                                                COMPS_Object *o2) {
+    return (COMPS_Object*)comps_docgroup_union((COMPS_DocGroup*)o1,
+                                               (COMPS_DocGroup*)o2);
+}
+static COMPS_Object* __comps_doccategory_union_obj(COMPS_Object *o1,
+                                                   COMPS_Object *o2) {
+    return (COMPS_Object*)comps_doccategory_union((COMPS_DocCategory*)o1,
+                                                  (COMPS_DocCategory*)o2);
+}
+static COMPS_Object* __comps_docenv_union_obj(COMPS_Object *o1,
+                                              COMPS_Object *o2) {
+    return (COMPS_Object*)comps_docenv_union((COMPS_DocEnv*)o1,
+                                             (COMPS_DocEnv*)o2);
+}
+static void __comps_docgroup_unite_obj(COMPS_Object *o1, COMPS_Object *o2) {
+    comps_docgroup_unite((COMPS_DocGroup*)o1, (COMPS_DocGroup*)o2);
+}
+static void __comps_doccategory_unite_obj(COMPS_Object *o1, COMPS_Object *o2) {
+    comps_doccategory_unite((COMPS_DocCategory*)o1, (COMPS_DocCategory*)o2);
+}
+static void __comps_docenv_unite_obj(COMPS_Object *o1, COMPS_Object *o2) {
+    comps_docenv_unite((COMPS_DocEnv*)o1, (COMPS_DocEnv*)o2);
+}
+
+typedef struct {
+    COMPS_ObjList* (*list_f)(COMPS_Doc*);
+    COMPS_Object* (*id_f)(COMPS_Object*);
+    COMPS_Object* (*union_f)(COMPS_Object*, COMPS_Object*);
+    void (*unite_f)(COMPS_Object*, COMPS_Object*);
+} COMPS_DocUnionOps;
+
+static const COMPS_DocUnionOps __comps_doc_union_ops[] = {
+    {&comps_doc_groups, &__comps_docgroup_id_x,
+     &__comps_docgroup_union_obj, &__comps_docgroup_unite_obj},
+    {&comps_doc_categories, &__comps_doccategory_id_x,
+     &__comps_doccategory_union_obj, &__comps_doccategory_unite_obj},
+    {&comps_doc_environments, &__comps_docenv_id_x,
+     &__comps_docenv_union_obj, &__comps_docenv_unite_obj}
+};
+
+#define COMPS_DOC_UNION_END ((size_t)-1)
+
+typedef struct {
+    COMPS_Object *obj;
+    size_t next; /* next source merged into the same object */
+} COMPS_DocUnionSrc;
+
+typedef struct {
+    size_t first, last; /* chain of merged sources, first is
+                           COMPS_DOC_UNION_END when slot was merged into
+                           later one */
+    COMPS_Object *res;
+} COMPS_DocUnionSlot;
+
+typedef struct {
+    const COMPS_DocUnionOps *ops;
+    COMPS_ObjList **lists;
+    size_t n;
+    COMPS_DocUnionSrc *srcs;
+    size_t first_len; /* sources from first list */
+    COMPS_DocUnionSlot *slots;
+    size_t len;
+    char unite;
+} COMPS_DocUnionPlan;
+
+/* Join objects of section selected by ops of all docs by id in one pass over
+ * each list. Every slot gets chain of objects merged into it. Slots of
+ * objects merged with later object of the same id are empty, so non-empty
+ * slots in array order give objects in order left-to-right pairwise union
+ * produces: objects untouched by later lists first, then merged or new
+ * objects in order of their last occurrence. When id repeats in first list,
+ * first occurrence wins.
+ *
+ * With unite set, objects of first list are moved to the plan (first list
+ * is emptied) so they can be merged in place.
+ */
+static int __comps_doc_union_plan(COMPS_DocUnionPlan *plan, COMPS_Doc **docs,
+                                  size_t n, const COMPS_DocUnionOps *ops,
+                                  char unite) {
+    COMPS_ObjListIt *it;
+    COMPS_RTree *ids;
+    COMPS_DocUnionSlot *slot, *newslot, **special;
+    /* rtree can't hold empty key, objects without id or with empty id are
+     * tracked separately */
+    COMPS_DocUnionSlot *noid = NULL, *emptyid = NULL;
+    char *idstr, *tofree;
+    size_t total, nsrcs, i, k;
+
+    memset(plan, 0, sizeof(*plan));
+    plan->ops = ops;
+    plan->unite = unite;
+    plan->n = n;
+    if ((plan->lists = malloc(sizeof(*plan->lists) * n)) == NULL)
+        return 0;
+    for (total = 0, i = 0; i < n; i++) {
+        plan->lists[i] = ops->list_f(docs[i]);
+        total += plan->lists[i]->len;
     }
-    COMPS_OBJECT_DESTROY(groups);
-    groups = comps_doc_groups(c2);
-    for (it = groups ? groups->first : NULL; it != NULL; it = it->next) {
-        if (comps_set_in(set, it->comps_obj)) {
-            tmpgroup = comps_docgroup_union(
-                                (COMPS_DocGroup*)comps_set_data_at(set,
-                                                               it->comps_obj),
-                                (COMPS_DocGroup*)it->comps_obj);
-            tmpdata = comps_set_data_at(set, it->comps_obj);
-            comps_set_remove(set, it->comps_obj);
-            COMPS_OBJECT_DESTROY(tmpdata);
-            comps_set_add(set, tmpgroup);
-        } else {
-            comps_set_add(set, comps_object_copy(it->comps_obj));
+    plan->srcs = malloc(sizeof(*plan->srcs) * (total ? total : 1));
+    plan->slots = malloc(sizeof(*plan->slots) * (total ? total : 1));
+    ids = comps_rtree_create(NULL, NULL, NULL);
+    if (plan->srcs == NULL || plan->slots == NULL || ids == NULL) {
+        comps_rtree_destroy(ids);
+        return 0;
+    }
+    nsrcs = 0;
+    for (i = 0; i < n; i++) {
+        for (it = plan->lists[i]->first; it; it = it->next) {
+            idstr = __comps_obj_keystr(ops->id_f(it->comps_obj), &tofree);
+            special = (idstr == NULL) ? &noid
+                                      : (idstr[0] == 0 ? &emptyid : NULL);
+            slot = special ? *special : comps_rtree_get(ids, idstr);
+            if (slot != NULL && i == 0) {
+                free(tofree);
+                continue;
+            }
+            k = nsrcs++;
+            plan->srcs[k].obj = it->comps_obj;
+            plan->srcs[k].next = COMPS_DOC_UNION_END;
+            newslot = &plan->slots[plan->len++];
+            newslot->res = NULL;
+            if (slot == NULL) {
+                newslot->first = k;
+            } else {
+                plan->srcs[slot->last].next = k;
+                newslot->first = slot->first;
+                slot->first = COMPS_DOC_UNION_END;
+            }
+            newslot->last = k;
+            if (special)
+                *special = newslot;
+            else
+                comps_rtree_set(ids, idstr, newslot);
+            free(tofree);
         }
+        if (i == 0)
+            plan->first_len = nsrcs;
     }
-    COMPS_OBJECT_DESTROY(groups);
-    for (hsit = set->data->first; hsit != NULL; hsit = hsit->next) {
-        comps_doc_add_group(res, hsit->data);
+    comps_rtree_destroy(ids);
+    if (unite) {
+        for (k = 0; k < plan->first_len; k++)
+            comps_object_incref(plan->srcs[k].obj);
+        comps_objlist_clear(plan->lists[0]);
     }
-    comps_set_clear(set);
+    return 1;
+}
 
-    comps_set_init(set, NULL, NULL, NULL, &__comps_doccategory_idcmp);
-    for (it = categories ? categories->first : NULL; it != NULL; it = it->next) {
-        comps_set_add(set, comps_object_copy(it->comps_obj));
-    }
-    COMPS_OBJECT_DESTROY(categories);
-    categories = comps_doc_categories(c2);
-    for (it = categories ? categories->first : NULL; it != NULL; it = it->next) {
-        if (comps_set_in(set, it->comps_obj)) {
-            tmpcat = comps_doccategory_union(
-                                (COMPS_DocCategory*)comps_set_data_at(set,
-                                                                it->comps_obj),
-                                (COMPS_DocCategory*)it->comps_obj);
-            tmpdata = comps_set_data_at(set, it->comps_obj);
-            comps_set_remove(set, it->comps_obj);
-            COMPS_OBJECT_DESTROY(tmpdata);
-            comps_set_add(set, tmpcat);
+/* Merge chain of slot into single object. Object nobody else references is
+ * merged in place. In unite mode merged object takes references to parts of
+ * later objects, otherwise they are copied first, so result doesn't share
+ * anything with inputs and inputs are only read.
+ */
+static void __comps_doc_union_merge(COMPS_DocUnionPlan *plan,
+                                    COMPS_DocUnionSlot *slot) {
+    const COMPS_DocUnionOps *ops = plan->ops;
+    COMPS_Object *res, *tmp;
+    size_t k;
+    char owned;
+
+    k = slot->first;
+    res = plan->srcs[k].obj;
+    owned = plan->unite && k < plan->first_len;
+    for (k = plan->srcs[k].next; k != COMPS_DOC_UNION_END;
+         k = plan->srcs[k].next) {
+        if (owned && res->refc->ref_count == 0) {
+            if (plan->unite) {
+                ops->unite_f(res, plan->srcs[k].obj);
+            } else {
+                tmp = comps_object_copy(plan->srcs[k].obj);
+                ops->unite_f(res, tmp);
+                COMPS_OBJECT_DESTROY(tmp);
+            }
         } else {
-            comps_set_add(set, comps_object_copy(it->comps_obj));
+            tmp = ops->union_f(res, plan->srcs[k].obj);
+            if (owned)
+                COMPS_OBJECT_DESTROY(res);
+            res = tmp;
+            owned = 1;
         }
     }
-    COMPS_OBJECT_DESTROY(categories);
-    for (hsit = set->data->first; hsit != NULL; hsit = hsit->next) {
-        comps_doc_add_category(res, hsit->data);
+    if (!owned)
+        res = plan->unite ? comps_object_incref(res) : comps_object_copy(res);
+    slot->res = res;
+}
+
+/* Append merged objects to section of dst and release the plan */
+static void __comps_doc_union_finish(COMPS_DocUnionPlan *plan,
+                                     COMPS_Doc *dst) {
+    COMPS_ObjList *out = NULL;
+    size_t i;
+
+    for (i = 0; plan->slots && i < plan->len; i++) {
+        if (plan->slots[i].res == NULL)
+            continue;
+        if (out == NULL)
+            out = plan->ops->list_f(dst);
+        comps_objlist_append_x(out, plan->slots[i].res);
     }
-    comps_set_clear(set);
+    COMPS_OBJECT_DESTROY(out);
+    for (i = 0; plan->lists && i < plan->n; i++)
+        COMPS_OBJECT_DESTROY(plan->lists[i]);
+    free(plan->lists);
+    free(plan->srcs);
+    free(plan->slots);
+}
 
-    comps_set_init(set, NULL, NULL, NULL, &__comps_docenv_idcmp);
-    if (envs) {
-        for (it = envs->first; it != NULL; it = it->next) {
-            comps_set_add(set, comps_object_copy(it->comps_obj));
-        }
+typedef struct {
+    COMPS_DocUnionPlan *plan;
+    COMPS_DocUnionSlot *slot;
+} COMPS_DocUnionTask;
+
+typedef struct {
+    COMPS_DocUnionTask *tasks;
+    size_t len;
+    size_t next; /* first task nobody took yet */
+    pthread_mutex_t lock;
+} COMPS_DocUnionPool;
+
+static void* __comps_doc_union_worker(void *arg) {
+    COMPS_DocUnionPool *pool = arg;
+    size_t i;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        i = pool->next;
+        if (i < pool->len)
+            pool->next++;
+        pthread_mutex_unlock(&pool->lock);
+        if (i >= pool->len)
+            break;
+        __comps_doc_union_merge(pool->tasks[i].plan, pool->tasks[i].slot);
     }
-    COMPS_OBJECT_DESTROY(envs);
-    envs = comps_doc_environments(c2);
-    if (envs) {
-        for (it = envs->first; it != NULL; it = it->next) {
-            if (comps_set_in(set, it->comps_obj)) {
-                tmpenv = comps_docenv_union(
-                                    (COMPS_DocEnv*)comps_set_data_at(set,
-                                                              it->comps_obj),
-                                    (COMPS_DocEnv*)it->comps_obj);
-                tmpdata = comps_set_data_at(set, it->comps_obj);
-                comps_set_remove(set, it->comps_obj);
-                comps_object_destroy((COMPS_Object*)tmpdata);
-                comps_set_add(set, tmpenv);
-            } else {
-                comps_set_add(set, comps_object_copy(it->comps_obj));
+    return NULL;
+}
+
+/* Merge all chains of plans, with more than one thread chains are taken
+ * from shared queue by workers and calling thread */
+static void __comps_doc_union_run(COMPS_DocUnionPlan *plans, size_t nplans,
+                                  unsigned int nthreads) {
+    COMPS_DocUnionPool pool;
+    pthread_t *threads;
+    size_t i, k, started;
+
+    if (nthreads < 2) {
+        for (i = 0; i < nplans; i++) {
+            for (k = 0; k < plans[i].len; k++) {
+                if (plans[i].slots[k].first != COMPS_DOC_UNION_END)
+                    __comps_doc_union_merge(&plans[i], &plans[i].slots[k]);
             }
         }
+        return;
     }
-    COMPS_OBJECT_DESTROY(envs);
-    for (hsit = set->data->first; hsit != NULL; hsit = hsit->next) {
-        comps_doc_add_environment(res, hsit->data);
+    for (pool.len = 0, i = 0; i < nplans; i++)
+        pool.len += plans[i].len;
+    pool.tasks = malloc(sizeof(*pool.tasks) * (pool.len ? pool.len : 1));
+    threads = malloc(sizeof(*threads) * (nthreads - 1));
+    if (pool.tasks == NULL || threads == NULL) {
+        free(pool.tasks);
+        free(threads);
+        __comps_doc_union_run(plans, nplans, 1);
+        return;
     }
-    comps_set_destroy(&set);
+    for (pool.len = 0, i = 0; i < nplans; i++) {
+        for (k = 0; k < plans[i].len; k++) {
+            if (plans[i].slots[k].first == COMPS_DOC_UNION_END)
+                continue;
+            pool.tasks[pool.len].plan = &plans[i];
+            pool.tasks[pool.len++].slot = &plans[i].slots[k];
+        }
+    }
+    pool.next = 0;
+    pthread_mutex_init(&pool.lock, NULL);
+    for (started = 0; started < nthreads - 1 && started < pool.len;
+         started++) {
+        if (pthread_create(&threads[started], NULL,
+                           &__comps_doc_union_worker, &pool) != 0)
+            break;
+    }
+    __comps_doc_union_worker(&pool);
+    for (i = 0; i < started; i++)
+        pthread_join(threads[i], NULL);
+    pthread_mutex_destroy(&pool.lock);
+    free(threads);
+    free(pool.tasks);
+}
 
-    d1 = comps_doc_langpacks(c1);
-    d2 = comps_doc_langpacks(c2);
-    langpacks = comps_objdict_union(d1,d2);
-    COMPS_OBJECT_DESTROY(d1);
-    COMPS_OBJECT_DESTROY(d2);
+static COMPS_Doc* __comps_doc_union_threaded(COMPS_Doc **docs, size_t n,
+                                             unsigned int nthreads) {
+    COMPS_Doc *res;
+    COMPS_DocUnionPlan plans[3];
+    COMPS_ObjDict *langpacks, *dict;
+    size_t i;
+
+    if (n == 0)
+        return NULL;
+    res = COMPS_OBJECT_CREATE(COMPS_Doc, (COMPS_Object*[]){(COMPS_Object*)
+                                                           docs[0]->encoding});
+    for (i = 0; i < 3; i++)
+        __comps_doc_union_plan(&plans[i], docs, n, &__comps_doc_union_ops[i],
+                               0);
+    __comps_doc_union_run(plans, 3, nthreads);
+    for (i = 0; i < 3; i++)
+        __comps_doc_union_finish(&plans[i], res);
+
+    langpacks = NULL;
+    for (i = 0; i < n; i++) {
+        dict = comps_doc_langpacks(docs[i]);
+        if (langpacks == NULL)
+            langpacks = comps_objrtree_clone(dict);
+        else
+            comps_objdict_unite(langpacks, dict);
+        COMPS_OBJECT_DESTROY(dict);
+    }
     comps_doc_set_langpacks(res, langpacks);
     COMPS_OBJECT_DESTROY(langpacks);
     return res;
 }
 
+COMPS_Doc* comps_doc_union_many(COMPS_Doc **docs, size_t n) {
+    return __comps_doc_union_threaded(docs, n, 1);
+}
+
+COMPS_Doc* comps_doc_union(COMPS_Doc *c1, COMPS_Doc *c2) {
+    return __comps_doc_union_threaded((COMPS_Doc*[]){c1, c2}, 2, 1);
+}
+
+COMPS_Doc* comps_doc_union_ex(COMPS_Doc *c1, COMPS_Doc *c2,
+                              const COMPS_DocUnionOptions *options) {
+    return __comps_doc_union_threaded((COMPS_Doc*[]){c1, c2}, 2,
+                                      options ? options->nthreads : 1);
+}
+
+void comps_doc_unite(COMPS_Doc *dst, COMPS_Doc *src) {
+    COMPS_DocUnionPlan plan;
+    COMPS_ObjDict *d1, *d2;
+    size_t i;
+
+    for (i = 0; i < 3; i++) {
+        if (__comps_doc_union_plan(&plan, (COMPS_Doc*[]){dst, src}, 2,
+                                   &__comps_doc_union_ops[i], 1))
+            __comps_doc_union_run(&plan, 1, 1);
+        __comps_doc_union_finish(&plan, dst);
+    }
+    d1 = comps_doc_langpacks(dst);
+    d2 = comps_doc_langpacks(src);
+    comps_objdict_unite(d1, d2);
+    COMPS_OBJECT_DESTROY(d1);
+    COMPS_OBJECT_DESTROY(d2);
+}
+
 /**
  * Make intersection of two existing COMPS_Doc objects. Result intersection is
  * completly new COMPS_Doc object (deep copy of those two).
@@ -467,228 +967,505 @@ COMPS_Doc* comps_doc_intersect(COMPS_Doc *c1, COMPS_Doc *c2) {
 
 COMPS_ObjList* comps_doc_get_groups(COMPS_Doc *doc, char *id, char *name,
                                     char *desc, char *lang, int flags) {
-    COMPS_ObjListIt *it;
+    COMPS_DocQuery *query;
     COMPS_ObjList *ret;
-    unsigned int matched, matched_max;
-    matched_max = 0;
-    COMPS_ObjList *groups = comps_doc_groups(doc);
-    COMPS_Str *objid, *objname, *objdesc, *tmp_prop;
-    objid = comps_str(id);
-    objname = comps_str(name);
-    objdesc = comps_str(desc);
-
-    ret = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
-    #define group ((COMPS_DocGroup*)it->comps_obj)
-
-    if (id != NULL) matched_max++;
-    if (name != NULL) matched_max++;
-    if (desc != NULL) matched_max++;
-
-    for (it = (groups)?groups->first:NULL; it != NULL; it = it->next) {
-        matched = 0;
-        tmp_prop = (COMPS_Str*)comps_docgroup_get_id(group);
-        if (id && tmp_prop && comps_str_fnmatch(tmp_prop, id, flags)) {
-            matched++;
-        }
-        COMPS_OBJECT_DESTROY(tmp_prop);
-        tmp_prop = (COMPS_Str*)comps_docgroup_get_name(group);
-        if (name && !lang && tmp_prop && comps_str_fnmatch(tmp_prop, name, flags))
-            matched++;
-        else if (name && lang != NULL) {
-            COMPS_OBJECT_DESTROY(tmp_prop);
-            tmp_prop = (COMPS_Str*)comps_objdict_get(group->name_by_lang, lang);
-            //printf("tmp_prop %s\n", tmp_prop->val);
-            if (tmp_prop && comps_str_fnmatch(tmp_prop, name, flags)) matched++;
-        }
-        COMPS_OBJECT_DESTROY(tmp_prop);
-        tmp_prop = (COMPS_Str*)comps_docgroup_get_desc(group);
-        if (desc && tmp_prop && comps_str_fnmatch(tmp_prop, desc, flags) == 1)
-            matched++;
-        else if (desc && lang != NULL) {
-            COMPS_OBJECT_DESTROY(tmp_prop);
-            tmp_prop = (COMPS_Str*)comps_objdict_get(group->desc_by_lang, lang);
-            if (tmp_prop && comps_str_fnmatch(tmp_prop, desc, flags)) matched++;
-        }
-        if (matched == matched_max) {
-            comps_objlist_append(ret, (COMPS_Object*)group);
-        }
-        COMPS_OBJECT_DESTROY(tmp_prop);
-    }
-    COMPS_OBJECT_DESTROY(objid);
-    COMPS_OBJECT_DESTROY(objname);
-    COMPS_OBJECT_DESTROY(objdesc);
-    COMPS_OBJECT_DESTROY(groups);
+
+    query = comps_doc_query_create(id, name, desc, lang, flags);
+    ret = comps_doc_query_groups(doc, query);
+    comps_doc_query_destroy(query);
     return ret;
-    #undef group
 }
 
 COMPS_ObjList* comps_doc_get_categories(COMPS_Doc *doc, char *id, char *name,
                                         char *desc, char *lang, int flags) {
-    COMPS_ObjListIt *it;
+    COMPS_DocQuery *query;
     COMPS_ObjList *ret;
-    unsigned int matched, matched_max;
-    matched_max = 0;
-    COMPS_ObjList *categories = comps_doc_categories(doc);
-    //COMPS_Object *tmp_prop;
-    COMPS_Str *objid, *objname, *objdesc, *tmp_prop;
-    objid = comps_str(id);
-    objname = comps_str(name);
-    objdesc = comps_str(desc);
-
-    ret = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
-    #define category ((COMPS_DocCategory*)it->comps_obj)
-
-    if (id != NULL) matched_max++;
-    if (name != NULL) matched_max++;
-    if (desc != NULL) matched_max++;
-
-    for (it = (categories)?categories->first:NULL; it != NULL; it = it->next) {
-        matched = 0;
-        tmp_prop = (COMPS_Str*)comps_doccategory_get_id(category);
-        if (id && tmp_prop && comps_str_fnmatch(tmp_prop, id, flags)) {
-            matched++;
-        }
-        COMPS_OBJECT_DESTROY(tmp_prop);
-        tmp_prop = (COMPS_Str*)comps_doccategory_get_name(category);
-        if (name && !lang && tmp_prop && comps_str_fnmatch(tmp_prop, name, flags))
-            matched++;
-        else if (name && lang != NULL) {
-            COMPS_OBJECT_DESTROY(tmp_prop);
-            tmp_prop = (COMPS_Str*)comps_objdict_get(category->name_by_lang, lang);
-            if (tmp_prop && comps_str_fnmatch(tmp_prop, name, flags)) matched++;
-        }
-        COMPS_OBJECT_DESTROY(tmp_prop);
-        tmp_prop = (COMPS_Str*)comps_doccategory_get_desc(category);
-        if (desc && !lang && tmp_prop && comps_str_fnmatch(tmp_prop, desc, flags))
-            matched++;
-        else if (desc && lang != NULL) {
-            COMPS_OBJECT_DESTROY(tmp_prop);
-            tmp_prop = (COMPS_Str*)comps_objdict_get(category->desc_by_lang, lang);
-            if (tmp_prop && comps_str_fnmatch(tmp_prop, desc, flags)) matched++;
-        }
-        if (matched == matched_max) {
-            comps_objlist_append(ret, (COMPS_Object*)category);
-        }
-        COMPS_OBJECT_DESTROY(tmp_prop);
-    }
-    COMPS_OBJECT_DESTROY(objid);
-    COMPS_OBJECT_DESTROY(objname);
-    COMPS_OBJECT_DESTROY(objdesc);
-    COMPS_OBJECT_DESTROY(categories);
+
+    query = comps_doc_query_create(id, name, desc, lang, flags);
+    ret = comps_doc_query_categories(doc, query);
+    comps_doc_query_destroy(query);
     return ret;
-    #undef category
 }
 
 COMPS_ObjList* comps_doc_get_envs(COMPS_Doc *doc, char *id, char *name,
                                   char *desc, char *lang, int flags) {
-    COMPS_ObjListIt *it;
+    COMPS_DocQuery *query;
     COMPS_ObjList *ret;
-    unsigned int matched, matched_max;
-    matched_max = 0;
-    COMPS_ObjList *envs = comps_doc_environments(doc);
-    //COMPS_Object *tmp_prop;
-    COMPS_Str *objid, *objname, *objdesc, *tmp_prop;
-    objid = comps_str(id);
-    objname = comps_str(name);
-    objdesc = comps_str(desc);
-
-    ret = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
-    #define env ((COMPS_DocEnv*)it->comps_obj)
-
-    if (id != NULL) matched_max++;
-    if (name != NULL) matched_max++;
-    if (desc != NULL) matched_max++;
-
-    for (it = (envs)?envs->first:NULL; it != NULL; it = it->next) {
-        matched = 0;
-        tmp_prop = (COMPS_Str*)comps_docenv_get_id(env);
-        if (id && tmp_prop && comps_str_fnmatch(tmp_prop, id, flags)) {
-            matched++;
+
+    query = comps_doc_query_create(id, name, desc, lang, flags);
+    ret = comps_doc_query_envs(doc, query);
+    comps_doc_query_destroy(query);
+    return ret;
+}
+
+typedef signed char (*COMPS_DocXMLFunc)(COMPS_Object*, xmlTextWriterPtr,
+                                        COMPS_Log*, COMPS_XMLOptions*,
+                                        COMPS_DefaultsOptions*);
+
+static signed char __comps_docgroup_xml_obj(COMPS_Object *obj,
+                                            xmlTextWriterPtr writer,
+                                            COMPS_Log *log,
+                                            COMPS_XMLOptions *xml_options,
+                                            COMPS_DefaultsOptions *def_options) {
+    return comps_docgroup_xml((COMPS_DocGroup*)obj, writer, log, xml_options,
+                              def_options);
+}
+static signed char __comps_doccategory_xml_obj(COMPS_Object *obj,
+                                            xmlTextWriterPtr writer,
+                                            COMPS_Log *log,
+                                            COMPS_XMLOptions *xml_options,
+                                            COMPS_DefaultsOptions *def_options) {
+    return comps_doccategory_xml((COMPS_DocCategory*)obj, writer, log,
+                                 xml_options, def_options);
+}
+static signed char __comps_docenv_xml_obj(COMPS_Object *obj,
+                                          xmlTextWriterPtr writer,
+                                          COMPS_Log *log,
+                                          COMPS_XMLOptions *xml_options,
+                                          COMPS_DefaultsOptions *def_options) {
+    return comps_docenv_xml((COMPS_DocEnv*)obj, writer, log, xml_options,
+                            def_options);
+}
+
+typedef struct {
+    COMPS_Object *obj;
+    COMPS_DocXMLFunc xml_f;
+    COMPS_XMLFragment **cache; /* xml_cache member of obj */
+} COMPS_DocXMLItem;
+
+/* Groups, categories and environments in order of output, all of doc or
+ * the selected ones. Objects are borrowed, doc or selection keeps them
+ * alive */
+static COMPS_DocXMLItem* __comps_doc_xml_items(COMPS_Doc *doc,
+                                               const COMPS_XMLSelection *sel,
+                                               size_t *len) {
+    static COMPS_ObjList* (*lists_f[])(COMPS_Doc*) = {&comps_doc_groups,
+                                                      &comps_doc_categories,
+                                                      &comps_doc_environments};
+    static COMPS_Object* (*id_f[])(COMPS_Object*) = {&__comps_docgroup_id_x,
+                                                     &__comps_doccategory_id_x,
+                                                     &__comps_docenv_id_x};
+    static COMPS_Object* (*props_f[])(COMPS_Object*) = {
+                                                &__comps_docgroup_props_x,
+                                                &__comps_doccategory_props_x,
+                                                &__comps_docenv_props_x};
+    static COMPS_ObjectInfo *infos[] = {&COMPS_DocGroup_ObjInfo,
+                                        &COMPS_DocCategory_ObjInfo,
+                                        &COMPS_DocEnv_ObjInfo};
+    static const COMPS_DocXMLFunc xml_f[] = {&__comps_docgroup_xml_obj,
+                                             &__comps_doccategory_xml_obj,
+                                             &__comps_docenv_xml_obj};
+    static const size_t cache_off[] = {offsetof(COMPS_DocGroup, xml_cache),
+                                       offsetof(COMPS_DocCategory, xml_cache),
+                                       offsetof(COMPS_DocEnv, xml_cache)};
+    COMPS_ObjList *lists[3];
+    COMPS_ObjListIt *it;
+    COMPS_Object *obj;
+    COMPS_DocXMLItem *items;
+    size_t total = 0;
+    int i;
+
+    if (sel) {
+        lists[0] = sel->groups;
+        lists[1] = sel->categories;
+        lists[2] = sel->envs;
+    }
+    for (i = 0; i < 3; i++) {
+        if (sel)
+            comps_object_incref((COMPS_Object*)lists[i]);
+        else
+            lists[i] = lists_f[i](doc);
+        total += lists[i] ? lists[i]->len : 0;
+    }
+    items = malloc(sizeof(*items) * (total ? total : 1));
+    *len = 0;
+    for (i = 0; i < 3; i++) {
+        for (it = lists[i] && items ? lists[i]->first : NULL; it != NULL;
+             it = it->next) {
+            obj = it->comps_obj;
+            if (obj->obj_info == &COMPS_Str_ObjInfo) {
+                /* id of object in doc, doc keeps found object alive */
+                obj = __comps_doc_by_id(doc, lists_f[i], id_f[i], props_f[i],
+                                        ((COMPS_Str*)obj)->val);
+                COMPS_OBJECT_DESTROY(obj);
+            }
+            if (obj == NULL || obj->obj_info != infos[i])
+                continue;
+            items[*len].obj = obj;
+            items[*len].cache = (COMPS_XMLFragment**)
+                                ((char*)obj + cache_off[i]);
+            items[(*len)++].xml_f = xml_f[i];
         }
-        COMPS_OBJECT_DESTROY(tmp_prop);
-        tmp_prop = (COMPS_Str*)comps_docenv_get_name(env);
-        if (name && !lang && tmp_prop && comps_str_fnmatch(tmp_prop, name, flags))
-            matched++;
-        else if (name && lang != NULL) {
-            COMPS_OBJECT_DESTROY(tmp_prop);
-            tmp_prop = (COMPS_Str*)comps_objdict_get(env->name_by_lang, lang);
-            if (tmp_prop && comps_str_fnmatch(tmp_prop, name, flags)) matched++;
+        COMPS_OBJECT_DESTROY(lists[i]);
+    }
+    return items;
+}
+
+/* Writer rendering into buf as if inside root element of document, so
+ * objects get the same indentation as there. Empty raw write closes start
+ * tag of the root the way preceding sibling would. *start is set to offset
+ * where rendered objects begin */
+static xmlTextWriterPtr __comps_doc_xml_subwriter(xmlBufferPtr buf,
+                                                  size_t *start) {
+    xmlTextWriterPtr writer;
+
+    if ((writer = xmlNewTextWriterMemory(buf, 0)) == NULL)
+        return NULL;
+    xmlTextWriterSetIndent(writer, 1);
+    xmlTextWriterSetIndentString(writer, BAD_CAST "  ");
+    if (xmlTextWriterStartElement(writer, BAD_CAST "comps") < 0
+        || xmlTextWriterWriteRaw(writer, BAD_CAST "") < 0
+        || xmlTextWriterFlush(writer) < 0) {
+        xmlFreeTextWriter(writer);
+        return NULL;
+    }
+    *start = xmlBufferLength(buf);
+    return writer;
+}
+
+/* Copy already rendered objects to writer. Start tag of the root is closed
+ * with newline before the first of them unless *root_closed is set */
+static int __comps_doc_xml_raw(xmlTextWriterPtr writer, const xmlChar *xml,
+                               size_t len, char *root_closed) {
+    if (len == 0)
+        return 0;
+    if (!*root_closed && xmlTextWriterWriteRaw(writer, BAD_CAST "\n") < 0)
+        return -1;
+    *root_closed = 1;
+    return xmlTextWriterWriteRawLen(writer, xml, len) < 0 ? -1 : 0;
+}
+
+/* Store fragment back to xml_cache slot, replacing one stored meanwhile by
+ * concurrent output of the same object */
+static void __comps_doc_xml_cache_put(COMPS_XMLFragment **cache,
+                                      COMPS_XMLFragment *frag) {
+    if (frag == NULL)
+        return;
+    __comps_xml_fragment_destroy(__atomic_exchange_n(cache, frag,
+                                                     __ATOMIC_ACQ_REL));
+}
+
+/* Output item from its xml_cache, rendering and storing it first if the
+ * object or options changed since. Objects skipped with warning aren't
+ * stored, so the warning is logged on every output. Fragment is taken out
+ * of the slot while in use, so outputs of the same object in several
+ * threads never free fragment the other one reads; the one finding the
+ * slot empty renders the object again */
+static signed char __comps_doc_xml_cached(COMPS_DocXMLItem *item,
+                                          xmlTextWriterPtr writer,
+                                          COMPS_Log *log,
+                                          COMPS_XMLOptions *xml_options,
+                                          COMPS_DefaultsOptions *def_options,
+                                          COMPS_Digest options,
+                                          char *root_closed) {
+    COMPS_XMLFragment *frag;
+    COMPS_Digest digest;
+    xmlTextWriterPtr subwriter;
+    xmlBufferPtr buf;
+    size_t start;
+    signed char ret;
+
+    frag = __atomic_exchange_n(item->cache, NULL, __ATOMIC_ACQ_REL);
+    digest = comps_object_digest(item->obj);
+    if (frag && frag->digest == digest && frag->options == options) {
+        ret = __comps_doc_xml_raw(writer, BAD_CAST frag->xml, frag->len,
+                                  root_closed);
+        __comps_doc_xml_cache_put(item->cache, frag);
+        return ret;
+    }
+    __comps_xml_fragment_destroy(frag);
+    frag = NULL;
+
+    if ((buf = xmlBufferCreate()) == NULL)
+        return -1;
+    if ((subwriter = __comps_doc_xml_subwriter(buf, &start)) == NULL) {
+        xmlBufferFree(buf);
+        return -1;
+    }
+    ret = item->xml_f(item->obj, subwriter, log, xml_options, def_options);
+    if (xmlTextWriterFlush(subwriter) < 0)
+        ret = -1;
+    xmlFreeTextWriter(subwriter);
+    if (ret != -1 && __comps_doc_xml_raw(writer, xmlBufferContent(buf) + start,
+                                         xmlBufferLength(buf) - start,
+                                         root_closed) < 0)
+        ret = -1;
+    if (ret == 0 && (frag = malloc(sizeof(*frag))) != NULL) {
+        frag->len = xmlBufferLength(buf) - start;
+        if ((frag->xml = malloc(frag->len ? frag->len : 1)) == NULL) {
+            free(frag);
+        } else {
+            memcpy(frag->xml, xmlBufferContent(buf) + start, frag->len);
+            frag->digest = digest;
+            frag->options = options;
+            __comps_doc_xml_cache_put(item->cache, frag);
         }
-        COMPS_OBJECT_DESTROY(tmp_prop);
-        tmp_prop = (COMPS_Str*)comps_docenv_get_desc(env);
-        if (desc && !lang && tmp_prop && comps_str_fnmatch(tmp_prop, desc, flags))
-            matched++;
-        else if (desc && lang != NULL) {
-            COMPS_OBJECT_DESTROY(tmp_prop);
-            tmp_prop = (COMPS_Str*)comps_objdict_get(env->desc_by_lang, lang);
-            if (tmp_prop && comps_str_fnmatch(tmp_prop, desc, flags)) matched++;
+    }
+    xmlBufferFree(buf);
+    return ret;
+}
+
+/* Output consecutive items. With cache_options they go through
+ * fragment cache, see __comps_doc_xml_cached() */
+static signed char __comps_doc_xml_range(COMPS_DocXMLItem *items, size_t len,
+                                         xmlTextWriterPtr writer,
+                                         COMPS_Log *log,
+                                         COMPS_XMLOptions *xml_options,
+                                         COMPS_DefaultsOptions *def_options,
+                                         const COMPS_Digest *cache_options,
+                                         char *root_closed) {
+    signed char ret = 0, tmpret;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        if (cache_options)
+            tmpret = __comps_doc_xml_cached(&items[i], writer, log,
+                                            xml_options, def_options,
+                                            *cache_options, root_closed);
+        else
+            tmpret = items[i].xml_f(items[i].obj, writer, log, xml_options,
+                                    def_options);
+        if (tmpret == -1)
+            return -1;
+        ret += tmpret;
+    }
+    return ret;
+}
+
+/* Digest of everything in options that changes rendered objects */
+static COMPS_Digest __comps_doc_xml_options_digest(
+                                          COMPS_XMLOptions *xml_options,
+                                          COMPS_DefaultsOptions *def_options) {
+    const bool flags[] = {xml_options->empty_groups,
+                          xml_options->empty_categories,
+                          xml_options->empty_environments,
+                          xml_options->empty_packages,
+                          xml_options->empty_grouplist,
+                          xml_options->empty_optionlist,
+                          xml_options->biarchonly_explicit,
+                          xml_options->uservisible_explicit,
+                          xml_options->default_explicit,
+                          xml_options->gid_default_explicit,
+                          xml_options->bao_explicit,
+                          xml_options->arch_output,
+                          def_options->default_uservisible,
+                          def_options->default_biarchonly,
+                          def_options->default_default};
+    COMPS_Digest ret = COMPS_DIGEST_INIT;
+    size_t i;
+
+    for (i = 0; i < sizeof(flags) / sizeof(flags[0]); i++)
+        ret = comps_digest_u64(ret, flags[i]);
+    ret = comps_digest_u64(ret, (uint64_t)def_options->default_pkgtype);
+    return comps_digest_finish(ret);
+}
+
+/* Consecutive items rendered by one worker into its own buffer and log */
+typedef struct {
+    COMPS_DocXMLItem *items;
+    size_t len;
+    xmlBufferPtr buf;
+    size_t start; /* offset of first rendered item in buf */
+    size_t end;
+    COMPS_Log *log;
+    signed char ret;
+} COMPS_DocXMLChunk;
+
+typedef struct {
+    COMPS_DocXMLChunk *chunks;
+    size_t len;
+    size_t next; /* first chunk nobody took yet */
+    pthread_mutex_t lock;
+    COMPS_XMLOptions *xml_options;
+    COMPS_DefaultsOptions *def_options;
+    const COMPS_Digest *cache_options;
+} COMPS_DocXMLPool;
+
+static void __comps_doc_xml_chunk(COMPS_DocXMLChunk *chunk,
+                                  COMPS_DocXMLPool *pool) {
+    xmlTextWriterPtr writer;
+    char root_closed = 1;
+
+    chunk->ret = -1;
+    chunk->log = COMPS_OBJECT_CREATE(COMPS_Log, NULL);
+    if ((chunk->buf = xmlBufferCreate()) == NULL)
+        return;
+    if ((writer = __comps_doc_xml_subwriter(chunk->buf,
+                                            &chunk->start)) == NULL)
+        return;
+    chunk->ret = __comps_doc_xml_range(chunk->items, chunk->len, writer,
+                                       chunk->log, pool->xml_options,
+                                       pool->def_options, pool->cache_options,
+                                       &root_closed);
+    if (xmlTextWriterFlush(writer) < 0)
+        chunk->ret = -1;
+    chunk->end = xmlBufferLength(chunk->buf);
+    xmlFreeTextWriter(writer);
+}
+
+static void* __comps_doc_xml_worker(void *arg) {
+    COMPS_DocXMLPool *pool = arg;
+    size_t i;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        i = pool->next;
+        if (i < pool->len)
+            pool->next++;
+        pthread_mutex_unlock(&pool->lock);
+        if (i >= pool->len)
+            break;
+        __comps_doc_xml_chunk(&pool->chunks[i], pool);
+    }
+    return NULL;
+}
+
+/* Move log entries of chunk to document log in order they were made */
+static void __comps_doc_xml_log_merge(COMPS_Log *log, COMPS_Log *chunk_log) {
+    COMPS_HSListItem *hsit;
+    char *str;
+
+    for (hsit = chunk_log->entries->first; hsit != NULL; hsit = hsit->next) {
+        if (log->std_out) {
+            str = comps_log_entry_str(hsit->data);
+            fprintf(stderr, "%s", str);
+            free(str);
         }
-        if (matched == matched_max) {
-            comps_objlist_append(ret, (COMPS_Object*)env);
+        comps_hslist_append(log->entries, hsit->data, 0);
+    }
+    chunk_log->entries->data_destructor = NULL;
+}
+
+/* Render items by pool of threads into per chunk buffers, then copy the
+ * buffers to writer in document order. Result is the same as of
+ * __comps_doc_xml_range() */
+static signed char __comps_doc_xml_threaded(COMPS_Doc *doc,
+                                            COMPS_DocXMLItem *items,
+                                            size_t nitems,
+                                            xmlTextWriterPtr writer,
+                                            COMPS_XMLOptions *xml_options,
+                                            COMPS_DefaultsOptions *def_options,
+                                            const COMPS_Digest *cache_options,
+                                            char *root_closed) {
+    COMPS_DocXMLPool pool;
+    pthread_t *threads;
+    size_t i, per_chunk, started;
+    signed char ret = 0;
+
+    /* few chunks per thread even out objects of different size */
+    pool.len = xml_options->nthreads * 4;
+    if (pool.len > nitems)
+        pool.len = nitems;
+    pool.chunks = calloc(pool.len, sizeof(*pool.chunks));
+    threads = malloc(sizeof(*threads) * (xml_options->nthreads - 1));
+    if (pool.chunks == NULL || threads == NULL) {
+        free(pool.chunks);
+        free(threads);
+        return __comps_doc_xml_range(items, nitems, writer, doc->log,
+                                     xml_options, def_options, cache_options,
+                                     root_closed);
+    }
+    per_chunk = nitems / pool.len;
+    for (i = 0; i < pool.len; i++) {
+        pool.chunks[i].items = items + i * per_chunk
+                               + (i < nitems % pool.len ? i : nitems % pool.len);
+        pool.chunks[i].len = per_chunk + (i < nitems % pool.len);
+    }
+    pool.next = 0;
+    pool.xml_options = xml_options;
+    pool.def_options = def_options;
+    pool.cache_options = cache_options;
+    pthread_mutex_init(&pool.lock, NULL);
+    for (started = 0; started < xml_options->nthreads - 1; started++) {
+        if (pthread_create(&threads[started], NULL,
+                           &__comps_doc_xml_worker, &pool) != 0)
+            break;
+    }
+    __comps_doc_xml_worker(&pool);
+    for (i = 0; i < started; i++)
+        pthread_join(threads[i], NULL);
+    pthread_mutex_destroy(&pool.lock);
+    free(threads);
+
+    for (i = 0; i < pool.len; i++) {
+        if (ret != -1) {
+            __comps_doc_xml_log_merge(doc->log, pool.chunks[i].log);
+            if (pool.chunks[i].ret == -1)
+                ret = -1;
+            else
+                ret += pool.chunks[i].ret;
         }
-        COMPS_OBJECT_DESTROY(tmp_prop);
+        if (ret != -1 && __comps_doc_xml_raw(writer,
+                            xmlBufferContent(pool.chunks[i].buf)
+                            + pool.chunks[i].start,
+                            pool.chunks[i].end - pool.chunks[i].start,
+                            root_closed) < 0)
+            ret = -1;
+        COMPS_OBJECT_DESTROY(pool.chunks[i].log);
+        if (pool.chunks[i].buf)
+            xmlBufferFree(pool.chunks[i].buf);
     }
-    COMPS_OBJECT_DESTROY(objid);
-    COMPS_OBJECT_DESTROY(objname);
-    COMPS_OBJECT_DESTROY(objdesc);
-    COMPS_OBJECT_DESTROY(envs);
+    free(pool.chunks);
     return ret;
-    #undef env
 }
 
 static signed char comps_doc_xml(COMPS_Doc *doc, xmlTextWriterPtr writer,
+                                 const COMPS_XMLSelection *selection,
                                  COMPS_XMLOptions *xml_options,
                                  COMPS_DefaultsOptions *def_options) {
     COMPS_ObjListIt *it;
-    COMPS_ObjList *list;
+    COMPS_DocXMLItem *items;
+    size_t nitems;
+    COMPS_Digest cache_options = 0;
+    char root_closed = 0;
     COMPS_ObjDict *dict;
     COMPS_ObjMDict *mdict;
     COMPS_HSList *hslist;
     COMPS_HSListItem *hsit;
     int retc;
-    signed char ret = 0, tmpret;
+    signed char ret = 0;
 
+    /* indenting writer would split DOCTYPE to several lines, but newline
+     * after it is still wanted */
+    xmlTextWriterSetIndent(writer, 0);
     retc = xmlTextWriterStartDTD(writer, (const xmlChar*)doc->doctype_name->val,
                                   (const xmlChar*)doc->doctype_pubid->val,
                                   (const xmlChar*)doc->doctype_sysid->val);
+    xmlTextWriterSetIndent(writer, 1);
     xmlTextWriterEndDTD(writer);
     if (__comps_check_xml_get(retc, (COMPS_Object*)doc->log) < 0) return -1;
 
     retc = xmlTextWriterStartElement(writer, BAD_CAST "comps");
     if (__comps_check_xml_get(retc, (COMPS_Object*)doc->log) < 0) return -1;
-    list = comps_doc_groups(doc);
-    if (list) {
-        for (it = list->first; it != NULL; it = it->next) {
-            tmpret = comps_docgroup_xml((COMPS_DocGroup*)it->comps_obj,
-                                        writer, doc->log, xml_options,
-                                        def_options);
-            if (tmpret == -1) return -1;
-            else ret += tmpret;
-        }
+    items = __comps_doc_xml_items(doc, selection, &nitems);
+    if (items == NULL) {
+        comps_log_error(doc->log, COMPS_ERR_MALLOC, 0);
+        return -1;
     }
-    COMPS_OBJECT_DESTROY(list);
-    list = comps_doc_categories(doc);
-    if (list) {
-        for (it = list->first; it != NULL; it = it->next) {
-            tmpret = comps_doccategory_xml((COMPS_DocCategory*)it->comps_obj,
-                                           writer, doc->log, xml_options,
-                                           def_options);
-            if (tmpret == -1) return -1;
-            else ret += tmpret;
-        }
-    }
-    COMPS_OBJECT_DESTROY(list);
-    list = comps_doc_environments(doc);
-    if (list) {
-        for (it = list->first; it != NULL; it = it->next) {
-            tmpret = comps_docenv_xml((COMPS_DocEnv*)it->comps_obj,
-                                      writer, doc->log, xml_options,
-                                      def_options);
-            if (tmpret == -1) return -1;
-            else ret += tmpret;
-        }
+    if (xml_options->fragment_cache)
+        cache_options = __comps_doc_xml_options_digest(xml_options,
+                                                       def_options);
+    if (xml_options->nthreads > 1 && nitems > 1)
+        ret = __comps_doc_xml_threaded(doc, items, nitems, writer,
+                                       xml_options, def_options,
+                                       xml_options->fragment_cache
+                                       ? &cache_options : NULL,
+                                       &root_closed);
+    else
+        ret = __comps_doc_xml_range(items, nitems, writer, doc->log,
+                                    xml_options, def_options,
+                                    xml_options->fragment_cache
+                                    ? &cache_options : NULL,
+                                    &root_closed);
+    free(items);
+    if (ret == -1)
+        return -1;
+    if (selection && !selection->doc_lists) {
+        retc = xmlTextWriterEndElement(writer);
+        if (__comps_check_xml_get(retc, (COMPS_Object*)doc->log) < 0)
+            return -1;
+        return ret;
     }
-    COMPS_OBJECT_DESTROY(list);
     dict = comps_doc_langpacks(doc);
     if (dict && dict->len) {
         retc = xmlTextWriterStartElement(writer, BAD_CAST "langpacks");
@@ -706,11 +1483,11 @@ static signed char comps_doc_xml(COMPS_Doc *doc, xmlTextWriterPtr writer,
                 return -1;
             }
 
-            xmlTextWriterWriteAttribute(writer, BAD_CAST "name",
-                    (xmlChar*) ((COMPS_ObjRTreePair*)hsit->data)->key);
+            __comps_xml_attr(writer, "name",
+                    ((COMPS_ObjRTreePair*)hsit->data)->key);
 
             char *tmp = comps_object_tostr(((COMPS_ObjRTreePair*)hsit->data)->data);
-            xmlTextWriterWriteAttribute(writer, BAD_CAST "install", BAD_CAST tmp);
+            __comps_xml_attr(writer, "install", tmp);
             free(tmp);
 
             retc = xmlTextWriterEndElement(writer);
@@ -734,6 +1511,7 @@ static signed char comps_doc_xml(COMPS_Doc *doc, xmlTextWriterPtr writer,
     if (mdict && mdict->len) {
         retc = xmlTextWriterStartElement(writer, BAD_CAST "blacklist");
         if (__comps_check_xml_get(retc, (COMPS_Object*)doc->log) < 0) {
+            COMPS_OBJECT_DESTROY(mdict);
             return -1;
         }
         hslist = comps_objmrtree_pairs(mdict);
@@ -744,18 +1522,20 @@ static signed char comps_doc_xml(COMPS_Doc *doc, xmlTextWriterPtr writer,
                 retc = xmlTextWriterStartElement(writer, BAD_CAST "package");
                 if (__comps_check_xml_get(retc, (COMPS_Object*)doc->log) < 0) {
                     comps_hslist_destroy(&hslist);
+                    COMPS_OBJECT_DESTROY(mdict);
                     return -1;
                 }
-                xmlTextWriterWriteAttribute(writer, BAD_CAST "name",
-                        (xmlChar*) ((COMPS_ObjRTreePair*)hsit->data)->key);
+                __comps_xml_attr(writer, "name",
+                        ((COMPS_ObjRTreePair*)hsit->data)->key);
 
                 char *tmp = comps_object_tostr(it->comps_obj);
-                xmlTextWriterWriteAttribute(writer, BAD_CAST "arch", BAD_CAST tmp);
+                __comps_xml_attr(writer, "arch", tmp);
                 free(tmp);
 
                 retc = xmlTextWriterEndElement(writer);
                 if (__comps_check_xml_get(retc, (COMPS_Object*)doc->log) < 0) {
                     comps_hslist_destroy(&hslist);
+                    COMPS_OBJECT_DESTROY(mdict);
                     return -1;
                 }
             }
@@ -764,6 +1544,7 @@ static signed char comps_doc_xml(COMPS_Doc *doc, xmlTextWriterPtr writer,
 
         retc = xmlTextWriterEndElement(writer);
         if (__comps_check_xml_get(retc, (COMPS_Object*)doc->log) < 0) {
+            COMPS_OBJECT_DESTROY(mdict);
             return -1;
         }
     }
@@ -783,19 +1564,21 @@ static signed char comps_doc_xml(COMPS_Doc *doc, xmlTextWriterPtr writer,
                 retc = xmlTextWriterStartElement(writer, BAD_CAST "ignoredep");
                 if (__comps_check_xml_get(retc, (COMPS_Object*)doc->log) < 0) {
                     comps_hslist_destroy(&hslist);
+                    COMPS_OBJECT_DESTROY(mdict);
                     return -1;
                 }
 
-                xmlTextWriterWriteAttribute(writer, BAD_CAST "requires",
-                        (xmlChar*) ((COMPS_ObjRTreePair*)hsit->data)->key);
+                __comps_xml_attr(writer, "requires",
+                        ((COMPS_ObjRTreePair*)hsit->data)->key);
 
                 char *tmp = comps_object_tostr(it->comps_obj);
-                xmlTextWriterWriteAttribute(writer, BAD_CAST "package", BAD_CAST tmp);
+                __comps_xml_attr(writer, "package", tmp);
                 free(tmp);
 
                 retc = xmlTextWriterEndElement(writer);
                 if (__comps_check_xml_get(retc, (COMPS_Object*)doc->log) < 0) {
                     comps_hslist_destroy(&hslist);
+                    COMPS_OBJECT_DESTROY(mdict);
                     return -1;
                 }
             }
@@ -804,6 +1587,7 @@ static signed char comps_doc_xml(COMPS_Doc *doc, xmlTextWriterPtr writer,
 
         retc = xmlTextWriterEndElement(writer);
         if (__comps_check_xml_get(retc, (COMPS_Object*)doc->log) < 0) {
+            COMPS_OBJECT_DESTROY(mdict);
             return -1;
         }
     }
@@ -833,48 +1617,90 @@ void comps_doc_doctype_pubid_set(COMPS_Doc* doc, COMPS_Str *val) {
 }
 
 
-COMPS_Doc* comps_doc_arch_filter(COMPS_Doc *source, COMPS_ObjList *arches) {
-    COMPS_ObjList *list, *arches2;
-    COMPS_Doc *ret;
-    COMPS_DocCategory *cat;
-    COMPS_DocGroup *group;
-    COMPS_DocEnv *env;
-
-    ret = COMPS_OBJECT_CREATE(COMPS_Doc, (COMPS_Object*[])
-                                         {(COMPS_Object*)source->encoding});
+COMPS_Doc** comps_doc_arch_filter_multi(COMPS_Doc *source,
+                                        COMPS_ObjList **arches,
+                                        unsigned int count) {
+    COMPS_ArchFilter *filter;
+    COMPS_ObjList *list;
+    COMPS_ObjListIt *it;
+    COMPS_Object **objs;
+    COMPS_Doc **ret;
+    char *keep;
+    unsigned int i;
+
+    if (count == 0)
+        return NULL;
+    ret = malloc(sizeof(*ret) * count);
+    objs = malloc(sizeof(*objs) * count);
+    keep = malloc(sizeof(*keep) * count);
+    filter = comps_archfilter_create(arches, count);
+    if (!ret || !objs || !keep || !filter) {
+        free(ret);
+        free(objs);
+        free(keep);
+        comps_archfilter_destroy(filter);
+        return NULL;
+    }
+    for (i = 0; i < count; i++) {
+        ret[i] = COMPS_OBJECT_CREATE(COMPS_Doc, (COMPS_Object*[])
+                                     {(COMPS_Object*)source->encoding});
+    }
+    /* arches of every object and its items are looked up once for all
+     * arch lists */
     list = comps_doc_categories(source);
-    for (COMPS_ObjListIt *it = list->first; it != NULL; it = it->next) {
-        arches2 = comps_doccategory_arches((COMPS_DocCategory*)it->comps_obj);
-        if ((!arches2) || (__comps_objlist_intersected(arches, arches2))) {
-            cat = comps_doccategory_arch_filter((COMPS_DocCategory*)it->comps_obj,
-                                                arches);
-            comps_doc_add_category(ret, cat);
+    for (it = list->first; it != NULL; it = it->next) {
+        comps_archfilter_match(filter, (COMPS_ObjList*)comps_objdict_get_x(
+                    ((COMPS_DocCategory*)it->comps_obj)->properties,
+                    "arches"), keep);
+        __comps_doccategory_arch_filter_multi(
+                    (COMPS_DocCategory*)it->comps_obj, filter, keep,
+                    (COMPS_DocCategory**)objs);
+        for (i = 0; i < count; i++) {
+            if (objs[i])
+                comps_doc_add_category(ret[i], (COMPS_DocCategory*)objs[i]);
         }
-        COMPS_OBJECT_DESTROY(arches2);
     }
     COMPS_OBJECT_DESTROY(list);
     list = comps_doc_groups(source);
-    for (COMPS_ObjListIt *it = list->first; it != NULL; it = it->next) {
-        arches2 = comps_docgroup_arches((COMPS_DocGroup*)it->comps_obj);
-        if ((!arches2) || (__comps_objlist_intersected(arches, arches2))) {
-            group = comps_docgroup_arch_filter((COMPS_DocGroup*)it->comps_obj,
-                                                arches);
-            comps_doc_add_group(ret, group);
+    for (it = list->first; it != NULL; it = it->next) {
+        comps_archfilter_match(filter, (COMPS_ObjList*)comps_objdict_get_x(
+                    ((COMPS_DocGroup*)it->comps_obj)->properties,
+                    "arches"), keep);
+        __comps_docgroup_arch_filter_multi((COMPS_DocGroup*)it->comps_obj,
+                                           filter, keep,
+                                           (COMPS_DocGroup**)objs);
+        for (i = 0; i < count; i++) {
+            if (objs[i])
+                comps_doc_add_group(ret[i], (COMPS_DocGroup*)objs[i]);
         }
-        COMPS_OBJECT_DESTROY(arches2);
     }
     COMPS_OBJECT_DESTROY(list);
     list = comps_doc_environments(source);
-    for (COMPS_ObjListIt *it = list->first; it != NULL; it = it->next) {
-        arches2 = comps_docenv_arches((COMPS_DocEnv*)it->comps_obj);
-        if ((!arches2) || (__comps_objlist_intersected(arches, arches2))) {
-            env = comps_docenv_arch_filter((COMPS_DocEnv*)it->comps_obj,
-                                           arches);
-            comps_doc_add_environment(ret, env);
+    for (it = list->first; it != NULL; it = it->next) {
+        comps_archfilter_match(filter, (COMPS_ObjList*)comps_objdict_get_x(
+                    ((COMPS_DocEnv*)it->comps_obj)->properties,
+                    "arches"), keep);
+        __comps_docenv_arch_filter_multi((COMPS_DocEnv*)it->comps_obj,
+                                         filter, keep, (COMPS_DocEnv**)objs);
+        for (i = 0; i < count; i++) {
+            if (objs[i])
+                comps_doc_add_environment(ret[i], (COMPS_DocEnv*)objs[i]);
         }
-        COMPS_OBJECT_DESTROY(arches2);
     }
     COMPS_OBJECT_DESTROY(list);
+    comps_archfilter_destroy(filter);
+    free(objs);
+    free(keep);
+    return ret;
+}
+
+COMPS_Doc* comps_doc_arch_filter(COMPS_Doc *source, COMPS_ObjList *arches) {
+    COMPS_Doc **docs, *ret;
+
+    if ((docs = comps_doc_arch_filter_multi(source, &arches, 1)) == NULL)
+        return NULL;
+    ret = docs[0];
+    free(docs);
     return ret;
 }
 
@@ -952,5 +1778,6 @@ COMPS_ObjectInfo COMPS_Doc_ObjInfo = {
     .constructor = &comps_doc_create_u,
     .destructor = &comps_doc_destroy_u,
     .copy = &comps_doc_copy_u,
-    .obj_cmp = &comps_doc_cmp_u
+    .obj_cmp = &comps_doc_cmp_u,
+    .digest = &comps_doc_digest_u
 };
@@ -26,6 +26,7 @@ void comps_doccategory_create(COMPS_DocCategory *category, COMPS_Object **args)
     category->name_by_lang = COMPS_OBJECT_CREATE(COMPS_ObjDict, NULL);
     category->desc_by_lang = COMPS_OBJECT_CREATE(COMPS_ObjDict, NULL);
     category->group_ids = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+    category->xml_cache = NULL;
 }
 COMPS_CREATE_u(doccategory, COMPS_DocCategory)  /*comps_utils.h macro*/
 
@@ -39,6 +40,7 @@ void comps_doccategory_copy(COMPS_DocCategory *category_dst,
                                 COMPS_OBJECT_COPY(category_src->desc_by_lang);
     category_dst->group_ids = (COMPS_ObjList*)
                                 COMPS_OBJECT_COPY(category_src->group_ids);
+    category_dst->xml_cache = NULL;
 }
 COMPS_COPY_u(doccategory, COMPS_DocCategory)    /*comps_utils.h macro*/
 
@@ -47,6 +49,7 @@ static void comps_doccategory_destroy(COMPS_DocCategory *category) {
     COMPS_OBJECT_DESTROY(category->name_by_lang);
     COMPS_OBJECT_DESTROY(category->desc_by_lang);
     COMPS_OBJECT_DESTROY(category->group_ids);
+    __comps_xml_fragment_destroy(category->xml_cache);
 }
 COMPS_DESTROY_u(doccategory, COMPS_DocCategory) /*comps_utils.h macro*/
 
@@ -80,6 +83,14 @@ void comps_doccategory_add_groupid(COMPS_DocCategory *category,
     comps_objlist_append_x(category->group_ids, (COMPS_Object*)gid);
 }
 
+COMPS_Object* __comps_doccategory_id_x(COMPS_Object *cat) {
+    return comps_objdict_get_x(((COMPS_DocCategory*)cat)->properties, "id");
+}
+
+COMPS_Object* __comps_doccategory_props_x(COMPS_Object *cat) {
+    return (COMPS_Object*)((COMPS_DocCategory*)cat)->properties;
+}
+
 signed char comps_doccategory_cmp_u(COMPS_Object *cat1, COMPS_Object *cat2) {
     #define _cat1 ((COMPS_DocCategory*)cat1)
     #define _cat2 ((COMPS_DocCategory*)cat2)
@@ -140,13 +151,17 @@ COMPS_DocCategory* comps_doccategory_union(COMPS_DocCategory *c1,
     it = c1->group_ids?c1->group_ids->first:NULL;
     for (; it != NULL; it = it->next) {
         obj = comps_object_copy(it->comps_obj);
-        comps_set_add(set, (void*)comps_object_incref(obj));
+        if (!comps_set_add(set, (void*)comps_object_incref(obj)))
+            COMPS_OBJECT_DESTROY(obj);
         comps_doccategory_add_groupid(res, (COMPS_DocGroupId*)obj);
     }
     it = c2->group_ids ? c2->group_ids->first : NULL;
     for (; it != NULL; it = it->next) {
         if ((data = comps_set_data_at(set, (void*)it->comps_obj)) != NULL) {
             index = comps_objlist_index(res->group_ids, (COMPS_Object*)data);
+            /* replaced already by previous duplicate */
+            if (index == -1)
+                continue;
             comps_objlist_remove_at(res->group_ids, index);
             comps_objlist_insert_at_x(res->group_ids, index,
                                       comps_object_copy(it->comps_obj));
@@ -163,6 +178,16 @@ COMPS_DocCategory* comps_doccategory_union(COMPS_DocCategory *c1,
     return res;
 }
 
+void comps_doccategory_unite(COMPS_DocCategory *c1, COMPS_DocCategory *c2) {
+    comps_objdict_unite(c1->properties, c2->properties);
+    if (c1->group_ids == NULL)
+        c1->group_ids = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+    __comps_objlist_unite_by(c1->group_ids, c2->group_ids,
+                             &__comps_docgroupid_name_x);
+    comps_objdict_unite(c1->name_by_lang, c2->name_by_lang);
+    comps_objdict_unite(c1->desc_by_lang, c2->desc_by_lang);
+}
+
 COMPS_DocCategory* comps_doccategory_intersect(COMPS_DocCategory *c1,
                                          COMPS_DocCategory *c2) {
     COMPS_DocCategory *res;
@@ -257,14 +282,14 @@ signed char comps_doccategory_xml(COMPS_DocCategory *category,
                     comps_hslist_destroy(&pairlist);
                     return -1;
                 }
-                ret = xmlTextWriterWriteAttribute(writer, (xmlChar*) "xml:lang",
-                        (xmlChar*) ((COMPS_ObjRTreePair*)hsit->data)->key);
+                ret = __comps_xml_attr(writer, "xml:lang",
+                        ((COMPS_ObjRTreePair*)hsit->data)->key);
                 if (__comps_check_xml_get(ret, (COMPS_Object*)log) < 0) {
                     comps_hslist_destroy(&pairlist);
                     return -1;
                 }
                 str = comps_object_tostr(((COMPS_ObjRTreePair*)hsit->data)->data);
-                ret = xmlTextWriterWriteString(writer, (xmlChar*)str);
+                ret = __comps_xml_text(writer, str);
                 free(str);
                 if (__comps_check_xml_get(ret, (COMPS_Object*)log) < 0) {
                     comps_hslist_destroy(&pairlist);
@@ -344,9 +369,8 @@ char* comps_doccategory_tostr_u(COMPS_Object* cat) {
     #undef _cat_
 }
 
-COMPS_DocCategory* comps_doccategory_arch_filter(COMPS_DocCategory *source,
-                                                 COMPS_ObjList *arches) {
-    COMPS_ObjList *arches2;
+static COMPS_DocCategory*
+__comps_doccategory_filter_base(COMPS_DocCategory *source) {
     COMPS_DocCategory *ret = COMPS_OBJECT_CREATE(COMPS_DocCategory, NULL);
     COMPS_OBJECT_DESTROY(ret->properties);
     ret->properties = (COMPS_ObjDict*)COMPS_OBJECT_COPY(source->properties);
@@ -354,25 +378,68 @@ COMPS_DocCategory* comps_doccategory_arch_filter(COMPS_DocCategory *source,
     ret->name_by_lang = (COMPS_ObjDict*)COMPS_OBJECT_COPY(source->name_by_lang);
     COMPS_OBJECT_DESTROY(ret->desc_by_lang);
     ret->desc_by_lang = (COMPS_ObjDict*)COMPS_OBJECT_COPY(source->desc_by_lang);
-    for (COMPS_ObjListIt *it = source->group_ids->first;
-         it != NULL; it = it->next) {
-        arches2 = comps_docgroupid_arches((COMPS_DocGroupId*)it->comps_obj);
-        if ((!arches2) || (__comps_objlist_intersected(arches, arches2))) {
-            comps_doccategory_add_groupid(ret, (COMPS_DocGroupId*)
-                                          comps_object_copy(it->comps_obj));
+    return ret;
+}
+
+void __comps_doccategory_arch_filter_multi(COMPS_DocCategory *source,
+                                           const COMPS_ArchFilter *filter,
+                                           const char *keep,
+                                           COMPS_DocCategory **ret) {
+    COMPS_ObjListIt *it;
+    char matched[filter->count];
+    unsigned int i;
+
+    for (i = 0; i < filter->count; i++)
+        ret[i] = keep[i] ? __comps_doccategory_filter_base(source) : NULL;
+    for (it = source->group_ids->first; it != NULL; it = it->next) {
+        comps_archfilter_match(filter,
+                               ((COMPS_DocGroupId*)it->comps_obj)->arches,
+                               matched);
+        for (i = 0; i < filter->count; i++) {
+            if (ret[i] && matched[i])
+                comps_doccategory_add_groupid(ret[i], (COMPS_DocGroupId*)
+                                              comps_object_copy(it->comps_obj));
         }
-        COMPS_OBJECT_DESTROY(arches2);
     }
+}
+
+COMPS_DocCategory* comps_doccategory_arch_filter(COMPS_DocCategory *source,
+                                                 COMPS_ObjList *arches) {
+    COMPS_ArchFilter *filter;
+    COMPS_DocCategory *ret;
+    const char keep = 1;
+
+    if ((filter = comps_archfilter_create(&arches, 1)) == NULL)
+        return NULL;
+    __comps_doccategory_arch_filter_multi(source, filter, &keep, &ret);
+    comps_archfilter_destroy(filter);
     return ret;
 }
 
+static COMPS_Digest comps_doccategory_digest_u(COMPS_Object *obj) {
+    COMPS_DocCategory *cat = (COMPS_DocCategory*)obj;
+    COMPS_Digest ret;
+
+    ret = comps_digest_str(COMPS_DIGEST_INIT, "category");
+    ret = comps_digest_u64(ret, comps_object_digest(
+                                          (COMPS_Object*)cat->properties));
+    ret = comps_digest_u64(ret, comps_object_digest(
+                                          (COMPS_Object*)cat->name_by_lang));
+    ret = comps_digest_u64(ret, comps_object_digest(
+                                          (COMPS_Object*)cat->desc_by_lang));
+    ret = comps_digest_u64(ret, comps_object_digest(
+                                          (COMPS_Object*)cat->group_ids));
+    return comps_digest_finish(ret);
+}
+
 COMPS_ObjectInfo COMPS_DocCategory_ObjInfo = {
     .obj_size = sizeof(COMPS_DocCategory),
     .constructor = &comps_doccategory_create_u,
     .destructor = &comps_doccategory_destroy_u,
     .copy = &comps_doccategory_copy_u,
     .obj_cmp = &comps_doccategory_cmp_u,
-    .to_str = &comps_doccategory_tostr_u
+    .to_str = &comps_doccategory_tostr_u,
+    .digest = &comps_doccategory_digest_u
 };
 
 COMPS_ValRuleGeneric* COMPS_DocCategory_ValidateRules[] = {
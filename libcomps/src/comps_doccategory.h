@@ -54,6 +54,8 @@ typedef struct {
     /**<language localization of description attribute */
     COMPS_ObjList *group_ids;
     /**< list of group_ids */
+    COMPS_XMLFragment *xml_cache;
+    /**< xml from last output, see COMPS_XMLOptions.fragment_cache */
 } COMPS_DocCategory;
 COMPS_Object_TAIL(COMPS_DocCategory);
 
@@ -163,6 +165,11 @@ HEAD_COMPS_DOCOBJ_GETARCHES(doccategory, COMPS_DocCategory)
 HEAD_COMPS_DOCOBJ_SETARCHES(doccategory, COMPS_DocCategory)
 
 char __comps_doccategory_idcmp(void *c1, void *c2);
+/* id of COMPS_DocCategory without incrementing reference counter */
+COMPS_Object* __comps_doccategory_id_x(COMPS_Object *cat);
+/* properties dict of COMPS_DocCategory, holding its id, without incrementing
+ * reference counter */
+COMPS_Object* __comps_doccategory_props_x(COMPS_Object *cat);
 
 /** COMPS_DocCategory compare callback
  * @param cat1 COMPS_DocCategory object
@@ -187,6 +194,15 @@ void comps_doccategory_add_groupid(COMPS_DocCategory *cat,
 COMPS_DocCategory* comps_doccategory_union(COMPS_DocCategory *c1,
                                            COMPS_DocCategory *c2);
 
+/** union second category into first one in place
+ *
+ * c1 ends up equal to what comps_doccategory_union(c1, c2) returns. Nothing
+ * is copied, c1 takes references to group ids and strings of c2
+ * @param c1 COMPS_DocCategory object which is modified
+ * @param c2 COMPS_DocCategory object
+ */
+void comps_doccategory_unite(COMPS_DocCategory *c1, COMPS_DocCategory *c2);
+
 /** intersect two categories into one and return new COMPS_DocCategory object
  * @param c1 COMPS_DocCategory object
  * @param c2 COMPS_DocCategory object
@@ -202,5 +218,12 @@ signed char comps_doccategory_xml(COMPS_DocCategory *category,
 COMPS_DocCategory* comps_doccategory_arch_filter(COMPS_DocCategory *source,
                                                  COMPS_ObjList *arches);
 
+/* Filter source by every arch list of filter at once. ret[i] is set to
+ * new filtered copy for every i with keep[i] set, NULL otherwise */
+void __comps_doccategory_arch_filter_multi(COMPS_DocCategory *source,
+                                           const COMPS_ArchFilter *filter,
+                                           const char *keep,
+                                           COMPS_DocCategory **ret);
+
 extern COMPS_ValRuleGeneric* COMPS_DocCategory_ValidateRules[];
 #endif
@@ -0,0 +1,1123 @@
+/* libcomps - C alternative to yum.comps library
+ * Copyright (C) 2013 Jindrich Luza
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to  Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA
+ */
+
+#include "comps_docdiff.h"
+#include "comps_radix.h"
+#include <expat.h>
+#include <libxml/xmlwriter.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* section of document, lists of its objects and their items */
+typedef struct {
+    const char *key; /* key of section in doc->objects */
+    size_t dicts[3]; /* offsets of properties, name_by_lang and
+                        desc_by_lang dicts in section object */
+    size_t lists[2]; /* offsets of item lists in section object */
+    unsigned int nlists;
+    COMPS_ObjectInfo *obj_info; /* type of section objects */
+    COMPS_ObjectInfo *item_info; /* type of list items */
+    COMPS_Object* (*key_f)(COMPS_Object*); /* name of list items */
+} COMPS_DocDiffSection;
+
+static const COMPS_DocDiffSection __comps_docdiff_sections[] = {
+    {"groups",
+     {offsetof(COMPS_DocGroup, properties),
+      offsetof(COMPS_DocGroup, name_by_lang),
+      offsetof(COMPS_DocGroup, desc_by_lang)},
+     {offsetof(COMPS_DocGroup, packages)}, 1,
+     &COMPS_DocGroup_ObjInfo, &COMPS_DocGroupPackage_ObjInfo,
+     &__comps_docpackage_name_x},
+    {"categories",
+     {offsetof(COMPS_DocCategory, properties),
+      offsetof(COMPS_DocCategory, name_by_lang),
+      offsetof(COMPS_DocCategory, desc_by_lang)},
+     {offsetof(COMPS_DocCategory, group_ids)}, 1,
+     &COMPS_DocCategory_ObjInfo, &COMPS_DocGroupId_ObjInfo,
+     &__comps_docgroupid_name_x},
+    {"environments",
+     {offsetof(COMPS_DocEnv, properties),
+      offsetof(COMPS_DocEnv, name_by_lang),
+      offsetof(COMPS_DocEnv, desc_by_lang)},
+     {offsetof(COMPS_DocEnv, group_list), offsetof(COMPS_DocEnv, option_list)},
+     2, &COMPS_DocEnv_ObjInfo, &COMPS_DocGroupId_ObjInfo,
+     &__comps_docgroupid_name_x}
+};
+
+/* element names of operations and section attribute values in XML, in
+ * order of COMPS_DocDeltaOpType and COMPS_DocDeltaSection */
+static const char *__comps_docdelta_ops[] = {"add", "remove", "order", "prop",
+                                             "name", "desc", "itemadd",
+                                             "itemremove", "itemset"};
+static const char *__comps_docdelta_sections[] = {"group", "category",
+                                                  "environment", "langpack"};
+/* package types in order of COMPS_PackageType */
+static const char *__comps_docdelta_types[] = {"default", "optional",
+                                               "conditional", "mandatory",
+                                               "unknown"};
+
+#define COMPS_DOCDIFF_NSECTIONS 3
+#define COMPS_DOCDIFF_PROPS 0
+
+/* dictionary of object of section, dict is index in
+ * COMPS_DocDiffSection.dicts */
+static COMPS_ObjDict* __comps_docdiff_dict(const COMPS_DocDiffSection *sect,
+                                           COMPS_Object *obj, int dict) {
+    return *(COMPS_ObjDict**)((char*)obj + sect->dicts[dict]);
+}
+
+static COMPS_ObjList* __comps_docdiff_list(const COMPS_DocDiffSection *sect,
+                                           COMPS_Object *obj,
+                                           unsigned int list) {
+    return *(COMPS_ObjList**)((char*)obj + sect->lists[list]);
+}
+
+/* string of COMPS_Str object, NULL for other objects and empty strings,
+ * which can't be key of radix tree */
+static const char* __comps_docdiff_str(COMPS_Object *obj) {
+    if (obj == NULL || obj->obj_info != &COMPS_Str_ObjInfo
+        || ((COMPS_Str*)obj)->val == NULL || !((COMPS_Str*)obj)->val[0])
+        return NULL;
+    return ((COMPS_Str*)obj)->val;
+}
+
+static const char* __comps_docdiff_id(const COMPS_DocDiffSection *sect,
+                                      COMPS_Object *obj) {
+    return __comps_docdiff_str(comps_objdict_get_x(
+                 __comps_docdiff_dict(sect, obj, COMPS_DOCDIFF_PROPS), "id"));
+}
+
+static const char* __comps_docdiff_name(const COMPS_DocDiffSection *sect,
+                                        COMPS_Object *item) {
+    return __comps_docdiff_str(sect->key_f(item));
+}
+
+static char* __comps_docdiff_strndup(const char *str, size_t len) {
+    char *ret;
+
+    if (str == NULL || (ret = malloc(len + 1)) == NULL)
+        return NULL;
+    memcpy(ret, str, len);
+    ret[len] = 0;
+    return ret;
+}
+
+static char* __comps_docdiff_strdup(const char *str) {
+    return str ? __comps_docdiff_strndup(str, strlen(str)) : NULL;
+}
+
+static void __comps_docdelta_op_clear(COMPS_DocDeltaOp *op) {
+    free(op->id);
+    free(op->key);
+    COMPS_OBJECT_DESTROY(op->value);
+}
+
+/* Move operation to the end of delta. Operation is cleared on failure */
+static int __comps_docdelta_append(COMPS_DocDelta *delta,
+                                   COMPS_DocDeltaOp *op) {
+    COMPS_DocDeltaOp *ops;
+    size_t size;
+
+    if (delta->len == delta->size) {
+        size = delta->size ? delta->size * 2 : 16;
+        if ((ops = realloc(delta->ops, sizeof(*ops) * size)) == NULL) {
+            __comps_docdelta_op_clear(op);
+            return 0;
+        }
+        delta->ops = ops;
+        delta->size = size;
+    }
+    delta->ops[delta->len++] = *op;
+    return 1;
+}
+
+/* Append operation with copies of id and key, value is stolen */
+static int __comps_docdelta_push(COMPS_DocDelta *delta,
+                                 COMPS_DocDeltaOpType type, int section,
+                                 unsigned int list, const char *id,
+                                 const char *key, size_t pos,
+                                 COMPS_Object *value) {
+    COMPS_DocDeltaOp op;
+
+    op.type = type;
+    op.section = section;
+    op.list = list;
+    op.id = __comps_docdiff_strdup(id);
+    op.key = __comps_docdiff_strdup(key);
+    op.pos = pos;
+    op.value = value;
+    if ((id && op.id == NULL) || (key && op.key == NULL)) {
+        __comps_docdelta_op_clear(&op);
+        return 0;
+    }
+    return __comps_docdelta_append(delta, &op);
+}
+
+void comps_docdelta_destroy(COMPS_DocDelta *delta) {
+    size_t i;
+
+    if (delta == NULL)
+        return;
+    for (i = 0; i < delta->len; i++)
+        __comps_docdelta_op_clear(&delta->ops[i]);
+    free(delta->ops);
+    free(delta);
+}
+
+/* Map keys of list items (ids of objects or names of items) to their
+ * position + 1. *unique is cleared when some item has no key or key is
+ * already taken, later items with such key aren't mapped */
+static COMPS_RTree* __comps_docdiff_positions(const COMPS_DocDiffSection *sect,
+                          COMPS_ObjList *list,
+                          const char* (*key_f)(const COMPS_DocDiffSection*,
+                                               COMPS_Object*),
+                          int *unique) {
+    COMPS_RTree *ret;
+    COMPS_ObjListIt *it;
+    const char *key;
+    size_t i;
+
+    *unique = 1;
+    if ((ret = comps_rtree_create(NULL, NULL, NULL)) == NULL)
+        return NULL;
+    for (it = list ? list->first : NULL, i = 0; it; it = it->next, i++) {
+        key = key_f(sect, it->comps_obj);
+        if (key == NULL || comps_rtree_get(ret, key) != NULL)
+            *unique = 0;
+        else
+            comps_rtree_set(ret, (char*)key, (void*)(uintptr_t)(i + 1));
+    }
+    return ret;
+}
+
+static size_t __comps_docdiff_position(COMPS_RTree *positions,
+                                       const char *key) {
+    return (size_t)(uintptr_t)comps_rtree_get(positions, key);
+}
+
+/* Check that keys present in both lists follow in the same order */
+static int __comps_docdiff_ordered(const COMPS_DocDiffSection *sect,
+                          COMPS_RTree *positions1, COMPS_ObjList *list2,
+                          const char* (*key_f)(const COMPS_DocDiffSection*,
+                                               COMPS_Object*)) {
+    COMPS_ObjListIt *it;
+    size_t pos, last;
+
+    last = 0;
+    for (it = list2 ? list2->first : NULL; it; it = it->next) {
+        pos = __comps_docdiff_position(positions1,
+                                       key_f(sect, it->comps_obj));
+        if (pos && pos < last)
+            return 0;
+        if (pos)
+            last = pos;
+    }
+    return 1;
+}
+
+/* Merge two dictionaries in key order into PROP, NAME or DESC operations.
+ * Either dictionary can be NULL */
+static int __comps_docdiff_dicts(COMPS_DocDelta *delta,
+                                 COMPS_DocDeltaOpType type, int section,
+                                 const char *id, COMPS_ObjDict *dict1,
+                                 COMPS_ObjDict *dict2) {
+    COMPS_ObjDictIt it1, it2;
+    COMPS_Object *val1, *val2;
+    const char *key1, *key2;
+    int has1, has2, cmp, skip, ret;
+
+    if (comps_object_digest((COMPS_Object*)dict1)
+        == comps_object_digest((COMPS_Object*)dict2))
+        return 1;
+    has1 = has2 = 0;
+    if (dict1) {
+        comps_objdict_it_init(&it1, dict1);
+        has1 = comps_objdict_it_next(&it1, &key1, &val1);
+    }
+    if (dict2) {
+        comps_objdict_it_init(&it2, dict2);
+        has2 = comps_objdict_it_next(&it2, &key2, &val2);
+    }
+    ret = 1;
+    while (ret && (has1 || has2)) {
+        if (!has1)
+            cmp = 1;
+        else if (!has2)
+            cmp = -1;
+        else
+            cmp = strcmp(key1, key2);
+        /* objects are paired by id, so it never changes */
+        skip = type == COMPS_DELTA_PROP && id
+               && strcmp(cmp <= 0 ? key1 : key2, "id") == 0;
+        if (!skip && cmp < 0)
+            ret = __comps_docdelta_push(delta, type, section, 0, id, key1, 0,
+                                        NULL);
+        else if (!skip && (cmp > 0 || comps_object_digest(val1)
+                                      != comps_object_digest(val2)))
+            ret = __comps_docdelta_push(delta, type, section, 0, id, key2, 0,
+                                        comps_object_copy(val2));
+        if (cmp <= 0)
+            has1 = comps_objdict_it_next(&it1, &key1, &val1);
+        if (cmp >= 0)
+            has2 = comps_objdict_it_next(&it2, &key2, &val2);
+    }
+    if (dict1)
+        comps_objdict_it_destroy(&it1);
+    if (dict2)
+        comps_objdict_it_destroy(&it2);
+    return ret;
+}
+
+/* Diff item lists of object. Lists with duplicate or missing names and
+ * lists with kept items reordered are cleared and filled again */
+static int __comps_docdiff_items(COMPS_DocDelta *delta, int section,
+                                 unsigned int list, const char *id,
+                                 COMPS_ObjList *list1, COMPS_ObjList *list2) {
+    const COMPS_DocDiffSection *sect = &__comps_docdiff_sections[section];
+    COMPS_RTree *pos1, *pos2;
+    COMPS_ObjListIt *it;
+    const char *name;
+    size_t i, pos;
+    int ret, unique1, unique2;
+
+    if (comps_object_digest((COMPS_Object*)list1)
+        == comps_object_digest((COMPS_Object*)list2))
+        return 1;
+    pos1 = __comps_docdiff_positions(sect, list1, &__comps_docdiff_name,
+                                     &unique1);
+    pos2 = __comps_docdiff_positions(sect, list2, &__comps_docdiff_name,
+                                     &unique2);
+    ret = pos1 != NULL && pos2 != NULL;
+    if (ret && (!unique1 || !unique2
+                || !__comps_docdiff_ordered(sect, pos1, list2,
+                                            &__comps_docdiff_name))) {
+        if (list1 && list1->len)
+            ret = __comps_docdelta_push(delta, COMPS_DELTA_ITEM_REMOVE,
+                                        section, list, id, NULL, 0, NULL);
+        for (it = list2 ? list2->first : NULL, i = 0; ret && it;
+             it = it->next, i++) {
+            ret = __comps_docdelta_push(delta, COMPS_DELTA_ITEM_ADD, section,
+                                        list, id, NULL, i,
+                                        comps_object_copy(it->comps_obj));
+        }
+    } else if (ret) {
+        for (it = list1 ? list1->first : NULL; ret && it; it = it->next) {
+            name = __comps_docdiff_name(sect, it->comps_obj);
+            if (!__comps_docdiff_position(pos2, name))
+                ret = __comps_docdelta_push(delta, COMPS_DELTA_ITEM_REMOVE,
+                                            section, list, id, name, 0, NULL);
+        }
+        for (it = list2 ? list2->first : NULL, i = 0; ret && it;
+             it = it->next, i++) {
+            pos = __comps_docdiff_position(pos1,
+                                    __comps_docdiff_name(sect, it->comps_obj));
+            if (!pos)
+                ret = __comps_docdelta_push(delta, COMPS_DELTA_ITEM_ADD,
+                                            section, list, id, NULL, i,
+                                            comps_object_copy(it->comps_obj));
+            else if (comps_object_digest(comps_objlist_get_x(list1, pos - 1))
+                     != comps_object_digest(it->comps_obj))
+                ret = __comps_docdelta_push(delta, COMPS_DELTA_ITEM_SET,
+                                            section, list, id, NULL, 0,
+                                            comps_object_copy(it->comps_obj));
+        }
+    }
+    comps_rtree_destroy(pos1);
+    comps_rtree_destroy(pos2);
+    return ret;
+}
+
+/* Diff content of object, obj1 is NULL for added object. Objects with
+ * equal digest are skipped as whole */
+static int __comps_docdiff_object(COMPS_DocDelta *delta, int section,
+                                  const char *id, COMPS_Object *obj1,
+                                  COMPS_Object *obj2) {
+    static const COMPS_DocDeltaOpType types[] = {COMPS_DELTA_PROP,
+                                                 COMPS_DELTA_NAME,
+                                                 COMPS_DELTA_DESC};
+    const COMPS_DocDiffSection *sect = &__comps_docdiff_sections[section];
+    unsigned int i;
+    int ret;
+
+    if (obj1 && comps_object_digest(obj1) == comps_object_digest(obj2))
+        return 1;
+    ret = 1;
+    for (i = 0; ret && i < 3; i++) {
+        ret = __comps_docdiff_dicts(delta, types[i], section, id,
+                           obj1 ? __comps_docdiff_dict(sect, obj1, i) : NULL,
+                           __comps_docdiff_dict(sect, obj2, i));
+    }
+    for (i = 0; ret && i < sect->nlists; i++) {
+        ret = __comps_docdiff_items(delta, section, i, id,
+                           obj1 ? __comps_docdiff_list(sect, obj1, i) : NULL,
+                           __comps_docdiff_list(sect, obj2, i));
+    }
+    return ret;
+}
+
+static int __comps_docdiff_section(COMPS_DocDelta *delta, int section,
+                                   COMPS_ObjList *list1,
+                                   COMPS_ObjList *list2) {
+    const COMPS_DocDiffSection *sect = &__comps_docdiff_sections[section];
+    COMPS_RTree *pos1, *pos2;
+    COMPS_ObjList *order;
+    COMPS_ObjListIt *it;
+    const char *id;
+    size_t i, pos;
+    int ret, unique1, unique2;
+
+    pos1 = __comps_docdiff_positions(sect, list1, &__comps_docdiff_id,
+                                     &unique1);
+    pos2 = __comps_docdiff_positions(sect, list2, &__comps_docdiff_id,
+                                     &unique2);
+    ret = pos1 != NULL && pos2 != NULL && unique1 && unique2;
+    for (it = list1 ? list1->first : NULL; ret && it; it = it->next) {
+        id = __comps_docdiff_id(sect, it->comps_obj);
+        if (!__comps_docdiff_position(pos2, id))
+            ret = __comps_docdelta_push(delta, COMPS_DELTA_REMOVE, section, 0,
+                                        id, NULL, 0, NULL);
+    }
+    if (ret && !__comps_docdiff_ordered(sect, pos1, list2,
+                                        &__comps_docdiff_id)) {
+        order = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+        for (it = list2->first; it; it = it->next) {
+            id = __comps_docdiff_id(sect, it->comps_obj);
+            if (__comps_docdiff_position(pos1, id))
+                comps_objlist_append_x(order, (COMPS_Object*)comps_str(id));
+        }
+        ret = __comps_docdelta_push(delta, COMPS_DELTA_ORDER, section, 0,
+                                    NULL, NULL, 0, (COMPS_Object*)order);
+    }
+    for (it = list2 ? list2->first : NULL, i = 0; ret && it;
+         it = it->next, i++) {
+        id = __comps_docdiff_id(sect, it->comps_obj);
+        pos = __comps_docdiff_position(pos1, id);
+        if (!pos)
+            ret = __comps_docdelta_push(delta, COMPS_DELTA_ADD, section, 0,
+                                        id, NULL, i, NULL);
+        if (ret)
+            ret = __comps_docdiff_object(delta, section, id,
+                              pos ? comps_objlist_get_x(list1, pos - 1) : NULL,
+                              it->comps_obj);
+    }
+    comps_rtree_destroy(pos1);
+    comps_rtree_destroy(pos2);
+    return ret;
+}
+
+COMPS_DocDelta* comps_doc_diff(COMPS_Doc *old_doc, COMPS_Doc *new_doc) {
+    COMPS_DocDelta *delta;
+    int i, ret;
+
+    if ((delta = malloc(sizeof(*delta))) == NULL)
+        return NULL;
+    delta->ops = NULL;
+    delta->len = delta->size = 0;
+    ret = 1;
+    for (i = 0; ret && i < COMPS_DOCDIFF_NSECTIONS; i++) {
+        ret = __comps_docdiff_section(delta, i,
+                (COMPS_ObjList*)comps_objdict_get_x(old_doc->objects,
+                                            __comps_docdiff_sections[i].key),
+                (COMPS_ObjList*)comps_objdict_get_x(new_doc->objects,
+                                            __comps_docdiff_sections[i].key));
+    }
+    if (ret)
+        ret = __comps_docdiff_dicts(delta, COMPS_DELTA_PROP,
+                COMPS_DELTA_LANGPACKS, NULL,
+                (COMPS_ObjDict*)comps_objdict_get_x(old_doc->objects,
+                                                    "langpacks"),
+                (COMPS_ObjDict*)comps_objdict_get_x(new_doc->objects,
+                                                    "langpacks"));
+    if (!ret) {
+        comps_docdelta_destroy(delta);
+        return NULL;
+    }
+    return delta;
+}
+
+/* List of section in document, created when missing */
+static COMPS_ObjList* __comps_docpatch_list(COMPS_Doc *doc,
+                                            const COMPS_DocDiffSection *sect) {
+    COMPS_ObjList *list;
+
+    list = (COMPS_ObjList*)comps_objdict_get_x(doc->objects, sect->key);
+    if (list == NULL) {
+        list = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+        comps_objdict_set_x(doc->objects, (char*)sect->key,
+                            (COMPS_Object*)list);
+    }
+    return list;
+}
+
+/* Map ids of section objects to objects, first of duplicates wins */
+static COMPS_RTree* __comps_docpatch_ids(const COMPS_DocDiffSection *sect,
+                                         COMPS_ObjList *list) {
+    COMPS_RTree *ret;
+    COMPS_ObjListIt *it;
+    const char *id;
+
+    if ((ret = comps_rtree_create(NULL, NULL, NULL)) == NULL)
+        return NULL;
+    for (it = list->first; it; it = it->next) {
+        id = __comps_docdiff_id(sect, it->comps_obj);
+        if (id && comps_rtree_get(ret, id) == NULL)
+            comps_rtree_set(ret, (char*)id, it->comps_obj);
+    }
+    return ret;
+}
+
+/* Position of first item of list with specified name or -1 */
+static long __comps_docpatch_find(const COMPS_DocDiffSection *sect,
+                                  COMPS_ObjList *list, const char *name) {
+    COMPS_ObjListIt *it;
+    const char *item_name;
+    long i;
+
+    for (it = list->first, i = 0; it; it = it->next, i++) {
+        item_name = __comps_docdiff_name(sect, it->comps_obj);
+        if (item_name && strcmp(item_name, name) == 0)
+            return i;
+    }
+    return -1;
+}
+
+static int __comps_docpatch_dict(COMPS_ObjDict *dict, const char *key,
+                                 COMPS_Object *value) {
+    if (dict == NULL || key == NULL)
+        return 0;
+    if (value) {
+        comps_objdict_set_x(dict, (char*)key, comps_object_copy(value));
+    } else {
+        if (comps_objdict_get_x(dict, key) == NULL)
+            return 0;
+        comps_objdict_unset(dict, key);
+    }
+    return 1;
+}
+
+/* Reorder objects by list of ids, objects not listed keep their order at
+ * the end */
+static int __comps_docpatch_order(const COMPS_DocDiffSection *sect,
+                                  COMPS_ObjList *list, COMPS_RTree *ids,
+                                  COMPS_Object *order) {
+    COMPS_Object **objs, *obj;
+    COMPS_RTree *placed;
+    COMPS_ObjListIt *it;
+    const char *id;
+    size_t i, len;
+
+    if (order == NULL || order->obj_info != &COMPS_ObjList_ObjInfo)
+        return 0;
+    len = list->len;
+    objs = malloc(sizeof(*objs) * (len ? len : 1));
+    if (objs == NULL || (placed = comps_rtree_create(NULL, NULL, NULL))
+                        == NULL) {
+        free(objs);
+        return 0;
+    }
+    for (i = 0; i < len; i++)
+        objs[i] = comps_object_incref(comps_objlist_get_x(list, i));
+    while (list->len)
+        comps_objlist_remove_at(list, list->len - 1);
+    for (it = ((COMPS_ObjList*)order)->first; it; it = it->next) {
+        id = __comps_docdiff_str(it->comps_obj);
+        obj = id ? comps_rtree_get(ids, id) : NULL;
+        if (obj && comps_rtree_get(placed, id) == NULL) {
+            comps_rtree_set(placed, (char*)id, obj);
+            comps_objlist_append(list, obj);
+        }
+    }
+    for (i = 0; i < len; i++) {
+        id = __comps_docdiff_id(sect, objs[i]);
+        if (id == NULL || comps_rtree_get(placed, id) != objs[i])
+            comps_objlist_append(list, objs[i]);
+        COMPS_OBJECT_DESTROY(objs[i]);
+    }
+    comps_rtree_destroy(placed);
+    free(objs);
+    return 1;
+}
+
+static int __comps_docpatch_items(const COMPS_DocDiffSection *sect,
+                                  COMPS_ObjList *items,
+                                  const COMPS_DocDeltaOp *op) {
+    COMPS_Object *item;
+    const char *name;
+    long pos;
+
+    if (items == NULL)
+        return 0;
+    if (op->type == COMPS_DELTA_ITEM_REMOVE) {
+        if (op->key == NULL) {
+            while (items->len)
+                comps_objlist_remove_at(items, items->len - 1);
+            return 1;
+        }
+        pos = __comps_docpatch_find(sect, items, op->key);
+        return pos >= 0 && comps_objlist_remove_at(items, pos);
+    }
+    if (op->value == NULL || op->value->obj_info != sect->item_info)
+        return 0;
+    if (op->type == COMPS_DELTA_ITEM_ADD) {
+        if (op->pos > items->len)
+            return 0;
+        pos = op->pos;
+    } else {
+        name = __comps_docdiff_name(sect, op->value);
+        if (name == NULL
+            || (pos = __comps_docpatch_find(sect, items, name)) < 0)
+            return 0;
+        comps_objlist_remove_at(items, pos);
+    }
+    item = comps_object_copy(op->value);
+    if (comps_objlist_insert_at_x(items, pos, item) <= 0) {
+        COMPS_OBJECT_DESTROY(item);
+        return 0;
+    }
+    return 1;
+}
+
+static int __comps_docpatch_op(COMPS_Doc *doc, COMPS_RTree **ids,
+                               const COMPS_DocDeltaOp *op) {
+    const COMPS_DocDiffSection *sect;
+    COMPS_ObjDict *langpacks;
+    COMPS_ObjList *list;
+    COMPS_Object *obj;
+    long pos;
+    int ret;
+
+    if (op->section == COMPS_DELTA_LANGPACKS) {
+        if (op->type != COMPS_DELTA_PROP)
+            return 0;
+        langpacks = comps_doc_langpacks(doc);
+        ret = __comps_docpatch_dict(langpacks, op->key, op->value);
+        COMPS_OBJECT_DESTROY(langpacks);
+        return ret;
+    }
+    if ((unsigned)op->section >= COMPS_DOCDIFF_NSECTIONS)
+        return 0;
+    sect = &__comps_docdiff_sections[op->section];
+    list = __comps_docpatch_list(doc, sect);
+    if (ids[op->section] == NULL
+        && (ids[op->section] = __comps_docpatch_ids(sect, list)) == NULL)
+        return 0;
+    if (op->type == COMPS_DELTA_ORDER)
+        return __comps_docpatch_order(sect, list, ids[op->section],
+                                      op->value);
+    if (op->id == NULL || !op->id[0])
+        return 0;
+    obj = comps_rtree_get(ids[op->section], op->id);
+    switch (op->type) {
+        case COMPS_DELTA_ADD:
+            if (obj || op->pos > list->len)
+                return 0;
+            obj = comps_object_create(sect->obj_info, NULL);
+            comps_objdict_set_x(__comps_docdiff_dict(sect, obj,
+                                                     COMPS_DOCDIFF_PROPS),
+                                "id", (COMPS_Object*)comps_str(op->id));
+            if (comps_objlist_insert_at_x(list, op->pos, obj) <= 0) {
+                COMPS_OBJECT_DESTROY(obj);
+                return 0;
+            }
+            comps_rtree_set(ids[op->section], op->id, obj);
+            return 1;
+        case COMPS_DELTA_REMOVE:
+            if (obj == NULL || (pos = comps_objlist_index(list, obj)) < 0)
+                return 0;
+            comps_rtree_unset(ids[op->section], op->id);
+            return comps_objlist_remove_at(list, pos);
+        case COMPS_DELTA_PROP:
+        case COMPS_DELTA_NAME:
+        case COMPS_DELTA_DESC:
+            /* changed id would leave object unreachable by its new id */
+            if (obj == NULL || (op->type == COMPS_DELTA_PROP && op->key
+                                && strcmp(op->key, "id") == 0))
+                return 0;
+            return __comps_docpatch_dict(__comps_docdiff_dict(sect, obj,
+                                             op->type - COMPS_DELTA_PROP),
+                                         op->key, op->value);
+        case COMPS_DELTA_ITEM_ADD:
+        case COMPS_DELTA_ITEM_REMOVE:
+        case COMPS_DELTA_ITEM_SET:
+            if (obj == NULL || op->list >= sect->nlists)
+                return 0;
+            return __comps_docpatch_items(sect,
+                                 __comps_docdiff_list(sect, obj, op->list), op);
+        default:
+            return 0;
+    }
+}
+
+int comps_doc_patch(COMPS_Doc *doc, const COMPS_DocDelta *delta) {
+    COMPS_RTree *ids[COMPS_DOCDIFF_NSECTIONS] = {NULL, NULL, NULL};
+    size_t i;
+    int skipped;
+
+    skipped = 0;
+    for (i = 0; i < delta->len; i++) {
+        if (!__comps_docpatch_op(doc, ids, &delta->ops[i]))
+            skipped++;
+    }
+    for (i = 0; i < COMPS_DOCDIFF_NSECTIONS; i++)
+        comps_rtree_destroy(ids[i]);
+    return skipped;
+}
+
+/* Space separated arches for arch attribute, NULL for no arches */
+static char* __comps_docdelta_arches(COMPS_ObjList *arches) {
+    COMPS_ObjListIt *it;
+    const char *arch;
+    size_t len;
+    char *ret;
+
+    len = 0;
+    for (it = arches ? arches->first : NULL; it; it = it->next) {
+        if ((arch = __comps_docdiff_str(it->comps_obj)) != NULL)
+            len += strlen(arch) + 1;
+    }
+    if (len == 0 || (ret = malloc(len)) == NULL)
+        return NULL;
+    len = 0;
+    for (it = arches->first; it; it = it->next) {
+        if ((arch = __comps_docdiff_str(it->comps_obj)) == NULL)
+            continue;
+        if (len)
+            ret[len++] = ' ';
+        strcpy(ret + len, arch);
+        len += strlen(arch);
+    }
+    return ret;
+}
+
+static int __comps_docdelta_arch_xml(xmlTextWriterPtr writer,
+                                     COMPS_ObjList *arches) {
+    char *arch;
+    int ret;
+
+    if ((arch = __comps_docdelta_arches(arches)) == NULL)
+        return 1;
+    ret = xmlTextWriterWriteAttribute(writer, BAD_CAST "arch",
+                                      BAD_CAST arch) >= 0;
+    free(arch);
+    return ret;
+}
+
+static int __comps_docdelta_package_xml(xmlTextWriterPtr writer,
+                                        COMPS_DocGroupPackage *pkg) {
+    const char *name;
+
+    name = __comps_docdiff_str((COMPS_Object*)pkg->name);
+    return xmlTextWriterStartElement(writer, BAD_CAST "package") >= 0
+           && (!name || xmlTextWriterWriteAttribute(writer, BAD_CAST "name",
+                                                    BAD_CAST name) >= 0)
+           && ((unsigned)pkg->type > COMPS_PACKAGE_UNKNOWN
+               || xmlTextWriterWriteAttribute(writer, BAD_CAST "type",
+                          BAD_CAST __comps_docdelta_types[pkg->type]) >= 0)
+           && (!pkg->requires || !pkg->requires->val
+               || xmlTextWriterWriteAttribute(writer, BAD_CAST "requires",
+                                    BAD_CAST pkg->requires->val) >= 0)
+           && (!pkg->basearchonly
+               || xmlTextWriterWriteFormatAttribute(writer,
+                                    BAD_CAST "basearchonly", "%d",
+                                    pkg->basearchonly->val) >= 0)
+           && __comps_docdelta_arch_xml(writer, pkg->arches)
+           && xmlTextWriterEndElement(writer) >= 0;
+}
+
+static int __comps_docdelta_groupid_xml(xmlTextWriterPtr writer,
+                                        COMPS_DocGroupId *gid) {
+    const char *name;
+
+    name = __comps_docdiff_str((COMPS_Object*)gid->name);
+    return xmlTextWriterStartElement(writer, BAD_CAST "groupid") >= 0
+           && (!name || xmlTextWriterWriteAttribute(writer, BAD_CAST "name",
+                                                    BAD_CAST name) >= 0)
+           && xmlTextWriterWriteAttribute(writer, BAD_CAST "default",
+                         BAD_CAST (gid->def ? "true" : "false")) >= 0
+           && __comps_docdelta_arch_xml(writer, gid->arches)
+           && xmlTextWriterEndElement(writer) >= 0;
+}
+
+static int __comps_docdelta_op_xml(xmlTextWriterPtr writer,
+                                   const COMPS_DocDeltaOp *op) {
+    COMPS_ObjListIt *it;
+    COMPS_Object *value;
+    const char *str;
+    int ret;
+
+    if ((unsigned)op->type > COMPS_DELTA_ITEM_SET
+        || (unsigned)op->section > COMPS_DELTA_LANGPACKS)
+        return 0;
+    value = op->value;
+    ret = xmlTextWriterStartElement(writer,
+                              BAD_CAST __comps_docdelta_ops[op->type]) >= 0
+          && xmlTextWriterWriteAttribute(writer, BAD_CAST "section",
+                     BAD_CAST __comps_docdelta_sections[op->section]) >= 0
+          && (!op->id || xmlTextWriterWriteAttribute(writer, BAD_CAST "id",
+                                                     BAD_CAST op->id) >= 0)
+          && (!op->key || xmlTextWriterWriteAttribute(writer, BAD_CAST "key",
+                                                      BAD_CAST op->key) >= 0);
+    if (ret && op->type >= COMPS_DELTA_ITEM_ADD)
+        ret = xmlTextWriterWriteFormatAttribute(writer, BAD_CAST "list", "%u",
+                                                op->list) >= 0;
+    if (ret && (op->type == COMPS_DELTA_ADD
+                || op->type == COMPS_DELTA_ITEM_ADD))
+        ret = xmlTextWriterWriteFormatAttribute(writer, BAD_CAST "pos", "%zu",
+                                                op->pos) >= 0;
+    if (!ret)
+        return 0;
+    if (value == NULL) {
+        if (op->type >= COMPS_DELTA_PROP && op->type <= COMPS_DELTA_DESC)
+            ret = xmlTextWriterWriteAttribute(writer, BAD_CAST "unset",
+                                              BAD_CAST "true") >= 0;
+    } else if (value->obj_info == &COMPS_Str_ObjInfo) {
+        str = ((COMPS_Str*)value)->val;
+        ret = xmlTextWriterWriteString(writer, BAD_CAST (str ? str : "")) >= 0;
+    } else if (value->obj_info == &COMPS_Num_ObjInfo) {
+        ret = xmlTextWriterWriteAttribute(writer, BAD_CAST "type",
+                                          BAD_CAST "num") >= 0
+              && xmlTextWriterWriteFormatString(writer, "%d",
+                                           ((COMPS_Num*)value)->val) >= 0;
+    } else if (value->obj_info == &COMPS_ObjList_ObjInfo) {
+        ret = xmlTextWriterWriteAttribute(writer, BAD_CAST "type",
+                                          BAD_CAST "list") >= 0;
+        for (it = ((COMPS_ObjList*)value)->first; ret && it; it = it->next) {
+            if (it->comps_obj->obj_info != &COMPS_Str_ObjInfo)
+                continue;
+            str = ((COMPS_Str*)it->comps_obj)->val;
+            ret = xmlTextWriterWriteElement(writer, BAD_CAST "str",
+                                            BAD_CAST (str ? str : "")) >= 0;
+        }
+    } else if (value->obj_info == &COMPS_DocGroupPackage_ObjInfo) {
+        ret = __comps_docdelta_package_xml(writer,
+                                           (COMPS_DocGroupPackage*)value);
+    } else if (value->obj_info == &COMPS_DocGroupId_ObjInfo) {
+        ret = __comps_docdelta_groupid_xml(writer, (COMPS_DocGroupId*)value);
+    } else {
+        ret = 0;
+    }
+    return ret && xmlTextWriterEndElement(writer) >= 0;
+}
+
+char* comps_docdelta_xml_str(const COMPS_DocDelta *delta) {
+    xmlBufferPtr buff;
+    xmlTextWriterPtr writer;
+    size_t i, len;
+    char *ret;
+    int ok;
+
+    if ((buff = xmlBufferCreate()) == NULL)
+        return NULL;
+    if ((writer = xmlNewTextWriterMemory(buff, 0)) == NULL) {
+        xmlBufferFree(buff);
+        return NULL;
+    }
+    xmlTextWriterSetIndent(writer, 1);
+    ok = xmlTextWriterStartDocument(writer, NULL, "UTF-8", NULL) >= 0
+         && xmlTextWriterStartElement(writer, BAD_CAST "compsdelta") >= 0;
+    for (i = 0; ok && i < delta->len; i++)
+        ok = __comps_docdelta_op_xml(writer, &delta->ops[i]);
+    ok = ok && xmlTextWriterEndDocument(writer) >= 0;
+    xmlFreeTextWriter(writer);
+
+    ret = NULL;
+    if (ok) {
+        len = strlen((const char*)xmlBufferContent(buff));
+        if ((ret = malloc(len + 1)) != NULL)
+            memcpy(ret, xmlBufferContent(buff), len + 1);
+    }
+    xmlBufferFree(buff);
+    return ret;
+}
+
+/* state of comps_docdelta_from_xml_str() */
+typedef struct {
+    COMPS_DocDelta *delta;
+    COMPS_DocDeltaOp op; /* operation being read */
+    int in_op;
+    int unset; /* op has unset attribute */
+    int num; /* text of op is number */
+    char *text; /* text of op or str element */
+    size_t text_len;
+    size_t text_size;
+    unsigned int depth;
+    int error;
+} COMPS_DocDeltaReader;
+
+static const char* __comps_docdelta_attr(const XML_Char **attrs,
+                                         const char *name) {
+    for (; attrs[0]; attrs += 2) {
+        if (strcmp(attrs[0], name) == 0)
+            return attrs[1];
+    }
+    return NULL;
+}
+
+/* index of str in table of n strings or -1 */
+static int __comps_docdelta_lookup(const char **table, int n,
+                                   const char *str) {
+    int i;
+
+    for (i = 0; str && i < n; i++) {
+        if (strcmp(table[i], str) == 0)
+            return i;
+    }
+    return -1;
+}
+
+/* parse decimal number, returns 0 for malformed one */
+static int __comps_docdelta_num(const char *str, long *num) {
+    char *end;
+
+    if (str == NULL || !str[0])
+        return 0;
+    *num = strtol(str, &end, 10);
+    return *end == 0;
+}
+
+static COMPS_ObjList* __comps_docdelta_split_arches(const char *arch) {
+    COMPS_ObjList *ret;
+    const char *end;
+
+    ret = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+    while (*arch) {
+        for (end = arch; *end && *end != ' '; end++);
+        if (end > arch)
+            comps_objlist_append_x(ret, (COMPS_Object*)comps_str_x(
+                                  __comps_docdiff_strndup(arch, end - arch)));
+        arch = *end ? end + 1 : end;
+    }
+    return ret;
+}
+
+static COMPS_Object* __comps_docdelta_read_item(const XML_Char *name,
+                                                const XML_Char **attrs) {
+    COMPS_DocGroupPackage *pkg;
+    COMPS_DocGroupId *gid;
+    const char *val;
+    long num;
+    int type;
+
+    if (strcmp(name, "package") == 0) {
+        pkg = COMPS_OBJECT_CREATE(COMPS_DocGroupPackage, NULL);
+        if ((val = __comps_docdelta_attr(attrs, "name")) != NULL)
+            comps_docpackage_set_name(pkg, (char*)val, 1);
+        type = __comps_docdelta_lookup(__comps_docdelta_types,
+                                  COMPS_PACKAGE_UNKNOWN + 1,
+                                  __comps_docdelta_attr(attrs, "type"));
+        if (type >= 0)
+            comps_docpackage_set_type_i(pkg, type, false);
+        if ((val = __comps_docdelta_attr(attrs, "requires")) != NULL)
+            comps_docpackage_set_requires(pkg, (char*)val, 1);
+        if (__comps_docdelta_num(__comps_docdelta_attr(attrs, "basearchonly"),
+                                 &num))
+            comps_docpackage_set_basearchonly(pkg, num, false);
+        if ((val = __comps_docdelta_attr(attrs, "arch")) != NULL)
+            comps_docpackage_set_arches(pkg,
+                                        __comps_docdelta_split_arches(val));
+        return (COMPS_Object*)pkg;
+    } else if (strcmp(name, "groupid") == 0) {
+        gid = COMPS_OBJECT_CREATE(COMPS_DocGroupId, NULL);
+        if ((val = __comps_docdelta_attr(attrs, "name")) != NULL)
+            comps_docgroupid_set_name(gid, (char*)val, 1);
+        val = __comps_docdelta_attr(attrs, "default");
+        comps_docgroupid_set_default(gid, val && strcmp(val, "true") == 0);
+        if ((val = __comps_docdelta_attr(attrs, "arch")) != NULL)
+            comps_docgroupid_set_arches(gid,
+                                        __comps_docdelta_split_arches(val));
+        return (COMPS_Object*)gid;
+    }
+    return NULL;
+}
+
+static void __comps_docdelta_read_op(COMPS_DocDeltaReader *reader,
+                                     const XML_Char *name,
+                                     const XML_Char **attrs) {
+    COMPS_DocDeltaOp *op = &reader->op;
+    const char *val;
+    int type, section;
+    long num;
+
+    type = __comps_docdelta_lookup(__comps_docdelta_ops,
+                                   COMPS_DELTA_ITEM_SET + 1, name);
+    section = __comps_docdelta_lookup(__comps_docdelta_sections,
+                                      COMPS_DELTA_LANGPACKS + 1,
+                                      __comps_docdelta_attr(attrs, "section"));
+    if (type < 0 || section < 0) {
+        reader->error = 1;
+        return;
+    }
+    op->type = type;
+    op->section = section;
+    op->id = __comps_docdiff_strdup(__comps_docdelta_attr(attrs, "id"));
+    op->key = __comps_docdiff_strdup(__comps_docdelta_attr(attrs, "key"));
+    op->list = 0;
+    op->pos = 0;
+    op->value = NULL;
+    reader->in_op = 1;
+    if (__comps_docdelta_num(__comps_docdelta_attr(attrs, "list"), &num)) {
+        op->list = num;
+        if (num < 0)
+            reader->error = 1;
+    }
+    if (__comps_docdelta_num(__comps_docdelta_attr(attrs, "pos"), &num)) {
+        op->pos = num;
+        if (num < 0)
+            reader->error = 1;
+    }
+    val = __comps_docdelta_attr(attrs, "unset");
+    reader->unset = val && strcmp(val, "true") == 0;
+    val = __comps_docdelta_attr(attrs, "type");
+    reader->num = val && strcmp(val, "num") == 0;
+    if (val && strcmp(val, "list") == 0)
+        op->value = (COMPS_Object*)COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+    reader->text_len = 0;
+}
+
+static void __comps_docdelta_start(void *data, const XML_Char *name,
+                                   const XML_Char **attrs) {
+    COMPS_DocDeltaReader *reader = (COMPS_DocDeltaReader*)data;
+
+    reader->depth++;
+    if (reader->error)
+        return;
+    if (reader->depth == 1) {
+        reader->error = strcmp(name, "compsdelta") != 0;
+    } else if (reader->depth == 2) {
+        __comps_docdelta_read_op(reader, name, attrs);
+    } else if (reader->depth == 3 && strcmp(name, "str") == 0) {
+        reader->error = reader->op.value == NULL
+                 || reader->op.value->obj_info != &COMPS_ObjList_ObjInfo;
+        reader->text_len = 0;
+    } else if (reader->depth == 3 && reader->op.value == NULL) {
+        reader->op.value = __comps_docdelta_read_item(name, attrs);
+        reader->error = reader->op.value == NULL;
+    } else {
+        reader->error = 1;
+    }
+}
+
+/* Append text and keep it NUL terminated */
+static int __comps_docdelta_text_append(COMPS_DocDeltaReader *reader,
+                                        const char *s, size_t len) {
+    size_t size;
+    char *text;
+
+    if (reader->text_len + len + 1 > reader->text_size) {
+        for (size = reader->text_size ? reader->text_size : 64;
+             size < reader->text_len + len + 1; size *= 2);
+        if ((text = realloc(reader->text, size)) == NULL)
+            return 0;
+        reader->text = text;
+        reader->text_size = size;
+    }
+    memcpy(reader->text + reader->text_len, s, len);
+    reader->text_len += len;
+    reader->text[reader->text_len] = 0;
+    return 1;
+}
+
+static void __comps_docdelta_text(void *data, const XML_Char *s, int len) {
+    COMPS_DocDeltaReader *reader = (COMPS_DocDeltaReader*)data;
+
+    if (!reader->error && reader->depth >= 2
+        && !__comps_docdelta_text_append(reader, s, len))
+        reader->error = 1;
+}
+
+/* Check that operation has everything comps_doc_patch() needs */
+static int __comps_docdelta_valid(const COMPS_DocDeltaOp *op) {
+    if (op->section == COMPS_DELTA_LANGPACKS)
+        return op->type == COMPS_DELTA_PROP && op->key;
+    if (op->type == COMPS_DELTA_ORDER)
+        return op->value != NULL;
+    if (op->id == NULL)
+        return 0;
+    if (op->type >= COMPS_DELTA_PROP && op->type <= COMPS_DELTA_DESC)
+        return op->key != NULL;
+    if (op->type == COMPS_DELTA_ITEM_ADD || op->type == COMPS_DELTA_ITEM_SET)
+        return op->value != NULL;
+    return 1;
+}
+
+static void __comps_docdelta_end(void *data, const XML_Char *name) {
+    COMPS_DocDeltaReader *reader = (COMPS_DocDeltaReader*)data;
+    COMPS_DocDeltaOp *op = &reader->op;
+    long num;
+
+    reader->depth--;
+    if (reader->error)
+        return;
+    if (reader->depth == 0)
+        return;
+    if (!__comps_docdelta_text_append(reader, "", 0)) {
+        reader->error = 1;
+        return;
+    }
+    if (reader->depth == 2 && strcmp(name, "str") == 0) {
+        comps_objlist_append_x((COMPS_ObjList*)op->value,
+                               (COMPS_Object*)comps_str(reader->text));
+    } else if (reader->depth == 1) {
+        if (op->value == NULL && !reader->unset
+            && op->type >= COMPS_DELTA_PROP && op->type <= COMPS_DELTA_DESC) {
+            if (!reader->num)
+                op->value = (COMPS_Object*)comps_str(reader->text);
+            else if (__comps_docdelta_num(reader->text, &num))
+                op->value = (COMPS_Object*)comps_num(num);
+        }
+        reader->in_op = 0;
+        if (!__comps_docdelta_valid(op)) {
+            __comps_docdelta_op_clear(op);
+            reader->error = 1;
+        } else if (!__comps_docdelta_append(reader->delta, op)) {
+            reader->error = 1;
+        }
+    }
+}
+
+COMPS_DocDelta* comps_docdelta_from_xml_str(const char *str) {
+    COMPS_DocDeltaReader reader;
+    XML_Parser parser;
+
+    if ((parser = XML_ParserCreate(NULL)) == NULL)
+        return NULL;
+    memset(&reader, 0, sizeof(reader));
+    if ((reader.delta = malloc(sizeof(*reader.delta))) == NULL) {
+        XML_ParserFree(parser);
+        return NULL;
+    }
+    reader.delta->ops = NULL;
+    reader.delta->len = reader.delta->size = 0;
+    XML_SetUserData(parser, &reader);
+    XML_SetElementHandler(parser, &__comps_docdelta_start,
+                          &__comps_docdelta_end);
+    XML_SetCharacterDataHandler(parser, &__comps_docdelta_text);
+    if (XML_Parse(parser, str, strlen(str), 1) == XML_STATUS_ERROR)
+        reader.error = 1;
+    XML_ParserFree(parser);
+    if (reader.in_op)
+        __comps_docdelta_op_clear(&reader.op);
+    free(reader.text);
+    if (reader.error) {
+        comps_docdelta_destroy(reader.delta);
+        return NULL;
+    }
+    return reader.delta;
+}
@@ -27,6 +27,7 @@ void comps_docenv_create(COMPS_DocEnv* env, COMPS_Object **args) {
     env->desc_by_lang = COMPS_OBJECT_CREATE(COMPS_ObjDict, NULL);
     env->group_list = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
     env->option_list = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+    env->xml_cache = NULL;
 }
 COMPS_CREATE_u(docenv, COMPS_DocEnv)
 
@@ -41,6 +42,7 @@ void comps_docenv_copy(COMPS_DocEnv *env_dst, COMPS_DocEnv *env_src) {
                                     (COMPS_Object*)env_src->group_list);
     env_dst->option_list = (COMPS_ObjList*)comps_object_copy(
                                     (COMPS_Object*)env_src->option_list);
+    env_dst->xml_cache = NULL;
 }
 COMPS_COPY_u(docenv, COMPS_DocEnv)    /*comps_utils.h macro*/
 
@@ -50,6 +52,7 @@ static void comps_docenv_destroy(COMPS_DocEnv *env) {
     comps_object_destroy((COMPS_Object*)env->desc_by_lang);
     comps_object_destroy((COMPS_Object*)env->group_list);
     comps_object_destroy((COMPS_Object*)env->option_list);
+    __comps_xml_fragment_destroy(env->xml_cache);
 }
 COMPS_DESTROY_u(docenv, COMPS_DocEnv) /*comps_utils.h macro*/
 
@@ -99,6 +102,14 @@ void comps_docenv_add_optionid(COMPS_DocEnv *env,
     comps_objlist_append_x(env->option_list, (COMPS_Object*)gid);
 }
 
+COMPS_Object* __comps_docenv_id_x(COMPS_Object *env) {
+    return comps_objdict_get_x(((COMPS_DocEnv*)env)->properties, "id");
+}
+
+COMPS_Object* __comps_docenv_props_x(COMPS_Object *env) {
+    return (COMPS_Object*)((COMPS_DocEnv*)env)->properties;
+}
+
 signed char comps_docenv_cmp_u(COMPS_Object *env1, COMPS_Object *env2) {
     #define _env1 ((COMPS_DocEnv*)env1)
     #define _env2 ((COMPS_DocEnv*)env2)
@@ -166,13 +177,17 @@ COMPS_DocEnv* comps_docenv_union(COMPS_DocEnv *e1, COMPS_DocEnv *e2) {
     it = e1->group_list?e1->group_list->first:NULL;
     for (; it != NULL; it = it->next) {
         obj = comps_object_copy(it->comps_obj);
-        comps_set_add(set, (void*)comps_object_incref(obj));
+        if (!comps_set_add(set, (void*)comps_object_incref(obj)))
+            COMPS_OBJECT_DESTROY(obj);
         comps_docenv_add_groupid(res, (COMPS_DocGroupId*)obj);
     }
     it = e2->group_list?e2->group_list->first:NULL;
     for (; it != NULL; it = it->next) {
         if ((data = comps_set_data_at(set, (void*)it->comps_obj)) != NULL) {
             index = comps_objlist_index(res->group_list, (COMPS_Object*)data);
+            /* replaced already by previous duplicate */
+            if (index == -1)
+                continue;
             comps_objlist_remove_at(res->group_list, index);
             comps_objlist_insert_at_x(res->group_list, index,
                                       comps_object_copy(it->comps_obj));
@@ -203,6 +218,9 @@ COMPS_DocEnv* comps_docenv_union(COMPS_DocEnv *e1, COMPS_DocEnv *e2) {
     for (; it != NULL; it = it->next) {
         if ((data = comps_set_data_at(set, (void*)it->comps_obj)) != NULL) {
             index = comps_objlist_index(res->option_list, (COMPS_Object*)data);
+            /* replaced already by previous duplicate */
+            if (index == -1)
+                continue;
             comps_objlist_remove_at(res->option_list, index);
             comps_objlist_insert_at_x(res->option_list, index,
                                       comps_object_copy(it->comps_obj));
@@ -219,6 +237,20 @@ COMPS_DocEnv* comps_docenv_union(COMPS_DocEnv *e1, COMPS_DocEnv *e2) {
     return res;
 }
 
+void comps_docenv_unite(COMPS_DocEnv *e1, COMPS_DocEnv *e2) {
+    comps_objdict_unite(e1->properties, e2->properties);
+    if (e1->group_list == NULL)
+        e1->group_list = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+    __comps_objlist_unite_by(e1->group_list, e2->group_list,
+                             &__comps_docgroupid_name_x);
+    if (e1->option_list == NULL)
+        e1->option_list = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+    __comps_objlist_unite_by(e1->option_list, e2->option_list,
+                             &__comps_docgroupid_name_x);
+    comps_objdict_unite(e1->name_by_lang, e2->name_by_lang);
+    comps_objdict_unite(e1->desc_by_lang, e2->desc_by_lang);
+}
+
 COMPS_DocEnv* comps_docenv_intersect(COMPS_DocEnv *e1, COMPS_DocEnv *e2) {
     COMPS_DocEnv *res;
     COMPS_ObjListIt *it;
@@ -341,14 +373,14 @@ signed char comps_docenv_xml(COMPS_DocEnv *env, xmlTextWriterPtr writer,
                     comps_hslist_destroy(&pairlist);
                     return -1;
                 }
-                ret = xmlTextWriterWriteAttribute(writer, BAD_CAST "xml:lang",
-                        (xmlChar*) ((COMPS_ObjRTreePair*)hsit->data)->key);
+                ret = __comps_xml_attr(writer, "xml:lang",
+                        ((COMPS_ObjRTreePair*)hsit->data)->key);
                 if (__comps_check_xml_get(ret, (COMPS_Object*)log) < 0) {
                     comps_hslist_destroy(&pairlist);
                     return -1;
                 }
                 str = comps_object_tostr(((COMPS_ObjRTreePair*)hsit->data)->data);
-                ret = xmlTextWriterWriteString(writer, (xmlChar*)str);
+                ret = __comps_xml_text(writer, str);
                 free(str);
                 if (__comps_check_xml_get(ret, (COMPS_Object*)log) < 0) {
                     comps_hslist_destroy(&pairlist);
@@ -446,9 +478,7 @@ char* comps_docenv_tostr_u(COMPS_Object* env) {
     #undef _env_
 }
 
-COMPS_DocEnv* comps_docenv_arch_filter(COMPS_DocEnv *source,
-                                       COMPS_ObjList *arches) {
-    COMPS_ObjList *arches2;
+static COMPS_DocEnv* __comps_docenv_filter_base(COMPS_DocEnv *source) {
     COMPS_DocEnv *ret = COMPS_OBJECT_CREATE(COMPS_DocEnv, NULL);
     COMPS_OBJECT_DESTROY(ret->properties);
     ret->properties = (COMPS_ObjDict*)COMPS_OBJECT_COPY(source->properties);
@@ -456,34 +486,79 @@ COMPS_DocEnv* comps_docenv_arch_filter(COMPS_DocEnv *source,
     ret->name_by_lang = (COMPS_ObjDict*)COMPS_OBJECT_COPY(source->name_by_lang);
     COMPS_OBJECT_DESTROY(ret->desc_by_lang);
     ret->desc_by_lang = (COMPS_ObjDict*)COMPS_OBJECT_COPY(source->desc_by_lang);
-    for (COMPS_ObjListIt *it = source->group_list->first;
-         it != NULL; it = it->next) {
-        arches2 = comps_docgroupid_arches((COMPS_DocGroupId*)it->comps_obj);
-        if ((!arches2) || (__comps_objlist_intersected(arches, arches2))) {
-            comps_docenv_add_groupid(ret, (COMPS_DocGroupId*)
-                                          comps_object_copy(it->comps_obj));
+    return ret;
+}
+
+void __comps_docenv_arch_filter_multi(COMPS_DocEnv *source,
+                                      const COMPS_ArchFilter *filter,
+                                      const char *keep, COMPS_DocEnv **ret) {
+    COMPS_ObjListIt *it;
+    char matched[filter->count];
+    unsigned int i;
+
+    for (i = 0; i < filter->count; i++)
+        ret[i] = keep[i] ? __comps_docenv_filter_base(source) : NULL;
+    for (it = source->group_list->first; it != NULL; it = it->next) {
+        comps_archfilter_match(filter,
+                               ((COMPS_DocGroupId*)it->comps_obj)->arches,
+                               matched);
+        for (i = 0; i < filter->count; i++) {
+            if (ret[i] && matched[i])
+                comps_docenv_add_groupid(ret[i], (COMPS_DocGroupId*)
+                                         comps_object_copy(it->comps_obj));
         }
-        COMPS_OBJECT_DESTROY(arches2);
     }
-    for (COMPS_ObjListIt *it = source->option_list->first;
-         it != NULL; it = it->next) {
-        arches2 = comps_docgroupid_arches((COMPS_DocGroupId*)it->comps_obj);
-        if ((!arches2) || (__comps_objlist_intersected(arches, arches2))) {
-            comps_docenv_add_optionid(ret, (COMPS_DocGroupId*)
+    for (it = source->option_list->first; it != NULL; it = it->next) {
+        comps_archfilter_match(filter,
+                               ((COMPS_DocGroupId*)it->comps_obj)->arches,
+                               matched);
+        for (i = 0; i < filter->count; i++) {
+            if (ret[i] && matched[i])
+                comps_docenv_add_optionid(ret[i], (COMPS_DocGroupId*)
                                           comps_object_copy(it->comps_obj));
         }
-        COMPS_OBJECT_DESTROY(arches2);
     }
+}
+
+COMPS_DocEnv* comps_docenv_arch_filter(COMPS_DocEnv *source,
+                                       COMPS_ObjList *arches) {
+    COMPS_ArchFilter *filter;
+    COMPS_DocEnv *ret;
+    const char keep = 1;
+
+    if ((filter = comps_archfilter_create(&arches, 1)) == NULL)
+        return NULL;
+    __comps_docenv_arch_filter_multi(source, filter, &keep, &ret);
+    comps_archfilter_destroy(filter);
     return ret;
 }
 
+static COMPS_Digest comps_docenv_digest_u(COMPS_Object *obj) {
+    COMPS_DocEnv *env = (COMPS_DocEnv*)obj;
+    COMPS_Digest ret;
+
+    ret = comps_digest_str(COMPS_DIGEST_INIT, "environment");
+    ret = comps_digest_u64(ret, comps_object_digest(
+                                          (COMPS_Object*)env->properties));
+    ret = comps_digest_u64(ret, comps_object_digest(
+                                          (COMPS_Object*)env->name_by_lang));
+    ret = comps_digest_u64(ret, comps_object_digest(
+                                          (COMPS_Object*)env->desc_by_lang));
+    ret = comps_digest_u64(ret, comps_object_digest(
+                                          (COMPS_Object*)env->group_list));
+    ret = comps_digest_u64(ret, comps_object_digest(
+                                          (COMPS_Object*)env->option_list));
+    return comps_digest_finish(ret);
+}
+
 COMPS_ObjectInfo COMPS_DocEnv_ObjInfo = {
     .obj_size = sizeof(COMPS_DocEnv),
     .constructor = &comps_docenv_create_u,
     .destructor = &comps_docenv_destroy_u,
     .copy = &comps_docenv_copy_u,
     .obj_cmp = &comps_docenv_cmp_u,
-    .to_str = &comps_docenv_tostr_u
+    .to_str = &comps_docenv_tostr_u,
+    .digest = &comps_docenv_digest_u
 };
 
 COMPS_ValRuleGeneric* COMPS_DocEnv_ValidateRules[] = {
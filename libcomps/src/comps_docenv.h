@@ -27,6 +27,8 @@ typedef struct {
     /**< list of group_ids in environment */
     COMPS_ObjList *option_list;
     /**< list of options in environment */
+    COMPS_XMLFragment *xml_cache;
+    /**< xml from last output, see COMPS_XMLOptions.fragment_cache */
 } COMPS_DocEnv;
 
 //HEAD_COMPS_CREATE_u(docenv, COMPS_DocEnv)  /*comps_utils.h macro*/
@@ -160,6 +162,11 @@ HEAD_COMPS_DOCOBJ_GETARCHES(docenv, COMPS_DocEnv)
 HEAD_COMPS_DOCOBJ_SETARCHES(docenv, COMPS_DocEnv)
 
 char __comps_docenv_idcmp(void *e1, void *e2);
+/* id of COMPS_DocEnv without incrementing reference counter */
+COMPS_Object* __comps_docenv_id_x(COMPS_Object *env);
+/* properties dict of COMPS_DocEnv, holding its id, without incrementing
+ * reference counter */
+COMPS_Object* __comps_docenv_props_x(COMPS_Object *env);
 
 /** add group_id to group_ids list in environment
  * @param env COMPS_DocEnv object
@@ -184,6 +191,15 @@ void comps_docenv_add_optionid(COMPS_DocEnv *env,
  */
 COMPS_DocEnv* comps_docenv_union(COMPS_DocEnv *e1, COMPS_DocEnv *e2);
 
+/** union second environment into first one in place
+ *
+ * e1 ends up equal to what comps_docenv_union(e1, e2) returns. Nothing is
+ * copied, e1 takes references to group ids, option ids and strings of e2
+ * @param e1 COMPS_DocEnv object which is modified
+ * @param e2 COMPS_DocEnv object
+ */
+void comps_docenv_unite(COMPS_DocEnv *e1, COMPS_DocEnv *e2);
+
 /** intersect two environments into one and return new COMPS_DocEnv object
  * @param e1 COMPS_DocEnv object
  * @param e2 COMPS_DocEnv object
@@ -197,6 +213,12 @@ signed char comps_docenv_xml(COMPS_DocEnv *env, xmlTextWriterPtr writer,
 COMPS_DocEnv* comps_docenv_arch_filter(COMPS_DocEnv *source,
                                        COMPS_ObjList *arches);
 
+/* Filter source by every arch list of filter at once. ret[i] is set to
+ * new filtered copy for every i with keep[i] set, NULL otherwise */
+void __comps_docenv_arch_filter_multi(COMPS_DocEnv *source,
+                                      const COMPS_ArchFilter *filter,
+                                      const char *keep, COMPS_DocEnv **ret);
+
 extern COMPS_ObjectInfo COMPS_DocEnv_ObjInfo;
 extern COMPS_ValRuleGeneric* COMPS_DocEnv_ValidateRules[];
 
@@ -26,6 +26,7 @@ void comps_docgroup_create(COMPS_DocGroup* group, COMPS_Object **args) {
     group->name_by_lang = COMPS_OBJECT_CREATE(COMPS_ObjDict, NULL);
     group->desc_by_lang = COMPS_OBJECT_CREATE(COMPS_ObjDict, NULL);
     group->packages = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+    group->xml_cache = NULL;
 }
 COMPS_CREATE_u(docgroup, COMPS_DocGroup)
 
@@ -39,6 +40,7 @@ void comps_docgroup_copy(COMPS_DocGroup *group_dst,
                                     (COMPS_Object*)group_src->desc_by_lang);
     group_dst->packages = (COMPS_ObjList*)comps_object_copy(
                                     (COMPS_Object*)group_src->packages);
+    group_dst->xml_cache = NULL;
 }
 COMPS_COPY_u(docgroup, COMPS_DocGroup)    /*comps_utils.h macro*/
 
@@ -48,6 +50,7 @@ static void comps_docgroup_destroy(COMPS_DocGroup *group) {
     COMPS_OBJECT_DESTROY(group->name_by_lang);
     COMPS_OBJECT_DESTROY(group->desc_by_lang);
     COMPS_OBJECT_DESTROY(group->packages);
+    __comps_xml_fragment_destroy(group->xml_cache);
 }
 COMPS_DESTROY_u(docgroup, COMPS_DocGroup) /*comps_utils.h macro*/
 
@@ -121,6 +124,14 @@ COMPS_ObjList* comps_docgroup_get_packages(COMPS_DocGroup *group, char *name,
 }
 
 
+COMPS_Object* __comps_docgroup_id_x(COMPS_Object *group) {
+    return comps_objdict_get_x(((COMPS_DocGroup*)group)->properties, "id");
+}
+
+COMPS_Object* __comps_docgroup_props_x(COMPS_Object *group) {
+    return (COMPS_Object*)((COMPS_DocGroup*)group)->properties;
+}
+
 signed char comps_docgroup_cmp_u(COMPS_Object *group1, COMPS_Object *group2) {
     #define _group1 ((COMPS_DocGroup*)group1)
     #define _group2 ((COMPS_DocGroup*)group2)
@@ -181,7 +192,9 @@ COMPS_DocGroup* comps_docgroup_union(COMPS_DocGroup *g1, COMPS_DocGroup *g2) {
     it = g1->packages?g1->packages->first:NULL;
     for (; it != NULL; it = it->next) {
         pkg = (COMPS_DocGroupPackage*) comps_object_copy(it->comps_obj);
-        comps_set_add(set, (void*)comps_object_incref((COMPS_Object*)pkg));
+        if (!comps_set_add(set,
+                           (void*)comps_object_incref((COMPS_Object*)pkg)))
+            COMPS_OBJECT_DESTROY(pkg);
         comps_docgroup_add_package(res, pkg);
     }
     void *data;
@@ -190,6 +203,9 @@ COMPS_DocGroup* comps_docgroup_union(COMPS_DocGroup *g1, COMPS_DocGroup *g2) {
     for (; it != NULL; it = it->next) {
         if ((data = comps_set_data_at(set, (void*)it->comps_obj)) != NULL) {
             index = comps_objlist_index(res->packages, (COMPS_Object*)data);
+            /* replaced already by previous duplicate */
+            if (index == -1)
+                continue;
             comps_objlist_remove_at(res->packages, index);
             comps_objlist_insert_at_x(res->packages, index,
                                       comps_object_copy(it->comps_obj));
@@ -206,6 +222,16 @@ COMPS_DocGroup* comps_docgroup_union(COMPS_DocGroup *g1, COMPS_DocGroup *g2) {
     return res;
 }
 
+void comps_docgroup_unite(COMPS_DocGroup *g1, COMPS_DocGroup *g2) {
+    comps_objdict_unite(g1->properties, g2->properties);
+    if (g1->packages == NULL)
+        g1->packages = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+    __comps_objlist_unite_by(g1->packages, g2->packages,
+                             &__comps_docpackage_name_x);
+    comps_objdict_unite(g1->name_by_lang, g2->name_by_lang);
+    comps_objdict_unite(g1->desc_by_lang, g2->desc_by_lang);
+}
+
 COMPS_DocGroup* comps_docgroup_intersect(COMPS_DocGroup *g1,
                                          COMPS_DocGroup *g2) {
     COMPS_DocGroup *res;
@@ -273,8 +299,10 @@ signed char comps_docgroup_xml(COMPS_DocGroup *group, xmlTextWriterPtr writer,
                               0, 0, 0, 0};
     static char* aliases[] = {NULL, NULL, NULL, "description", "description",
                               "default", NULL, NULL, NULL, NULL};
-    static bool explicit[] = {true, true, true, true, true, false, false,
-                              false, true, true};
+    /* filled from options, static would be shared by parallel
+     * serialization */
+    bool explicit[] = {true, true, true, true, true, false, false,
+                       false, true, true};
     const char *str_true = "true";
     const char *str_false = "false";
     const char *default_val[] = {NULL, NULL, NULL, NULL, NULL,
@@ -346,11 +374,11 @@ signed char comps_docgroup_xml(COMPS_DocGroup *group, xmlTextWriterPtr writer,
                             (const xmlChar*)((aliases[i])?aliases[i]:props[i]));
                 COMPS_XMLRET_CHECK(comps_hslist_destroy(&pairlist))
 
-                ret = xmlTextWriterWriteAttribute(writer, BAD_CAST "xml:lang",
-                            (xmlChar*) ((COMPS_ObjRTreePair*)hsit->data)->key);
+                ret = __comps_xml_attr(writer, "xml:lang",
+                            ((COMPS_ObjRTreePair*)hsit->data)->key);
                 COMPS_XMLRET_CHECK(comps_hslist_destroy(&pairlist))
                 str = tostrf[i](((COMPS_ObjRTreePair*)hsit->data)->data);
-                ret = xmlTextWriterWriteString(writer, (xmlChar*)str);
+                ret = __comps_xml_text(writer, str);
                 COMPS_XMLRET_CHECK(comps_hslist_destroy(&pairlist))
                 free(str);
                 ret = xmlTextWriterEndElement(writer);
@@ -426,9 +454,7 @@ char* comps_docgroup_tostr_u(COMPS_Object* group) {
     #undef _group_
 }
 
-COMPS_DocGroup* comps_docgroup_arch_filter(COMPS_DocGroup *source,
-                                           COMPS_ObjList *arches) {
-    COMPS_ObjList *arches2;
+static COMPS_DocGroup* __comps_docgroup_filter_base(COMPS_DocGroup *source) {
     COMPS_DocGroup *ret = COMPS_OBJECT_CREATE(COMPS_DocGroup, NULL);
     COMPS_OBJECT_DESTROY(ret->properties);
     ret->properties = (COMPS_ObjDict*)COMPS_OBJECT_COPY(source->properties);
@@ -436,25 +462,70 @@ COMPS_DocGroup* comps_docgroup_arch_filter(COMPS_DocGroup *source,
     ret->name_by_lang = (COMPS_ObjDict*)COMPS_OBJECT_COPY(source->name_by_lang);
     COMPS_OBJECT_DESTROY(ret->desc_by_lang);
     ret->desc_by_lang = (COMPS_ObjDict*)COMPS_OBJECT_COPY(source->desc_by_lang);
-    for (COMPS_ObjListIt *it = source->packages->first;
-         it != NULL; it = it->next) {
-        arches2 = comps_docpackage_arches((COMPS_DocGroupPackage*)it->comps_obj);
-        if ((!arches2) || (__comps_objlist_intersected(arches, arches2))) {
-            comps_docgroup_add_package(ret, (COMPS_DocGroupPackage*)
-                                            comps_object_copy(it->comps_obj));
+    return ret;
+}
+
+void __comps_docgroup_arch_filter_multi(COMPS_DocGroup *source,
+                                        const COMPS_ArchFilter *filter,
+                                        const char *keep,
+                                        COMPS_DocGroup **ret) {
+    COMPS_ObjListIt *it;
+    char matched[filter->count];
+    unsigned int i;
+
+    for (i = 0; i < filter->count; i++)
+        ret[i] = keep[i] ? __comps_docgroup_filter_base(source) : NULL;
+    for (it = source->packages->first; it != NULL; it = it->next) {
+        comps_archfilter_match(filter,
+                               ((COMPS_DocGroupPackage*)it->comps_obj)->arches,
+                               matched);
+        for (i = 0; i < filter->count; i++) {
+            if (ret[i] && matched[i])
+                comps_docgroup_add_package(ret[i], (COMPS_DocGroupPackage*)
+                                           comps_object_copy(it->comps_obj));
         }
-        COMPS_OBJECT_DESTROY(arches2);
     }
+}
+
+COMPS_DocGroup* comps_docgroup_arch_filter(COMPS_DocGroup *source,
+                                           COMPS_ObjList *arches) {
+    COMPS_ArchFilter *filter;
+    COMPS_DocGroup *ret;
+    const char keep = 1;
+
+    if ((filter = comps_archfilter_create(&arches, 1)) == NULL)
+        return NULL;
+    __comps_docgroup_arch_filter_multi(source, filter, &keep, &ret);
+    comps_archfilter_destroy(filter);
     return ret;
 }
 
+/* Properties and translations are dictionaries of strings, their digests
+ * are cached until they change. Item lists are digested on every call */
+static COMPS_Digest comps_docgroup_digest_u(COMPS_Object *obj) {
+    COMPS_DocGroup *group = (COMPS_DocGroup*)obj;
+    COMPS_Digest ret;
+
+    ret = comps_digest_str(COMPS_DIGEST_INIT, "group");
+    ret = comps_digest_u64(ret, comps_object_digest(
+                                          (COMPS_Object*)group->properties));
+    ret = comps_digest_u64(ret, comps_object_digest(
+                                          (COMPS_Object*)group->name_by_lang));
+    ret = comps_digest_u64(ret, comps_object_digest(
+                                          (COMPS_Object*)group->desc_by_lang));
+    ret = comps_digest_u64(ret, comps_object_digest(
+                                          (COMPS_Object*)group->packages));
+    return comps_digest_finish(ret);
+}
+
 COMPS_ObjectInfo COMPS_DocGroup_ObjInfo = {
     .obj_size = sizeof(COMPS_DocGroup),
     .constructor = &comps_docgroup_create_u,
     .destructor = &comps_docgroup_destroy_u,
     .copy = &comps_docgroup_copy_u,
     .obj_cmp = &comps_docgroup_cmp_u,
-    .to_str = &comps_docgroup_tostr_u
+    .to_str = &comps_docgroup_tostr_u,
+    .digest = &comps_docgroup_digest_u
 };
 
 COMPS_ValRuleGeneric* COMPS_DocGroup_ValidateRules[] = {
@@ -56,6 +56,8 @@ typedef struct {
     /**< language localization of description attribute */
     COMPS_ObjList *packages;
     /**< list of packages in group */
+    COMPS_XMLFragment *xml_cache;
+    /**< xml from last output, see COMPS_XMLOptions.fragment_cache */
 } COMPS_DocGroup;
 
 //HEAD_COMPS_CREATE_u(docgroup, COMPS_DocGroup)  /*comps_utils.h macro*/
@@ -218,6 +220,11 @@ HEAD_COMPS_DOCOBJ_SETARCHES(docgroup, COMPS_DocGroup)
 
 signed char comps_docgroup_cmp_u(COMPS_Object *group1, COMPS_Object *group2);
 char __comps_docgroup_idcmp(void *g1, void *g2);
+/* id of COMPS_DocGroup without incrementing reference counter */
+COMPS_Object* __comps_docgroup_id_x(COMPS_Object *group);
+/* properties dict of COMPS_DocGroup, holding its id, without incrementing
+ * reference counter */
+COMPS_Object* __comps_docgroup_props_x(COMPS_Object *group);
 
 /** add package to packages list in group
  * @param cat COMPS_DocGroup object
@@ -245,6 +252,15 @@ COMPS_ObjList* comps_docgroup_get_packages(COMPS_DocGroup *group, char *name,
  */
 COMPS_DocGroup* comps_docgroup_union(COMPS_DocGroup *g1, COMPS_DocGroup *g2);
 
+/** union second group into first one in place
+ *
+ * g1 ends up equal to what comps_docgroup_union(g1, g2) returns. Nothing is
+ * copied, g1 takes references to packages and strings of g2
+ * @param g1 COMPS_DocGroup object which is modified
+ * @param g2 COMPS_DocGroup object
+ */
+void comps_docgroup_unite(COMPS_DocGroup *g1, COMPS_DocGroup *g2);
+
 /** intersect two groups into one and return new COMPS_DocGroup object
  * @param c1 COMPS_DocGroup object
  * @param c2 COMPS_DocGroup object
@@ -260,6 +276,13 @@ signed char comps_docgroup_xml(COMPS_DocGroup *group, xmlTextWriterPtr writer,
 COMPS_DocGroup* comps_docgroup_arch_filter(COMPS_DocGroup *source,
                                            COMPS_ObjList *arches);
 
+/* Filter source by every arch list of filter at once. ret[i] is set to
+ * new filtered copy for every i with keep[i] set, NULL otherwise */
+void __comps_docgroup_arch_filter_multi(COMPS_DocGroup *source,
+                                        const COMPS_ArchFilter *filter,
+                                        const char *keep,
+                                        COMPS_DocGroup **ret);
+
 extern COMPS_ObjectInfo COMPS_DocGroup_ObjInfo;
 extern COMPS_ValRuleGeneric* COMPS_DocGroup_ValidateRules[];
 
@@ -85,10 +85,26 @@ signed char comps_docgroupid_cmp_u(COMPS_Object *gid1, COMPS_Object *gid2) {
     #undef _gid2
 }
 
+static COMPS_Digest comps_docgroupid_digest_u(COMPS_Object *obj) {
+    COMPS_DocGroupId *gid = (COMPS_DocGroupId*)obj;
+    COMPS_Digest ret;
+
+    ret = comps_digest_str(COMPS_DIGEST_INIT, "groupid");
+    ret = comps_digest_u64(ret, comps_object_digest((COMPS_Object*)gid->name));
+    ret = comps_digest_u64(ret, gid->def != 0);
+    if (gid->arches && gid->arches->len)
+        ret = comps_digest_u64(ret,
+                             comps_object_digest((COMPS_Object*)gid->arches));
+    return comps_digest_finish(ret);
+}
+
 char __comps_docgroupid_cmp_set(void *gid1, void *gid2) {
     return comps_object_cmp((COMPS_Object*)((COMPS_DocGroupId*)gid1)->name,
                             (COMPS_Object*)((COMPS_DocGroupId*)gid2)->name);
 }
+COMPS_Object* __comps_docgroupid_name_x(COMPS_Object *gid) {
+    return (COMPS_Object*)((COMPS_DocGroupId*)gid)->name;
+}
 char* comps_docgroupid_str_u(COMPS_Object* docgroupid) {
     const int len = strlen("<COMPS_DocGroupId name='' default=''>");
     char *name = comps_object_tostr((COMPS_Object*)((COMPS_DocGroupId*)docgroupid)->name);
@@ -118,22 +134,18 @@ signed char comps_docgroupid_xml(COMPS_DocGroupId *groupid,
     }
     if (options->gid_default_explicit) {
         if (groupid->def)
-            ret = xmlTextWriterWriteAttribute(writer, BAD_CAST "default",
-                                              BAD_CAST "true");
+            ret = __comps_xml_attr(writer, "default", "true");
         else
-            ret = xmlTextWriterWriteAttribute(writer, BAD_CAST "default",
-                                              BAD_CAST "false");
+            ret = __comps_xml_attr(writer, "default", "false");
         COMPS_XMLRET_CHECK()
     } else if (groupid->def != default_def) {
         if (groupid->def)
-            ret = xmlTextWriterWriteAttribute(writer, BAD_CAST "default",
-                                              BAD_CAST "true");
+            ret = __comps_xml_attr(writer, "default", "true");
         else
-            ret = xmlTextWriterWriteAttribute(writer, BAD_CAST "default",
-                                              BAD_CAST "false");
+            ret = __comps_xml_attr(writer, "default", "false");
     }
     str = comps_object_tostr((COMPS_Object*)groupid->name);
-    ret = xmlTextWriterWriteString(writer, BAD_CAST str);
+    ret = __comps_xml_text(writer, str);
     free(str);
     COMPS_XMLRET_CHECK()
     ret = xmlTextWriterEndElement(writer);
@@ -147,7 +159,8 @@ COMPS_ObjectInfo COMPS_DocGroupId_ObjInfo = {
     .destructor = &comps_docgroupid_destroy_u,
     .copy = &comps_docgroupid_copy_u,
     .obj_cmp = &comps_docgroupid_cmp_u,
-    .to_str = &comps_docgroupid_str_u
+    .to_str = &comps_docgroupid_str_u,
+    .digest = &comps_docgroupid_digest_u
 };
 
 COMPS_ValRuleGeneric* COMPS_DocGroupId_ValidateRules[] = {
@@ -48,6 +48,8 @@ COMPS_Object_TAIL(COMPS_DocGroupId);
 //HEAD_COMPS_DESTROY_u(docgroupid, COMPS_DocGroupId)  /*comps_utils.h macro*/
 
 char __comps_docgroupid_cmp_set(void *gid1, void *gid2);
+/* name of COMPS_DocGroupId without incrementing reference counter */
+COMPS_Object* __comps_docgroupid_name_x(COMPS_Object *gid);
 
 /** COMPS_DocGroupId name getter
  * @param gid COMPS_DocGroupId object
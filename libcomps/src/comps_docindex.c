@@ -0,0 +1,1141 @@
+/* libcomps - C alternative to yum.comps library
+ * Copyright (C) 2013 Jindrich Luza
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to  Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA
+ */
+
+#include "comps_docindex.h"
+#include "comps_radix.h"
+
+#include <fnmatch.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+    COMPS_Object *owner; /* group, category or environment */
+    COMPS_Object *item; /* package or group id in owner */
+    size_t pos; /* position of owner in its section list */
+} COMPS_DocIndexRef;
+
+typedef struct {
+    COMPS_DocIndexRef *refs;
+    size_t len;
+    size_t size;
+} COMPS_DocIndexRefs;
+
+typedef struct {
+    COMPS_Object *obj; /* referenced, so address can't be reused */
+    unsigned int version;
+} COMPS_DocIndexState;
+
+#define COMPS_DOCINDEX_PACKAGES 0
+#define COMPS_DOCINDEX_CATEGORIES 1
+#define COMPS_DOCINDEX_ENVS 2
+
+typedef struct {
+    unsigned int obj; /* number of object in COMPS_DocText objs */
+    unsigned int lang; /* 0 for default text, language number otherwise */
+    unsigned int weight; /* weight of field the token comes from */
+} COMPS_DocTextPosting;
+
+typedef struct {
+    COMPS_DocTextPosting *postings;
+    size_t len;
+    size_t size;
+} COMPS_DocTextPostings;
+
+/* inverted index of names and descriptions, built on first search */
+typedef struct {
+    COMPS_RTree *tokens; /* lowercased token -> COMPS_DocTextPostings */
+    COMPS_RTree *langs; /* language -> its number, stored as pointer */
+    unsigned int nlangs;
+    COMPS_Object **objs; /* groups, categories and environments */
+    size_t nobjs;
+} COMPS_DocText;
+
+struct COMPS_DocIndex {
+    COMPS_DocIndexState *states; /* every list index was built from */
+    size_t states_len;
+    size_t states_size;
+    COMPS_RTree *trees[3]; /* key -> COMPS_DocIndexRefs */
+    COMPS_RTree *expanded; /* resolve key -> COMPS_ObjList of packages */
+    COMPS_RTree *ids[3]; /* id -> COMPS_DocIndexRefs of section objects */
+    COMPS_RTree *folded[3]; /* ASCII lowercased id -> COMPS_DocIndexRefs */
+    COMPS_DocIndexRefs unfoldable[3]; /* objects with non-ASCII id */
+    COMPS_DocText *text; /* search index or NULL until first search */
+};
+
+/* section of document and lists of its objects index is built from */
+typedef struct {
+    const char *key; /* key of section in doc->objects */
+    size_t dicts[3]; /* offsets of properties, name_by_lang and
+                        desc_by_lang dicts in section object */
+    size_t offsets[2]; /* offsets of item lists in section object */
+    unsigned int nlists;
+    COMPS_Object* (*key_f)(COMPS_Object*); /* key of list items */
+    int tree;
+} COMPS_DocIndexSection;
+
+static const COMPS_DocIndexSection __comps_docindex_sections[] = {
+    {"groups",
+     {offsetof(COMPS_DocGroup, properties),
+      offsetof(COMPS_DocGroup, name_by_lang),
+      offsetof(COMPS_DocGroup, desc_by_lang)},
+     {offsetof(COMPS_DocGroup, packages)}, 1,
+     &__comps_docpackage_name_x, COMPS_DOCINDEX_PACKAGES},
+    {"categories",
+     {offsetof(COMPS_DocCategory, properties),
+      offsetof(COMPS_DocCategory, name_by_lang),
+      offsetof(COMPS_DocCategory, desc_by_lang)},
+     {offsetof(COMPS_DocCategory, group_ids)}, 1,
+     &__comps_docgroupid_name_x, COMPS_DOCINDEX_CATEGORIES},
+    {"environments",
+     {offsetof(COMPS_DocEnv, properties),
+      offsetof(COMPS_DocEnv, name_by_lang),
+      offsetof(COMPS_DocEnv, desc_by_lang)},
+     {offsetof(COMPS_DocEnv, group_list), offsetof(COMPS_DocEnv, option_list)},
+     2, &__comps_docgroupid_name_x, COMPS_DOCINDEX_ENVS}
+};
+
+#define COMPS_DOCINDEX_PROPS 0
+#define COMPS_DOCINDEX_NAMES 1
+#define COMPS_DOCINDEX_DESCS 2
+
+/* properties, name_by_lang or desc_by_lang of object of section */
+static COMPS_ObjDict* __comps_docindex_dict(size_t sect, COMPS_Object *obj,
+                                            int dict) {
+    return *(COMPS_ObjDict**)((char*)obj
+                              + __comps_docindex_sections[sect].dicts[dict]);
+}
+
+static void __comps_docindex_refs_destroy(void *refs) {
+    if (refs == NULL)
+        return;
+    free(((COMPS_DocIndexRefs*)refs)->refs);
+    free(refs);
+}
+
+static void __comps_doctext_postings_destroy(void *postings) {
+    if (postings == NULL)
+        return;
+    free(((COMPS_DocTextPostings*)postings)->postings);
+    free(postings);
+}
+
+static void __comps_doctext_destroy(COMPS_DocText *text) {
+    if (text == NULL)
+        return;
+    comps_rtree_destroy(text->tokens);
+    comps_rtree_destroy(text->langs);
+    free(text->objs);
+    free(text);
+}
+
+void comps_docindex_destroy(COMPS_DocIndex *index) {
+    size_t i;
+
+    if (index == NULL)
+        return;
+    for (i = 0; i < index->states_len; i++)
+        COMPS_OBJECT_DESTROY(index->states[i].obj);
+    free(index->states);
+    for (i = 0; i < 3; i++) {
+        comps_rtree_destroy(index->trees[i]);
+        comps_rtree_destroy(index->ids[i]);
+        comps_rtree_destroy(index->folded[i]);
+        free(index->unfoldable[i].refs);
+    }
+    comps_rtree_destroy(index->expanded);
+    __comps_doctext_destroy(index->text);
+    free(index);
+}
+
+static COMPS_DocIndex* __comps_docindex_create(void) {
+    COMPS_DocIndex *index;
+    int i;
+
+    if ((index = malloc(sizeof(*index))) == NULL)
+        return NULL;
+    index->states = NULL;
+    index->states_len = 0;
+    index->states_size = 0;
+    index->text = NULL;
+    for (i = 0; i < 3; i++) {
+        index->trees[i] = comps_rtree_create(NULL, NULL,
+                                             &__comps_docindex_refs_destroy);
+        index->ids[i] = comps_rtree_create(NULL, NULL,
+                                           &__comps_docindex_refs_destroy);
+        index->folded[i] = comps_rtree_create(NULL, NULL,
+                                              &__comps_docindex_refs_destroy);
+        index->unfoldable[i].refs = NULL;
+        index->unfoldable[i].len = index->unfoldable[i].size = 0;
+    }
+    index->expanded = comps_rtree_create(NULL, NULL,
+                                    (void(*)(void*))&comps_object_destroy);
+    for (i = 0; i < 3; i++) {
+        if (!index->trees[i] || !index->ids[i] || !index->folded[i])
+            break;
+    }
+    if (i < 3 || !index->expanded) {
+        comps_docindex_destroy(index);
+        return NULL;
+    }
+    return index;
+}
+
+/* Record version of list or dict when building, compare it with recorded
+ * one otherwise. Objects are visited in the same order both times */
+static int __comps_docindex_state(COMPS_DocIndex *index, size_t *pos,
+                                  COMPS_Object *obj, unsigned int version,
+                                  char build) {
+    COMPS_DocIndexState *states;
+    size_t size;
+
+    if (!build) {
+        if (*pos >= index->states_len || index->states[*pos].obj != obj
+            || index->states[*pos].version != version)
+            return 0;
+        (*pos)++;
+        return 1;
+    }
+    if (index->states_len == index->states_size) {
+        size = index->states_size ? index->states_size * 2 : 64;
+        states = realloc(index->states, sizeof(*states) * size);
+        if (states == NULL)
+            return 0;
+        index->states = states;
+        index->states_size = size;
+    }
+    index->states[index->states_len].obj = comps_object_incref(obj);
+    index->states[index->states_len].version = version;
+    index->states_len++;
+    (*pos)++;
+    return 1;
+}
+
+static int __comps_docindex_append(COMPS_DocIndexRefs *refs,
+                                   COMPS_Object *owner, COMPS_Object *item,
+                                   size_t pos) {
+    COMPS_DocIndexRef *tmp;
+    size_t size;
+
+    if (refs->len == refs->size) {
+        size = refs->size ? refs->size * 2 : 4;
+        if ((tmp = realloc(refs->refs, sizeof(*tmp) * size)) == NULL)
+            return 0;
+        refs->refs = tmp;
+        refs->size = size;
+    }
+    refs->refs[refs->len].owner = owner;
+    refs->refs[refs->len].item = item;
+    refs->refs[refs->len].pos = pos;
+    refs->len++;
+    return 1;
+}
+
+/* references of key in tree, created when missing */
+static COMPS_DocIndexRefs* __comps_docindex_refs(COMPS_RTree *tree,
+                                                char *key) {
+    COMPS_DocIndexRefs *refs;
+
+    if ((refs = comps_rtree_get(tree, key)) == NULL) {
+        if ((refs = malloc(sizeof(*refs))) == NULL)
+            return NULL;
+        refs->refs = NULL;
+        refs->len = refs->size = 0;
+        comps_rtree_set(tree, key, refs);
+    }
+    return refs;
+}
+
+static int __comps_docindex_add(COMPS_RTree *tree, char *key,
+                                COMPS_Object *owner, COMPS_Object *item) {
+    COMPS_DocIndexRefs *refs;
+
+    if ((refs = __comps_docindex_refs(tree, key)) == NULL)
+        return 0;
+    /* owner lists the same key more times */
+    if (refs->len && refs->refs[refs->len - 1].owner == owner)
+        return 1;
+    return __comps_docindex_append(refs, owner, item, 0);
+}
+
+/* string value of dict key, NULL when missing or not string */
+static const char* __comps_docindex_str(COMPS_ObjDict *dict, const char *key) {
+    COMPS_Object *obj;
+
+    if (dict == NULL || key == NULL)
+        return NULL;
+    obj = comps_objdict_get_x(dict, key);
+    if (obj == NULL || obj->obj_info != &COMPS_Str_ObjInfo)
+        return NULL;
+    return ((COMPS_Str*)obj)->val;
+}
+
+static int __comps_docindex_ascii(const char *str) {
+    for (; *str; str++) {
+        if ((unsigned char)*str >= 0x80)
+            return 0;
+    }
+    return 1;
+}
+
+static char __comps_docindex_fold(char c) {
+    return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+/* Add object at position pos of section list to id trees */
+static int __comps_docindex_add_id(COMPS_DocIndex *index, size_t sect,
+                                   COMPS_Object *obj, size_t pos) {
+    COMPS_DocIndexRefs *refs;
+    const char *id;
+    char *folded;
+    size_t i;
+
+    id = __comps_docindex_str(__comps_docindex_dict(sect, obj,
+                                                    COMPS_DOCINDEX_PROPS),
+                              "id");
+    /* radix tree can't hold empty key, such objects are found by scan */
+    if (id == NULL || id[0] == 0)
+        return 1;
+    if ((refs = __comps_docindex_refs(index->ids[sect], (char*)id)) == NULL
+        || !__comps_docindex_append(refs, obj, NULL, pos))
+        return 0;
+    if (!__comps_docindex_ascii(id))
+        return __comps_docindex_append(&index->unfoldable[sect], obj, NULL,
+                                       pos);
+    if ((folded = malloc(strlen(id) + 1)) == NULL)
+        return 0;
+    for (i = 0; id[i]; i++)
+        folded[i] = __comps_docindex_fold(id[i]);
+    folded[i] = 0;
+    refs = __comps_docindex_refs(index->folded[sect], folded);
+    free(folded);
+    return refs && __comps_docindex_append(refs, obj, NULL, pos);
+}
+
+/* Walk all lists of document index depends on. When building, index is
+ * filled, otherwise it's checked to be up to date */
+static int __comps_docindex_walk(COMPS_DocIndex *index, COMPS_Doc *doc,
+                                 char build) {
+    const COMPS_DocIndexSection *sect;
+    COMPS_ObjList *list, *sub;
+    COMPS_ObjListIt *it, *subit;
+    COMPS_ObjDict *dict;
+    char *key, *tofree;
+    size_t pos, i, n;
+    unsigned int j;
+
+    pos = 0;
+    for (i = 0; i < 3; i++) {
+        sect = &__comps_docindex_sections[i];
+        list = (COMPS_ObjList*)comps_objdict_get_x(doc->objects, sect->key);
+        if (!__comps_docindex_state(index, &pos, (COMPS_Object*)list,
+                                    list ? list->version : 0, build))
+            return 0;
+        n = 0;
+        for (it = list ? list->first : NULL; it != NULL; it = it->next, n++) {
+            /* properties hold id, names and descriptions hold text of
+             * search index, all can change in place */
+            for (j = 0; j < 3; j++) {
+                dict = __comps_docindex_dict(i, it->comps_obj, j);
+                if (!__comps_docindex_state(index, &pos, (COMPS_Object*)dict,
+                                            dict ? dict->version : 0, build))
+                    return 0;
+            }
+            if (build && !__comps_docindex_add_id(index, i, it->comps_obj,
+                                                  n))
+                return 0;
+            for (j = 0; j < sect->nlists; j++) {
+                sub = *(COMPS_ObjList**)((char*)it->comps_obj
+                                         + sect->offsets[j]);
+                if (!__comps_docindex_state(index, &pos, (COMPS_Object*)sub,
+                                            sub ? sub->version : 0, build))
+                    return 0;
+                if (!build || sub == NULL)
+                    continue;
+                for (subit = sub->first; subit != NULL; subit = subit->next) {
+                    key = __comps_obj_keystr(sect->key_f(subit->comps_obj),
+                                             &tofree);
+                    /* radix tree can't hold empty key */
+                    if (key && key[0]
+                        && !__comps_docindex_add(index->trees[sect->tree], key,
+                                                 it->comps_obj,
+                                                 subit->comps_obj)) {
+                        free(tofree);
+                        return 0;
+                    }
+                    free(tofree);
+                }
+            }
+        }
+    }
+    return pos == index->states_len;
+}
+
+/* Return index of document, (re)built when missing or out of date */
+static COMPS_DocIndex* __comps_docindex_update(COMPS_Doc *doc) {
+    if (doc->index == NULL || !__comps_docindex_walk(doc->index, doc, 0)) {
+        comps_docindex_destroy(doc->index);
+        if ((doc->index = __comps_docindex_create()) == NULL)
+            return NULL;
+        if (!__comps_docindex_walk(doc->index, doc, 1)) {
+            comps_docindex_destroy(doc->index);
+            doc->index = NULL;
+        }
+    }
+    return doc->index;
+}
+
+static COMPS_DocIndexRefs* __comps_docindex_get(COMPS_Doc *doc, int tree,
+                                                const char *key) {
+    if (__comps_docindex_update(doc) == NULL)
+        return NULL;
+    return comps_rtree_get(doc->index->trees[tree], key);
+}
+
+/* Owners of references which item is still named key */
+static COMPS_ObjList* __comps_docindex_owners(COMPS_Doc *doc, int tree,
+                                             const char *key,
+                                             COMPS_Object* (*key_f)(COMPS_Object*),
+                                             COMPS_PackageType **types) {
+    COMPS_DocIndexRefs *refs;
+    COMPS_ObjList *ret;
+    char *str, *tofree;
+    size_t i;
+
+    ret = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+    if (types)
+        *types = NULL;
+    if (doc == NULL || key == NULL || key[0] == 0)
+        return ret;
+    if ((refs = __comps_docindex_get(doc, tree, key)) == NULL)
+        return ret;
+    if (types && (*types = malloc(sizeof(**types) * refs->len)) == NULL)
+        return ret;
+    for (i = 0; i < refs->len; i++) {
+        str = __comps_obj_keystr(key_f(refs->refs[i].item), &tofree);
+        if (str && strcmp(str, key) == 0) {
+            if (types) {
+                (*types)[ret->len] =
+                        ((COMPS_DocGroupPackage*)refs->refs[i].item)->type;
+            }
+            comps_objlist_append(ret, refs->refs[i].owner);
+        }
+        free(tofree);
+    }
+    if (types && ret->len == 0) {
+        free(*types);
+        *types = NULL;
+    }
+    return ret;
+}
+
+COMPS_ObjList* comps_doc_package_groups(COMPS_Doc *doc, const char *name,
+                                        COMPS_PackageType **types) {
+    return __comps_docindex_owners(doc, COMPS_DOCINDEX_PACKAGES, name,
+                                   &__comps_docpackage_name_x, types);
+}
+
+COMPS_ObjList* comps_doc_group_categories(COMPS_Doc *doc,
+                                          const char *group_id) {
+    return __comps_docindex_owners(doc, COMPS_DOCINDEX_CATEGORIES, group_id,
+                                   &__comps_docgroupid_name_x, NULL);
+}
+
+COMPS_ObjList* comps_doc_group_envs(COMPS_Doc *doc, const char *group_id) {
+    return __comps_docindex_owners(doc, COMPS_DOCINDEX_ENVS, group_id,
+                                   &__comps_docgroupid_name_x, NULL);
+}
+
+/* object without arches or with arches matching any of requested ones */
+static int __comps_docindex_arch_match(COMPS_Object *obj_arches,
+                                       COMPS_ObjList *arches) {
+    return arches == NULL || obj_arches == NULL
+           || __comps_objlist_intersected(arches, (COMPS_ObjList*)obj_arches);
+}
+
+/* key of group expansion: flags, arches and group id separated by
+ * character which can't appear in any of them */
+static char* __comps_docindex_expand_key(int flags, COMPS_ObjList *arches,
+                                         const char *group_id) {
+    COMPS_ObjListIt *it;
+    char *key, *pos;
+    size_t len;
+
+    len = 2 * sizeof(int) + 2 + strlen(group_id);
+    for (it = arches ? arches->first : NULL; it != NULL; it = it->next)
+        len += strlen(((COMPS_Str*)it->comps_obj)->val) + 1;
+    if ((key = malloc(len + 1)) == NULL)
+        return NULL;
+    pos = key + sprintf(key, "%x\n", flags);
+    for (it = arches ? arches->first : NULL; it != NULL; it = it->next)
+        pos += sprintf(pos, "%s,", ((COMPS_Str*)it->comps_obj)->val);
+    sprintf(pos, "\n%s", group_id);
+    return key;
+}
+
+/* packages of group of selected types and arches, each name once */
+static COMPS_ObjList* __comps_docindex_expand(COMPS_DocGroup *group,
+                                              int flags,
+                                              COMPS_ObjList *arches) {
+    COMPS_ObjList *ret;
+    COMPS_ObjListIt *it;
+    COMPS_DocGroupPackage *pkg;
+    COMPS_RTree *seen;
+    char *name;
+
+    ret = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+    seen = comps_rtree_create(NULL, NULL, NULL);
+    for (it = group->packages ? group->packages->first : NULL; it != NULL;
+         it = it->next) {
+        pkg = (COMPS_DocGroupPackage*)it->comps_obj;
+        if (!(flags & (1 << pkg->type)) || pkg->name == NULL
+            || !__comps_docindex_arch_match((COMPS_Object*)pkg->arches,
+                                            arches))
+            continue;
+        name = pkg->name->val;
+        if (name[0] && comps_rtree_get(seen, name))
+            continue;
+        if (name[0])
+            comps_rtree_set(seen, name, pkg);
+        comps_objlist_append(ret, (COMPS_Object*)pkg);
+    }
+    comps_rtree_destroy(seen);
+    return ret;
+}
+
+COMPS_ObjList* comps_doc_env_resolve(COMPS_Doc *doc, const char *env_id,
+                                     int flags, COMPS_ObjList *arches) {
+    COMPS_DocEnv *env;
+    COMPS_DocGroup *group;
+    COMPS_DocGroupId *gid;
+    COMPS_ObjList *ret, *lists[2], *expanded, *owned;
+    COMPS_ObjListIt *it, *pit;
+    COMPS_DocIndex *index;
+    COMPS_RTree *seen;
+    char *key, *name;
+    int i;
+
+    if (doc == NULL || env_id == NULL
+        || (env = comps_doc_env_by_id(doc, env_id)) == NULL)
+        return NULL;
+    ret = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+    if (!__comps_docindex_arch_match(comps_objdict_get_x(env->properties,
+                                                         "arches"), arches)) {
+        COMPS_OBJECT_DESTROY(env);
+        return ret;
+    }
+    index = __comps_docindex_update(doc);
+    seen = comps_rtree_create(NULL, NULL, NULL);
+    lists[0] = env->group_list;
+    lists[1] = (flags & COMPS_RESOLVE_OPTIONS) ? env->option_list : NULL;
+    for (i = 0; i < 2; i++) {
+        for (it = lists[i] ? lists[i]->first : NULL; it; it = it->next) {
+            gid = (COMPS_DocGroupId*)it->comps_obj;
+            if (gid->name == NULL
+                || !__comps_docindex_arch_match((COMPS_Object*)gid->arches,
+                                                arches))
+                continue;
+            owned = NULL;
+            key = __comps_docindex_expand_key(flags, arches, gid->name->val);
+            expanded = (index && key) ? comps_rtree_get(index->expanded, key)
+                                      : NULL;
+            if (expanded == NULL) {
+                group = comps_doc_group_by_id(doc, gid->name->val);
+                if (group && __comps_docindex_arch_match(
+                        comps_objdict_get_x(group->properties, "arches"),
+                        arches)) {
+                    expanded = __comps_docindex_expand(group, flags, arches);
+                } else {
+                    expanded = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+                }
+                COMPS_OBJECT_DESTROY(group);
+                if (index && key)
+                    comps_rtree_set(index->expanded, key, expanded);
+                else
+                    owned = expanded;
+            }
+            free(key);
+            for (pit = expanded->first; pit != NULL; pit = pit->next) {
+                name = ((COMPS_DocGroupPackage*)pit->comps_obj)->name->val;
+                if (name[0] && comps_rtree_get(seen, name))
+                    continue;
+                if (name[0])
+                    comps_rtree_set(seen, name, pit->comps_obj);
+                comps_objlist_append(ret, pit->comps_obj);
+            }
+            COMPS_OBJECT_DESTROY(owned);
+        }
+    }
+    comps_rtree_destroy(seen);
+    COMPS_OBJECT_DESTROY(env);
+    return ret;
+}
+
+void comps_doc_index_invalidate(COMPS_Doc *doc) {
+    if (doc == NULL)
+        return;
+    comps_docindex_destroy(doc->index);
+    doc->index = NULL;
+}
+
+#define COMPS_DOCQUERY_LITERAL 0
+#define COMPS_DOCQUERY_PREFIX 1
+#define COMPS_DOCQUERY_GLOB 2
+
+/* flags fast matching handles itself, anything else goes to fnmatch */
+#define COMPS_DOCQUERY_FAST_FLAGS (FNM_CASEFOLD | FNM_NOESCAPE \
+                                   | FNM_PATHNAME | FNM_PERIOD)
+
+typedef struct {
+    char *pattern; /* original pattern for fnmatch, NULL matches anything */
+    char *literal; /* unescaped literal part, lowercased with FNM_CASEFOLD */
+    size_t len; /* length of literal */
+    int kind;
+} COMPS_DocPattern;
+
+struct COMPS_DocQuery {
+    COMPS_DocPattern id;
+    COMPS_DocPattern name;
+    COMPS_DocPattern desc;
+    char *lang;
+    int flags;
+};
+
+static char* __comps_docquery_strdup(const char *str) {
+    char *ret;
+
+    if (str == NULL || (ret = malloc(strlen(str) + 1)) == NULL)
+        return NULL;
+    return strcpy(ret, str);
+}
+
+/* Sort pattern into literal, prefix followed only by stars, or glob */
+static int __comps_docpattern_compile(COMPS_DocPattern *pat,
+                                      const char *pattern, int flags) {
+    const char *p;
+    char fold;
+
+    pat->literal = NULL;
+    pat->len = 0;
+    pat->kind = COMPS_DOCQUERY_GLOB;
+    if (pattern == NULL) {
+        pat->pattern = NULL;
+        return 1;
+    }
+    if ((pat->pattern = __comps_docquery_strdup(pattern)) == NULL
+        || (pat->literal = malloc(strlen(pattern) + 1)) == NULL)
+        return 0;
+    if (flags & ~COMPS_DOCQUERY_FAST_FLAGS)
+        return 1;
+    fold = (flags & FNM_CASEFOLD) != 0;
+    for (p = pattern; *p; p++) {
+        if (*p == '*') {
+            while (*p == '*')
+                p++;
+            if (*p)
+                return 1;
+            pat->kind = COMPS_DOCQUERY_PREFIX;
+            break;
+        }
+        if (*p == '?' || *p == '[')
+            return 1;
+        if (*p == '\\' && !(flags & FNM_NOESCAPE) && *++p == 0)
+            return 1;
+        /* glibc folds non-ASCII characters by locale, leave them to it */
+        if (fold && (unsigned char)*p >= 0x80)
+            return 1;
+        pat->literal[pat->len++] = fold ? __comps_docindex_fold(*p) : *p;
+    }
+    pat->literal[pat->len] = 0;
+    if (pat->kind == COMPS_DOCQUERY_GLOB)
+        pat->kind = COMPS_DOCQUERY_LITERAL;
+    return 1;
+}
+
+static void __comps_docpattern_destroy(COMPS_DocPattern *pat) {
+    free(pat->pattern);
+    free(pat->literal);
+}
+
+static int __comps_docpattern_match(const COMPS_DocPattern *pat, int flags,
+                                    const char *str) {
+    size_t i;
+
+    if (pat->kind == COMPS_DOCQUERY_GLOB
+        || ((flags & FNM_CASEFOLD) && !__comps_docindex_ascii(str)))
+        return fnmatch(pat->pattern, str, flags) == 0;
+    if (flags & FNM_CASEFOLD) {
+        for (i = 0; i < pat->len; i++) {
+            if (__comps_docindex_fold(str[i]) != pat->literal[i])
+                return 0;
+        }
+    } else if (strncmp(str, pat->literal, pat->len) != 0) {
+        return 0;
+    }
+    str += pat->len;
+    if (pat->kind == COMPS_DOCQUERY_LITERAL)
+        return *str == 0;
+    /* trailing stars don't match slash and explicit leading period */
+    if ((flags & FNM_PATHNAME) && strchr(str, '/'))
+        return 0;
+    if ((flags & FNM_PERIOD) && *str == '.')
+        return pat->len && !((flags & FNM_PATHNAME)
+                             && pat->literal[pat->len - 1] == '/');
+    return 1;
+}
+
+COMPS_DocQuery* comps_doc_query_create(const char *id, const char *name,
+                                       const char *desc, const char *lang,
+                                       int flags) {
+    COMPS_DocQuery *query;
+
+    if ((query = malloc(sizeof(*query))) == NULL)
+        return NULL;
+    query->flags = flags;
+    query->lang = NULL;
+    query->name.pattern = query->name.literal = NULL;
+    query->desc.pattern = query->desc.literal = NULL;
+    if (!__comps_docpattern_compile(&query->id, id, flags)
+        || !__comps_docpattern_compile(&query->name, name, flags)
+        || !__comps_docpattern_compile(&query->desc, desc, flags)
+        || (lang && (query->lang = __comps_docquery_strdup(lang)) == NULL)) {
+        comps_doc_query_destroy(query);
+        return NULL;
+    }
+    return query;
+}
+
+void comps_doc_query_destroy(COMPS_DocQuery *query) {
+    if (query == NULL)
+        return;
+    __comps_docpattern_destroy(&query->id);
+    __comps_docpattern_destroy(&query->name);
+    __comps_docpattern_destroy(&query->desc);
+    free(query->lang);
+    free(query);
+}
+
+static int __comps_docquery_field(const COMPS_DocPattern *pat, int flags,
+                                  COMPS_ObjDict *dict, const char *key) {
+    const char *str;
+
+    str = __comps_docindex_str(dict, key);
+    return str && __comps_docpattern_match(pat, flags, str);
+}
+
+/* Match object of section the same way comps_doc_get_groups() and its
+ * siblings always did. Only group description is matched in default
+ * language even when language is set */
+static int __comps_docquery_match(const COMPS_DocQuery *query, size_t sect,
+                                  COMPS_Object *obj) {
+    COMPS_ObjDict *props, *name_by_lang, *desc_by_lang;
+    const int flags = query->flags;
+
+    props = __comps_docindex_dict(sect, obj, COMPS_DOCINDEX_PROPS);
+    name_by_lang = __comps_docindex_dict(sect, obj, COMPS_DOCINDEX_NAMES);
+    desc_by_lang = __comps_docindex_dict(sect, obj, COMPS_DOCINDEX_DESCS);
+    if (query->id.pattern
+        && !__comps_docquery_field(&query->id, flags, props, "id"))
+        return 0;
+    if (query->name.pattern
+        && !(query->lang
+             ? __comps_docquery_field(&query->name, flags, name_by_lang,
+                                      query->lang)
+             : __comps_docquery_field(&query->name, flags, props, "name")))
+        return 0;
+    if (query->desc.pattern
+        && !((!query->lang || sect == COMPS_DOCINDEX_PACKAGES)
+             && __comps_docquery_field(&query->desc, flags, props, "desc"))
+        && !(query->lang
+             && __comps_docquery_field(&query->desc, flags, desc_by_lang,
+                                       query->lang)))
+        return 0;
+    return 1;
+}
+
+typedef struct {
+    size_t *pos;
+    size_t len;
+    size_t size;
+    char failed;
+} COMPS_DocQueryCands;
+
+static void __comps_docquery_cands_add(COMPS_DocQueryCands *cands,
+                                       const COMPS_DocIndexRefs *refs) {
+    size_t *tmp;
+    size_t size, i;
+
+    if (cands->len + refs->len > cands->size) {
+        for (size = cands->size ? cands->size : 16;
+             size < cands->len + refs->len; size *= 2);
+        if ((tmp = realloc(cands->pos, sizeof(*tmp) * size)) == NULL) {
+            cands->failed = 1;
+            return;
+        }
+        cands->pos = tmp;
+        cands->size = size;
+    }
+    for (i = 0; i < refs->len; i++)
+        cands->pos[cands->len++] = refs->refs[i].pos;
+}
+
+static void __comps_docquery_walk(void *cands, const char *key, void *refs) {
+    (void)key;
+    __comps_docquery_cands_add(cands, refs);
+}
+
+static int __comps_docquery_poscmp(const void *a, const void *b) {
+    const size_t x = *(const size_t*)a, y = *(const size_t*)b;
+    return (x > y) - (x < y);
+}
+
+/* Collect positions of objects which id can match literal or prefix
+ * pattern. Returns zero when whole list has to be scanned */
+static int __comps_docquery_cands(const COMPS_DocQuery *query,
+                                  COMPS_DocIndex *index, size_t sect,
+                                  COMPS_DocQueryCands *cands) {
+    const COMPS_DocPattern *pat = &query->id;
+    COMPS_RTree *tree;
+    COMPS_DocIndexRefs *refs;
+
+    if (pat->pattern == NULL || pat->kind == COMPS_DOCQUERY_GLOB
+        || pat->len == 0)
+        return 0;
+    if (query->flags & FNM_CASEFOLD) {
+        tree = index->folded[sect];
+        /* non-ASCII ids are matched by fnmatch, which folds by locale */
+        __comps_docquery_cands_add(cands, &index->unfoldable[sect]);
+    } else {
+        tree = index->ids[sect];
+    }
+    if (pat->kind == COMPS_DOCQUERY_PREFIX) {
+        comps_rtree_prefix_walk(tree, pat->literal, cands,
+                                &__comps_docquery_walk);
+    } else if ((refs = comps_rtree_get(tree, pat->literal)) != NULL) {
+        __comps_docquery_cands_add(cands, refs);
+    }
+    return !cands->failed;
+}
+
+static COMPS_ObjList* __comps_docquery_run(COMPS_Doc *doc,
+                                          const COMPS_DocQuery *query,
+                                          size_t sect) {
+    COMPS_ObjList *ret, *list;
+    COMPS_ObjListIt *it;
+    COMPS_DocIndex *index;
+    COMPS_DocQueryCands cands = {NULL, 0, 0, 0};
+    COMPS_Object *obj;
+    size_t i;
+
+    ret = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+    if (doc == NULL || query == NULL)
+        return ret;
+    list = (COMPS_ObjList*)comps_objdict_get_x(doc->objects,
+                                        __comps_docindex_sections[sect].key);
+    if (list == NULL)
+        return ret;
+    if (query->id.pattern && query->id.kind != COMPS_DOCQUERY_GLOB
+        && query->id.len && (index = __comps_docindex_update(doc)) != NULL
+        && __comps_docquery_cands(query, index, sect, &cands)) {
+        /* candidates come in key order, result keeps list order */
+        qsort(cands.pos, cands.len, sizeof(*cands.pos),
+              &__comps_docquery_poscmp);
+        for (i = 0; i < cands.len; i++) {
+            obj = comps_objlist_get_x(list, cands.pos[i]);
+            if (obj && __comps_docquery_match(query, sect, obj))
+                comps_objlist_append(ret, obj);
+        }
+    } else {
+        for (it = list->first; it != NULL; it = it->next) {
+            if (__comps_docquery_match(query, sect, it->comps_obj))
+                comps_objlist_append(ret, it->comps_obj);
+        }
+    }
+    free(cands.pos);
+    return ret;
+}
+
+COMPS_ObjList* comps_doc_query_groups(COMPS_Doc *doc,
+                                      const COMPS_DocQuery *query) {
+    return __comps_docquery_run(doc, query, COMPS_DOCINDEX_PACKAGES);
+}
+
+COMPS_ObjList* comps_doc_query_categories(COMPS_Doc *doc,
+                                          const COMPS_DocQuery *query) {
+    return __comps_docquery_run(doc, query, COMPS_DOCINDEX_CATEGORIES);
+}
+
+COMPS_ObjList* comps_doc_query_envs(COMPS_Doc *doc,
+                                    const COMPS_DocQuery *query) {
+    return __comps_docquery_run(doc, query, COMPS_DOCINDEX_ENVS);
+}
+
+#define COMPS_DOCTEXT_NAME_WEIGHT 4
+#define COMPS_DOCTEXT_DESC_WEIGHT 1
+
+/* letters and digits make tokens, non-ASCII bytes too, so words of UTF-8
+ * text are kept whole */
+static int __comps_doctext_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+           || (c >= '0' && c <= '9') || (unsigned char)c >= 0x80;
+}
+
+/* Copy next lowercased token of str to token
+ * @return position after the token or NULL when there's none */
+static const char* __comps_doctext_token(const char *str, char *token) {
+    while (*str && !__comps_doctext_char(*str))
+        str++;
+    if (*str == 0)
+        return NULL;
+    while (__comps_doctext_char(*str))
+        *token++ = __comps_docindex_fold(*str++);
+    *token = 0;
+    return str;
+}
+
+static int __comps_doctext_add(COMPS_DocText *text, const char *str,
+                               unsigned int obj, unsigned int lang,
+                               unsigned int weight) {
+    COMPS_DocTextPostings *postings;
+    COMPS_DocTextPosting *tmp, *last;
+    char *token;
+    size_t size;
+
+    if (str == NULL || (token = malloc(strlen(str) + 1)) == NULL)
+        return str == NULL;
+    while ((str = __comps_doctext_token(str, token)) != NULL) {
+        if ((postings = comps_rtree_get(text->tokens, token)) == NULL) {
+            if ((postings = malloc(sizeof(*postings))) == NULL)
+                break;
+            postings->postings = NULL;
+            postings->len = postings->size = 0;
+            comps_rtree_set(text->tokens, token, postings);
+        }
+        last = postings->len ? &postings->postings[postings->len - 1] : NULL;
+        /* token repeated in the same text */
+        if (last && last->obj == obj && last->lang == lang
+            && last->weight == weight)
+            continue;
+        if (postings->len == postings->size) {
+            size = postings->size ? postings->size * 2 : 4;
+            tmp = realloc(postings->postings, sizeof(*tmp) * size);
+            if (tmp == NULL)
+                break;
+            postings->postings = tmp;
+            postings->size = size;
+        }
+        postings->postings[postings->len].obj = obj;
+        postings->postings[postings->len].lang = lang;
+        postings->postings[postings->len].weight = weight;
+        postings->len++;
+    }
+    free(token);
+    return str == NULL;
+}
+
+/* number of language, new languages are numbered from 1 */
+static unsigned int __comps_doctext_lang(COMPS_DocText *text,
+                                         const char *lang) {
+    void *num;
+
+    if ((num = comps_rtree_get(text->langs, lang)) == NULL) {
+        num = (void*)(size_t)++text->nlangs;
+        comps_rtree_set(text->langs, (char*)lang, num);
+    }
+    return (unsigned int)(size_t)num;
+}
+
+static int __comps_doctext_add_langs(COMPS_DocText *text, COMPS_ObjDict *dict,
+                                     unsigned int obj, unsigned int weight) {
+    COMPS_ObjDictIt it;
+    COMPS_Object *val;
+    const char *lang;
+    int ret = 1;
+
+    if (dict == NULL)
+        return 1;
+    comps_objdict_it_init(&it, dict);
+    while (ret && comps_objdict_it_next(&it, &lang, &val)) {
+        if (lang[0] == 0 || val->obj_info != &COMPS_Str_ObjInfo)
+            continue;
+        ret = __comps_doctext_add(text, ((COMPS_Str*)val)->val, obj,
+                                  __comps_doctext_lang(text, lang), weight);
+    }
+    comps_objdict_it_destroy(&it);
+    return ret;
+}
+
+static COMPS_DocText* __comps_doctext_build(COMPS_Doc *doc) {
+    COMPS_DocText *text;
+    COMPS_ObjList *lists[3];
+    COMPS_ObjListIt *it;
+    COMPS_ObjDict *props;
+    COMPS_Object *obj;
+    size_t i, n;
+    int ok;
+
+    if ((text = malloc(sizeof(*text))) == NULL)
+        return NULL;
+    text->tokens = comps_rtree_create(NULL, NULL,
+                                      &__comps_doctext_postings_destroy);
+    text->langs = comps_rtree_create(NULL, NULL, NULL);
+    text->nlangs = 0;
+    text->nobjs = 0;
+    for (i = 0; i < 3; i++) {
+        lists[i] = (COMPS_ObjList*)comps_objdict_get_x(doc->objects,
+                                        __comps_docindex_sections[i].key);
+        text->nobjs += lists[i] ? lists[i]->len : 0;
+    }
+    text->objs = malloc(sizeof(*text->objs) * (text->nobjs + 1));
+    ok = text->tokens && text->langs && text->objs;
+    n = 0;
+    for (i = 0; ok && i < 3; i++) {
+        for (it = lists[i] ? lists[i]->first : NULL; ok && it;
+             it = it->next, n++) {
+            obj = text->objs[n] = it->comps_obj;
+            props = __comps_docindex_dict(i, obj, COMPS_DOCINDEX_PROPS);
+            ok = __comps_doctext_add(text, __comps_docindex_str(props, "name"),
+                                     n, 0, COMPS_DOCTEXT_NAME_WEIGHT)
+                 && __comps_doctext_add(text,
+                                        __comps_docindex_str(props, "desc"),
+                                        n, 0, COMPS_DOCTEXT_DESC_WEIGHT)
+                 && __comps_doctext_add_langs(text,
+                        __comps_docindex_dict(i, obj, COMPS_DOCINDEX_NAMES),
+                        n, COMPS_DOCTEXT_NAME_WEIGHT)
+                 && __comps_doctext_add_langs(text,
+                        __comps_docindex_dict(i, obj, COMPS_DOCINDEX_DESCS),
+                        n, COMPS_DOCTEXT_DESC_WEIGHT);
+        }
+    }
+    if (!ok) {
+        __comps_doctext_destroy(text);
+        return NULL;
+    }
+    return text;
+}
+
+typedef struct {
+    const char *token;
+    unsigned int lang; /* requested language or 0 for default text only */
+    char all_langs;
+    unsigned int *best; /* best score of current token for every object */
+} COMPS_DocTextSearch;
+
+static void __comps_doctext_walk(void *udata, const char *key,
+                                 void *data) {
+    COMPS_DocTextSearch *search = udata;
+    COMPS_DocTextPostings *postings = data;
+    COMPS_DocTextPosting *p;
+    unsigned int score;
+    size_t i;
+    char exact;
+
+    /* whole word match ranks above word only starting with token */
+    exact = strcmp(key, search->token) == 0;
+    for (i = 0; i < postings->len; i++) {
+        p = &postings->postings[i];
+        if (!search->all_langs && p->lang && p->lang != search->lang)
+            continue;
+        score = exact ? p->weight * 2 : p->weight;
+        if (score > search->best[p->obj])
+            search->best[p->obj] = score;
+    }
+}
+
+typedef struct {
+    unsigned int obj;
+    unsigned int score;
+} COMPS_DocTextHit;
+
+static int __comps_doctext_hitcmp(const void *a, const void *b) {
+    const COMPS_DocTextHit *x = a, *y = b;
+
+    if (x->score != y->score)
+        return x->score > y->score ? -1 : 1;
+    return (x->obj > y->obj) - (x->obj < y->obj);
+}
+
+COMPS_ObjList* comps_doc_search(COMPS_Doc *doc, const char *query,
+                                const char *lang, unsigned int limit) {
+    COMPS_DocIndex *index;
+    COMPS_DocText *text;
+    COMPS_DocTextSearch search;
+    COMPS_DocTextHit *hits;
+    COMPS_ObjList *ret;
+    unsigned int *total, *matched, ntokens;
+    const char *str;
+    char *token;
+    size_t i, nhits;
+
+    ret = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+    if (doc == NULL || query == NULL
+        || (index = __comps_docindex_update(doc)) == NULL)
+        return ret;
+    if (index->text == NULL)
+        index->text = __comps_doctext_build(doc);
+    if (index->text == NULL)
+        return ret;
+    text = index->text;
+    search.all_langs = lang == NULL;
+    search.lang = lang ? (unsigned int)(size_t)comps_rtree_get(text->langs,
+                                                               lang)
+                       : 0;
+    token = malloc(strlen(query) + 1);
+    search.best = malloc(sizeof(*search.best) * (text->nobjs + 1));
+    total = calloc(text->nobjs + 1, sizeof(*total));
+    matched = calloc(text->nobjs + 1, sizeof(*matched));
+    hits = malloc(sizeof(*hits) * (text->nobjs + 1));
+    if (token && search.best && total && matched && hits) {
+        /* every token of query has to match some word, as word prefix at
+         * least, so incomplete last word of typed query matches too */
+        ntokens = 0;
+        search.token = token;
+        for (str = query; (str = __comps_doctext_token(str, token)) != NULL;) {
+            memset(search.best, 0, sizeof(*search.best) * text->nobjs);
+            comps_rtree_prefix_walk(text->tokens, token, &search,
+                                    &__comps_doctext_walk);
+            for (i = 0; i < text->nobjs; i++) {
+                if (search.best[i]) {
+                    total[i] += search.best[i];
+                    matched[i]++;
+                }
+            }
+            ntokens++;
+        }
+        nhits = 0;
+        for (i = 0; ntokens && i < text->nobjs; i++) {
+            if (matched[i] == ntokens) {
+                hits[nhits].obj = i;
+                hits[nhits].score = total[i];
+                nhits++;
+            }
+        }
+        qsort(hits, nhits, sizeof(*hits), &__comps_doctext_hitcmp);
+        if (limit && nhits > limit)
+            nhits = limit;
+        for (i = 0; i < nhits; i++)
+            comps_objlist_append(ret, text->objs[hits[i].obj]);
+    }
+    free(token);
+    free(search.best);
+    free(total);
+    free(matched);
+    free(hits);
+    return ret;
+}
@@ -0,0 +1,175 @@
+/* libcomps - C alternative to yum.comps library
+ * Copyright (C) 2013 Jindrich Luza
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to  Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA
+ */
+
+/** \file comps_docindex.h
+ * \brief Reverse index of COMPS_Doc
+ *
+ * Index maps package names to groups containing them and group ids to
+ * categories and environments referencing them. Ids of groups, categories
+ * and environments are indexed too, as given and ASCII lowercased, for
+ * COMPS_DocQuery, and words of their names and descriptions for
+ * comps_doc_search(). It's built on first query
+ * and kept in COMPS_Doc. Every query checks that lists index was built from
+ * are still the same and unchanged, which costs few steps per group,
+ * category and environment instead of walk over all packages and group ids.
+ * Changed document is reindexed on next query.
+ *
+ * Properties and translations of groups, categories and environments are
+ * checked the same way, so setting an id, name or description is noticed.
+ * Renaming package or group id in place doesn't change any list, so old
+ * name stops matching immediately, but new name is found only after
+ * comps_doc_index_invalidate() or after any change of the lists. The same
+ * applies to in place changes of package types and arches seen by
+ * comps_doc_env_resolve().
+ * Queries modify the index, so they must not run concurrently on the same
+ * document.
+ */
+
+#ifndef COMPS_DOCINDEX_H
+#define COMPS_DOCINDEX_H
+
+#include "comps_doc.h"
+
+/** Return groups containing package of specified name
+ * @param doc COMPS_Doc object
+ * @param name package name
+ * @param types if not NULL, *types is set to newly allocated array holding
+ * type of the package in each returned group, in the same order as groups.
+ * *types is NULL when no group is found
+ * @return new COMPS_ObjList of COMPS_DocGroup objects, in order of
+ * document
+ */
+COMPS_ObjList* comps_doc_package_groups(COMPS_Doc *doc, const char *name,
+                                        COMPS_PackageType **types);
+
+/** Return categories listing group of specified id
+ * @param doc COMPS_Doc object
+ * @param group_id group id
+ * @return new COMPS_ObjList of COMPS_DocCategory objects
+ */
+COMPS_ObjList* comps_doc_group_categories(COMPS_Doc *doc,
+                                          const char *group_id);
+
+/** Return environments listing group of specified id in group list or in
+ * option list
+ * @param doc COMPS_Doc object
+ * @param group_id group id
+ * @return new COMPS_ObjList of COMPS_DocEnv objects
+ */
+COMPS_ObjList* comps_doc_group_envs(COMPS_Doc *doc, const char *group_id);
+
+/** Package types and options selected by comps_doc_env_resolve() */
+typedef enum {
+    COMPS_RESOLVE_DEFAULT = 1 << COMPS_PACKAGE_DEFAULT,
+    COMPS_RESOLVE_OPTIONAL = 1 << COMPS_PACKAGE_OPTIONAL,
+    COMPS_RESOLVE_CONDITIONAL = 1 << COMPS_PACKAGE_CONDITIONAL,
+    COMPS_RESOLVE_MANDATORY = 1 << COMPS_PACKAGE_MANDATORY,
+    COMPS_RESOLVE_UNKNOWN = 1 << COMPS_PACKAGE_UNKNOWN,
+    /** expand also groups of environment option list */
+    COMPS_RESOLVE_OPTIONS = 1 << 8
+} COMPS_ResolveFlags;
+
+/** Expand environment into packages of its groups
+ * Groups of environment group list (and option list with
+ * COMPS_RESOLVE_OPTIONS) are looked up by id and their packages of types
+ * selected by flags are collected. Package which appears in more groups is
+ * returned once, the first occurrence wins. With arches, group ids, groups
+ * and packages with arches not matching any of them are skipped the same
+ * way comps_doc_arch_filter() drops them. Packages of each group filtered
+ * by the same flags and arches are remembered in reverse index, so
+ * environments sharing groups don't expand them again.
+ * @param doc COMPS_Doc object
+ * @param env_id environment id
+ * @param flags bitwise or of COMPS_ResolveFlags
+ * @param arches COMPS_ObjList of COMPS_Str arches or NULL for no filtering
+ * @return new COMPS_ObjList of COMPS_DocGroupPackage objects (not copies)
+ * or NULL when there's no such environment
+ */
+COMPS_ObjList* comps_doc_env_resolve(COMPS_Doc *doc, const char *env_id,
+                                     int flags, COMPS_ObjList *arches);
+
+/** Compiled pattern query of comps_doc_query_groups() and its siblings */
+typedef struct COMPS_DocQuery COMPS_DocQuery;
+
+/** Compile query matching objects the way comps_doc_get_groups() does
+ *
+ * Every pattern is sorted once: literal patterns of id are looked up in id
+ * index of document, patterns ending with stars only walk index keys
+ * starting with the literal part and FNM_CASEFOLD uses index of lowercased
+ * ids. Name and description patterns are matched without fnmatch when they
+ * are literal or prefix ones too. fnmatch is left for real globs, flags
+ * other than FNM_CASEFOLD, FNM_NOESCAPE, FNM_PATHNAME and FNM_PERIOD, and
+ * case insensitive matching of non-ASCII text.
+ * @param id pattern of id or NULL
+ * @param name pattern of name or NULL
+ * @param desc pattern of description or NULL
+ * @param lang language of name and description or NULL for default one
+ * @param flags fnmatch flags
+ * @return new query or NULL if allocation fails
+ */
+COMPS_DocQuery* comps_doc_query_create(const char *id, const char *name,
+                                       const char *desc, const char *lang,
+                                       int flags);
+
+/** Destroy query */
+void comps_doc_query_destroy(COMPS_DocQuery *query);
+
+/** Return groups matching query
+ * @param doc COMPS_Doc object
+ * @param query compiled query, can be used for any number of documents
+ * @return new COMPS_ObjList of COMPS_DocGroup objects, in order of
+ * document
+ */
+COMPS_ObjList* comps_doc_query_groups(COMPS_Doc *doc,
+                                      const COMPS_DocQuery *query);
+
+/** Return categories matching query, see comps_doc_query_groups() */
+COMPS_ObjList* comps_doc_query_categories(COMPS_Doc *doc,
+                                          const COMPS_DocQuery *query);
+
+/** Return environments matching query, see comps_doc_query_groups() */
+COMPS_ObjList* comps_doc_query_envs(COMPS_Doc *doc,
+                                    const COMPS_DocQuery *query);
+
+/** Search names and descriptions of groups, categories and environments
+ *
+ * Text is split to words of ASCII letters and digits (bytes of non-ASCII
+ * characters are part of words) and lowercased. Inverted index from words
+ * to objects is built on first search and kept with reverse index until
+ * document changes. Every word of query has to match start of some word of
+ * object, which lets incomplete last word of typed query match. Words
+ * matched whole rank above prefixes and names rank above descriptions.
+ * @param doc COMPS_Doc object
+ * @param query searched text
+ * @param lang language of searched translations or NULL for all languages.
+ * Untranslated text is searched always
+ * @param limit maximum number of returned objects, 0 for no limit
+ * @return new COMPS_ObjList of COMPS_DocGroup, COMPS_DocCategory and
+ * COMPS_DocEnv objects, best hits first, ties in document order
+ */
+COMPS_ObjList* comps_doc_search(COMPS_Doc *doc, const char *query,
+                                const char *lang, unsigned int limit);
+
+/** Drop reverse index of document, next query builds it again */
+void comps_doc_index_invalidate(COMPS_Doc *doc);
+
+/** Destroy reverse index. Used by COMPS_Doc destructor */
+void comps_docindex_destroy(COMPS_DocIndex *index);
+
+#endif
@@ -140,6 +140,10 @@ inline char comps_docpackage_cmp_set(void *pkg1, void *pkg2) {
                             ((COMPS_DocGroupPackage*)pkg2)->name);
 }
 
+COMPS_Object* __comps_docpackage_name_x(COMPS_Object *pkg) {
+    return (COMPS_Object*)((COMPS_DocGroupPackage*)pkg)->name;
+}
+
 signed char comps_docpackage_xml(COMPS_DocGroupPackage *pkg,
                                  xmlTextWriterPtr writer,
                                  COMPS_Log *log, COMPS_XMLOptions *xml_options,
@@ -165,33 +169,30 @@ signed char comps_docpackage_xml(COMPS_DocGroupPackage *pkg,
     else
         str = "default";
 
-    ret = xmlTextWriterWriteAttribute(writer, BAD_CAST "type", BAD_CAST str);
+    ret = __comps_xml_attr(writer, "type", str);
 
     if (pkg->requires) {
         str = comps_object_tostr((COMPS_Object*)pkg->requires);
         if (str && *str) {
-            ret = xmlTextWriterWriteAttribute(writer, (xmlChar*) "requires", BAD_CAST str);
+            ret = __comps_xml_attr(writer, "requires", str);
         }
         free(str);
     }
     COMPS_XMLRET_CHECK()
     if (xml_options->bao_explicit) {
         if (pkg->basearchonly) {
-            ret = xmlTextWriterWriteAttribute(writer, (xmlChar*) "basearchonly",
-                                                BAD_CAST "true");
+            ret = __comps_xml_attr(writer, "basearchonly", "true");
         } else {
-            ret = xmlTextWriterWriteAttribute(writer, (xmlChar*) "basearchonly",
-                                                BAD_CAST "false");
+            ret = __comps_xml_attr(writer, "basearchonly", "false");
         }
     } else {
         if (pkg->basearchonly && pkg->basearchonly->val != bao_def) {
-            ret = xmlTextWriterWriteAttribute(writer, (xmlChar*) "basearchonly",
-                                                BAD_CAST "true");
+            ret = __comps_xml_attr(writer, "basearchonly", "true");
         }
     }
     COMPS_XMLRET_CHECK()
     str = comps_object_tostr((COMPS_Object*)pkg->name);
-    ret = xmlTextWriterWriteString(writer, (xmlChar*)str);
+    ret = __comps_xml_text(writer, str);
     free(str);
     COMPS_XMLRET_CHECK()
     ret = xmlTextWriterEndElement(writer);
@@ -225,6 +226,24 @@ static char* comps_docpackage_str_u(COMPS_Object* docpackage) {
     return ret;
 }
 
+/* Arches attribute isn't written for missing or empty list, so both get the
+ * same digest */
+static COMPS_Digest comps_docpackage_digest_u(COMPS_Object *obj) {
+    COMPS_DocGroupPackage *pkg = (COMPS_DocGroupPackage*)obj;
+    COMPS_Digest ret;
+
+    ret = comps_digest_str(COMPS_DIGEST_INIT, "package");
+    ret = comps_digest_u64(ret, comps_object_digest((COMPS_Object*)pkg->name));
+    ret = comps_digest_u64(ret, pkg->type);
+    ret = comps_digest_u64(ret,
+                           comps_object_digest((COMPS_Object*)pkg->requires));
+    ret = comps_digest_u64(ret, pkg->basearchonly && pkg->basearchonly->val);
+    if (pkg->arches && pkg->arches->len)
+        ret = comps_digest_u64(ret,
+                             comps_object_digest((COMPS_Object*)pkg->arches));
+    return comps_digest_finish(ret);
+}
+
 COMPS_ObjList* comps_docpackage_arches(COMPS_DocGroupPackage *pkg) {
     return (COMPS_ObjList*)comps_object_incref((COMPS_Object*)pkg->arches);
 }
@@ -248,5 +267,6 @@ COMPS_ObjectInfo COMPS_DocGroupPackage_ObjInfo = {
     .destructor = &comps_docpackage_destroy_u,
     .copy = &comps_docpackage_copy_u,
     .obj_cmp = &comps_docpackage_cmp_u,
-    .to_str = &comps_docpackage_str_u
+    .to_str = &comps_docpackage_str_u,
+    .digest = &comps_docpackage_digest_u
 };
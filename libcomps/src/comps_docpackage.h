@@ -54,6 +54,8 @@ typedef struct {
 
 signed char comps_docpackage_cmp_u(COMPS_Object *pkg1, COMPS_Object *pkg2);
 char comps_docpackage_cmp_set(void *pkg1, void *pkg2);
+/* name of COMPS_DocGroupPackage without incrementing reference counter */
+COMPS_Object* __comps_docpackage_name_x(COMPS_Object *pkg);
 
 /** COMPS_DocGroupPackage name getter
  * @param pkg COMPS_DocGroupPackage object
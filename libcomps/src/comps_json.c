@@ -0,0 +1,1161 @@
+/* libcomps - C alternative to yum.comps library
+ * Copyright (C) 2013 Jindrich Luza
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to  Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA
+ */
+
+#include "comps_json.h"
+
+#include "comps_elem.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef enum {
+    COMPS_JSON_STR,
+    COMPS_JSON_BOOL,
+    COMPS_JSON_INT
+} COMPS_JSONPropType;
+
+/* JSON key of property stored in properties dictionary under prop key */
+typedef struct {
+    const char *key;
+    const char *prop;
+    COMPS_JSONPropType type;
+} COMPS_JSONProp;
+
+static const COMPS_JSONProp __comps_json_group_props[] = {
+    {"id", "id", COMPS_JSON_STR},
+    {"name", "name", COMPS_JSON_STR},
+    {"desc", "desc", COMPS_JSON_STR},
+    {"default", "def", COMPS_JSON_BOOL},
+    {"uservisible", "uservisible", COMPS_JSON_BOOL},
+    {"biarchonly", "biarchonly", COMPS_JSON_BOOL},
+    {"display_order", "display_order", COMPS_JSON_INT},
+    {"lang_only", "langonly", COMPS_JSON_STR},
+    {NULL, NULL, COMPS_JSON_STR}
+};
+
+/* categories and environments */
+static const COMPS_JSONProp __comps_json_common_props[] = {
+    {"id", "id", COMPS_JSON_STR},
+    {"name", "name", COMPS_JSON_STR},
+    {"desc", "desc", COMPS_JSON_STR},
+    {"display_order", "display_order", COMPS_JSON_INT},
+    {NULL, NULL, COMPS_JSON_STR}
+};
+
+/* Writer */
+
+#define COMPS_JSON_BUFSIZE 8192
+
+typedef struct {
+    COMPS_JSONWriteCallback write_cb;
+    void *ctx;
+    size_t len;
+    char failed;
+    char buf[COMPS_JSON_BUFSIZE];
+} COMPS_JSONWriter;
+
+static void __comps_json_flush(COMPS_JSONWriter *w) {
+    if (w->len && !w->failed && w->write_cb(w->ctx, w->buf, (int)w->len) < 0)
+        w->failed = 1;
+    w->len = 0;
+}
+
+static void __comps_json_raw(COMPS_JSONWriter *w, const char *s, size_t len) {
+    size_t n;
+
+    while (len) {
+        n = COMPS_JSON_BUFSIZE - w->len;
+        if (n > len)
+            n = len;
+        memcpy(w->buf + w->len, s, n);
+        w->len += n;
+        s += n;
+        len -= n;
+        if (w->len == COMPS_JSON_BUFSIZE)
+            __comps_json_flush(w);
+    }
+}
+
+#define __comps_json_lit(w, s) __comps_json_raw(w, s, sizeof(s) - 1)
+
+static void __comps_json_str(COMPS_JSONWriter *w, const char *s) {
+    const char *start;
+    char esc[7];
+
+    __comps_json_lit(w, "\"");
+    for (start = s; *s; s++) {
+        if (*s != '"' && *s != '\\' && (unsigned char)*s >= 0x20)
+            continue;
+        __comps_json_raw(w, start, s - start);
+        start = s + 1;
+        switch (*s) {
+            case '"': __comps_json_lit(w, "\\\""); break;
+            case '\\': __comps_json_lit(w, "\\\\"); break;
+            case '\n': __comps_json_lit(w, "\\n"); break;
+            case '\r': __comps_json_lit(w, "\\r"); break;
+            case '\t': __comps_json_lit(w, "\\t"); break;
+            default:
+                sprintf(esc, "\\u%04x", (unsigned char)*s);
+                __comps_json_raw(w, esc, 6);
+        }
+    }
+    __comps_json_raw(w, start, s - start);
+    __comps_json_lit(w, "\"");
+}
+
+static void __comps_json_obj_str(COMPS_JSONWriter *w, COMPS_Object *obj) {
+    char *str;
+
+    if (obj->obj_info == &COMPS_Str_ObjInfo && ((COMPS_Str*)obj)->val) {
+        __comps_json_str(w, ((COMPS_Str*)obj)->val);
+    } else {
+        str = comps_object_tostr(obj);
+        __comps_json_str(w, str);
+        free(str);
+    }
+}
+
+/* Write key of next member, *first tracks whether comma is needed */
+static void __comps_json_key(COMPS_JSONWriter *w, char *first,
+                             const char *key) {
+    if (!*first)
+        __comps_json_lit(w, ",");
+    *first = 0;
+    __comps_json_str(w, key);
+    __comps_json_lit(w, ":");
+}
+
+static void __comps_json_write_bool(COMPS_JSONWriter *w, int val) {
+    if (val)
+        __comps_json_lit(w, "true");
+    else
+        __comps_json_lit(w, "false");
+}
+
+static void __comps_json_write_props(COMPS_JSONWriter *w, char *first,
+                               COMPS_ObjDict *props,
+                               const COMPS_JSONProp *table) {
+    COMPS_Object *obj;
+    char num[24];
+
+    for (; table->key; table++) {
+        obj = comps_objdict_get_x(props, table->prop);
+        if (obj == NULL)
+            continue;
+        __comps_json_key(w, first, table->key);
+        if (table->type == COMPS_JSON_STR
+            || obj->obj_info != &COMPS_Num_ObjInfo) {
+            __comps_json_obj_str(w, obj);
+        } else if (table->type == COMPS_JSON_BOOL) {
+            __comps_json_write_bool(w, ((COMPS_Num*)obj)->val);
+        } else {
+            sprintf(num, "%d", ((COMPS_Num*)obj)->val);
+            __comps_json_raw(w, num, strlen(num));
+        }
+    }
+}
+
+/* Member with object of strings, omitted if dict is empty unless always
+ * is set */
+static void __comps_json_strdict(COMPS_JSONWriter *w, char *first,
+                                 const char *key, COMPS_ObjDict *dict,
+                                 char always) {
+    COMPS_HSList *pairs;
+    COMPS_HSListItem *it;
+    char inner = 1;
+
+    if ((dict == NULL || dict->len == 0) && !always)
+        return;
+    __comps_json_key(w, first, key);
+    __comps_json_lit(w, "{");
+    if (dict != NULL) {
+        pairs = comps_objdict_pairs(dict);
+        for (it = pairs->first; it != NULL; it = it->next) {
+            __comps_json_key(w, &inner, ((COMPS_ObjRTreePair*)it->data)->key);
+            __comps_json_obj_str(w, ((COMPS_ObjRTreePair*)it->data)->data);
+        }
+        comps_hslist_destroy(&pairs);
+    }
+    __comps_json_lit(w, "}");
+}
+
+/* Member with array of strings, omitted if list is empty */
+static void __comps_json_strlist(COMPS_JSONWriter *w, char *first,
+                                 const char *key, COMPS_ObjList *list) {
+    COMPS_ObjListIt *it;
+
+    if (list == NULL || list->len == 0)
+        return;
+    __comps_json_key(w, first, key);
+    __comps_json_lit(w, "[");
+    for (it = list->first; it != NULL; it = it->next) {
+        __comps_json_obj_str(w, it->comps_obj);
+        if (it->next)
+            __comps_json_lit(w, ",");
+    }
+    __comps_json_lit(w, "]");
+}
+
+static void __comps_json_common(COMPS_JSONWriter *w, char *first,
+                                COMPS_ObjDict *props,
+                                COMPS_ObjDict *name_by_lang,
+                                COMPS_ObjDict *desc_by_lang,
+                                const COMPS_JSONProp *table) {
+    __comps_json_write_props(w, first, props, table);
+    __comps_json_strdict(w, first, "name_by_lang", name_by_lang, 0);
+    __comps_json_strdict(w, first, "desc_by_lang", desc_by_lang, 0);
+    __comps_json_strlist(w, first, "arches",
+                         (COMPS_ObjList*)comps_objdict_get_x(props, "arches"));
+}
+
+static void __comps_json_package(COMPS_JSONWriter *w,
+                                 COMPS_DocGroupPackage *pkg) {
+    const char *type;
+    char first = 1;
+
+    __comps_json_lit(w, "{");
+    if (pkg->name) {
+        __comps_json_key(w, &first, "name");
+        __comps_json_obj_str(w, (COMPS_Object*)pkg->name);
+    }
+    __comps_json_key(w, &first, "type");
+    type = comps_docpackage_type_str(pkg->type);
+    __comps_json_str(w, type);
+    if (pkg->requires) {
+        __comps_json_key(w, &first, "requires");
+        __comps_json_obj_str(w, (COMPS_Object*)pkg->requires);
+    }
+    if (pkg->basearchonly) {
+        __comps_json_key(w, &first, "basearchonly");
+        __comps_json_write_bool(w, pkg->basearchonly->val);
+    }
+    __comps_json_strlist(w, &first, "arches", pkg->arches);
+    __comps_json_lit(w, "}");
+}
+
+static void __comps_json_groupid(COMPS_JSONWriter *w, COMPS_DocGroupId *gid) {
+    char first = 1;
+
+    __comps_json_lit(w, "{");
+    if (gid->name) {
+        __comps_json_key(w, &first, "name");
+        __comps_json_obj_str(w, (COMPS_Object*)gid->name);
+    }
+    if (gid->def) {
+        __comps_json_key(w, &first, "default");
+        __comps_json_lit(w, "true");
+    }
+    __comps_json_strlist(w, &first, "arches", gid->arches);
+    __comps_json_lit(w, "}");
+}
+
+/* Member with array of objects, always written */
+static void __comps_json_objlist(COMPS_JSONWriter *w, char *first,
+                                 const char *key, COMPS_ObjList *list,
+                                 void (*write_f)(COMPS_JSONWriter*,
+                                                 COMPS_Object*)) {
+    COMPS_ObjListIt *it;
+
+    __comps_json_key(w, first, key);
+    __comps_json_lit(w, "[");
+    for (it = list ? list->first : NULL; it != NULL; it = it->next) {
+        write_f(w, it->comps_obj);
+        if (it->next)
+            __comps_json_lit(w, ",");
+    }
+    __comps_json_lit(w, "]");
+}
+
+static void __comps_json_package_obj(COMPS_JSONWriter *w, COMPS_Object *obj) {
+    __comps_json_package(w, (COMPS_DocGroupPackage*)obj);
+}
+
+static void __comps_json_groupid_obj(COMPS_JSONWriter *w, COMPS_Object *obj) {
+    __comps_json_groupid(w, (COMPS_DocGroupId*)obj);
+}
+
+static void __comps_json_group(COMPS_JSONWriter *w, COMPS_Object *obj) {
+    COMPS_DocGroup *group = (COMPS_DocGroup*)obj;
+    char first = 1;
+
+    __comps_json_lit(w, "{");
+    __comps_json_common(w, &first, group->properties, group->name_by_lang,
+                        group->desc_by_lang, __comps_json_group_props);
+    __comps_json_objlist(w, &first, "packages", group->packages,
+                         &__comps_json_package_obj);
+    __comps_json_lit(w, "}");
+}
+
+static void __comps_json_category(COMPS_JSONWriter *w, COMPS_Object *obj) {
+    COMPS_DocCategory *cat = (COMPS_DocCategory*)obj;
+    char first = 1;
+
+    __comps_json_lit(w, "{");
+    __comps_json_common(w, &first, cat->properties, cat->name_by_lang,
+                        cat->desc_by_lang, __comps_json_common_props);
+    __comps_json_objlist(w, &first, "group_ids", cat->group_ids,
+                         &__comps_json_groupid_obj);
+    __comps_json_lit(w, "}");
+}
+
+static void __comps_json_env(COMPS_JSONWriter *w, COMPS_Object *obj) {
+    COMPS_DocEnv *env = (COMPS_DocEnv*)obj;
+    char first = 1;
+
+    __comps_json_lit(w, "{");
+    __comps_json_common(w, &first, env->properties, env->name_by_lang,
+                        env->desc_by_lang, __comps_json_common_props);
+    __comps_json_objlist(w, &first, "group_ids", env->group_list,
+                         &__comps_json_groupid_obj);
+    __comps_json_objlist(w, &first, "option_ids", env->option_list,
+                         &__comps_json_groupid_obj);
+    __comps_json_lit(w, "}");
+}
+
+/* blacklist and whiteout, every value of multidict is separate object and
+ * unset value is omitted */
+static void __comps_json_mdict(COMPS_JSONWriter *w, char *first,
+                               const char *key, COMPS_ObjMDict *mdict,
+                               const char *key_name, const char *val_name) {
+    COMPS_HSList *pairs;
+    COMPS_HSListItem *hsit;
+    COMPS_ObjListIt *it;
+    char inner, sep = 0;
+
+    __comps_json_key(w, first, key);
+    __comps_json_lit(w, "[");
+    pairs = comps_objmrtree_pairs(mdict);
+    for (hsit = pairs->first; hsit != NULL; hsit = hsit->next) {
+        for (it = ((COMPS_ObjMRTreePair*)hsit->data)->data->first;
+             it != NULL; it = it->next) {
+            if (sep)
+                __comps_json_lit(w, ",");
+            sep = 1;
+            inner = 1;
+            __comps_json_lit(w, "{");
+            __comps_json_key(w, &inner, key_name);
+            __comps_json_str(w, ((COMPS_ObjMRTreePair*)hsit->data)->key);
+            if (((COMPS_Str*)it->comps_obj)->val) {
+                __comps_json_key(w, &inner, val_name);
+                __comps_json_obj_str(w, it->comps_obj);
+            }
+            __comps_json_lit(w, "}");
+        }
+    }
+    comps_hslist_destroy(&pairs);
+    __comps_json_lit(w, "]");
+}
+
+signed char comps2json_cb(COMPS_Doc *doc, COMPS_JSONWriteCallback write_cb,
+                          void *ctx) {
+    COMPS_JSONWriter *w;
+    COMPS_ObjList *list;
+    COMPS_ObjDict *dict;
+    COMPS_ObjMDict *mdict;
+    char first = 1;
+    signed char ret;
+
+    if ((w = malloc(sizeof(*w))) == NULL)
+        return -1;
+    w->write_cb = write_cb;
+    w->ctx = ctx;
+    w->len = 0;
+    w->failed = 0;
+
+    __comps_json_lit(w, "{");
+    list = comps_doc_groups(doc);
+    __comps_json_objlist(w, &first, "groups", list, &__comps_json_group);
+    COMPS_OBJECT_DESTROY(list);
+    list = comps_doc_categories(doc);
+    __comps_json_objlist(w, &first, "categories", list,
+                         &__comps_json_category);
+    COMPS_OBJECT_DESTROY(list);
+    list = comps_doc_environments(doc);
+    __comps_json_objlist(w, &first, "environments", list, &__comps_json_env);
+    COMPS_OBJECT_DESTROY(list);
+
+    dict = comps_doc_langpacks(doc);
+    __comps_json_strdict(w, &first, "langpacks", dict, 1);
+    COMPS_OBJECT_DESTROY(dict);
+
+    mdict = comps_doc_blacklist(doc);
+    __comps_json_mdict(w, &first, "blacklist", mdict, "name", "arch");
+    COMPS_OBJECT_DESTROY(mdict);
+    mdict = comps_doc_whiteout(doc);
+    __comps_json_mdict(w, &first, "whiteout", mdict, "requires", "package");
+    COMPS_OBJECT_DESTROY(mdict);
+    __comps_json_lit(w, "}");
+    __comps_json_flush(w);
+
+    ret = w->failed ? -1 : 0;
+    free(w);
+    return ret;
+}
+
+typedef struct {
+    char *str;
+    size_t len;
+    size_t size;
+} COMPS_JSONStrSink;
+
+static int __comps2json_str_write(void *ctx, const char *buffer, int len) {
+    COMPS_JSONStrSink *sink = ctx;
+    size_t size;
+    char *tmp;
+
+    if (sink->len + len + 1 > sink->size) {
+        for (size = sink->size ? sink->size : 4096;
+             size < sink->len + len + 1; size *= 2);
+        if ((tmp = realloc(sink->str, size)) == NULL)
+            return -1;
+        sink->str = tmp;
+        sink->size = size;
+    }
+    memcpy(sink->str + sink->len, buffer, len);
+    sink->len += len;
+    sink->str[sink->len] = 0;
+    return len;
+}
+
+char* comps2json_str(COMPS_Doc *doc) {
+    COMPS_JSONStrSink sink = {NULL, 0, 0};
+
+    if (comps2json_cb(doc, &__comps2json_str_write, &sink) == -1) {
+        comps_log_error(doc->log, COMPS_ERR_MALLOC, 0);
+        free(sink.str);
+        return NULL;
+    }
+    return sink.str;
+}
+
+static int __comps2json_fd_write(void *ctx, const char *buffer, int len) {
+    int fd = *(int*)ctx;
+    ssize_t written;
+    int left;
+
+    for (left = len; left > 0; buffer += written, left -= written) {
+        written = write(fd, buffer, left);
+        if (written < 0)
+            return -1;
+    }
+    return len;
+}
+
+signed char comps2json_f(COMPS_Doc *doc, char *filename) {
+    signed char genret = -1;
+    int fd;
+
+    fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd >= 0) {
+        genret = comps2json_cb(doc, &__comps2json_fd_write, &fd);
+        if (close(fd) < 0)
+            genret = -1;
+    }
+    if (genret == -1)
+        comps_log_error_x(doc->log, COMPS_ERR_WRITEF,
+                          1, comps_str(filename));
+    return genret;
+}
+
+/* Parser */
+
+/* nesting limit of skipped values */
+#define COMPS_JSON_MAXDEPTH 512
+
+typedef struct {
+    const char *cur;
+    const char *end;
+    const char *line_start;
+    int line;
+    COMPS_Log *log;
+    char fatal;
+} COMPS_JSONParser;
+
+/* Log fatal error at current position, only first error is logged */
+static void __comps_json_error(COMPS_JSONParser *p, const char *msg) {
+    if (p->fatal)
+        return;
+    p->fatal = 1;
+    comps_log_error_x(p->log, COMPS_ERR_PARSER, 3, comps_num(p->line),
+                      comps_num((int)(p->cur - p->line_start) + 1),
+                      comps_str(msg));
+}
+
+/* Skip whitespace and return next character, 0 at end of input */
+static char __comps_json_peek(COMPS_JSONParser *p) {
+    for (; p->cur < p->end; p->cur++) {
+        if (*p->cur == '\n') {
+            p->line++;
+            p->line_start = p->cur + 1;
+        } else if (*p->cur != ' ' && *p->cur != '\t' && *p->cur != '\r') {
+            return *p->cur;
+        }
+    }
+    return 0;
+}
+
+static int __comps_json_expect(COMPS_JSONParser *p, char c) {
+    char msg[] = "expected ' '";
+
+    if (__comps_json_peek(p) == c) {
+        p->cur++;
+        return 0;
+    }
+    msg[10] = c;
+    __comps_json_error(p, msg);
+    return -1;
+}
+
+/* Consume literal if it's next in input */
+static int __comps_json_literal(COMPS_JSONParser *p, const char *lit) {
+    size_t len = strlen(lit);
+
+    if (__comps_json_peek(p) != *lit || (size_t)(p->end - p->cur) < len
+        || memcmp(p->cur, lit, len) != 0)
+        return 0;
+    p->cur += len;
+    return 1;
+}
+
+static int __comps_json_hex4(COMPS_JSONParser *p, unsigned *val) {
+    int i;
+    char c;
+
+    if (p->end - p->cur < 4) {
+        __comps_json_error(p, "invalid \\u escape");
+        return -1;
+    }
+    for (*val = 0, i = 0; i < 4; i++) {
+        c = *p->cur++;
+        *val <<= 4;
+        if (c >= '0' && c <= '9')
+            *val |= c - '0';
+        else if (c >= 'a' && c <= 'f')
+            *val |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            *val |= c - 'A' + 10;
+        else {
+            __comps_json_error(p, "invalid \\u escape");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* Decode hex digits of unicode escape (with following low surrogate if
+ * needed) as UTF-8 into out, return number of bytes written or -1 */
+static int __comps_json_unicode(COMPS_JSONParser *p, char *out) {
+    unsigned cp, low;
+
+    if (__comps_json_hex4(p, &cp) < 0)
+        return -1;
+    if (cp >= 0xd800 && cp < 0xdc00) {
+        if (!__comps_json_literal(p, "\\u") || __comps_json_hex4(p, &low) < 0
+            || low < 0xdc00 || low >= 0xe000) {
+            __comps_json_error(p, "invalid surrogate pair");
+            return -1;
+        }
+        cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+    } else if (cp >= 0xdc00 && cp < 0xe000) {
+        __comps_json_error(p, "invalid surrogate pair");
+        return -1;
+    } else if (cp == 0) {
+        /* strings are NUL terminated, value would be silently truncated */
+        __comps_json_error(p, "NUL character in string");
+        return -1;
+    }
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    } else if (cp < 0x800) {
+        out[0] = (char)(0xc0 | cp >> 6);
+        out[1] = (char)(0x80 | (cp & 0x3f));
+        return 2;
+    } else if (cp < 0x10000) {
+        out[0] = (char)(0xe0 | cp >> 12);
+        out[1] = (char)(0x80 | (cp >> 6 & 0x3f));
+        out[2] = (char)(0x80 | (cp & 0x3f));
+        return 3;
+    }
+    out[0] = (char)(0xf0 | cp >> 18);
+    out[1] = (char)(0x80 | (cp >> 12 & 0x3f));
+    out[2] = (char)(0x80 | (cp >> 6 & 0x3f));
+    out[3] = (char)(0x80 | (cp & 0x3f));
+    return 4;
+}
+
+/* Parse string, return newly allocated decoded string or NULL on error.
+ * Decoded string is never longer than its JSON representation. */
+static char* __comps_json_string(COMPS_JSONParser *p) {
+    const char *start;
+    char *ret, *out;
+    int n;
+
+    if (__comps_json_peek(p) != '"') {
+        __comps_json_error(p, "expected string");
+        return NULL;
+    }
+    p->cur++;
+    for (start = p->cur; start < p->end && *start != '"'; start++) {
+        if (*start == '\\' && start + 1 < p->end)
+            start++;
+    }
+    if (start == p->end) {
+        __comps_json_error(p, "unterminated string");
+        return NULL;
+    }
+    if ((ret = malloc(start - p->cur + 1)) == NULL) {
+        comps_log_error(p->log, COMPS_ERR_MALLOC, 0);
+        p->fatal = 1;
+        return NULL;
+    }
+    for (out = ret; *p->cur != '"'; ) {
+        if ((unsigned char)*p->cur < 0x20) {
+            __comps_json_error(p, "control character in string");
+            break;
+        } else if (*p->cur != '\\') {
+            *out++ = *p->cur++;
+            continue;
+        }
+        p->cur++;
+        switch (*p->cur++) {
+            case '"': *out++ = '"'; break;
+            case '\\': *out++ = '\\'; break;
+            case '/': *out++ = '/'; break;
+            case 'b': *out++ = '\b'; break;
+            case 'f': *out++ = '\f'; break;
+            case 'n': *out++ = '\n'; break;
+            case 'r': *out++ = '\r'; break;
+            case 't': *out++ = '\t'; break;
+            case 'u':
+                if ((n = __comps_json_unicode(p, out)) > 0)
+                    out += n;
+                break;
+            default:
+                p->cur--;
+                __comps_json_error(p, "invalid escape");
+        }
+        if (p->fatal)
+            break;
+    }
+    if (p->fatal) {
+        free(ret);
+        return NULL;
+    }
+    *out = 0;
+    p->cur++;
+    return ret;
+}
+
+static int __comps_json_bool(COMPS_JSONParser *p, int *val) {
+    if (__comps_json_literal(p, "true"))
+        *val = 1;
+    else if (__comps_json_literal(p, "false"))
+        *val = 0;
+    else {
+        __comps_json_error(p, "expected boolean");
+        return -1;
+    }
+    return 0;
+}
+
+static int __comps_json_int(COMPS_JSONParser *p, int *val) {
+    long num = 0;
+    int neg = 0;
+
+    if (__comps_json_peek(p) == '-') {
+        neg = 1;
+        p->cur++;
+    }
+    if (p->cur == p->end || *p->cur < '0' || *p->cur > '9') {
+        __comps_json_error(p, "expected integer");
+        return -1;
+    }
+    for (; p->cur < p->end && *p->cur >= '0' && *p->cur <= '9'; p->cur++) {
+        num = num * 10 + (*p->cur - '0');
+        if (num > INT_MAX) {
+            __comps_json_error(p, "integer out of range");
+            return -1;
+        }
+    }
+    if (p->cur < p->end
+        && (*p->cur == '.' || *p->cur == 'e' || *p->cur == 'E')) {
+        __comps_json_error(p, "expected integer");
+        return -1;
+    }
+    *val = neg ? -(int)num : (int)num;
+    return 0;
+}
+
+/* Iterate over members of object. Opens object on first call (*first set),
+ * returns 1 with newly allocated key of next member, 0 at the end of
+ * object and -1 on error */
+static int __comps_json_member(COMPS_JSONParser *p, char *first,
+                               char **key) {
+    if (*first) {
+        if (__comps_json_expect(p, '{') < 0)
+            return -1;
+    }
+    if (__comps_json_peek(p) == '}') {
+        p->cur++;
+        return 0;
+    }
+    if (!*first && __comps_json_expect(p, ',') < 0)
+        return -1;
+    *first = 0;
+    if ((*key = __comps_json_string(p)) == NULL)
+        return -1;
+    if (__comps_json_expect(p, ':') < 0) {
+        free(*key);
+        return -1;
+    }
+    return 1;
+}
+
+/* Iterate over elements of array, same as __comps_json_member */
+static int __comps_json_element(COMPS_JSONParser *p, char *first) {
+    if (*first) {
+        if (__comps_json_expect(p, '[') < 0)
+            return -1;
+    }
+    if (__comps_json_peek(p) == ']') {
+        p->cur++;
+        return 0;
+    }
+    if (!*first && __comps_json_expect(p, ',') < 0)
+        return -1;
+    *first = 0;
+    return 1;
+}
+
+static void __comps_json_skip(COMPS_JSONParser *p, int depth) {
+    char first = 1;
+    char *key;
+    char c;
+
+    if (depth > COMPS_JSON_MAXDEPTH) {
+        __comps_json_error(p, "nesting too deep");
+        return;
+    }
+    c = __comps_json_peek(p);
+    if (c == '{') {
+        while (__comps_json_member(p, &first, &key) == 1) {
+            free(key);
+            __comps_json_skip(p, depth + 1);
+            if (p->fatal)
+                return;
+        }
+    } else if (c == '[') {
+        while (__comps_json_element(p, &first) == 1) {
+            __comps_json_skip(p, depth + 1);
+            if (p->fatal)
+                return;
+        }
+    } else if (c == '"') {
+        free(__comps_json_string(p));
+    } else if (c == '-' || (c >= '0' && c <= '9')) {
+        for (p->cur++; p->cur < p->end && *p->cur
+                       && strchr("0123456789.eE+-", *p->cur); p->cur++);
+    } else if (!__comps_json_literal(p, "true")
+               && !__comps_json_literal(p, "false")
+               && !__comps_json_literal(p, "null")) {
+        __comps_json_error(p, "expected value");
+    }
+}
+
+/* Warn about unknown key and skip its value */
+static void __comps_json_unknown(COMPS_JSONParser *p, char *key) {
+    comps_log_warning_x(p->log, COMPS_ERR_ELEM_UNKNOWN, 2, comps_str(key),
+                        comps_num(p->line));
+    __comps_json_skip(p, 0);
+}
+
+static void __comps_json_parse_strdict(COMPS_JSONParser *p,
+                                       COMPS_ObjDict *dict) {
+    char first = 1;
+    char *key, *val;
+
+    while (__comps_json_member(p, &first, &key) == 1) {
+        if (!__comps_json_literal(p, "null")) {
+            if ((val = __comps_json_string(p)) != NULL)
+                comps_objdict_set_x(dict, key, (COMPS_Object*)comps_str_x(val));
+        }
+        free(key);
+        if (p->fatal)
+            return;
+    }
+}
+
+static COMPS_ObjList* __comps_json_parse_strlist(COMPS_JSONParser *p) {
+    COMPS_ObjList *list = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+    char first = 1;
+    char *val;
+
+    while (__comps_json_element(p, &first) == 1) {
+        if ((val = __comps_json_string(p)) == NULL)
+            break;
+        comps_objlist_append_x(list, (COMPS_Object*)comps_str_x(val));
+    }
+    return list;
+}
+
+/* Parse value of key if it's in table of properties, return 0 if it isn't */
+static int __comps_json_parse_prop(COMPS_JSONParser *p, const char *key,
+                                   COMPS_ObjDict *props,
+                                   const COMPS_JSONProp *table) {
+    char *str;
+    int val;
+
+    for (; table->key; table++) {
+        if (strcmp(table->key, key) == 0)
+            break;
+    }
+    if (table->key == NULL)
+        return 0;
+    if (table->type == COMPS_JSON_STR) {
+        if ((str = __comps_json_string(p)) != NULL)
+            comps_objdict_set_x(props, (char*)table->prop,
+                                (COMPS_Object*)comps_str_x(str));
+    } else if ((table->type == COMPS_JSON_BOOL ? __comps_json_bool(p, &val)
+                                               : __comps_json_int(p, &val))
+               == 0) {
+        comps_objdict_set_x(props, (char*)table->prop,
+                            (COMPS_Object*)comps_num(val));
+    }
+    return 1;
+}
+
+/* Parse members shared by groups, categories and environments, return 0 if
+ * key isn't one of them */
+static int __comps_json_parse_common(COMPS_JSONParser *p, const char *key,
+                                     COMPS_ObjDict *props,
+                                     COMPS_ObjDict *name_by_lang,
+                                     COMPS_ObjDict *desc_by_lang,
+                                     const COMPS_JSONProp *table) {
+    if (strcmp(key, "name_by_lang") == 0)
+        __comps_json_parse_strdict(p, name_by_lang);
+    else if (strcmp(key, "desc_by_lang") == 0)
+        __comps_json_parse_strdict(p, desc_by_lang);
+    else if (strcmp(key, "arches") == 0)
+        comps_objdict_set_x(props, "arches",
+                            (COMPS_Object*)__comps_json_parse_strlist(p));
+    else
+        return __comps_json_parse_prop(p, key, props, table);
+    return 1;
+}
+
+static COMPS_DocGroupPackage* __comps_json_parse_package(
+                                                    COMPS_JSONParser *p) {
+    COMPS_DocGroupPackage *pkg;
+    char first = 1;
+    char *key, *str;
+    int val, line;
+
+    pkg = COMPS_OBJECT_CREATE(COMPS_DocGroupPackage, NULL);
+    while (__comps_json_member(p, &first, &key) == 1) {
+        if (__comps_json_literal(p, "null")) {
+        } else if (strcmp(key, "name") == 0
+                   || strcmp(key, "requires") == 0) {
+            if ((str = __comps_json_string(p)) != NULL) {
+                if (key[0] == 'n')
+                    comps_docpackage_set_name(pkg, str, 0);
+                else
+                    comps_docpackage_set_requires(pkg, str, 0);
+                free(str);
+            }
+        } else if (strcmp(key, "type") == 0) {
+            line = p->line;
+            val = (int)(p->cur - p->line_start) + 1;
+            if ((str = __comps_json_string(p)) != NULL) {
+                pkg->type = comps_package_get_type(str);
+                if (pkg->type == COMPS_PACKAGE_UNKNOWN)
+                    comps_log_warning_x(p->log, COMPS_ERR_PACKAGE_UNKNOWN, 3,
+                                        comps_str_x(str), comps_num(line),
+                                        comps_num(val));
+                else
+                    free(str);
+            }
+        } else if (strcmp(key, "basearchonly") == 0) {
+            if (__comps_json_bool(p, &val) == 0)
+                comps_docpackage_set_basearchonly(pkg, val, false);
+        } else if (strcmp(key, "arches") == 0) {
+            comps_docpackage_set_arches(pkg, __comps_json_parse_strlist(p));
+        } else {
+            __comps_json_unknown(p, key);
+        }
+        free(key);
+        if (p->fatal)
+            break;
+    }
+    return pkg;
+}
+
+static COMPS_DocGroupId* __comps_json_parse_groupid(COMPS_JSONParser *p) {
+    COMPS_DocGroupId *gid;
+    char first = 1;
+    char *key, *str;
+    int val;
+
+    gid = COMPS_OBJECT_CREATE(COMPS_DocGroupId, NULL);
+    while (__comps_json_member(p, &first, &key) == 1) {
+        if (__comps_json_literal(p, "null")) {
+        } else if (strcmp(key, "name") == 0) {
+            if ((str = __comps_json_string(p)) != NULL) {
+                comps_docgroupid_set_name(gid, str, 0);
+                free(str);
+            }
+        } else if (strcmp(key, "default") == 0) {
+            if (__comps_json_bool(p, &val) == 0)
+                comps_docgroupid_set_default(gid, val);
+        } else if (strcmp(key, "arches") == 0) {
+            comps_docgroupid_set_arches(gid, __comps_json_parse_strlist(p));
+        } else {
+            __comps_json_unknown(p, key);
+        }
+        free(key);
+        if (p->fatal)
+            break;
+    }
+    return gid;
+}
+
+/* Parse array of group ids, add_f takes ownership of parsed group id */
+static void __comps_json_parse_groupids(COMPS_JSONParser *p, void *obj,
+                                        void (*add_f)(void*,
+                                                      COMPS_DocGroupId*)) {
+    char first = 1;
+
+    while (__comps_json_element(p, &first) == 1) {
+        if (__comps_json_literal(p, "null"))
+            continue;
+        add_f(obj, __comps_json_parse_groupid(p));
+        if (p->fatal)
+            return;
+    }
+}
+
+static void __comps_json_category_add(void *cat, COMPS_DocGroupId *gid) {
+    comps_doccategory_add_groupid((COMPS_DocCategory*)cat, gid);
+}
+
+static void __comps_json_env_add(void *env, COMPS_DocGroupId *gid) {
+    comps_docenv_add_groupid((COMPS_DocEnv*)env, gid);
+}
+
+static void __comps_json_env_add_option(void *env, COMPS_DocGroupId *gid) {
+    comps_docenv_add_optionid((COMPS_DocEnv*)env, gid);
+}
+
+static void __comps_json_parse_group(COMPS_JSONParser *p, COMPS_Doc *doc) {
+    COMPS_DocGroup *group;
+    char first = 1, pfirst;
+    char *key;
+
+    group = COMPS_OBJECT_CREATE(COMPS_DocGroup, NULL);
+    comps_doc_add_group(doc, group);
+    while (__comps_json_member(p, &first, &key) == 1) {
+        if (__comps_json_literal(p, "null")) {
+        } else if (strcmp(key, "packages") == 0) {
+            pfirst = 1;
+            while (__comps_json_element(p, &pfirst) == 1) {
+                if (__comps_json_literal(p, "null"))
+                    continue;
+                comps_docgroup_add_package(group,
+                                           __comps_json_parse_package(p));
+                if (p->fatal)
+                    break;
+            }
+        } else if (!__comps_json_parse_common(p, key, group->properties,
+                                              group->name_by_lang,
+                                              group->desc_by_lang,
+                                              __comps_json_group_props)) {
+            __comps_json_unknown(p, key);
+        }
+        free(key);
+        if (p->fatal)
+            return;
+    }
+}
+
+static void __comps_json_parse_category(COMPS_JSONParser *p,
+                                        COMPS_Doc *doc) {
+    COMPS_DocCategory *cat;
+    char first = 1;
+    char *key;
+
+    cat = COMPS_OBJECT_CREATE(COMPS_DocCategory, NULL);
+    comps_doc_add_category(doc, cat);
+    while (__comps_json_member(p, &first, &key) == 1) {
+        if (__comps_json_literal(p, "null")) {
+        } else if (strcmp(key, "group_ids") == 0) {
+            __comps_json_parse_groupids(p, cat, &__comps_json_category_add);
+        } else if (!__comps_json_parse_common(p, key, cat->properties,
+                                              cat->name_by_lang,
+                                              cat->desc_by_lang,
+                                              __comps_json_common_props)) {
+            __comps_json_unknown(p, key);
+        }
+        free(key);
+        if (p->fatal)
+            return;
+    }
+}
+
+static void __comps_json_parse_env(COMPS_JSONParser *p, COMPS_Doc *doc) {
+    COMPS_DocEnv *env;
+    char first = 1;
+    char *key;
+
+    env = COMPS_OBJECT_CREATE(COMPS_DocEnv, NULL);
+    comps_doc_add_environment(doc, env);
+    while (__comps_json_member(p, &first, &key) == 1) {
+        if (__comps_json_literal(p, "null")) {
+        } else if (strcmp(key, "group_ids") == 0) {
+            __comps_json_parse_groupids(p, env, &__comps_json_env_add);
+        } else if (strcmp(key, "option_ids") == 0) {
+            __comps_json_parse_groupids(p, env, &__comps_json_env_add_option);
+        } else if (!__comps_json_parse_common(p, key, env->properties,
+                                              env->name_by_lang,
+                                              env->desc_by_lang,
+                                              __comps_json_common_props)) {
+            __comps_json_unknown(p, key);
+        }
+        free(key);
+        if (p->fatal)
+            return;
+    }
+}
+
+/* Parse array of objects of top level section */
+static void __comps_json_parse_list(COMPS_JSONParser *p, COMPS_Doc *doc,
+                                    void (*parse_f)(COMPS_JSONParser*,
+                                                    COMPS_Doc*)) {
+    char first = 1;
+
+    while (__comps_json_element(p, &first) == 1) {
+        if (__comps_json_literal(p, "null"))
+            continue;
+        parse_f(p, doc);
+        if (p->fatal)
+            return;
+    }
+}
+
+/* Parse blacklist or whiteout, array of objects with two string members,
+ * the first one is required */
+static void __comps_json_parse_mdict(COMPS_JSONParser *p, COMPS_Doc *doc,
+                                     const char *key_name,
+                                     const char *val_name,
+                                     void (*add_f)(COMPS_Doc*, char*,
+                                                   COMPS_Str*)) {
+    char first = 1, ifirst;
+    char *key, *name, *val;
+
+    while (__comps_json_element(p, &first) == 1) {
+        if (__comps_json_literal(p, "null"))
+            continue;
+        ifirst = 1;
+        name = val = NULL;
+        while (__comps_json_member(p, &ifirst, &key) == 1) {
+            if (__comps_json_literal(p, "null")) {
+            } else if (strcmp(key, key_name) == 0) {
+                free(name);
+                name = __comps_json_string(p);
+            } else if (strcmp(key, val_name) == 0) {
+                free(val);
+                val = __comps_json_string(p);
+            } else {
+                __comps_json_unknown(p, key);
+            }
+            free(key);
+            if (p->fatal)
+                break;
+        }
+        if (name && !p->fatal)
+            add_f(doc, name, comps_str_x(val));
+        else
+            free(val);
+        free(name);
+        if (p->fatal)
+            return;
+    }
+}
+
+signed char comps_parse_json(COMPS_Parsed *parsed, const char *str,
+                             size_t len) {
+    COMPS_JSONParser p;
+    COMPS_Object *enc;
+    COMPS_ObjDict *langpacks;
+    char first = 1;
+    char *key;
+
+    p.cur = p.line_start = str;
+    p.end = str + len;
+    p.line = 1;
+    p.log = parsed->log;
+    p.fatal = 0;
+
+    COMPS_OBJECT_DESTROY(parsed->comps_doc);
+    enc = (COMPS_Object*)comps_str("UTF-8");
+    parsed->comps_doc = COMPS_OBJECT_CREATE(COMPS_Doc, (COMPS_Object*[]){enc});
+    COMPS_OBJECT_DESTROY(enc);
+
+    while (__comps_json_member(&p, &first, &key) == 1) {
+        if (__comps_json_literal(&p, "null")) {
+        } else if (strcmp(key, "groups") == 0) {
+            __comps_json_parse_list(&p, parsed->comps_doc,
+                                    &__comps_json_parse_group);
+        } else if (strcmp(key, "categories") == 0) {
+            __comps_json_parse_list(&p, parsed->comps_doc,
+                                    &__comps_json_parse_category);
+        } else if (strcmp(key, "environments") == 0) {
+            __comps_json_parse_list(&p, parsed->comps_doc,
+                                    &__comps_json_parse_env);
+        } else if (strcmp(key, "langpacks") == 0) {
+            langpacks = comps_doc_langpacks(parsed->comps_doc);
+            __comps_json_parse_strdict(&p, langpacks);
+            COMPS_OBJECT_DESTROY(langpacks);
+        } else if (strcmp(key, "blacklist") == 0) {
+            __comps_json_parse_mdict(&p, parsed->comps_doc, "name", "arch",
+                                     &comps_doc_add_blacklist);
+        } else if (strcmp(key, "whiteout") == 0) {
+            __comps_json_parse_mdict(&p, parsed->comps_doc, "requires",
+                                     "package", &comps_doc_add_whiteout);
+        } else {
+            __comps_json_unknown(&p, key);
+        }
+        free(key);
+        if (p.fatal)
+            break;
+    }
+    if (!p.fatal && __comps_json_peek(&p) != 0)
+        __comps_json_error(&p, "trailing characters after document");
+    if (p.fatal)
+        parsed->fatal_error = 1;
+
+    if (parsed->fatal_error == 0 && parsed->log->entries->first == NULL)
+        return 0;
+    else if (parsed->fatal_error != 1)
+        return 1;
+    else
+        return -1;
+}
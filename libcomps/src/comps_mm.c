@@ -31,13 +31,25 @@ COMPS_RefC* comps_refc_create(void *obj, void (*destructor)(void*)) {
     return refc;
 }
 
-void comps_refc_destroy(COMPS_RefC *refc) {
-    if (!refc->ref_count) {
-        if (refc->destructor) refc->destructor(refc->obj);
-        free(refc);
-    } else {
-        refc->ref_count--;
-    }
+/* Counter is changed atomically, so objects shared by documents can be
+ * referenced and released by several threads at once. Old value of zero
+ * means the last reference was released. */
+#ifdef __GNUC__
+#define COMPS_REFC_INC(refc) __atomic_fetch_add(&(refc)->ref_count, 1, \
+                                                __ATOMIC_RELAXED)
+#define COMPS_REFC_DEC(refc) __atomic_fetch_sub(&(refc)->ref_count, 1, \
+                                                __ATOMIC_ACQ_REL)
+#else
+#define COMPS_REFC_INC(refc) ((refc)->ref_count++)
+#define COMPS_REFC_DEC(refc) ((refc)->ref_count--)
+#endif
+
+char comps_refc_destroy(COMPS_RefC *refc) {
+    if (COMPS_REFC_DEC(refc))
+        return 0;
+    if (refc->destructor) refc->destructor(refc->obj);
+    free(refc);
+    return 1;
 }
 
 inline void comps_refc_destroy_v(void *refc) {
@@ -50,5 +62,5 @@ inline void comps_refc_decref(COMPS_RefC *refc) {
 
 inline void comps_refc_incref(COMPS_RefC *refc) {
     //COMPS_Check_NULL(refc, )
-    refc->ref_count++;
+    COMPS_REFC_INC(refc);
 }
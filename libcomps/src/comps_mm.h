@@ -44,10 +44,12 @@ typedef struct {
 COMPS_RefC* comps_refc_create(void *obj, void (*destructor)(void*));
 
 /** if ref counter equals zero destroy holded object
- *  and ref counter object itself, otherwise decrement counter
+ *  and ref counter object itself, otherwise decrement counter.
+ *  Counter is updated atomically when compiled with GCC compatible compiler
+ *  @return 1 if object was destroyed, 0 otherwise
  *  @see comps_refc_decref
  * */
-void comps_refc_destroy(COMPS_RefC *refc);
+char comps_refc_destroy(COMPS_RefC *refc);
 
 /** alias with void argument
  *  @see comps_refc_destroy
@@ -17,12 +17,8 @@ COMPS_Object * comps_object_create(COMPS_ObjectInfo *obj_info, COMPS_Object **ar
 
 void comps_object_destroy(COMPS_Object *comps_obj) {
     if (!comps_obj || !comps_obj->refc) return;
-    if (comps_obj->refc->ref_count)
-        comps_refc_destroy(comps_obj->refc);
-    else {
-        comps_refc_destroy(comps_obj->refc);
+    if (comps_refc_destroy(comps_obj->refc))
         free(comps_obj);
-    }
 }
 
 void comps_object_destroy_v(void *comps_obj) {
@@ -60,6 +56,69 @@ char comps_object_cmp_v(void *obj1, void *obj2) {
     return (char)comps_object_cmp((COMPS_Object*)obj1, (COMPS_Object*)obj2);
 }
 
+/* Multiply-rotate step of digest. Values are combined as integers, so
+ * result doesn't depend on byte order of host */
+static COMPS_Digest __comps_digest_mix(COMPS_Digest digest, uint64_t val) {
+    digest ^= val * 0x9e3779b97f4a7c15ULL;
+    digest = (digest << 27 | digest >> 37) * 0xbf58476d1ce4e5b9ULL;
+    return digest;
+}
+
+COMPS_Digest comps_digest_u64(COMPS_Digest digest, uint64_t val) {
+    return __comps_digest_mix(digest, val);
+}
+
+COMPS_Digest comps_digest_bytes(COMPS_Digest digest, const void *data,
+                                size_t len) {
+    const unsigned char *bytes = data;
+    uint64_t word;
+    size_t i;
+
+    digest = __comps_digest_mix(digest, len);
+    for (; len >= 8; bytes += 8, len -= 8) {
+        word = 0;
+        for (i = 0; i < 8; i++)
+            word |= (uint64_t)bytes[i] << (8 * i);
+        digest = __comps_digest_mix(digest, word);
+    }
+    if (len) {
+        word = 0;
+        for (i = 0; i < len; i++)
+            word |= (uint64_t)bytes[i] << (8 * i);
+        digest = __comps_digest_mix(digest, word);
+    }
+    return digest;
+}
+
+COMPS_Digest comps_digest_str(COMPS_Digest digest, const char *str) {
+    if (str == NULL)
+        return __comps_digest_mix(digest, UINT64_MAX);
+    return comps_digest_bytes(digest, str, strlen(str));
+}
+
+COMPS_Digest comps_digest_finish(COMPS_Digest digest) {
+    digest ^= digest >> 30;
+    digest *= 0xbf58476d1ce4e5b9ULL;
+    digest ^= digest >> 27;
+    digest *= 0x94d049bb133111ebULL;
+    return digest ^ (digest >> 31);
+}
+
+COMPS_Digest comps_object_digest(COMPS_Object *obj) {
+    COMPS_Digest ret;
+    char *str;
+
+    if (obj == NULL)
+        return 0;
+    if (obj->obj_info->digest)
+        return obj->obj_info->digest(obj);
+    str = comps_object_tostr(obj);
+    ret = comps_digest_str(comps_digest_str(COMPS_DIGEST_INIT, "object"),
+                           str);
+    free(str);
+    return comps_digest_finish(ret);
+}
+
 char* comps_object_tostr(COMPS_Object *obj1) {
     char *ret;
     if (obj1 && obj1->obj_info->to_str != NULL) {
@@ -110,6 +169,12 @@ signed char comps_num_cmp_u(COMPS_Object *num1, COMPS_Object *num2) {
     return ((COMPS_Num*)num1)->val == ((COMPS_Num*)num2)->val;
 }
 
+static COMPS_Digest comps_num_digest_u(COMPS_Object *num) {
+    return comps_digest_finish(comps_digest_u64(
+                             comps_digest_str(COMPS_DIGEST_INIT, "num"),
+                             (uint64_t)(int64_t)((COMPS_Num*)num)->val));
+}
+
 void comps_str_create_u(COMPS_Object* str, COMPS_Object **args){
     if (args && args[0]->obj_info == &COMPS_Str_ObjInfo) {
         ((COMPS_Str*)str)->val = malloc(sizeof(char) *
@@ -144,6 +209,12 @@ char* comps_str_tostr(COMPS_Object *str) {
     return ret;
 }
 
+static COMPS_Digest comps_str_digest_u(COMPS_Object *str) {
+    return comps_digest_finish(comps_digest_str(
+                             comps_digest_str(COMPS_DIGEST_INIT, "str"),
+                             ((COMPS_Str*)str)->val));
+}
+
 signed char comps_str_cmp_u(COMPS_Object *str1, COMPS_Object *str2) {
     if (!((COMPS_Str*)str1)->val && !((COMPS_Str*)str2)->val) {
         return 1;
@@ -192,7 +263,8 @@ COMPS_ObjectInfo COMPS_Num_ObjInfo = {
     .destructor = &comps_num_destroy_u,
     .copy = &comps_num_copy_u,
     .to_str = &comps_num_tostr,
-    .obj_cmp = &comps_num_cmp_u
+    .obj_cmp = &comps_num_cmp_u,
+    .digest = &comps_num_digest_u
 };
 
 COMPS_ObjectInfo COMPS_Str_ObjInfo = {
@@ -201,6 +273,7 @@ COMPS_ObjectInfo COMPS_Str_ObjInfo = {
     .destructor = &comps_str_destroy_u,
     .copy = &comps_str_copy_u,
     .to_str = &comps_str_tostr,
-    .obj_cmp = &comps_str_cmp_u
+    .obj_cmp = &comps_str_cmp_u,
+    .digest = &comps_str_digest_u
 };
 
@@ -22,6 +22,8 @@
 
 #include "comps_mm.h"
 
+#include <stdint.h>
+
 /** \file comps_obj.h
  * \brief COMPS_Object header file
  *
@@ -94,6 +96,9 @@ typedef struct COMPS_Packed COMPS_Packed;
 typedef struct COMPS_Num COMPS_Num;
 typedef struct COMPS_Str COMPS_Str;
 
+/** Content digest of COMPS_Object derivate @see comps_object_digest */
+typedef uint64_t COMPS_Digest;
+
 
 /** Structure holding all importating callback functions supporting
  * COMPS_Object derivate proper behavior. All callbacks except constructor
@@ -113,6 +118,8 @@ struct COMPS_ObjectInfo {
     /**< pointer to comparator function*/
     char* (*to_str)(COMPS_Object*);
     /**< pointer to string representation convert function */
+    COMPS_Digest (*digest)(COMPS_Object*);
+    /**< pointer to content digest function @see comps_object_digest */
 };
 
 /** COMPS Object structure
@@ -194,6 +201,43 @@ char comps_object_cmp_v(void *obj1, void *obj2);
  */
 char* comps_object_tostr(COMPS_Object *obj1);
 
+/** Initial value of content digest, see comps_digest_str */
+#define COMPS_DIGEST_INIT 0x6a09e667f3bcc908ULL
+
+/** Return digest of COMPS_Object derivate content
+ *
+ * Digest covers everything written to comps.xml, so it's stricter than
+ * comps_object_cmp, which ignores some attributes (for example arches of
+ * packages). Digest doesn't depend on memory layout or byte order of host,
+ * so digests of documents loaded by different processes can be compared.
+ * Different digests mean different content, equal digests mean equal
+ * content up to collisions of 64-bit hash. Derivates without digest
+ * callback are digested through their string representation.
+ *
+ * @param obj COMPS_Object derivate or NULL
+ * @return digest of content, 0 for NULL
+ */
+COMPS_Digest comps_object_digest(COMPS_Object *obj);
+
+/** Add 64-bit value (number or digest of nested object) to digest
+ * @param digest digest computed so far
+ * @param val added value
+ * @return new digest
+ */
+COMPS_Digest comps_digest_u64(COMPS_Digest digest, uint64_t val);
+
+/** Add bytes to digest, length is added too, so consecutive byte
+ * sequences can't be confused
+ */
+COMPS_Digest comps_digest_bytes(COMPS_Digest digest, const void *data,
+                                size_t len);
+
+/** Add string to digest, NULL is digested differently from empty string */
+COMPS_Digest comps_digest_str(COMPS_Digest digest, const char *str);
+
+/** Mix all bits of digest, called once after all content is added */
+COMPS_Digest comps_digest_finish(COMPS_Digest digest);
+
 /** Increment COMPS_Object derivate reference counter
  */
 COMPS_Object* comps_object_incref(COMPS_Object *obj);
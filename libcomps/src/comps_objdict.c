@@ -63,6 +63,40 @@ inline COMPS_HSList* comps_objdict_pairs(COMPS_ObjDict *rt) {
 inline COMPS_ObjDict* comps_objdict_union(COMPS_ObjDict *d1, COMPS_ObjDict *d2) {
     return comps_objrtree_union((COMPS_ObjRTree*)d1, (COMPS_ObjRTree*)d2);
 }
+void comps_objdict_unite(COMPS_ObjDict *d1, COMPS_ObjDict *d2) {
+    if (d1 == NULL || d2 == NULL)
+        return;
+    comps_objrtree_unite((COMPS_ObjRTree*)d1, (COMPS_ObjRTree*)d2);
+}
+inline void comps_objdict_it_init(COMPS_ObjDictIt *it, COMPS_ObjDict *rt) {
+    comps_objrtree_it_init(it, (COMPS_ObjRTree*)rt);
+}
+inline int comps_objdict_it_next(COMPS_ObjDictIt *it, const char **key,
+                                 COMPS_Object **data) {
+    return comps_objrtree_it_next(it, key, data);
+}
+inline void comps_objdict_it_destroy(COMPS_ObjDictIt *it) {
+    comps_objrtree_it_destroy(it);
+}
+inline void comps_objdict_it_init_prefix(COMPS_ObjDictIt *it,
+                                         COMPS_ObjDict *rt,
+                                         const char *prefix) {
+    comps_objrtree_it_init_prefix(it, (COMPS_ObjRTree*)rt, prefix);
+}
+inline void comps_objdict_it_init_range(COMPS_ObjDictIt *it, COMPS_ObjDict *rt,
+                                        const char *first, const char *last) {
+    comps_objrtree_it_init_range(it, (COMPS_ObjRTree*)rt, first, last);
+}
+inline void comps_objdict_prefix_walk(COMPS_ObjDict *rt, const char *prefix,
+                                      void *udata,
+                                      void (*walk_f)(void*, const char*,
+                                                     COMPS_Object*)) {
+    comps_objrtree_prefix_walk((COMPS_ObjRTree*)rt, prefix, udata, walk_f);
+}
+inline COMPS_HSList* comps_objdict_keys_with_prefix(COMPS_ObjDict *rt,
+                                                    const char *prefix) {
+    return comps_objrtree_keys_with_prefix((COMPS_ObjRTree*)rt, prefix);
+}
 
 inline void comps_objmdict_set_x(COMPS_ObjMDict *rt, char *key, COMPS_Object *data){
     comps_objmrtree_set_x((COMPS_ObjMRTree*) rt, key, data);
@@ -111,13 +145,24 @@ inline COMPS_HSList* comps_objmdict_pairs(COMPS_ObjMDict *rt) {
 inline COMPS_HSList * comps_objmdict_values(COMPS_ObjMDict * rt) {
     return comps_objmrtree_values((COMPS_ObjMRTree*)rt);
 }
+inline void comps_objmdict_it_init(COMPS_ObjMDictIt *it, COMPS_ObjMDict *rt) {
+    comps_objmrtree_it_init(it, (COMPS_ObjMRTree*)rt);
+}
+inline int comps_objmdict_it_next(COMPS_ObjMDictIt *it, const char **key,
+                                  COMPS_ObjList **data) {
+    return comps_objmrtree_it_next(it, key, data);
+}
+inline void comps_objmdict_it_destroy(COMPS_ObjMDictIt *it) {
+    comps_objmrtree_it_destroy(it);
+}
 
 COMPS_ObjectInfo COMPS_ObjMDict_ObjInfo = {
     .obj_size = sizeof(COMPS_ObjMRTree),
     .constructor = &comps_objmrtree_create_u,
     .destructor = &comps_objmrtree_destroy_u,
     .copy = &comps_objmrtree_copy_u,
-    .obj_cmp = &comps_objmrtree_cmp_u
+    .obj_cmp = &comps_objmrtree_cmp_u,
+    .digest = &comps_objmrtree_digest_u
 };
 
 COMPS_ObjectInfo COMPS_ObjDict_ObjInfo = {
@@ -125,5 +170,6 @@ COMPS_ObjectInfo COMPS_ObjDict_ObjInfo = {
     .constructor = &comps_objrtree_create_u,
     .destructor = &comps_objrtree_destroy_u,
     .copy = &comps_objrtree_copy_u,
-    .obj_cmp = &comps_objrtree_cmp_u
+    .obj_cmp = &comps_objrtree_cmp_u,
+    .digest = &comps_objrtree_digest_u
 };
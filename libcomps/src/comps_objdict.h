@@ -38,6 +38,9 @@ COMPS_Object_TAIL(COMPS_ObjDict);
 typedef COMPS_ObjMRTree COMPS_ObjMDict;
 COMPS_Object_TAIL(COMPS_ObjMDict);
 
+typedef COMPS_ObjRTreeIt COMPS_ObjDictIt;
+typedef COMPS_ObjMRTreeIt COMPS_ObjMDictIt;
+
 COMPS_ObjDict* comps_objdict_create();
 COMPS_ObjMDict* comps_objmdict_create();
 
@@ -316,6 +319,115 @@ COMPS_HSList* comps_objdict_pairs(COMPS_ObjDict *rt);
 COMPS_HSList* comps_objmdict_pairs(COMPS_ObjMDict *rt);
 /** @}*/
 
+/** \addtogroup comps_dict
+ *@{*/
+/** Initialize iterator over (key, value) pairs of dictionary
+ *
+ * Iterator lives on caller's stack and doesn't allocate memory unless
+ * dictionary contains very long keys. Keys mustn't be added or removed
+ * while iterating; COMPS_ObjDict keys_version member changes with every
+ * such modification and can be used to detect it. Replacing value of
+ * existing key is fine.
+ *
+ * @param it COMPS_ObjDictIt iterator
+ * @param rt COMPS_ObjDict object
+ */
+void comps_objdict_it_init(COMPS_ObjDictIt *it, COMPS_ObjDict *rt);
+
+/** Move iterator to next pair of dictionary. Pairs are visited in key order
+ *
+ * Returned key is borrowed and valid only until next call, returned value
+ * is borrowed too and its reference counter isn't incremented
+ *
+ * @param it COMPS_ObjDictIt iterator
+ * @param key pointer where key is stored
+ * @param data pointer where value is stored
+ * @return 1 if next pair was found, 0 at the end of dictionary
+ */
+int comps_objdict_it_next(COMPS_ObjDictIt *it, const char **key,
+                          COMPS_Object **data);
+
+/** Release resources possibly held by iterator
+ *
+ * @param it COMPS_ObjDictIt iterator
+ */
+void comps_objdict_it_destroy(COMPS_ObjDictIt *it);
+
+/** Initialize iterator over pairs whose keys start with prefix
+ *
+ * Only the subtree under prefix is visited, so cost doesn't depend on size
+ * of the rest of dictionary
+ *
+ * @param it COMPS_ObjDictIt iterator
+ * @param rt COMPS_ObjDict object
+ * @param prefix key prefix, empty string matches every key
+ */
+void comps_objdict_it_init_prefix(COMPS_ObjDictIt *it, COMPS_ObjDict *rt,
+                                  const char *prefix);
+
+/** Initialize iterator over pairs with keys in range [first, last)
+ *
+ * Keys are compared bytewise like with strcmp. Upper bound isn't copied and
+ * has to stay valid until iteration ends
+ *
+ * @param it COMPS_ObjDictIt iterator
+ * @param rt COMPS_ObjDict object
+ * @param first lowest included key or NULL for no lower bound
+ * @param last first excluded key or NULL for no upper bound
+ */
+void comps_objdict_it_init_range(COMPS_ObjDictIt *it, COMPS_ObjDict *rt,
+                                 const char *first, const char *last);
+
+/** Call walk_f for every pair whose key starts with prefix
+ *
+ * @param rt COMPS_ObjDict object
+ * @param prefix key prefix
+ * @param udata user data passed as first argument to walk_f
+ * @param walk_f callback taking user data, key and value
+ */
+void comps_objdict_prefix_walk(COMPS_ObjDict *rt, const char *prefix,
+                               void *udata,
+                               void (*walk_f)(void*, const char*,
+                                              COMPS_Object*));
+
+/** Return list of keys starting with prefix
+ *
+ * @param rt COMPS_ObjDict object
+ * @param prefix key prefix
+ * @return COMPS_HSList of matching keys in ascending order
+ */
+COMPS_HSList* comps_objdict_keys_with_prefix(COMPS_ObjDict *rt,
+                                             const char *prefix);
+/** @}*/
+
+/** \addtogroup comps_multi_dict
+ *@{*/
+/** Initialize iterator over (key, list) pairs of multi-dictionary
+ *
+ * @see comps_objdict_it_init
+ * @param it COMPS_ObjMDictIt iterator
+ * @param rt COMPS_ObjMDict object
+ */
+void comps_objmdict_it_init(COMPS_ObjMDictIt *it, COMPS_ObjMDict *rt);
+
+/** Move iterator to next pair of multi-dictionary
+ *
+ * @see comps_objdict_it_next
+ * @param it COMPS_ObjMDictIt iterator
+ * @param key pointer where key is stored
+ * @param data pointer where list of values is stored
+ * @return 1 if next pair was found, 0 at the end of multi-dictionary
+ */
+int comps_objmdict_it_next(COMPS_ObjMDictIt *it, const char **key,
+                           COMPS_ObjList **data);
+
+/** Release resources possibly held by iterator
+ *
+ * @param it COMPS_ObjMDictIt iterator
+ */
+void comps_objmdict_it_destroy(COMPS_ObjMDictIt *it);
+/** @}*/
+
 /** \addtogroup comps_dict
  *@{*/
 //void comps_mdict_unite(COMPS_MDict *d1, COMPS_MDict *d2);
@@ -331,5 +443,16 @@ COMPS_HSList* comps_objmdict_pairs(COMPS_ObjMDict *rt);
  * @return new COMPS_ObjDict object
  */
 COMPS_ObjDict* comps_objdict_union(COMPS_ObjDict *d1, COMPS_ObjDict *d2);
+
+/** Join second dictionary into first one in place
+ *
+ * Pairs of second dictionary are set to first one with incremented reference
+ * counter. Result is the same as comps_objdict_union(d1, d2) produces
+ * without copying d1.
+ *
+ * @param d1 COMPS_ObjDict object which is modified
+ * @param d2 COMPS_ObjDict object or NULL
+ */
+void comps_objdict_unite(COMPS_ObjDict *d1, COMPS_ObjDict *d2);
 /** @}*/
 #endif
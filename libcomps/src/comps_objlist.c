@@ -1,23 +1,65 @@
 #include "comps_objlist.h"
 #include "comps_utils.h"
+#include "comps_radix.h"
+#include "comps_objradix.h"
 
 inline const COMPS_ObjListIt *comps_objlist_it_next(const COMPS_ObjListIt *it) {
     return (const COMPS_ObjListIt*)it->next;
 }
 
-COMPS_ObjListIt* comps_objlist_it_create(COMPS_Object *obj) {
+struct COMPS_ObjListChunk {
+    struct COMPS_ObjListChunk *next;
+    size_t len;
+    size_t size;
+    COMPS_ObjListIt items[];
+};
+
+typedef struct {
+    COMPS_Object *src; /* referenced, so address can't be reused */
+    unsigned int version;
+} COMPS_ObjListKeySrc;
+
+struct COMPS_ObjListKeys {
+    COMPS_Object* (*key_f)(COMPS_Object*);
+    COMPS_Object* (*props_f)(COMPS_Object*);
+    unsigned int version; /* list version index was built for */
+    COMPS_RTree *its; /* key -> first item iterator with the key */
+    COMPS_ObjListKeySrc *srcs; /* where keys of items came from, in order */
+    size_t srcs_len;
+};
+
+static COMPS_ObjListIt* __comps_objlist_it_alloc(COMPS_ObjList *objlist) {
+    COMPS_ObjListChunk *chunk;
     COMPS_ObjListIt *objit;
-    objit = malloc(sizeof(COMPS_ObjListIt));
-    if (!objit) return NULL;
+    size_t size;
 
-    objit->comps_obj = comps_object_incref(obj);
-    objit->next = NULL;
-    return objit;
+    if (objlist->free_its) {
+        objit = objlist->free_its;
+        objlist->free_its = objit->next;
+        return objit;
+    }
+    chunk = objlist->chunks;
+    if (chunk == NULL || chunk->len == chunk->size) {
+        /* grow chunks with the list, but keep waste of sparse lists small */
+        size = objlist->len;
+        if (size < COMPS_OBJLIST_CHUNK_MIN)
+            size = COMPS_OBJLIST_CHUNK_MIN;
+        else if (size > COMPS_OBJLIST_CHUNK_MAX)
+            size = COMPS_OBJLIST_CHUNK_MAX;
+        chunk = malloc(sizeof(*chunk) + sizeof(COMPS_ObjListIt) * size);
+        if (!chunk) return NULL;
+        chunk->len = 0;
+        chunk->size = size;
+        chunk->next = objlist->chunks;
+        objlist->chunks = chunk;
+    }
+    return &chunk->items[chunk->len++];
 }
 
-COMPS_ObjListIt* comps_objlist_it_create_x(COMPS_Object *obj) {
+static COMPS_ObjListIt* comps_objlist_it_create_x(COMPS_ObjList *objlist,
+                                                  COMPS_Object *obj) {
     COMPS_ObjListIt *objit;
-    objit = malloc(sizeof(COMPS_ObjListIt));
+    objit = __comps_objlist_it_alloc(objlist);
     if (!objit) return NULL;
 
     objit->comps_obj = obj;
@@ -25,10 +67,58 @@ COMPS_ObjListIt* comps_objlist_it_create_x(COMPS_Object *obj) {
     return objit;
 }
 
-void comps_objlist_it_destroy(COMPS_ObjListIt *objit) {
-    //objit = malloc(sizeof(COMPS_ObjListIt));
+static COMPS_ObjListIt* comps_objlist_it_create(COMPS_ObjList *objlist,
+                                                COMPS_Object *obj) {
+    COMPS_ObjListIt *objit;
+    objit = comps_objlist_it_create_x(objlist, obj);
+    if (objit)
+        comps_object_incref(obj);
+    return objit;
+}
+
+static void comps_objlist_it_destroy(COMPS_ObjList *objlist,
+                                     COMPS_ObjListIt *objit) {
     comps_object_destroy(objit->comps_obj);
-    free(objit);
+    objit->comps_obj = NULL;
+    objit->next = objlist->free_its;
+    objlist->free_its = objit;
+}
+
+static int __comps_objlist_reserve(COMPS_ObjList *objlist, size_t len) {
+    COMPS_ObjListIt **index;
+    size_t size;
+
+    if (len <= objlist->index_size)
+        return 1;
+    size = objlist->index_size ? objlist->index_size * 2
+                               : COMPS_OBJLIST_CHUNK_MIN;
+    while (size < len)
+        size *= 2;
+    index = realloc(objlist->index, sizeof(*index) * size);
+    if (!index) return 0;
+    objlist->index = index;
+    objlist->index_size = size;
+    return 1;
+}
+
+static void __comps_objlist_keys_clear(COMPS_ObjListKeys *keys) {
+    size_t i;
+
+    comps_rtree_destroy(keys->its);
+    keys->its = NULL;
+    for (i = 0; i < keys->srcs_len; i++)
+        comps_object_destroy(keys->srcs[i].src);
+    free(keys->srcs);
+    keys->srcs = NULL;
+    keys->srcs_len = 0;
+}
+
+static void __comps_objlist_keys_destroy(COMPS_ObjList *objlist) {
+    if (objlist->keys == NULL)
+        return;
+    __comps_objlist_keys_clear(objlist->keys);
+    free(objlist->keys);
+    objlist->keys = NULL;
 }
 
 void comps_objlist_create(COMPS_ObjList *objlist, COMPS_Object **args) {
@@ -36,6 +126,12 @@ void comps_objlist_create(COMPS_ObjList *objlist, COMPS_Object **args) {
     objlist->first = NULL;
     objlist->last = NULL;
     objlist->len = 0;
+    objlist->index = NULL;
+    objlist->index_size = 0;
+    objlist->chunks = NULL;
+    objlist->free_its = NULL;
+    objlist->version = 0;
+    objlist->keys = NULL;
 }
 COMPS_CREATE_u(objlist, COMPS_ObjList)
 
@@ -43,10 +139,8 @@ void comps_objlist_copy(COMPS_ObjList *objlist_dst,
                         COMPS_ObjList *objlist_src) {
     COMPS_ObjListIt *it;
 
-    objlist_dst->first = NULL;
-    objlist_dst->last = NULL;
-    objlist_dst->len = 0;
-
+    comps_objlist_create(objlist_dst, NULL);
+    __comps_objlist_reserve(objlist_dst, objlist_src->len);
     for (it = objlist_src->first; it != NULL; it = it->next) {
         comps_objlist_append_x(objlist_dst, comps_object_copy(it->comps_obj));
     }
@@ -55,71 +149,155 @@ COMPS_COPY_u(objlist, COMPS_ObjList)
 
 
 void comps_objlist_destroy(COMPS_ObjList *objlist) {
-    COMPS_ObjListIt *oldit, *it = objlist->first;
-    COMPS_Object **obj= NULL;
+    COMPS_ObjListIt *it;
+    COMPS_ObjListChunk *chunk, *next;
 
-    for (oldit = it; comps_objlist_walk(&it, obj); oldit = it) {
-        comps_objlist_it_destroy(oldit);
+    for (it = objlist->first; it != NULL; it = it->next) {
+        comps_object_destroy(it->comps_obj);
+    }
+    for (chunk = objlist->chunks; chunk != NULL; chunk = next) {
+        next = chunk->next;
+        free(chunk);
     }
-    if (oldit)
-        comps_objlist_it_destroy(oldit);
+    free(objlist->index);
+    __comps_objlist_keys_destroy(objlist);
 }
 COMPS_DESTROY_u(objlist, COMPS_ObjList)
 
 void comps_objlist_clear(COMPS_ObjList *objlist) {
     comps_objlist_destroy(objlist);
-    objlist->first = NULL;
-    objlist->last = NULL;
-    objlist->len = 0;
+    comps_objlist_create(objlist, NULL);
 }
 
 
 COMPS_Object* comps_objlist_get(COMPS_ObjList *objlist, unsigned int atpos) {
-    unsigned int pos;
-    COMPS_ObjListIt *it;
-    if (!objlist) return NULL;
-
-    for (it = objlist->first, pos=0;
-         it != NULL && pos != atpos;
-         it = it->next, pos++);
+    if (!objlist || atpos >= objlist->len) return NULL;
+    return comps_object_incref(objlist->index[atpos]->comps_obj);
+}
 
-    if (pos != atpos)
-        return NULL;
+COMPS_Object* comps_objlist_get_x(COMPS_ObjList *objlist, unsigned int atpos) {
+    if (!objlist || atpos >= objlist->len) return NULL;
+    return objlist->index[atpos]->comps_obj;
+}
 
-    return (it)?comps_object_incref(it->comps_obj):NULL;
+COMPS_ObjListIt* comps_objlist_get_it(COMPS_ObjList *objlist,
+                              unsigned int atpos) {
+    if (!objlist || atpos >= objlist->len) return NULL;
+    return objlist->index[atpos];
 }
 
-COMPS_Object* comps_objlist_get_x(COMPS_ObjList *objlist, unsigned int atpos) {
-    unsigned int pos;
-    COMPS_ObjListIt *it;
-    if (!objlist) return NULL;
 
-    for (it = objlist->first, pos=0;
-         it != NULL && pos != atpos;
-         it = it->next, pos++);
+static int __comps_objlist_key_eq(COMPS_Object *keyobj, const char *key) {
+    char *str, *tofree;
+    int ret;
 
-    if (pos != atpos)
-        return NULL;
+    str = __comps_obj_keystr(keyobj, &tofree);
+    ret = str != NULL && strcmp(str, key) == 0;
+    free(tofree);
+    return ret;
+}
 
-    return (it)?it->comps_obj:NULL;
+/* Source of key of item is properties dict returned by props_f, whose
+ * version changes when key is set. Without props_f it's key object itself,
+ * which is replaced rather than changed in place */
+static void __comps_objlist_key_src(COMPS_Object *obj,
+                                    COMPS_Object* (*key_f)(COMPS_Object*),
+                                    COMPS_Object* (*props_f)(COMPS_Object*),
+                                    COMPS_ObjListKeySrc *src) {
+    if (props_f) {
+        src->src = props_f(obj);
+        src->version = src->src ? ((COMPS_ObjRTree*)src->src)->version : 0;
+    } else {
+        src->src = key_f(obj);
+        src->version = 0;
+    }
 }
 
-COMPS_ObjListIt* comps_objlist_get_it(COMPS_ObjList *objlist,
-                              unsigned int atpos) {
-    unsigned int pos;
+static int __comps_objlist_keys_build(COMPS_ObjList *objlist,
+                                      COMPS_Object* (*key_f)(COMPS_Object*),
+                                      COMPS_Object* (*props_f)(COMPS_Object*)) {
+    COMPS_ObjListKeys *keys;
     COMPS_ObjListIt *it;
-    if (!objlist) return NULL;
+    COMPS_ObjListKeySrc *src;
+    char *str, *tofree;
 
-    for (it = objlist->first, pos=0;
-         it != NULL && pos != atpos;
-         it = it->next, pos++);
+    if ((keys = objlist->keys) == NULL) {
+        if ((keys = malloc(sizeof(*keys))) == NULL)
+            return 0;
+        keys->its = NULL;
+        keys->srcs = NULL;
+        keys->srcs_len = 0;
+        objlist->keys = keys;
+    }
+    __comps_objlist_keys_clear(keys);
+    keys->its = comps_rtree_create(NULL, NULL, NULL);
+    if (objlist->len)
+        keys->srcs = malloc(sizeof(*keys->srcs) * objlist->len);
+    if (keys->its == NULL || (objlist->len && keys->srcs == NULL)) {
+        __comps_objlist_keys_destroy(objlist);
+        return 0;
+    }
+    for (it = objlist->first; it != NULL; it = it->next) {
+        src = &keys->srcs[keys->srcs_len++];
+        __comps_objlist_key_src(it->comps_obj, key_f, props_f, src);
+        comps_object_incref(src->src);
+        str = __comps_obj_keystr(key_f(it->comps_obj), &tofree);
+        /* radix tree can't hold empty key, such keys are always scanned */
+        if (str != NULL && str[0] && comps_rtree_get(keys->its, str) == NULL)
+            comps_rtree_set(keys->its, str, it);
+        free(tofree);
+    }
+    keys->key_f = key_f;
+    keys->props_f = props_f;
+    keys->version = objlist->version;
+    return 1;
+}
 
-    if (pos+1 != atpos)
-        return NULL;
+/* Index is current when neither list nor any key source changed since it
+ * was built */
+static int __comps_objlist_keys_current(COMPS_ObjList *objlist,
+                                     COMPS_Object* (*key_f)(COMPS_Object*),
+                                     COMPS_Object* (*props_f)(COMPS_Object*)) {
+    COMPS_ObjListKeys *keys;
+    COMPS_ObjListKeySrc src;
+    COMPS_ObjListIt *it;
+    size_t i;
 
-    return (it)?it:NULL;
+    keys = objlist->keys;
+    if (keys == NULL || keys->key_f != key_f || keys->props_f != props_f
+        || keys->version != objlist->version)
+        return 0;
+    for (it = objlist->first, i = 0; it != NULL; it = it->next, i++) {
+        __comps_objlist_key_src(it->comps_obj, key_f, props_f, &src);
+        if (src.src != keys->srcs[i].src
+            || src.version != keys->srcs[i].version)
+            return 0;
+    }
+    return 1;
 }
 
+COMPS_Object* comps_objlist_find_by_x(COMPS_ObjList *objlist,
+                                      COMPS_Object* (*key_f)(COMPS_Object*),
+                                      COMPS_Object* (*props_f)(COMPS_Object*),
+                                      const char *key) {
+    COMPS_ObjListIt *it;
+
+    if (!objlist || !key) return NULL;
+    /* hit must be checked too, earlier item could have got the same key */
+    if (key[0]) {
+        if (__comps_objlist_keys_current(objlist, key_f, props_f)
+            || __comps_objlist_keys_build(objlist, key_f, props_f)) {
+            it = comps_rtree_get(objlist->keys->its, key);
+            return it ? it->comps_obj : NULL;
+        }
+    }
+    /* empty key isn't indexed */
+    for (it = objlist->first; it != NULL; it = it->next) {
+        if (__comps_objlist_key_eq(key_f(it->comps_obj), key))
+            return it->comps_obj;
+    }
+    return NULL;
+}
 
 int comps_objlist_walk(COMPS_ObjListIt **walker, COMPS_Object **result) {
     if (!walker || !*walker) return 0;
@@ -140,102 +318,88 @@ int comps_objlist_walk_r(COMPS_ObjListIt *start,
     return 1;
 }
 
-static int __comps_objlist_append(COMPS_ObjList *objlist, COMPS_ObjListIt *objit) {
-    if (!objlist || !objit) return 0;
-    if (objlist->first == NULL) {
-        objlist->first = objit;
-        objlist->last = objit;
+static int __comps_objlist_insert_at(COMPS_ObjList *objlist,
+                                     unsigned int pos,
+                                     COMPS_ObjListIt *newit) {
+    if (!__comps_objlist_reserve(objlist, objlist->len + 1)) {
+        comps_objlist_it_destroy(objlist, newit);
+        return 0;
+    }
+    if (pos == 0) {
+        newit->next = objlist->first;
+        objlist->first = newit;
     } else {
-        objlist->last->next = objit;
-        objlist->last = objlist->last->next;
+        newit->next = objlist->index[pos - 1]->next;
+        objlist->index[pos - 1]->next = newit;
     }
+    if (pos == objlist->len)
+        objlist->last = newit;
+    memmove(objlist->index + pos + 1, objlist->index + pos,
+            sizeof(*objlist->index) * (objlist->len - pos));
+    objlist->index[pos] = newit;
     objlist->len++;
+    objlist->version++;
     return 1;
 }
 
+static int __comps_objlist_append(COMPS_ObjList *objlist, COMPS_ObjListIt *objit) {
+    if (!objlist || !objit) return 0;
+    return __comps_objlist_insert_at(objlist, objlist->len, objit);
+}
+
 int comps_objlist_append_x(COMPS_ObjList *objlist, COMPS_Object *obj) {
-    COMPS_ObjListIt *new_it = comps_objlist_it_create_x(obj);
+    if (!objlist) return 0;
+    COMPS_ObjListIt *new_it = comps_objlist_it_create_x(objlist, obj);
     return __comps_objlist_append(objlist, new_it);
 }
 int comps_objlist_append(COMPS_ObjList *objlist, COMPS_Object *obj) {
-    COMPS_ObjListIt *new_it = comps_objlist_it_create(obj);
+    if (!objlist) return 0;
+    COMPS_ObjListIt *new_it = comps_objlist_it_create(objlist, obj);
     return __comps_objlist_append(objlist, new_it);
 }
 
+static int __comps_objlist_it_pos(COMPS_ObjList *objlist, COMPS_ObjListIt *it) {
+    unsigned int pos;
+    for (pos = 0; pos < objlist->len; pos++) {
+        if (objlist->index[pos] == it)
+            return pos;
+    }
+    return -1;
+}
+
 int comps_objlist_insert_after(COMPS_ObjList *objlist,
                               COMPS_ObjListIt *it,
                               COMPS_Object *obj) {
+    int pos;
     if (!objlist) return -1;
     if (!it) return -1;
+    if ((pos = __comps_objlist_it_pos(objlist, it)) == -1) return -1;
 
-    COMPS_ObjListIt *new_it = comps_objlist_it_create(obj);
-
-    new_it->next = it->next;
-    it->next = new_it;
-    if (it == objlist->last) {
-        objlist->last = new_it;
-    }
-    objlist->len++;
-    return 1;
+    COMPS_ObjListIt *new_it = comps_objlist_it_create(objlist, obj);
+    if (!new_it) return -1;
+    return __comps_objlist_insert_at(objlist, pos + 1, new_it);
 }
 
 int comps_objlist_insert_before(COMPS_ObjList *objlist,
                                COMPS_ObjListIt *it,
                                COMPS_Object *obj) {
+    int pos;
     if (!objlist) return -1;
     if (!it) return -1;
+    if ((pos = __comps_objlist_it_pos(objlist, it)) == -1) return -1;
 
-    COMPS_ObjListIt *new_it = comps_objlist_it_create(obj);
-    COMPS_ObjListIt *tmpit;
-    for (tmpit = objlist->first; tmpit->next != it; tmpit = tmpit->next);
-
-    if (tmpit == objlist->first) {
-        new_it->next = objlist->first;
-        objlist->first = new_it;
-        if (objlist->last == NULL)
-            objlist->last = new_it;
-    } else {
-        new_it->next = tmpit->next;
-        tmpit->next = new_it;
-    }
-    objlist->len++;
-    return 1;
+    COMPS_ObjListIt *new_it = comps_objlist_it_create(objlist, obj);
+    if (!new_it) return -1;
+    return __comps_objlist_insert_at(objlist, pos, new_it);
 }
 
-int __comps_objlist_insert_at(COMPS_ObjList *objlist,
-                           unsigned int pos,
-                           COMPS_ObjListIt *newit) {
-    COMPS_ObjListIt *tmpit, *oldit;
-    unsigned int i;
-    if (pos == 0) {
-        newit->next = objlist->first;
-        objlist->first = newit;
-        if (!objlist->last) {
-            objlist->last = newit;
-        }
-    } else if (pos == objlist->len){
-        newit->next = NULL;
-        objlist->last->next = newit;
-        objlist->last = newit;
-    } else {
-        i = 0;
-        oldit = NULL;
-        for (tmpit = objlist->first; tmpit != NULL && i != pos;
-             i++, tmpit = tmpit->next) {
-            oldit = tmpit;
-        }
-        newit->next = oldit->next;
-        oldit->next = newit; 
-    }
-    objlist->len++;
-    return 1;
-}
 int comps_objlist_insert_at_x(COMPS_ObjList *objlist,
                            unsigned int pos,
                            COMPS_Object *obj) {
     if (!objlist) return -1;
     if (pos > objlist->len) return -1;
-    COMPS_ObjListIt *newit = comps_objlist_it_create_x(obj);
+    COMPS_ObjListIt *newit = comps_objlist_it_create_x(objlist, obj);
+    if (!newit) return -1;
     return __comps_objlist_insert_at(objlist, pos, newit);
 }
 int comps_objlist_insert_at(COMPS_ObjList *objlist,
@@ -243,63 +407,48 @@ int comps_objlist_insert_at(COMPS_ObjList *objlist,
                            COMPS_Object *obj) {
     if (!objlist) return -1;
     if (pos > objlist->len) return -1;
-    COMPS_ObjListIt *newit = comps_objlist_it_create(obj);
+    COMPS_ObjListIt *newit = comps_objlist_it_create(objlist, obj);
+    if (!newit) return -1;
     return __comps_objlist_insert_at(objlist, pos, newit);
 }
 
 int comps_objlist_remove_at(COMPS_ObjList *objlist, unsigned int atpos) {
-    int pos;
-    COMPS_ObjListIt *it, *itprev = NULL;
-    if (!objlist) return 0;
+    COMPS_ObjListIt *it, *itprev;
+    if (!objlist || atpos >= objlist->len) return 0;
 
-    for (it = objlist->first, pos=0;
-         it != NULL && pos != (int)atpos;
-         it = it->next, pos++) {
-        itprev = it;
-    }
-    if (!it)
-        return 0;
+    it = objlist->index[atpos];
+    itprev = atpos ? objlist->index[atpos - 1] : NULL;
     if (itprev)
         itprev->next = it->next;
     else
         objlist->first = it->next;
     if (it == objlist->last)
         objlist->last = itprev;
-    comps_objlist_it_destroy(it);
     objlist->len--;
+    objlist->version++;
+    memmove(objlist->index + atpos, objlist->index + atpos + 1,
+            sizeof(*objlist->index) * (objlist->len - atpos));
+    comps_objlist_it_destroy(objlist, it);
     return 1;
 }
 
 int comps_objlist_remove(COMPS_ObjList *objlist, COMPS_Object *obj) {
-    COMPS_ObjListIt *it, *itprev = NULL;
+    int pos;
     if (!objlist) return 0;
 
-    for (it = objlist->first; it != NULL && it->comps_obj != obj;
-         it = it->next) {
-        itprev = it;
-    }
-    if (!it)
+    if ((pos = comps_objlist_index(objlist, obj)) == -1)
         return 0;
-    if (itprev)
-        itprev->next = it->next;
-    else
-        objlist->first = it->next;
-    if (it == objlist->last)
-        objlist->last = itprev;
-    comps_objlist_it_destroy(it);
-    objlist->len--;
-    return 1;
+    return comps_objlist_remove_at(objlist, pos);
 }
 
 int comps_objlist_index(COMPS_ObjList *objlist, COMPS_Object *obj) {
-    int x;
-    COMPS_ObjListIt *it;
+    unsigned int x;
 
-    for (it = objlist->first, x=0; it != NULL && it->comps_obj != obj;
-         it = it->next, x++) {
-    };
-    if (it == NULL) return -1;
-    return x;
+    for (x = 0; x < objlist->len; x++) {
+        if (objlist->index[x]->comps_obj == obj)
+            return x;
+    }
+    return -1;
 }
 
 COMPS_ObjList* comps_objlist_sublist_it(COMPS_ObjListIt *startit,
@@ -337,16 +486,12 @@ COMPS_ObjList* comps_objlist_sublist_indexed(COMPS_ObjList *objlist,
                                            unsigned int end) {
     unsigned int pos;
     COMPS_ObjList *ret;
-    COMPS_ObjListIt *it;
     ret = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
 
-    for (it = objlist->first, pos=0;
-         it != NULL && pos != start;
-         it = it->next, pos++);
-    if (!it)
-        return ret;
-    for (; it->next != NULL && pos != end; it = it->next, pos++) {
-        comps_objlist_append(ret, it->comps_obj);
+    if (end > objlist->len)
+        end = objlist->len;
+    for (pos = start; pos < end; pos++) {
+        comps_objlist_append(ret, objlist->index[pos]->comps_obj);
     }
     return ret;
 }
@@ -356,23 +501,15 @@ COMPS_ObjList* comps_objlist_sublist_indexed_step(COMPS_ObjList *objlist,
                                                unsigned int end,
                                                unsigned int step) {
     unsigned int pos;
-    unsigned int stepc;
     COMPS_ObjList *ret;
-    COMPS_ObjListIt *it;
     ret = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
 
-    pos = 0;
-    stepc = 0;
-    for (it = objlist->first;
-         it != NULL && pos != start;
-         it = it->next, pos++);
-    if (!it)
-        return ret;
-    for (; it->next != NULL && pos != end; it = it->next, pos++, stepc++) {
-        if (stepc == step) {
-            step = 0;
-            comps_objlist_append(ret, it->comps_obj);
-        }
+    if (step == 0)
+        step = 1;
+    if (end > objlist->len)
+        end = objlist->len;
+    for (pos = start; pos < end; pos += step) {
+        comps_objlist_append(ret, objlist->index[pos]->comps_obj);
     }
     return ret;
 }
@@ -380,12 +517,11 @@ COMPS_ObjList* comps_objlist_sublist_indexed_step(COMPS_ObjList *objlist,
 COMPS_ObjList* comps_objlist_filter(COMPS_ObjList *list,
                                   char (*filter_func)(COMPS_Object*)) {
     COMPS_ObjList *ret;
-    unsigned int i = 0;
     COMPS_ObjListIt *it;
 
     ret = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
 
-    for (i=0, it = list->first; i < list->len; it = it->next, i++) {
+    for (it = list->first; it != NULL; it = it->next) {
         if (filter_func(it->comps_obj))
             comps_objlist_append(ret, it->comps_obj);
     }
@@ -397,6 +533,7 @@ COMPS_ObjList* comps_objlist_concat(COMPS_ObjList *list1, COMPS_ObjList *list2)
     COMPS_ObjListIt *it;
 
     ret = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+    __comps_objlist_reserve(ret, list1->len + list2->len);
     for (it = list1->first; it != NULL; it = it->next) {
         comps_objlist_append(ret, it->comps_obj);
     }
@@ -408,6 +545,7 @@ COMPS_ObjList* comps_objlist_concat(COMPS_ObjList *list1, COMPS_ObjList *list2)
 
 void comps_objlist_concat_in(COMPS_ObjList *list1, COMPS_ObjList *list2) {
     COMPS_ObjListIt *it;
+    __comps_objlist_reserve(list1, list1->len + list2->len);
     for (it = list2->first; it != NULL; it = it->next) {
         comps_objlist_append(list1, it->comps_obj);
     }
@@ -416,6 +554,8 @@ void comps_objlist_concat_in(COMPS_ObjList *list1, COMPS_ObjList *list2) {
 signed char comps_objlist_cmp(COMPS_Object *list1, COMPS_Object *list2) {
     COMPS_ObjListIt *it, *it2;
     if (!list1 || !list2) return -1;
+    if (((COMPS_ObjList*)list1)->len != ((COMPS_ObjList*)list2)->len)
+        return 0;
     it =  ((COMPS_ObjList*)list1)->first;
     it2 =  ((COMPS_ObjList*)list2)->first;
 
@@ -432,16 +572,12 @@ signed char comps_objlist_cmp(COMPS_Object *list1, COMPS_Object *list2) {
 int comps_objlist_set(COMPS_ObjList *objlist, unsigned int atpos,
                       COMPS_Object *obj) {
     COMPS_ObjListIt *it;
-    unsigned int i = 0;
-
-    if (!objlist) return -1;
-    it =  ((COMPS_ObjList*)objlist)->first;
 
-    for (; it != NULL && i != atpos; it = it->next, i++);
-    if (!it)
-        return -1;
+    if (!objlist || atpos >= objlist->len) return -1;
+    it = objlist->index[atpos];
     COMPS_OBJECT_DESTROY(it->comps_obj);
     it->comps_obj = comps_object_incref(obj);
+    objlist->version++;
     return 0;
 }
 
@@ -487,6 +623,17 @@ char* comps_objlist_tostr_u(COMPS_Object* list) {
     return ret;
 }
 
+static COMPS_Digest comps_objlist_digest_u(COMPS_Object *list) {
+    COMPS_ObjListIt *it;
+    COMPS_Digest ret;
+
+    ret = comps_digest_u64(comps_digest_str(COMPS_DIGEST_INIT, "list"),
+                           ((COMPS_ObjList*)list)->len);
+    for (it = ((COMPS_ObjList*)list)->first; it != NULL; it = it->next)
+        ret = comps_digest_u64(ret, comps_object_digest(it->comps_obj));
+    return comps_digest_finish(ret);
+}
+
 
 COMPS_ObjectInfo COMPS_ObjList_ObjInfo = {
     .obj_size = sizeof(COMPS_ObjList),
@@ -494,5 +641,6 @@ COMPS_ObjectInfo COMPS_ObjList_ObjInfo = {
     .destructor = &comps_objlist_destroy_u,
     .copy = &comps_objlist_copy_u,
     .obj_cmp = &comps_objlist_cmp,
-    .to_str = &comps_objlist_tostr_u
+    .to_str = &comps_objlist_tostr_u,
+    .digest = &comps_objlist_digest_u
 };
@@ -37,12 +37,37 @@ struct COMPS_ObjListIt {
 };
 
 
-/** COMPS_Object derivate representing category element in comps.xml structure*/
+/** minimal number of items allocated at once */
+#define COMPS_OBJLIST_CHUNK_MIN 8
+/** maximal number of items allocated at once */
+#define COMPS_OBJLIST_CHUNK_MAX 1024
+
+typedef struct COMPS_ObjListChunk COMPS_ObjListChunk;
+typedef struct COMPS_ObjListKeys COMPS_ObjListKeys;
+
+/** COMPS_Object derivate representing list of objects
+ *
+ * Items are linked from first to last, so existing code walking
+ * first/next keeps working and item iterators stay valid until the item is
+ * removed. Items are additionally referenced from index array in list order,
+ * which makes positional access constant time. Item iterators are allocated
+ * in chunks owned by the list. Structure of list must be changed only
+ * through comps_objlist_* functions, replacing comps_obj of an item
+ * directly is fine as long as version is incremented afterwards. Every change
+ * made by comps_objlist_* functions bumps version, which invalidates indexes
+ * built over the list.
+ */
 typedef struct COMPS_ObjList {
     COMPS_Object_HEAD;
     COMPS_ObjListIt *first; /**< first list item iterator */
     COMPS_ObjListIt *last; /**< last list item iterator */
     size_t len; /**< list lenght*/
+    COMPS_ObjListIt **index; /**< item iterators in list order */
+    size_t index_size; /**< allocated slots of index */
+    COMPS_ObjListChunk *chunks; /**< storage of item iterators */
+    COMPS_ObjListIt *free_its; /**< removed item iterators for reuse */
+    unsigned int version; /**< changes with every change of items */
+    COMPS_ObjListKeys *keys; /**< key index of comps_objlist_find_by_x */
 } COMPS_ObjList;
 COMPS_Object_TAIL(COMPS_ObjList);
 
@@ -103,7 +128,7 @@ int comps_objlist_append_x(COMPS_ObjList *objlist, COMPS_Object *obj);
  */
 int comps_objlist_append(COMPS_ObjList *objlist, COMPS_Object *obj);
 
-/** Return item's object at specified position
+/** Return item's object at specified position in constant time
  *
  * Returned object has incremented reference counter
  * @param objlist COMPS_ObjList object
@@ -126,7 +151,7 @@ COMPS_Object* comps_objlist_get(COMPS_ObjList *objlist, unsigned int atpos);
 int comps_objlist_set(COMPS_ObjList *objlist, unsigned int atpos,
                       COMPS_Object *obj);
 
-/** Return item's object at specified position
+/** Return item's object at specified position in constant time
  *
  * Returned object HASN'T incremented reference count
  * @param objlist COMPS_ObjList object
@@ -179,6 +204,35 @@ int comps_objlist_remove(COMPS_ObjList *objlist, COMPS_Object *obj);
 
 int comps_objlist_index(COMPS_ObjList *objlist, COMPS_Object *obj);
 
+/** Return first object of list with specified key
+ * Key of object is string of object returned by key_f. Lookup goes through
+ * index built on first call. Index records version of properties dict of
+ * every item, or key object itself when props_f is NULL, and is rebuilt
+ * when list, any of them or key_f changes. Checking them only compares
+ * pointers and versions, without converting and comparing keys of items.
+ * Found object isn't incref'd
+ * @param objlist COMPS_ObjList object
+ * @param key_f function returning key object of list item without incref
+ * @param props_f function returning COMPS_ObjDict key_f reads key from,
+ * without incref, or NULL
+ * @param key searched key
+ * @return found object or NULL
+ */
+COMPS_Object* comps_objlist_find_by_x(COMPS_ObjList *objlist,
+                                      COMPS_Object* (*key_f)(COMPS_Object*),
+                                      COMPS_Object* (*props_f)(COMPS_Object*),
+                                      const char *key);
+
+/** Return item iterator at specified position in constant time
+ *
+ * Allows to start first/next walk in the middle of list
+ * @param objlist COMPS_ObjList object
+ * @param atpos item's position
+ * @return item iterator or NULL if list hasn't enough items
+ */
+COMPS_ObjListIt* comps_objlist_get_it(COMPS_ObjList *objlist,
+                                      unsigned int atpos);
+
 /** Returns new sublist from original list
  *
  * Returns new sublist from original list, starting item startit and ending
@@ -24,7 +24,7 @@
 void comps_objmrtree_data_destroy(COMPS_ObjMRTreeData * rtd) {
     free(rtd->key);
     COMPS_OBJECT_DESTROY(rtd->data);
-    comps_hslist_destroy(&rtd->subnodes);
+    comps_rnodes_destroy(&rtd->subnodes);
     free(rtd);
 }
 
@@ -49,10 +49,7 @@ static COMPS_ObjMRTreeData * __comps_objmrtree_data_create(char * key,
     rtd->data = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
     if (data)
         comps_objlist_append_x(rtd->data, data);
-    rtd->subnodes = comps_hslist_create();
-    comps_hslist_init(rtd->subnodes, NULL,
-                                     NULL,
-                                     &comps_objmrtree_data_destroy_v);
+    rtd->subnodes = comps_rnodes_create(&comps_objmrtree_data_destroy_v);
     return rtd;
 }
 
@@ -70,13 +67,13 @@ COMPS_ObjMRTreeData * comps_objmrtree_data_create_n(char * key, unsigned keylen,
 }
 static void comps_objmrtree_create(COMPS_ObjMRTree *rtree, COMPS_Object **args){
     (void)args;
-    rtree->subnodes = comps_hslist_create();
-    comps_hslist_init(rtree->subnodes, NULL, NULL, &comps_objmrtree_data_destroy_v);
+    rtree->subnodes = comps_rnodes_create(&comps_objmrtree_data_destroy_v);
     if (rtree->subnodes == NULL) {
         COMPS_OBJECT_DESTROY(rtree);
         return;
     }
     rtree->len = 0;
+    rtree->version = 0;
 }
 void comps_objmrtree_create_u(COMPS_Object * obj, COMPS_Object **args) {
     (void)args;
@@ -84,7 +81,7 @@ void comps_objmrtree_create_u(COMPS_Object * obj, COMPS_Object **args) {
 }
 
 static void comps_objmrtree_destroy(COMPS_ObjMRTree * rt) {
-    comps_hslist_destroy(&(rt->subnodes));
+    comps_rnodes_destroy(&(rt->subnodes));
 }
 void comps_objmrtree_destroy_u(COMPS_Object *obj) {
     comps_objmrtree_destroy((COMPS_ObjMRTree*)obj);
@@ -92,24 +89,27 @@ void comps_objmrtree_destroy_u(COMPS_Object *obj) {
 
 void comps_objmrtree_values_walk(COMPS_ObjMRTree * rt, void* udata,
                               void (*walk_f)(void*, void*)) {
-    COMPS_HSList *tmplist, *tmp_subnodes;
-    COMPS_HSListItem *it, *it2;
+    COMPS_HSList *tmplist;
+    COMPS_RNodes *tmp_subnodes;
+    COMPS_HSListItem *it;
+    COMPS_ObjListIt *it2;
+    COMPS_ObjMRTreeData *rtdata;
+    unsigned int i;
     tmplist = comps_hslist_create();
     comps_hslist_init(tmplist, NULL, NULL, NULL);
     comps_hslist_append(tmplist, rt->subnodes, 0);
     while (tmplist->first != NULL) {
         it = tmplist->first;
         comps_hslist_remove(tmplist, tmplist->first);
-        tmp_subnodes = (COMPS_HSList*)it->data;
+        tmp_subnodes = (COMPS_RNodes*)it->data;
         free(it);
-        for (it = tmp_subnodes->first; it != NULL; it=it->next) {
-            if (((COMPS_ObjMRTreeData*)it->data)->subnodes->first) {
-                comps_hslist_append(tmplist,
-                                    ((COMPS_ObjMRTreeData*)it->data)->subnodes, 0);
+        for (i = 0; i < tmp_subnodes->len; i++) {
+            rtdata = (COMPS_ObjMRTreeData*)tmp_subnodes->nodes[i];
+            if (rtdata->subnodes->len) {
+                comps_hslist_append(tmplist, rtdata->subnodes, 0);
             }
-            for (it2 = (COMPS_HSListItem*)((COMPS_ObjMRTreeData*)it->data)->data->first;
-                 it2 != NULL; it2 = it2->next) {
-                walk_f(udata, it2->data);
+            for (it2 = rtdata->data->first; it2 != NULL; it2 = it2->next) {
+                walk_f(udata, it2->comps_obj);
             }
         }
     }
@@ -117,48 +117,49 @@ void comps_objmrtree_values_walk(COMPS_ObjMRTree * rt, void* udata,
 }
 
 void comps_objmrtree_copy(COMPS_ObjMRTree *ret, COMPS_ObjMRTree *rt){
-    COMPS_HSList * to_clone, *tmplist, *new_subnodes;
-    COMPS_HSListItem *it, *it2;
-    COMPS_ObjMRTreeData *rtdata;
+    COMPS_HSList * to_clone;
+    COMPS_RNodes *tmpnodes, *new_subnodes;
+    COMPS_HSListItem *it2;
+    COMPS_ObjMRTreeData *rtdata, *olddata;
     COMPS_ObjList *new_data_list;
+    unsigned int i;
+
+    ret->subnodes = comps_rnodes_create(&comps_objmrtree_data_destroy_v);
+    ret->version = 0;
 
     to_clone = comps_hslist_create();
     comps_hslist_init(to_clone, NULL, NULL, NULL);
 
-    for (it = rt->subnodes->first; it != NULL; it = it->next) {
-        rtdata = comps_objmrtree_data_create(
-                                       ((COMPS_ObjMRTreeData*)it->data)->key,
-                                       NULL);
-        new_data_list = (COMPS_ObjList*)
-                        COMPS_OBJECT_COPY(((COMPS_ObjMRTreeData*)it->data)->data);
-        COMPS_OBJECT_DESTROY(&rtdata->data);
-        comps_hslist_destroy(&rtdata->subnodes);
-        rtdata->subnodes = ((COMPS_ObjMRTreeData*)it->data)->subnodes;
+    for (i = 0; i < rt->subnodes->len; i++) {
+        olddata = (COMPS_ObjMRTreeData*)rt->subnodes->nodes[i];
+        rtdata = comps_objmrtree_data_create(olddata->key, NULL);
+        new_data_list = (COMPS_ObjList*)COMPS_OBJECT_COPY(olddata->data);
+        COMPS_OBJECT_DESTROY(rtdata->data);
+        comps_rnodes_destroy(&rtdata->subnodes);
+        rtdata->subnodes = olddata->subnodes;
         rtdata->data = new_data_list;
-        comps_hslist_append(ret->subnodes, rtdata, 0);
+        comps_rnodes_insert_at(ret->subnodes, i, rtdata->key[0], rtdata);
 
         comps_hslist_append(to_clone, rtdata, 0);
     }
 
     while (to_clone->first) {
         it2 = to_clone->first;
-        tmplist = ((COMPS_ObjMRTreeData*)it2->data)->subnodes;
+        tmpnodes = ((COMPS_ObjMRTreeData*)it2->data)->subnodes;
         comps_hslist_remove(to_clone, to_clone->first);
 
-        new_subnodes = comps_hslist_create();
-        comps_hslist_init(new_subnodes, NULL, NULL, &comps_objmrtree_data_destroy_v);
-        for (it = tmplist->first; it != NULL; it = it->next) {
-            rtdata = comps_objmrtree_data_create(
-                                          ((COMPS_ObjMRTreeData*)it->data)->key,
-                                          NULL);
+        new_subnodes = comps_rnodes_create(&comps_objmrtree_data_destroy_v);
+        for (i = 0; i < tmpnodes->len; i++) {
+            olddata = (COMPS_ObjMRTreeData*)tmpnodes->nodes[i];
+            rtdata = comps_objmrtree_data_create(olddata->key, NULL);
             new_data_list = (COMPS_ObjList*)
-                            COMPS_OBJECT_COPY(((COMPS_ObjMRTreeData*)it->data)->data);
+                            COMPS_OBJECT_COPY(olddata->data);
 
-            comps_hslist_destroy(&rtdata->subnodes);
+            comps_rnodes_destroy(&rtdata->subnodes);
             COMPS_OBJECT_DESTROY(rtdata->data);
-            rtdata->subnodes = ((COMPS_ObjMRTreeData*)it->data)->subnodes;
+            rtdata->subnodes = olddata->subnodes;
             rtdata->data = new_data_list;
-            comps_hslist_append(new_subnodes, rtdata, 0);
+            comps_rnodes_insert_at(new_subnodes, i, rtdata->key[0], rtdata);
 
             comps_hslist_append(to_clone, rtdata, 0);
         }
@@ -171,47 +172,46 @@ void comps_objmrtree_copy(COMPS_ObjMRTree *ret, COMPS_ObjMRTree *rt){
 COMPS_COPY_u(objmrtree, COMPS_ObjMRTree) /*comps_utils.h macro*/
 
 void comps_objmrtree_copy_shallow(COMPS_ObjMRTree *ret, COMPS_ObjMRTree *rt){
-    COMPS_HSList * to_clone, *tmplist, *new_subnodes;
-    COMPS_HSListItem *it, *it2;
-    COMPS_ObjMRTreeData *rtdata;
+    COMPS_HSList * to_clone;
+    COMPS_RNodes *tmpnodes, *new_subnodes;
+    COMPS_HSListItem *it2;
+    COMPS_ObjMRTreeData *rtdata, *olddata;
     COMPS_ObjList *new_data_list;
+    unsigned int i;
 
     to_clone = comps_hslist_create();
     comps_hslist_init(to_clone, NULL, NULL, NULL);
 
-    for (it = rt->subnodes->first; it != NULL; it = it->next) {
-        rtdata = comps_objmrtree_data_create(
-                                       ((COMPS_ObjMRTreeData*)it->data)->key,
-                                       NULL);
-        new_data_list = (COMPS_ObjList*)
-                        COMPS_OBJECT_COPY(((COMPS_ObjMRTreeData*)it->data)->data);
-        COMPS_OBJECT_DESTROY(&rtdata->data);
-        comps_hslist_destroy(&rtdata->subnodes);
-        rtdata->subnodes = ((COMPS_ObjMRTreeData*)it->data)->subnodes;
+    for (i = 0; i < rt->subnodes->len; i++) {
+        olddata = (COMPS_ObjMRTreeData*)rt->subnodes->nodes[i];
+        rtdata = comps_objmrtree_data_create(olddata->key, NULL);
+        new_data_list = (COMPS_ObjList*)COMPS_OBJECT_COPY(olddata->data);
+        COMPS_OBJECT_DESTROY(rtdata->data);
+        comps_rnodes_destroy(&rtdata->subnodes);
+        rtdata->subnodes = olddata->subnodes;
         rtdata->data = new_data_list;
-        comps_hslist_append(ret->subnodes, rtdata, 0);
+        comps_rnodes_insert_at(ret->subnodes, i, rtdata->key[0], rtdata);
 
         comps_hslist_append(to_clone, rtdata, 0);
     }
 
     while (to_clone->first) {
         it2 = to_clone->first;
-        tmplist = ((COMPS_ObjMRTreeData*)it2->data)->subnodes;
+        tmpnodes = ((COMPS_ObjMRTreeData*)it2->data)->subnodes;
         comps_hslist_remove(to_clone, to_clone->first);
 
-        new_subnodes = comps_hslist_create();
-        comps_hslist_init(new_subnodes, NULL, NULL, &comps_objmrtree_data_destroy_v);
-        for (it = tmplist->first; it != NULL; it = it->next) {
-            rtdata = comps_objmrtree_data_create(
-                                          ((COMPS_ObjMRTreeData*)it->data)->key,
-                                          NULL);
-            new_data_list = ((COMPS_ObjMRTreeData*)it->data)->data;
+        new_subnodes = comps_rnodes_create(&comps_objmrtree_data_destroy_v);
+        for (i = 0; i < tmpnodes->len; i++) {
+            olddata = (COMPS_ObjMRTreeData*)tmpnodes->nodes[i];
+            rtdata = comps_objmrtree_data_create(olddata->key, NULL);
+            new_data_list = (COMPS_ObjList*)
+                            COMPS_OBJECT_INCREF(olddata->data);
 
-            comps_hslist_destroy(&rtdata->subnodes);
+            comps_rnodes_destroy(&rtdata->subnodes);
             COMPS_OBJECT_DESTROY(rtdata->data);
-            rtdata->subnodes = ((COMPS_ObjMRTreeData*)it->data)->subnodes;
+            rtdata->subnodes = olddata->subnodes;
             rtdata->data = new_data_list;
-            comps_hslist_append(new_subnodes, rtdata, 0);
+            comps_rnodes_insert_at(new_subnodes, i, rtdata->key[0], rtdata);
 
             comps_hslist_append(to_clone, rtdata, 0);
         }
@@ -223,50 +223,48 @@ void comps_objmrtree_copy_shallow(COMPS_ObjMRTree *ret, COMPS_ObjMRTree *rt){
 }
 
 COMPS_ObjMRTree * comps_objmrtree_clone(COMPS_ObjMRTree * rt) {
-    COMPS_HSList * to_clone, *tmplist, *new_subnodes;
+    COMPS_HSList * to_clone;
+    COMPS_RNodes *tmpnodes, *new_subnodes;
     COMPS_ObjMRTree * ret;
-    COMPS_HSListItem *it, *it2;
-    COMPS_ObjMRTreeData *rtdata;
+    COMPS_HSListItem *it2;
+    COMPS_ObjMRTreeData *rtdata, *olddata;
     COMPS_ObjList *new_data_list;
+    unsigned int i;
 
     to_clone = comps_hslist_create();
     comps_hslist_init(to_clone, NULL, NULL, NULL);
     ret = COMPS_OBJECT_CREATE(COMPS_ObjMRTree, NULL);
 
-    for (it = rt->subnodes->first; it != NULL; it = it->next) {
-        rtdata = comps_objmrtree_data_create(
-                                       ((COMPS_ObjMRTreeData*)it->data)->key,
-                                       NULL);
-        new_data_list = (COMPS_ObjList*)
-                        COMPS_OBJECT_COPY(((COMPS_ObjMRTreeData*)it->data)->data);
-        COMPS_OBJECT_DESTROY(&rtdata->data);
-        comps_hslist_destroy(&rtdata->subnodes);
-        rtdata->subnodes = ((COMPS_ObjMRTreeData*)it->data)->subnodes;
+    for (i = 0; i < rt->subnodes->len; i++) {
+        olddata = (COMPS_ObjMRTreeData*)rt->subnodes->nodes[i];
+        rtdata = comps_objmrtree_data_create(olddata->key, NULL);
+        new_data_list = (COMPS_ObjList*)COMPS_OBJECT_COPY(olddata->data);
+        COMPS_OBJECT_DESTROY(rtdata->data);
+        comps_rnodes_destroy(&rtdata->subnodes);
+        rtdata->subnodes = olddata->subnodes;
         rtdata->data = new_data_list;
-        comps_hslist_append(ret->subnodes, rtdata, 0);
+        comps_rnodes_insert_at(ret->subnodes, i, rtdata->key[0], rtdata);
 
         comps_hslist_append(to_clone, rtdata, 0);
     }
 
     while (to_clone->first) {
         it2 = to_clone->first;
-        tmplist = ((COMPS_ObjMRTreeData*)it2->data)->subnodes;
+        tmpnodes = ((COMPS_ObjMRTreeData*)it2->data)->subnodes;
         comps_hslist_remove(to_clone, to_clone->first);
 
-        new_subnodes = comps_hslist_create();
-        comps_hslist_init(new_subnodes, NULL, NULL, &comps_objmrtree_data_destroy_v);
-        for (it = tmplist->first; it != NULL; it = it->next) {
-            rtdata = comps_objmrtree_data_create(
-                                          ((COMPS_ObjMRTreeData*)it->data)->key,
-                                          NULL);
+        new_subnodes = comps_rnodes_create(&comps_objmrtree_data_destroy_v);
+        for (i = 0; i < tmpnodes->len; i++) {
+            olddata = (COMPS_ObjMRTreeData*)tmpnodes->nodes[i];
+            rtdata = comps_objmrtree_data_create(olddata->key, NULL);
             new_data_list = (COMPS_ObjList*)
-                            COMPS_OBJECT_COPY(((COMPS_ObjMRTreeData*)it->data)->data);
+                            COMPS_OBJECT_COPY(olddata->data);
 
-            comps_hslist_destroy(&rtdata->subnodes);
+            comps_rnodes_destroy(&rtdata->subnodes);
             COMPS_OBJECT_DESTROY(rtdata->data);
-            rtdata->subnodes = ((COMPS_ObjMRTreeData*)it->data)->subnodes;
+            rtdata->subnodes = olddata->subnodes;
             rtdata->data = new_data_list;
-            comps_hslist_append(new_subnodes, rtdata, 0);
+            comps_rnodes_insert_at(new_subnodes, i, rtdata->key[0], rtdata);
 
             comps_hslist_append(to_clone, rtdata, 0);
         }
@@ -279,11 +277,14 @@ COMPS_ObjMRTree * comps_objmrtree_clone(COMPS_ObjMRTree * rt) {
 }
 
 void comps_objmrtree_unite(COMPS_ObjMRTree *rt1, COMPS_ObjMRTree *rt2) {
-    COMPS_HSList *tmplist, *tmp_subnodes;
+    COMPS_HSList *tmplist;
+    COMPS_RNodes *tmp_subnodes;
     COMPS_HSListItem *it;
     COMPS_ObjListIt *it2;
+    COMPS_ObjMRTreeData *rtdata;
+    unsigned int i;
     struct Pair {
-        COMPS_HSList * subnodes;
+        COMPS_RNodes * subnodes;
         char * key;
     } *pair, *parent_pair;
 
@@ -302,35 +303,32 @@ void comps_objmrtree_unite(COMPS_ObjMRTree *rt1, COMPS_ObjMRTree *rt2) {
         parent_pair = (struct Pair*) it->data;
         free(it);
 
-        for (it = tmp_subnodes->first; it != NULL; it=it->next) {
+        for (i = 0; i < tmp_subnodes->len; i++) {
+            rtdata = (COMPS_ObjMRTreeData*)tmp_subnodes->nodes[i];
             pair = malloc(sizeof(struct Pair));
-            pair->subnodes = ((COMPS_ObjMRTreeData*)it->data)->subnodes;
+            pair->subnodes = rtdata->subnodes;
 
             if (parent_pair->key != NULL) {
                 pair->key =
                     malloc(sizeof(char)
-                           * (strlen(((COMPS_ObjMRTreeData*)it->data)->key)
+                           * (strlen(rtdata->key)
                            + strlen(parent_pair->key) + 1));
                 memcpy(pair->key, parent_pair->key,
                        sizeof(char) * strlen(parent_pair->key));
-                memcpy(pair->key+strlen(parent_pair->key),
-                       ((COMPS_ObjMRTreeData*)it->data)->key,
-                       sizeof(char)*(strlen(((COMPS_ObjMRTreeData*)it->data)->key)+1));
+                memcpy(pair->key+strlen(parent_pair->key), rtdata->key,
+                       sizeof(char)*(strlen(rtdata->key)+1));
             } else {
-                pair->key = malloc(sizeof(char)*
-                                (strlen(((COMPS_ObjMRTreeData*)it->data)->key) +
-                                1));
-                memcpy(pair->key, ((COMPS_ObjMRTreeData*)it->data)->key,
-                       sizeof(char)*(strlen(((COMPS_ObjMRTreeData*)it->data)->key)+1));
+                pair->key = malloc(sizeof(char)* (strlen(rtdata->key) + 1));
+                memcpy(pair->key, rtdata->key,
+                       sizeof(char)*(strlen(rtdata->key)+1));
             }
             /* current node has data */
-            if (((COMPS_ObjMRTreeData*)it->data)->data->first != NULL) {
-                for (it2 = ((COMPS_ObjMRTreeData*)it->data)->data->first;
-                     it2 != NULL; it2 = it2->next) {
+            if (rtdata->data->first != NULL) {
+                for (it2 = rtdata->data->first; it2 != NULL; it2 = it2->next) {
                     comps_objmrtree_set(rt1, pair->key, it2->comps_obj);
                 }
 
-                if (((COMPS_ObjMRTreeData*)it->data)->subnodes->first) {
+                if (rtdata->subnodes->len) {
                     comps_hslist_append(tmplist, pair, 0);
                 } else {
                     free(pair->key);
@@ -338,7 +336,7 @@ void comps_objmrtree_unite(COMPS_ObjMRTree *rt1, COMPS_ObjMRTree *rt2) {
                 }
             /* current node hasn't data */
             } else {
-                if (((COMPS_ObjMRTreeData*)it->data)->subnodes->first) {
+                if (rtdata->subnodes->len) {
                     comps_hslist_append(tmplist, pair, 0);
                 } else {
                     free(pair->key);
@@ -361,35 +359,29 @@ void comps_objmrtree_set(COMPS_ObjMRTree *rt, char *key, COMPS_Object *data) {
 
 void __comps_objmrtree_set(COMPS_ObjMRTree *rt, char *key,
                            size_t len, COMPS_Object *ndata) {
-    static COMPS_HSListItem *it;
-    COMPS_HSList *subnodes;
-    COMPS_ObjMRTreeData *rtd;
-    static COMPS_ObjMRTreeData *rtdata;
+    COMPS_RNodes *subnodes;
+    COMPS_ObjMRTreeData *rtd, *rtdata;
 
     size_t _len, offset=0;
-    unsigned x, found = 0;
-    char ended;//, tmpch;
+    unsigned x;
+    int pos;
+    char ended;
 
     if (rt->subnodes == NULL)
         return;
+    rt->version++;
 
     subnodes = rt->subnodes;
     while (offset != len)
     {
-        found = 0;
-        for (it = subnodes->first; it != NULL; it = it->next) {
-            if (((COMPS_ObjMRTreeData*)it->data)->key[0] == key[offset]) {
-                found = 1;
-                break;
-            }
-        }
-        if (!found) { // not found in subnodes; create new subnode
-            rtd = comps_objmrtree_data_create(key+offset, ndata);
-            comps_hslist_append(subnodes, rtd, 0);
+        pos = comps_rnodes_find(subnodes, key[offset]);
+        if (pos == -1) { // not found in subnodes; create new subnode
+            rtd = comps_objmrtree_data_create_n(key+offset, len-offset, ndata);
+            comps_rnodes_insert(subnodes, key[offset], rtd);
             rt->len++;
             return;
         } else {
-            rtdata = (COMPS_ObjMRTreeData*)it->data;
+            rtdata = (COMPS_ObjMRTreeData*)subnodes->nodes[pos];
             ended = 0;
             for (x=1; ;x++) {
                 if (rtdata->key[x] == 0) ended += 1;
@@ -402,18 +394,16 @@ void __comps_objmrtree_set(COMPS_ObjMRTree *rt, char *key,
                 rt->len++;
                 return;
             } else if (ended == 2) { //global key ends first; make global leaf
-                comps_hslist_remove(subnodes, it);
-                it->next = NULL;
-                rtd = comps_objmrtree_data_create(key+offset, ndata);
-                comps_hslist_append(subnodes, rtd, 0);
-                ((COMPS_ObjMRTreeData*)subnodes->last->data)->subnodes->last = it;
-                ((COMPS_ObjMRTreeData*)subnodes->last->data)->subnodes->first = it;
-                _len = strlen(key + offset);
+                rtd = comps_objmrtree_data_create_n(key+offset, len-offset,
+                                                    ndata);
+                subnodes->nodes[pos] = rtd;
+                _len = len - offset;
                 memmove(rtdata->key,rtdata->key + _len,
                                     strlen(rtdata->key) - _len);
                 rtdata->key[strlen(rtdata->key) - _len] = 0;
                 rtdata->key = realloc(rtdata->key,
                                       sizeof(char)* (strlen(rtdata->key)+1));
+                comps_rnodes_insert(rtd->subnodes, rtdata->key[0], rtdata);
                 rt->len++;
                 return;
             } else if (ended == 1) { //local key ends first; go deeper
@@ -421,35 +411,23 @@ void __comps_objmrtree_set(COMPS_ObjMRTree *rt, char *key,
                 offset += x;
             } else { /* keys differ */
                 COMPS_ObjList *tmpdata = rtdata->data;
-                COMPS_HSList *tmphslist = rtdata->subnodes;
+                COMPS_RNodes *tmpnodes = rtdata->subnodes;
 
-                rtdata->subnodes = comps_hslist_create();
-                comps_hslist_init(rtdata->subnodes, NULL, NULL,
-                                  &comps_objmrtree_data_destroy_v);
-                int cmpret = strcmp(key+offset+x, rtdata->key+x);
+                rtdata->subnodes = comps_rnodes_create(
+                                            &comps_objmrtree_data_destroy_v);
                 rtdata->data = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
 
-                if (cmpret > 0) {
-                    rtd = comps_objmrtree_data_create(rtdata->key+x,
-                                                      (COMPS_Object*)tmpdata);
-                    comps_hslist_destroy(&rtd->subnodes);
-                    rtd->subnodes = tmphslist;
+                rtd = comps_objmrtree_data_create(rtdata->key+x, NULL);
+                COMPS_OBJECT_DESTROY(rtd->data);
+                rtd->data = tmpdata;
+                comps_rnodes_destroy(&rtd->subnodes);
+                rtd->subnodes = tmpnodes;
+                comps_rnodes_insert(rtdata->subnodes, rtd->key[0], rtd);
 
-                    comps_hslist_append(rtdata->subnodes, rtd, 0);
-                    rtd = comps_objmrtree_data_create(key+offset+x,
-                                                     (COMPS_Object*)ndata);
-                    comps_hslist_append(rtdata->subnodes, rtd, 0);
+                rtd = comps_objmrtree_data_create_n(key+offset+x,
+                                                    len-offset-x, ndata);
+                comps_rnodes_insert(rtdata->subnodes, rtd->key[0], rtd);
 
-                } else {
-                    rtd = comps_objmrtree_data_create(key+offset+x,
-                                                     (COMPS_Object*)ndata);
-                    comps_hslist_append(rtdata->subnodes, rtd, 0);
-                    rtd = comps_objmrtree_data_create(rtdata->key+x,
-                                                     (COMPS_Object*)tmpdata);
-                    comps_hslist_destroy(&rtd->subnodes);
-                    rtd->subnodes = tmphslist;
-                    comps_hslist_append(rtdata->subnodes, rtd, 0);
-                }
                 rtdata->key = realloc(rtdata->key, sizeof(char)*(x+1));
                 rtdata->key[x] = 0;
                 rt->len++;
@@ -465,26 +443,20 @@ void comps_objmrtree_set_n(COMPS_ObjMRTree *rt, char *key,
 }
 
 COMPS_ObjList * comps_objmrtree_get(COMPS_ObjMRTree * rt, const char * key) {
-    COMPS_HSList * subnodes;
-    COMPS_HSListItem * it = NULL;
+    COMPS_RNodes * subnodes;
     COMPS_ObjMRTreeData * rtdata;
     unsigned int offset, len, x;
-    char found, ended;
+    int pos;
+    char ended;
 
     len = strlen(key);
     offset = 0;
     subnodes = rt->subnodes;
     while (offset != len) {
-        found = 0;
-        for (it = subnodes->first; it != NULL; it=it->next) {
-            if (((COMPS_ObjMRTreeData*)it->data)->key[0] == key[offset]) {
-                found = 1;
-                break;
-            }
-        }
-        if (!found)
+        pos = comps_rnodes_find(subnodes, key[offset]);
+        if (pos == -1)
             return NULL;
-        rtdata = (COMPS_ObjMRTreeData*)it->data;
+        rtdata = (COMPS_ObjMRTreeData*)subnodes->nodes[pos];
 
         for (x=1; ;x++) {
             ended=0;
@@ -497,45 +469,37 @@ COMPS_ObjList * comps_objmrtree_get(COMPS_ObjMRTree * rt, const char * key) {
                                comps_object_incref((COMPS_Object*)rtdata->data);
         else if (ended == 1) offset+=x;
         else return NULL;
-        subnodes = ((COMPS_ObjMRTreeData*)it->data)->subnodes;
+        subnodes = rtdata->subnodes;
     }
-    if (it)
-        return ((COMPS_ObjMRTreeData*)it->data)->data;
-    else return NULL;
+    return NULL;
 }
 
 void comps_objmrtree_unset(COMPS_ObjMRTree * rt, const char * key) {
-    COMPS_HSList * subnodes;
-    COMPS_HSListItem * it;
+    COMPS_RNodes * subnodes;
     COMPS_ObjMRTreeData * rtdata;
-    unsigned int offset, len, x;
-    char found, ended;
-    COMPS_HSList * path;
+    unsigned int offset, len, x, depth;
+    int pos;
+    char ended;
 
     struct Relation {
-        COMPS_HSList * parent_nodes;
-        COMPS_HSListItem * child_it;
-    } *relation;
-
-    path = comps_hslist_create();
-    comps_hslist_init(path, NULL, NULL, &free);
+        COMPS_RNodes * parent_nodes;
+        unsigned int child_pos;
+    } *path;
 
     len = strlen(key);
+    /* every step along the path consumes at least one char of key */
+    if ((path = malloc(sizeof(*path) * (len + 1))) == NULL)
+        return;
+    rt->version++;
     offset = 0;
+    depth = 0;
     subnodes = rt->subnodes;
     while (offset != len) {
-        found = 0;
-        for (it = subnodes->first; it != NULL; it=it->next) {
-            if (((COMPS_ObjMRTreeData*)it->data)->key[0] == key[offset]) {
-                found = 1;
-                break;
-            }
-        }
-        if (!found) {
-            comps_hslist_destroy(&path);
-            return;
+        pos = comps_rnodes_find(subnodes, key[offset]);
+        if (pos == -1) {
+            break;
         }
-        rtdata = (COMPS_ObjMRTreeData*)it->data;
+        rtdata = (COMPS_ObjMRTreeData*)subnodes->nodes[pos];
 
         for (x=1; ;x++) {
             ended=0;
@@ -544,60 +508,35 @@ void comps_objmrtree_unset(COMPS_ObjMRTree * rt, const char * key) {
             if (ended != 0) break;
             if (key[offset+x] != rtdata->key[x]) break;
         }
-        if (ended == 3) {
-            /* remove node from tree only if there's no descendant*/
-            if (rtdata->subnodes->last == NULL) {
-                comps_hslist_remove(subnodes, it);
-                rt->len -= rtdata->data->len;
-                comps_objmrtree_data_destroy(rtdata);
-                free(it);
-            }
-            else {
-                rt->len -= rtdata->data->len;
-                comps_objlist_clear(rtdata->data);
-                rtdata->is_leaf = 0;
-            }
-
-            if (path->last == NULL) {
-                comps_hslist_destroy(&path);
-                return;
-            }
-            rtdata = (COMPS_ObjMRTreeData*)
-                     ((struct Relation*)path->last->data)->child_it->data;
+        path[depth].parent_nodes = subnodes;
+        path[depth].child_pos = pos;
+        depth++;
 
-            /*remove all predecessor of deleted node (recursive) with no childs*/
-            while (rtdata->subnodes->last == NULL) {
-                //printf("removing '%s'\n", rtdata->key);
-                comps_objmrtree_data_destroy(rtdata);
-                comps_hslist_remove(
-                            ((struct Relation*)path->last->data)->parent_nodes,
-                            ((struct Relation*)path->last->data)->child_it);
-                free(((struct Relation*)path->last->data)->child_it);
-                it = path->last;
-                comps_hslist_remove(path, path->last);
-                free(it);
+        if (ended == 3) {
+            rt->len -= rtdata->data->len;
+            comps_objlist_clear(rtdata->data);
+            rtdata->is_leaf = 0;
+
+            /*remove deleted node and all its predecessors left without data
+              and descendants*/
+            while (depth--) {
+                subnodes = path[depth].parent_nodes;
                 rtdata = (COMPS_ObjMRTreeData*)
-                         ((struct Relation*)path->last->data)->child_it->data;
+                         subnodes->nodes[path[depth].child_pos];
+                if (rtdata->data->len != 0 || rtdata->subnodes->len != 0)
+                    break;
+                comps_rnodes_remove_at(subnodes, path[depth].child_pos);
+                comps_objmrtree_data_destroy(rtdata);
             }
-            comps_hslist_destroy(&path);
-            return;
+            break;
         }
         else if (ended == 1) offset+=x;
         else {
-            comps_hslist_destroy(&path);
-            return;
-        }
-        if ((relation = malloc(sizeof(struct Relation))) == NULL) {
-            comps_hslist_destroy(&path);
-            return;
+            break;
         }
-        subnodes = ((COMPS_ObjMRTreeData*)it->data)->subnodes;
-        relation->parent_nodes = subnodes;
-        relation->child_it = it;
-        comps_hslist_append(path, (void*)relation, 0);
+        subnodes = rtdata->subnodes;
     }
-    comps_hslist_destroy(&path);
-    return;
+    free(path);
 }
 
 inline void comps_objmrtree_pair_destroy_v(void * pair) {
@@ -606,18 +545,11 @@ inline void comps_objmrtree_pair_destroy_v(void * pair) {
 }
 
 static inline COMPS_HSList* __comps_objmrtree_all(COMPS_ObjMRTree * rt, char keyvalpair) {
-    COMPS_HSList *to_process, *ret;
-    COMPS_HSListItem *hsit, *oldit;
-    size_t x;
-    struct Pair {
-        char *key;
-        void *data;
-        COMPS_HSList *subnodes;
-    } *pair, *current_pair=NULL;//, *oldpair=NULL;
+    COMPS_HSList *ret;
+    COMPS_ObjMRTreeIt it;
     COMPS_ObjMRTreePair *rtpair;
-
-    to_process = comps_hslist_create();
-    comps_hslist_init(to_process, NULL, NULL, &free);
+    const char *key;
+    COMPS_ObjList *data;
 
     ret = comps_hslist_create();
     if (keyvalpair == 0)
@@ -627,46 +559,43 @@ static inline COMPS_HSList* __comps_objmrtree_all(COMPS_ObjMRTree * rt, char key
     else
         comps_hslist_init(ret, NULL, NULL, &comps_objmrtree_pair_destroy_v);
 
-    for (hsit = rt->subnodes->first; hsit != NULL; hsit = hsit->next) {
-        pair = malloc(sizeof(struct Pair));
-        pair->key = __comps_strcpy(((COMPS_ObjMRTreeData*)hsit->data)->key);
-        pair->data = ((COMPS_ObjMRTreeData*)hsit->data)->data;
-        pair->subnodes = ((COMPS_ObjMRTreeData*)hsit->data)->subnodes;
-        comps_hslist_append(to_process, pair, 0);
-    }
-    while (to_process->first) {
-        //oldpair = current_pair;
-        current_pair = to_process->first->data;
-        oldit = to_process->first;
-        comps_hslist_remove(to_process, to_process->first);
-        if (current_pair->data) {
-            if (keyvalpair == 0) {
-                comps_hslist_append(ret, __comps_strcpy(current_pair->key), 0);
-            } else if (keyvalpair == 1) {
-                comps_hslist_append(ret, current_pair->data, 0);
-            } else {
-                rtpair = malloc(sizeof(COMPS_ObjMRTreePair));
-                rtpair->key = __comps_strcpy(current_pair->key);
-                rtpair->data = current_pair->data;
-                comps_hslist_append(ret, rtpair, 0);
-            }
+    comps_objmrtree_it_init(&it, rt);
+    while (comps_objmrtree_it_next(&it, &key, &data)) {
+        if (keyvalpair == 0) {
+            comps_hslist_append(ret, __comps_strcpy((char*)key), 0);
+        } else if (keyvalpair == 1) {
+            comps_hslist_append(ret, data, 0);
+        } else {
+            rtpair = malloc(sizeof(COMPS_ObjMRTreePair));
+            rtpair->key = __comps_strcpy((char*)key);
+            rtpair->data = data;
+            comps_hslist_append(ret, rtpair, 0);
         }
-        for (hsit = current_pair->subnodes->first, x = 0;
-             hsit != NULL; hsit = hsit->next, x++) {
-            pair = malloc(sizeof(struct Pair));
-            pair->key = __comps_strcat(current_pair->key,
-                                       ((COMPS_ObjMRTreeData*)hsit->data)->key);
-            pair->data = ((COMPS_ObjMRTreeData*)hsit->data)->data;
-            pair->subnodes = ((COMPS_ObjMRTreeData*)hsit->data)->subnodes;
-            comps_hslist_insert_at(to_process, x, pair, 0);
+    }
+    comps_objmrtree_it_destroy(&it);
+    return ret;
+}
+
+void comps_objmrtree_it_init(COMPS_ObjMRTreeIt *it, COMPS_ObjMRTree *rt) {
+    comps_rnodes_it_init(it, rt->subnodes);
+}
+
+int comps_objmrtree_it_next(COMPS_ObjMRTreeIt *it, const char **key, COMPS_ObjList **data) {
+    COMPS_ObjMRTreeData *rtdata;
+    while ((rtdata = comps_rnodes_it_next(it)) != NULL) {
+        if (!comps_rnodes_it_enter(it, rtdata->key, rtdata->subnodes))
+            return 0;
+        if (rtdata->data) {
+            *key = it->key;
+            *data = rtdata->data;
+            return 1;
         }
-        free(current_pair->key);
-        free(current_pair);
-        free(oldit);
     }
+    return 0;
+}
 
-    comps_hslist_destroy(&to_process);
-    return ret;
+void comps_objmrtree_it_destroy(COMPS_ObjMRTreeIt *it) {
+    comps_rnodes_it_destroy(it);
 }
 
 COMPS_HSList* comps_objmrtree_keys(COMPS_ObjMRTree * rt) {
@@ -682,22 +611,11 @@ COMPS_HSList* comps_objmrtree_pairs(COMPS_ObjMRTree * rt) {
 }
 
 void comps_objmrtree_clear(COMPS_ObjMRTree * rt) {
-    COMPS_HSListItem *it, *oldit;
     if (rt == NULL) return;
     if (rt->subnodes == NULL) return;
-    oldit = rt->subnodes->first;
-    it = (oldit)?oldit->next:NULL;
-    for (;it != NULL; it=it->next) {
-        if (rt->subnodes->data_destructor != NULL)
-            rt->subnodes->data_destructor(oldit->data);
-        free(oldit);
-        oldit = it;
-    }
-    if (oldit) {
-        if (rt->subnodes->data_destructor != NULL)
-            rt->subnodes->data_destructor(oldit->data);
-        free(oldit);
-    }
+    comps_rnodes_clear(rt->subnodes);
+    rt->len = 0;
+    rt->version++;
 }
 
 char comps_objmrtree_paircmp(void *obj1, void *obj2) {
@@ -737,10 +655,29 @@ signed char comps_objmrtree_cmp(COMPS_ObjMRTree *ort1, COMPS_ObjMRTree *ort2) {
 }
 COMPS_CMP_u(objmrtree, COMPS_ObjMRTree)
 
+COMPS_Digest comps_objmrtree_digest_u(COMPS_Object *obj) {
+    COMPS_ObjMRTreeIt it;
+    COMPS_Digest ret;
+    COMPS_ObjList *data;
+    const char *key;
+    uint64_t count = 0;
+
+    ret = comps_digest_str(COMPS_DIGEST_INIT, "mdict");
+    comps_objmrtree_it_init(&it, (COMPS_ObjMRTree*)obj);
+    while (comps_objmrtree_it_next(&it, &key, &data)) {
+        count++;
+        ret = comps_digest_str(ret, key);
+        ret = comps_digest_u64(ret, comps_object_digest((COMPS_Object*)data));
+    }
+    comps_objmrtree_it_destroy(&it);
+    return comps_digest_finish(comps_digest_u64(ret, count));
+}
+
 COMPS_ObjectInfo COMPS_ObjMRTree_ObjInfo = {
     .obj_size = sizeof(COMPS_ObjMRTree),
     .constructor = &comps_objmrtree_create_u,
     .destructor = &comps_objmrtree_destroy_u,
     .copy = &comps_objmrtree_copy_u,
-    .obj_cmp = &comps_objmrtree_cmp_u
+    .obj_cmp = &comps_objmrtree_cmp_u,
+    .digest = &comps_objmrtree_digest_u
 };
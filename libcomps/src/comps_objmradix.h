@@ -26,21 +26,27 @@
 #include "comps_obj.h"
 #include "comps_utils.h"
 #include "comps_hslist.h"
+#include "comps_rnodes.h"
 #include "comps_objlist.h"
 
 typedef struct {
     char * key;
     unsigned is_leaf;
-    COMPS_HSList * subnodes;
+    COMPS_RNodes * subnodes;
     COMPS_ObjList * data;
 } COMPS_ObjMRTreeData;
 
 typedef struct {
     COMPS_Object_HEAD;
-    COMPS_HSList *  subnodes;
+    COMPS_RNodes *  subnodes;
     unsigned int len;
+    /* bumped on every structural change, used to detect modification
+     * during iteration */
+    unsigned int version;
 } COMPS_ObjMRTree;
 
+typedef COMPS_RNodesIt COMPS_ObjMRTreeIt;
+
 typedef struct {
     char *key;
     COMPS_ObjList *data;
@@ -80,6 +86,18 @@ void comps_objmrtree_unite(COMPS_ObjMRTree *rt1, COMPS_ObjMRTree *rt2);
 
 COMPS_HSList* comps_objmrtree_pairs(COMPS_ObjMRTree * rt);
 
+/** Digest of keys and value lists in key order, never cached
+ * @see comps_object_digest */
+COMPS_Digest comps_objmrtree_digest_u(COMPS_Object *rt);
+
+/* Iterator doesn't allocate for common trees and yields borrowed key and
+ * value. Key is valid until next call of comps_objmrtree_it_next. Tree mustn't
+ * be modified during iteration */
+void comps_objmrtree_it_init(COMPS_ObjMRTreeIt *it, COMPS_ObjMRTree *rt);
+int comps_objmrtree_it_next(COMPS_ObjMRTreeIt *it, const char **key,
+                            COMPS_ObjList **data);
+void comps_objmrtree_it_destroy(COMPS_ObjMRTreeIt *it);
+
 extern COMPS_ObjectInfo COMPS_ObjMRTree_ObjInfo;
 
 #endif
@@ -24,7 +24,7 @@
 void comps_objrtree_data_destroy(COMPS_ObjRTreeData * rtd) {
     free(rtd->key);
     comps_object_destroy(rtd->data);
-    comps_hslist_destroy(&rtd->subnodes);
+    comps_rnodes_destroy(&rtd->subnodes);
     free(rtd);
 }
 
@@ -48,8 +48,7 @@ inline COMPS_ObjRTreeData * __comps_objrtree_data_create(char *key,
     if (data != NULL) {
         rtd->is_leaf = 1;
     }
-    rtd->subnodes = comps_hslist_create();
-    comps_hslist_init(rtd->subnodes, NULL, NULL, &comps_objrtree_data_destroy_v);
+    rtd->subnodes = comps_rnodes_create(&comps_objrtree_data_destroy_v);
     return rtd;
 }
 
@@ -68,13 +67,16 @@ COMPS_ObjRTreeData * comps_objrtree_data_create_n(char *key, size_t keylen,
 
 static void comps_objrtree_create(COMPS_ObjRTree *rtree, COMPS_Object **args) {
     (void)args;
-    rtree->subnodes = comps_hslist_create();
-    comps_hslist_init(rtree->subnodes, NULL, NULL, &comps_objrtree_data_destroy_v);
+    rtree->subnodes = comps_rnodes_create(&comps_objrtree_data_destroy_v);
     if (rtree->subnodes == NULL) {
         COMPS_OBJECT_DESTROY(rtree);
         return;
     }
     rtree->len = 0;
+    rtree->version = 0;
+    rtree->keys_version = 0;
+    rtree->digest_cached = 0;
+    rtree->digest_version = 0;
 }
 void comps_objrtree_create_u(COMPS_Object * obj, COMPS_Object **args) {
     (void)args;
@@ -82,7 +84,7 @@ void comps_objrtree_create_u(COMPS_Object * obj, COMPS_Object **args) {
 }
 
 static void comps_objrtree_destroy(COMPS_ObjRTree * rt) {
-    comps_hslist_destroy(&(rt->subnodes));
+    comps_rnodes_destroy(&(rt->subnodes));
 }
 void comps_objrtree_destroy_u(COMPS_Object *obj) {
     comps_objrtree_destroy((COMPS_ObjRTree*)obj);
@@ -90,11 +92,13 @@ void comps_objrtree_destroy_u(COMPS_Object *obj) {
 
 COMPS_ObjRTree * comps_objrtree_clone(COMPS_ObjRTree *rt) {
 
-    COMPS_HSList *to_clone, *tmplist, *new_subnodes;
+    COMPS_HSList *to_clone;
+    COMPS_RNodes *tmpnodes, *new_subnodes;
     COMPS_ObjRTree *ret;
-    COMPS_HSListItem *it, *it2;
-    COMPS_ObjRTreeData *rtdata;
+    COMPS_HSListItem *it2;
+    COMPS_ObjRTreeData *rtdata, *olddata;
     COMPS_Object *new_data;
+    unsigned int i;
 
     if (!rt) return NULL;
 
@@ -103,38 +107,37 @@ COMPS_ObjRTree * comps_objrtree_clone(COMPS_ObjRTree *rt) {
     ret = COMPS_OBJECT_CREATE(COMPS_ObjRTree, NULL);
     ret->len = rt->len;
 
-    for (it = rt->subnodes->first; it != NULL; it = it->next) {
-        rtdata = comps_objrtree_data_create(
-                                    ((COMPS_ObjRTreeData*)it->data)->key, NULL);
-        if (((COMPS_ObjRTreeData*)it->data)->data != NULL)
-            new_data = comps_object_copy(((COMPS_ObjRTreeData*)it->data)->data);
+    for (i = 0; i < rt->subnodes->len; i++) {
+        olddata = (COMPS_ObjRTreeData*)rt->subnodes->nodes[i];
+        rtdata = comps_objrtree_data_create(olddata->key, NULL);
+        if (olddata->data != NULL)
+            new_data = comps_object_copy(olddata->data);
         else
             new_data = NULL;
-        comps_hslist_destroy(&rtdata->subnodes);
-        rtdata->subnodes = ((COMPS_ObjRTreeData*)it->data)->subnodes;
+        comps_rnodes_destroy(&rtdata->subnodes);
+        rtdata->subnodes = olddata->subnodes;
         rtdata->data = new_data;
-        comps_hslist_append(ret->subnodes, rtdata, 0);
+        comps_rnodes_insert_at(ret->subnodes, i, rtdata->key[0], rtdata);
         comps_hslist_append(to_clone, rtdata, 0);
     }
 
     while (to_clone->first) {
         it2 = to_clone->first;
-        tmplist = ((COMPS_ObjRTreeData*)it2->data)->subnodes;
+        tmpnodes = ((COMPS_ObjRTreeData*)it2->data)->subnodes;
         comps_hslist_remove(to_clone, to_clone->first);
 
-        new_subnodes = comps_hslist_create();
-        comps_hslist_init(new_subnodes, NULL, NULL, &comps_objrtree_data_destroy_v);
-        for (it = tmplist->first; it != NULL; it = it->next) {
-            rtdata = comps_objrtree_data_create(
-                                      ((COMPS_ObjRTreeData*)it->data)->key, NULL);
-            if (((COMPS_ObjRTreeData*)it->data)->data != NULL)
-                new_data = comps_object_copy(((COMPS_ObjRTreeData*)it->data)->data);
+        new_subnodes = comps_rnodes_create(&comps_objrtree_data_destroy_v);
+        for (i = 0; i < tmpnodes->len; i++) {
+            olddata = (COMPS_ObjRTreeData*)tmpnodes->nodes[i];
+            rtdata = comps_objrtree_data_create(olddata->key, NULL);
+            if (olddata->data != NULL)
+                new_data = comps_object_copy(olddata->data);
             else
                 new_data = NULL;
-            comps_hslist_destroy(&rtdata->subnodes);
-            rtdata->subnodes = ((COMPS_ObjRTreeData*)it->data)->subnodes;
+            comps_rnodes_destroy(&rtdata->subnodes);
+            rtdata->subnodes = olddata->subnodes;
             rtdata->data = new_data;
-            comps_hslist_append(new_subnodes, rtdata, 0);
+            comps_rnodes_insert_at(new_subnodes, i, rtdata->key[0], rtdata);
             comps_hslist_append(to_clone, rtdata, 0);
         }
         ((COMPS_ObjRTreeData*)it2->data)->subnodes = new_subnodes;
@@ -144,54 +147,58 @@ COMPS_ObjRTree * comps_objrtree_clone(COMPS_ObjRTree *rt) {
     return ret;
 }
 void comps_objrtree_copy(COMPS_ObjRTree *rt1, COMPS_ObjRTree *rt2){
-    COMPS_HSList *to_clone, *tmplist, *new_subnodes;
-    COMPS_HSListItem *it, *it2;
-    COMPS_ObjRTreeData *rtdata;
+    COMPS_HSList *to_clone;
+    COMPS_RNodes *tmpnodes, *new_subnodes;
+    COMPS_HSListItem *it2;
+    COMPS_ObjRTreeData *rtdata, *olddata;
     COMPS_Object *new_data;
+    unsigned int i;
 
-    rt1->subnodes = comps_hslist_create();
-    comps_hslist_init(rt1->subnodes, NULL, NULL, &comps_objrtree_data_destroy_v);
+    rt1->subnodes = comps_rnodes_create(&comps_objrtree_data_destroy_v);
     if (rt1->subnodes == NULL) {
         COMPS_OBJECT_DESTROY(rt1);
         return;
     }
-    rt1->len = 0;
+    rt1->len = rt2->len;
+    rt1->version = 0;
+    rt1->keys_version = 0;
+    rt1->digest_cached = 0;
+    rt1->digest_version = 0;
 
     to_clone = comps_hslist_create();
     comps_hslist_init(to_clone, NULL, NULL, NULL);
 
-    for (it = rt2->subnodes->first; it != NULL; it = it->next) {
-        rtdata = comps_objrtree_data_create(
-                                    ((COMPS_ObjRTreeData*)it->data)->key, NULL);
-        if (((COMPS_ObjRTreeData*)it->data)->data != NULL)
-            new_data = comps_object_copy(((COMPS_ObjRTreeData*)it->data)->data);
+    for (i = 0; i < rt2->subnodes->len; i++) {
+        olddata = (COMPS_ObjRTreeData*)rt2->subnodes->nodes[i];
+        rtdata = comps_objrtree_data_create(olddata->key, NULL);
+        if (olddata->data != NULL)
+            new_data = comps_object_copy(olddata->data);
         else
             new_data = NULL;
-        comps_hslist_destroy(&rtdata->subnodes);
-        rtdata->subnodes = ((COMPS_ObjRTreeData*)it->data)->subnodes;
+        comps_rnodes_destroy(&rtdata->subnodes);
+        rtdata->subnodes = olddata->subnodes;
         rtdata->data = new_data;
-        comps_hslist_append(rt1->subnodes, rtdata, 0);
+        comps_rnodes_insert_at(rt1->subnodes, i, rtdata->key[0], rtdata);
         comps_hslist_append(to_clone, rtdata, 0);
     }
 
     while (to_clone->first) {
         it2 = to_clone->first;
-        tmplist = ((COMPS_ObjRTreeData*)it2->data)->subnodes;
+        tmpnodes = ((COMPS_ObjRTreeData*)it2->data)->subnodes;
         comps_hslist_remove(to_clone, to_clone->first);
 
-        new_subnodes = comps_hslist_create();
-        comps_hslist_init(new_subnodes, NULL, NULL, &comps_objrtree_data_destroy_v);
-        for (it = tmplist->first; it != NULL; it = it->next) {
-            rtdata = comps_objrtree_data_create(
-                                      ((COMPS_ObjRTreeData*)it->data)->key, NULL);
-            if (((COMPS_ObjRTreeData*)it->data)->data != NULL)
-                new_data = comps_object_copy(((COMPS_ObjRTreeData*)it->data)->data);
+        new_subnodes = comps_rnodes_create(&comps_objrtree_data_destroy_v);
+        for (i = 0; i < tmpnodes->len; i++) {
+            olddata = (COMPS_ObjRTreeData*)tmpnodes->nodes[i];
+            rtdata = comps_objrtree_data_create(olddata->key, NULL);
+            if (olddata->data != NULL)
+                new_data = comps_object_copy(olddata->data);
             else
                 new_data = NULL;
-            comps_hslist_destroy(&rtdata->subnodes);
-            rtdata->subnodes = ((COMPS_ObjRTreeData*)it->data)->subnodes;
+            comps_rnodes_destroy(&rtdata->subnodes);
+            rtdata->subnodes = olddata->subnodes;
             rtdata->data = new_data;
-            comps_hslist_append(new_subnodes, rtdata, 0);
+            comps_rnodes_insert_at(new_subnodes, i, rtdata->key[0], rtdata);
             comps_hslist_append(to_clone, rtdata, 0);
         }
         ((COMPS_ObjRTreeData*)it2->data)->subnodes = new_subnodes;
@@ -203,54 +210,58 @@ void comps_objrtree_copy(COMPS_ObjRTree *rt1, COMPS_ObjRTree *rt2){
 COMPS_COPY_u(objrtree, COMPS_ObjRTree) /*comps_utils.h macro*/
 
 void comps_objrtree_copy_shallow(COMPS_ObjRTree *rt1, COMPS_ObjRTree *rt2){
-    COMPS_HSList *to_clone, *tmplist, *new_subnodes;
-    COMPS_HSListItem *it, *it2;
-    COMPS_ObjRTreeData *rtdata;
+    COMPS_HSList *to_clone;
+    COMPS_RNodes *tmpnodes, *new_subnodes;
+    COMPS_HSListItem *it2;
+    COMPS_ObjRTreeData *rtdata, *olddata;
     COMPS_Object *new_data;
+    unsigned int i;
 
-    rt1->subnodes = comps_hslist_create();
-    comps_hslist_init(rt1->subnodes, NULL, NULL, &comps_objrtree_data_destroy_v);
+    rt1->subnodes = comps_rnodes_create(&comps_objrtree_data_destroy_v);
     if (rt1->subnodes == NULL) {
         COMPS_OBJECT_DESTROY(rt1);
         return;
     }
-    rt1->len = 0;
+    rt1->len = rt2->len;
+    rt1->version = 0;
+    rt1->keys_version = 0;
+    rt1->digest_cached = 0;
+    rt1->digest_version = 0;
 
     to_clone = comps_hslist_create();
     comps_hslist_init(to_clone, NULL, NULL, NULL);
 
-    for (it = rt2->subnodes->first; it != NULL; it = it->next) {
-        rtdata = comps_objrtree_data_create(
-                                    ((COMPS_ObjRTreeData*)it->data)->key, NULL);
-        if (((COMPS_ObjRTreeData*)it->data)->data != NULL)
-            new_data = COMPS_OBJECT_INCREF(((COMPS_ObjRTreeData*)it->data)->data);
+    for (i = 0; i < rt2->subnodes->len; i++) {
+        olddata = (COMPS_ObjRTreeData*)rt2->subnodes->nodes[i];
+        rtdata = comps_objrtree_data_create(olddata->key, NULL);
+        if (olddata->data != NULL)
+            new_data = COMPS_OBJECT_INCREF(olddata->data);
         else
             new_data = NULL;
-        comps_hslist_destroy(&rtdata->subnodes);
-        rtdata->subnodes = ((COMPS_ObjRTreeData*)it->data)->subnodes;
+        comps_rnodes_destroy(&rtdata->subnodes);
+        rtdata->subnodes = olddata->subnodes;
         rtdata->data = new_data;
-        comps_hslist_append(rt1->subnodes, rtdata, 0);
+        comps_rnodes_insert_at(rt1->subnodes, i, rtdata->key[0], rtdata);
         comps_hslist_append(to_clone, rtdata, 0);
     }
 
     while (to_clone->first) {
         it2 = to_clone->first;
-        tmplist = ((COMPS_ObjRTreeData*)it2->data)->subnodes;
+        tmpnodes = ((COMPS_ObjRTreeData*)it2->data)->subnodes;
         comps_hslist_remove(to_clone, to_clone->first);
 
-        new_subnodes = comps_hslist_create();
-        comps_hslist_init(new_subnodes, NULL, NULL, &comps_objrtree_data_destroy_v);
-        for (it = tmplist->first; it != NULL; it = it->next) {
-            rtdata = comps_objrtree_data_create(
-                                      ((COMPS_ObjRTreeData*)it->data)->key, NULL);
-            if (((COMPS_ObjRTreeData*)it->data)->data != NULL)
-                new_data = comps_object_incref(((COMPS_ObjRTreeData*)it->data)->data);
+        new_subnodes = comps_rnodes_create(&comps_objrtree_data_destroy_v);
+        for (i = 0; i < tmpnodes->len; i++) {
+            olddata = (COMPS_ObjRTreeData*)tmpnodes->nodes[i];
+            rtdata = comps_objrtree_data_create(olddata->key, NULL);
+            if (olddata->data != NULL)
+                new_data = comps_object_incref(olddata->data);
             else
                 new_data = NULL;
-            comps_hslist_destroy(&rtdata->subnodes);
-            rtdata->subnodes = ((COMPS_ObjRTreeData*)it->data)->subnodes;
+            comps_rnodes_destroy(&rtdata->subnodes);
+            rtdata->subnodes = olddata->subnodes;
             rtdata->data = new_data;
-            comps_hslist_append(new_subnodes, rtdata, 0);
+            comps_rnodes_insert_at(new_subnodes, i, rtdata->key[0], rtdata);
             comps_hslist_append(to_clone, rtdata, 0);
         }
         ((COMPS_ObjRTreeData*)it2->data)->subnodes = new_subnodes;
@@ -261,22 +272,26 @@ void comps_objrtree_copy_shallow(COMPS_ObjRTree *rt1, COMPS_ObjRTree *rt2){
 
 void comps_objrtree_values_walk(COMPS_ObjRTree * rt, void* udata,
                               void (*walk_f)(void*, COMPS_Object*)) {
-    COMPS_HSList *tmplist, *tmp_subnodes;
+    COMPS_HSList *tmplist;
+    COMPS_RNodes *tmp_subnodes;
     COMPS_HSListItem *it;
+    COMPS_ObjRTreeData *rtdata;
+    unsigned int i;
     tmplist = comps_hslist_create();
     comps_hslist_init(tmplist, NULL, NULL, NULL);
     comps_hslist_append(tmplist, rt->subnodes, 0);
     while (tmplist->first != NULL) {
         it = tmplist->first;
         comps_hslist_remove(tmplist, tmplist->first);
-        tmp_subnodes = (COMPS_HSList*)it->data;
-        for (it = tmp_subnodes->first; it != NULL; it=it->next) {
-            if (((COMPS_ObjRTreeData*)it->data)->subnodes->first) {
-                comps_hslist_append(tmplist,
-                                    ((COMPS_ObjRTreeData*)it->data)->subnodes, 0);
+        tmp_subnodes = (COMPS_RNodes*)it->data;
+        free(it);
+        for (i = 0; i < tmp_subnodes->len; i++) {
+            rtdata = (COMPS_ObjRTreeData*)tmp_subnodes->nodes[i];
+            if (rtdata->subnodes->len) {
+                comps_hslist_append(tmplist, rtdata->subnodes, 0);
             }
-            if (((COMPS_ObjRTreeData*)it->data)->data != NULL) {
-               walk_f(udata, ((COMPS_ObjRTreeData*)it->data)->data);
+            if (rtdata->data != NULL) {
+               walk_f(udata, rtdata->data);
             }
         }
     }
@@ -336,47 +351,73 @@ signed char comps_objrtree_cmp(COMPS_ObjRTree *ort1, COMPS_ObjRTree *ort2) {
 }
 COMPS_CMP_u(objrtree, COMPS_ObjRTree)
 
+COMPS_Digest comps_objrtree_digest(COMPS_ObjRTree *rt) {
+    COMPS_ObjRTreeIt it;
+    COMPS_Digest ret;
+    COMPS_Object *data;
+    const char *key;
+    uint64_t count = 0;
+    char cacheable = 1;
+
+    /* outputs of the same tree in several threads may fill the cache at
+     * once. They store the same values, and digest_version is stored last,
+     * so the one seeing current version sees its digest too */
+    if (__atomic_load_n(&rt->digest_version, __ATOMIC_ACQUIRE) == rt->version
+        && __atomic_load_n(&rt->digest_cached, __ATOMIC_RELAXED))
+        return __atomic_load_n(&rt->digest, __ATOMIC_RELAXED);
+    /* len isn't decreased by unset, so entries are counted */
+    ret = comps_digest_str(COMPS_DIGEST_INIT, "dict");
+    comps_objrtree_it_init(&it, rt);
+    while (comps_objrtree_it_next(&it, &key, &data)) {
+        count++;
+        if (data->obj_info != &COMPS_Str_ObjInfo
+            && data->obj_info != &COMPS_Num_ObjInfo)
+            cacheable = 0;
+        ret = comps_digest_str(ret, key);
+        ret = comps_digest_u64(ret, comps_object_digest(data));
+    }
+    comps_objrtree_it_destroy(&it);
+    ret = comps_digest_finish(comps_digest_u64(ret, count));
+    __atomic_store_n(&rt->digest, ret, __ATOMIC_RELAXED);
+    __atomic_store_n(&rt->digest_cached, cacheable, __ATOMIC_RELAXED);
+    __atomic_store_n(&rt->digest_version, rt->version, __ATOMIC_RELEASE);
+    return ret;
+}
+
+COMPS_Digest comps_objrtree_digest_u(COMPS_Object *rt) {
+    return comps_objrtree_digest((COMPS_ObjRTree*)rt);
+}
+
 void __comps_objrtree_set(COMPS_ObjRTree *rt, char *key, size_t len,
                           COMPS_Object *ndata) {
 
-    COMPS_HSListItem *it, *lesser;
-    COMPS_HSList *subnodes;
-    COMPS_ObjRTreeData *rtd;
-    static COMPS_ObjRTreeData *rtdata;
+    COMPS_RNodes *subnodes;
+    COMPS_ObjRTreeData *rtd, *rtdata;
 
     size_t _len, offset=0;
-    unsigned x, found = 0;
+    unsigned x;
+    int pos;
     char ended;
 
-    //len = strlen(key);
-
-    if (rt->subnodes == NULL)
+    /* empty key can't be stored, value is owned by tree anyway */
+    if (rt->subnodes == NULL || len == 0) {
+        comps_object_destroy(ndata);
         return;
+    }
+    rt->version++;
 
     subnodes = rt->subnodes;
     while (offset != len)
     {
-        found = 0;
-        lesser = NULL;
-        for (it = subnodes->first; it != NULL; it=it->next) {
-            if (((COMPS_ObjRTreeData*)it->data)->key[0] == key[offset]) {
-                found = 1;
-                break;
-            } else if (((COMPS_ObjRTreeData*)it->data)->key[0] < key[offset]) {
-                lesser = it;
-            }
-        }
-        if (!found) { // not found in subnodes; create new subnode
+        pos = comps_rnodes_find(subnodes, key[offset]);
+        if (pos == -1) { // not found in subnodes; create new subnode
             rtd = comps_objrtree_data_create_n(key+offset, len-offset, ndata);
-            if (!lesser) {
-                comps_hslist_prepend(subnodes, rtd, 0);
-            } else {
-                comps_hslist_insert_after(subnodes, lesser, rtd, 0);
-            }
+            comps_rnodes_insert(subnodes, key[offset], rtd);
             rt->len++;
+            rt->keys_version++;
             return;
         } else {
-            rtdata = (COMPS_ObjRTreeData*)it->data;
+            rtdata = (COMPS_ObjRTreeData*)subnodes->nodes[pos];
             ended = 0;
             for (x=1; ;x++) {
                 if (rtdata->key[x] == 0) ended += 1;
@@ -385,17 +426,14 @@ void __comps_objrtree_set(COMPS_ObjRTree *rt, char *key, size_t len,
                 if (key[offset+x] != rtdata->key[x]) break;
             }
             if (ended == 3) { //keys equals; data replacement
+                if (rtdata->data == NULL)
+                    rt->keys_version++;
                 comps_object_destroy(rtdata->data);
                 rtdata->data = ndata;
                 return;
             } else if (ended == 2) { //global key ends first; make global leaf
-                //printf("ended2\n");
-                comps_hslist_remove(subnodes, it);
-                it->next = NULL;
                 rtd = comps_objrtree_data_create_n(key+offset, len-offset, ndata);
-                comps_hslist_append(subnodes, rtd, 0);
-                ((COMPS_ObjRTreeData*)subnodes->last->data)->subnodes->last = it;
-                ((COMPS_ObjRTreeData*)subnodes->last->data)->subnodes->first = it;
+                subnodes->nodes[pos] = rtd;
                 _len = len - offset;
 
                 memmove(rtdata->key,rtdata->key+_len,
@@ -403,41 +441,34 @@ void __comps_objrtree_set(COMPS_ObjRTree *rt, char *key, size_t len,
                 rtdata->key[strlen(rtdata->key) - _len] = 0;
                 rtdata->key = realloc(rtdata->key,
                                       sizeof(char)* (strlen(rtdata->key)+1));
+                comps_rnodes_insert(rtd->subnodes, rtdata->key[0], rtdata);
                 rt->len++;
+                rt->keys_version++;
                 return;
             } else if (ended == 1) { //local key ends first; go deeper
                 subnodes = rtdata->subnodes;
                 offset += x;
             } else {
                 COMPS_Object *tmpdata = rtdata->data;
-                COMPS_HSList *tmphslist = rtdata->subnodes;
-                //tmpch = rtdata->key[x];             // split mutual key
-                rtdata->subnodes = comps_hslist_create();
-                comps_hslist_init(rtdata->subnodes, NULL, NULL,
-                                  &comps_objrtree_data_destroy_v);
-                int cmpret = strcmp(key+offset+x, rtdata->key+x);
+                COMPS_RNodes *tmpnodes = rtdata->subnodes;
+                // split mutual key
+                rtdata->subnodes = comps_rnodes_create(
+                                                &comps_objrtree_data_destroy_v);
                 rtdata->data = NULL;
 
-                if (cmpret > 0) {
-                    rtd = comps_objrtree_data_create(rtdata->key+x, tmpdata);
-                    comps_hslist_destroy(&rtd->subnodes);
-                    rtd->subnodes = tmphslist;
-
-                    comps_hslist_append(rtdata->subnodes,rtd, 0);
-                    rtd = comps_objrtree_data_create(key+offset+x, ndata);
-                    comps_hslist_append(rtdata->subnodes, rtd, 0);
-
-                } else {
-                    rtd = comps_objrtree_data_create(key+offset+x, ndata);
-                    comps_hslist_append(rtdata->subnodes, rtd, 0);
-                    rtd = comps_objrtree_data_create(rtdata->key+x, tmpdata);
-                    comps_hslist_destroy(&rtd->subnodes);
-                    rtd->subnodes = tmphslist;
-                    comps_hslist_append(rtdata->subnodes, rtd, 0);
-                }
+                rtd = comps_objrtree_data_create(rtdata->key+x, tmpdata);
+                comps_rnodes_destroy(&rtd->subnodes);
+                rtd->subnodes = tmpnodes;
+                comps_rnodes_insert(rtdata->subnodes, rtd->key[0], rtd);
+
+                rtd = comps_objrtree_data_create_n(key+offset+x, len-offset-x,
+                                                   ndata);
+                comps_rnodes_insert(rtdata->subnodes, rtd->key[0], rtd);
+
                 rtdata->key = realloc(rtdata->key, sizeof(char)*(x+1));
                 rtdata->key[x] = 0;
                 rt->len++;
+                rt->keys_version++;
                 return;
             }
         }
@@ -460,32 +491,26 @@ void comps_objrtree_set_nx(COMPS_ObjRTree *rt, char *key, size_t len,
 }
 
 COMPS_Object* __comps_objrtree_get(COMPS_ObjRTree * rt, const char * key) {
-    COMPS_HSList * subnodes;
-    COMPS_HSListItem * it = NULL;
+    COMPS_RNodes * subnodes;
     COMPS_ObjRTreeData * rtdata;
     unsigned int offset, len, x;
-    char found, ended;
+    int pos;
+    char ended;
 
     len = strlen(key);
     offset = 0;
     subnodes = rt->subnodes;
 
     while (offset != len) {
-        found = 0;
-        for (it = subnodes->first; it != NULL; it=it->next) {
-            if (((COMPS_ObjRTreeData*)it->data)->key[0] == key[offset]) {
-                found = 1;
-                break;
-            }
-        }
-        if (!found) {
+        pos = comps_rnodes_find(subnodes, key[offset]);
+        if (pos == -1) {
             return NULL;
         }
-        rtdata = (COMPS_ObjRTreeData*)it->data;
+        rtdata = (COMPS_ObjRTreeData*)subnodes->nodes[pos];
 
         for (x=1; ;x++) {
             ended=0;
-            if (x == strlen(rtdata->key)) ended += 1;
+            if (rtdata->key[x] == 0) ended += 1;
             if (x == len-offset) ended += 2;
             if (ended != 0) break;
             if (key[offset+x] != rtdata->key[x]) break;
@@ -497,14 +522,9 @@ COMPS_Object* __comps_objrtree_get(COMPS_ObjRTree * rt, const char * key) {
         else {
             return NULL;
         }
-        subnodes = ((COMPS_ObjRTreeData*)it->data)->subnodes;
-    }
-    if (it != NULL) {
-        return ((COMPS_ObjRTreeData*)it->data)->data;
-    }
-    else {
-        return NULL;
+        subnodes = rtdata->subnodes;
     }
+    return NULL;
 }
 COMPS_Object* comps_objrtree_get(COMPS_ObjRTree * rt, const char * key) {
     return comps_object_incref(__comps_objrtree_get(rt, key));
@@ -514,37 +534,31 @@ COMPS_Object* comps_objrtree_get_x(COMPS_ObjRTree * rt, const char * key) {
 }
 
 void comps_objrtree_unset(COMPS_ObjRTree * rt, const char * key) {
-    COMPS_HSList * subnodes;
-    COMPS_HSListItem * it;
+    COMPS_RNodes * subnodes;
     COMPS_ObjRTreeData * rtdata;
-    unsigned int offset, len, x;
-    char found, ended;
-    COMPS_HSList * path;
+    unsigned int offset, len, x, depth;
+    int pos;
+    char ended;
 
     struct Relation {
-        COMPS_HSList * parent_nodes;
-        COMPS_HSListItem * child_it;
-    } *relation;
-
-    path = comps_hslist_create();
-    comps_hslist_init(path, NULL, NULL, &free);
+        COMPS_RNodes * parent_nodes;
+        unsigned int child_pos;
+    } *path;
 
     len = strlen(key);
+    /* every step along the path consumes at least one char of key */
+    if ((path = malloc(sizeof(*path) * (len + 1))) == NULL)
+        return;
+    rt->version++;
     offset = 0;
+    depth = 0;
     subnodes = rt->subnodes;
     while (offset != len) {
-        found = 0;
-        for (it = subnodes->first; it != NULL; it=it->next) {
-            if (((COMPS_ObjRTreeData*)it->data)->key[0] == key[offset]) {
-                found = 1;
-                break;
-            }
+        pos = comps_rnodes_find(subnodes, key[offset]);
+        if (pos == -1) {
+            break;
         }
-        if (!found) {
-            comps_hslist_destroy(&path);
-            return;
-        }
-        rtdata = (COMPS_ObjRTreeData*)it->data;
+        rtdata = (COMPS_ObjRTreeData*)subnodes->nodes[pos];
 
         for (x=1; ;x++) {
             ended=0;
@@ -553,82 +567,54 @@ void comps_objrtree_unset(COMPS_ObjRTree * rt, const char * key) {
             if (ended != 0) break;
             if (key[offset+x] != rtdata->key[x]) break;
         }
-        if (ended == 3) {
-            /* remove node from tree only if there's no descendant*/
-            if (rtdata->subnodes->last == NULL) {
-                //printf("removing all\n");
-                comps_hslist_remove(subnodes, it);
-                comps_objrtree_data_destroy(rtdata);
-                free(it);
-            }
-            else {
-                //printf("removing data only\n");
-                comps_object_destroy(rtdata->data);
-                rtdata->is_leaf = 0;
-                rtdata->data = NULL;
-            }
-
-            if (path->last == NULL) {
-                comps_hslist_destroy(&path);
-                return;
-            }
-            rtdata = (COMPS_ObjRTreeData*)
-                     ((struct Relation*)path->last->data)->child_it->data;
+        path[depth].parent_nodes = subnodes;
+        path[depth].child_pos = pos;
+        depth++;
 
-            /*remove all predecessor of deleted node (recursive) with no childs*/
-            while (rtdata->subnodes->last == NULL) {
-                //printf("removing '%s'\n", rtdata->key);
-                comps_objrtree_data_destroy(rtdata);
-                comps_hslist_remove(
-                            ((struct Relation*)path->last->data)->parent_nodes,
-                            ((struct Relation*)path->last->data)->child_it);
-                free(((struct Relation*)path->last->data)->child_it);
-                it = path->last;
-                comps_hslist_remove(path, path->last);
-                free(it);
+        if (ended == 3) {
+            if (rtdata->data == NULL)
+                break;
+            comps_object_destroy(rtdata->data);
+            rtdata->is_leaf = 0;
+            rtdata->data = NULL;
+            rt->keys_version++;
+
+            /*remove deleted node and all its predecessors left without data
+              and descendants*/
+            while (depth--) {
+                subnodes = path[depth].parent_nodes;
                 rtdata = (COMPS_ObjRTreeData*)
-                         ((struct Relation*)path->last->data)->child_it->data;
+                         subnodes->nodes[path[depth].child_pos];
+                if (rtdata->data != NULL || rtdata->subnodes->len != 0)
+                    break;
+                comps_rnodes_remove_at(subnodes, path[depth].child_pos);
+                comps_objrtree_data_destroy(rtdata);
             }
-            comps_hslist_destroy(&path);
-            return;
+            break;
         }
         else if (ended == 1) offset+=x;
         else {
-            comps_hslist_destroy(&path);
-            return;
-        }
-        if ((relation = malloc(sizeof(struct Relation))) == NULL) {
-            comps_hslist_destroy(&path);
-            return;
+            break;
         }
-        subnodes = ((COMPS_ObjRTreeData*)it->data)->subnodes;
-        relation->parent_nodes = subnodes;
-        relation->child_it = it;
-        comps_hslist_append(path, (void*)relation, 0);
+        subnodes = rtdata->subnodes;
     }
-    comps_hslist_destroy(&path);
-    return;
+    free(path);
 }
 
 void comps_objrtree_clear(COMPS_ObjRTree * rt) {
     if (rt==NULL) return;
-    comps_hslist_clear(rt->subnodes);
+    comps_rnodes_clear(rt->subnodes);
     rt->len = 0;
+    rt->version++;
+    rt->keys_version++;
 }
 
 inline COMPS_HSList* __comps_objrtree_all(COMPS_ObjRTree * rt, char keyvalpair) {
-    COMPS_HSList *to_process, *ret;
-    COMPS_HSListItem *hsit, *oldit;
-    size_t x;
-    struct Pair {
-        char *key;
-        void *data;
-        COMPS_HSList *subnodes;
-    } *pair, *current_pair=NULL;//, *oldpair=NULL;
+    COMPS_HSList *ret;
+    COMPS_ObjRTreeIt it;
     COMPS_ObjRTreePair *rtpair;
-
-    to_process = comps_hslist_create();
-    comps_hslist_init(to_process, NULL, NULL, &free);
+    const char *key;
+    COMPS_Object *data;
 
     ret = comps_hslist_create();
     if (keyvalpair == 0)
@@ -638,53 +624,166 @@ inline COMPS_HSList* __comps_objrtree_all(COMPS_ObjRTree * rt, char keyvalpair)
     else
         comps_hslist_init(ret, NULL, NULL, &comps_objrtree_pair_destroy_v);
 
-    for (hsit = rt->subnodes->first; hsit != NULL; hsit = hsit->next) {
-        pair = malloc(sizeof(struct Pair));
-        pair->key = __comps_strcpy(((COMPS_ObjRTreeData*)hsit->data)->key);
-        pair->data = ((COMPS_ObjRTreeData*)hsit->data)->data;
-        pair->subnodes = ((COMPS_ObjRTreeData*)hsit->data)->subnodes;
-        comps_hslist_append(to_process, pair, 0);
+    comps_objrtree_it_init(&it, rt);
+    while (comps_objrtree_it_next(&it, &key, &data)) {
+        if (keyvalpair == 0) {
+            comps_hslist_append(ret, __comps_strcpy((char*)key), 0);
+        } else if (keyvalpair == 1) {
+            comps_hslist_append(ret, data, 0);
+        } else {
+            rtpair = malloc(sizeof(COMPS_ObjRTreePair));
+            rtpair->key = __comps_strcpy((char*)key);
+            rtpair->data = data;
+            comps_hslist_append(ret, rtpair, 0);
+        }
     }
-    while (to_process->first) {
-        //oldpair = current_pair;
-        current_pair = to_process->first->data;
-        oldit = to_process->first;
-        comps_hslist_remove(to_process, to_process->first);
-        if (current_pair->data) {
-            if (keyvalpair == 0) {
-                comps_hslist_append(ret, __comps_strcpy(current_pair->key), 0);
-            } else if (keyvalpair == 1) {
-                comps_hslist_append(ret, current_pair->data, 0);
-            } else {
-                rtpair = malloc(sizeof(COMPS_ObjRTreePair));
-                rtpair->key = __comps_strcpy(current_pair->key);
-                rtpair->data = current_pair->data;
-                comps_hslist_append(ret, rtpair, 0);
+    comps_objrtree_it_destroy(&it);
+    return ret;
+}
+
+void comps_objrtree_it_init(COMPS_ObjRTreeIt *it, COMPS_ObjRTree *rt) {
+    comps_rnodes_it_init(it, rt->subnodes);
+}
+
+int comps_objrtree_it_next(COMPS_ObjRTreeIt *it, const char **key, COMPS_Object **data) {
+    COMPS_ObjRTreeData *rtdata;
+    while ((rtdata = comps_rnodes_it_next(it)) != NULL) {
+        if (!comps_rnodes_it_enter(it, rtdata->key, rtdata->subnodes))
+            return 0;
+        if (rtdata->data) {
+            if (it->end_key && strcmp(it->key, it->end_key) >= 0) {
+                it->depth = 0;
+                return 0;
             }
+            *key = it->key;
+            *data = rtdata->data;
+            return 1;
         }
-        for (hsit = current_pair->subnodes->first, x = 0;
-             hsit != NULL; hsit = hsit->next, x++) {
-            pair = malloc(sizeof(struct Pair));
-            pair->key = __comps_strcat(current_pair->key,
-                                       ((COMPS_ObjRTreeData*)hsit->data)->key);
-            pair->data = ((COMPS_ObjRTreeData*)hsit->data)->data;
-            pair->subnodes = ((COMPS_ObjRTreeData*)hsit->data)->subnodes;
-            comps_hslist_insert_at(to_process, x, pair, 0);
+    }
+    return 0;
+}
+
+void comps_objrtree_it_destroy(COMPS_ObjRTreeIt *it) {
+    comps_rnodes_it_destroy(it);
+}
+
+void comps_objrtree_it_init_prefix(COMPS_ObjRTreeIt *it, COMPS_ObjRTree *rt,
+                                   const char *prefix) {
+    COMPS_RNodes *subnodes;
+    COMPS_ObjRTreeData *rtdata;
+    size_t len, seglen;
+    int pos;
+
+    comps_rnodes_it_init(it, NULL);
+    subnodes = rt->subnodes;
+    len = strlen(prefix);
+    if (len == 0) {
+        comps_rnodes_it_push(it, subnodes, 0, subnodes->len);
+        return;
+    }
+    /* descend to the node where prefix ends, its subtree is the result */
+    while (len) {
+        pos = comps_rnodes_find(subnodes, *prefix);
+        if (pos == -1)
+            return;
+        rtdata = (COMPS_ObjRTreeData*)subnodes->nodes[pos];
+        seglen = strlen(rtdata->key);
+        if (len <= seglen) {
+            if (strncmp(rtdata->key, prefix, len) == 0)
+                comps_rnodes_it_push(it, subnodes, pos, pos + 1);
+            return;
+        }
+        if (strncmp(rtdata->key, prefix, seglen) != 0)
+            return;
+        if (!comps_rnodes_it_append(it, prefix, seglen))
+            return;
+        prefix += seglen;
+        len -= seglen;
+        subnodes = rtdata->subnodes;
+    }
+}
+
+void comps_objrtree_it_init_range(COMPS_ObjRTreeIt *it, COMPS_ObjRTree *rt,
+                                  const char *first, const char *last) {
+    COMPS_RNodes *subnodes;
+    COMPS_ObjRTreeData *rtdata;
+    unsigned int pos;
+    size_t x, seglen;
+
+    comps_rnodes_it_init(it, NULL);
+    it->end_key = last;
+    subnodes = rt->subnodes;
+    if (first == NULL)
+        first = "";
+    /* leave frames with nodes greater than first on the way down */
+    while (*first) {
+        pos = comps_rnodes_lower_bound(subnodes, *first);
+        if (pos == subnodes->len || subnodes->index[pos] != (unsigned char)*first)
+            break;
+        rtdata = (COMPS_ObjRTreeData*)subnodes->nodes[pos];
+        seglen = strlen(rtdata->key);
+        for (x = 0; x < seglen && rtdata->key[x] == first[x]; x++);
+        if (first[x] == 0) {
+            /* node key is equal to or longer than rest of first */
+            break;
+        } else if (x < seglen) {
+            if ((unsigned char)rtdata->key[x] < (unsigned char)first[x])
+                pos++;
+            comps_rnodes_it_push(it, subnodes, pos, subnodes->len);
+            return;
         }
-        free(current_pair->key);
-        free(current_pair);
-        free(oldit);
+        if (!comps_rnodes_it_push(it, subnodes, pos + 1, subnodes->len))
+            return;
+        if (!comps_rnodes_it_append(it, rtdata->key, seglen))
+            return;
+        first += seglen;
+        subnodes = rtdata->subnodes;
     }
+    if (*first)
+        pos = comps_rnodes_lower_bound(subnodes, *first);
+    else
+        pos = 0;
+    comps_rnodes_it_push(it, subnodes, pos, subnodes->len);
+}
 
-    comps_hslist_destroy(&to_process);
+void comps_objrtree_prefix_walk(COMPS_ObjRTree *rt, const char *prefix,
+                                void *udata,
+                                void (*walk_f)(void*, const char*,
+                                               COMPS_Object*)) {
+    COMPS_ObjRTreeIt it;
+    const char *key;
+    COMPS_Object *data;
+
+    comps_objrtree_it_init_prefix(&it, rt, prefix);
+    while (comps_objrtree_it_next(&it, &key, &data))
+        walk_f(udata, key, data);
+    comps_objrtree_it_destroy(&it);
+}
+
+COMPS_HSList* comps_objrtree_keys_with_prefix(COMPS_ObjRTree *rt,
+                                              const char *prefix) {
+    COMPS_HSList *ret;
+    COMPS_ObjRTreeIt it;
+    const char *key;
+    COMPS_Object *data;
+
+    ret = comps_hslist_create();
+    comps_hslist_init(ret, NULL, NULL, &free);
+    comps_objrtree_it_init_prefix(&it, rt, prefix);
+    while (comps_objrtree_it_next(&it, &key, &data))
+        comps_hslist_append(ret, __comps_strcpy((char*)key), 0);
+    comps_objrtree_it_destroy(&it);
     return ret;
 }
 
 void comps_objrtree_unite(COMPS_ObjRTree *rt1, COMPS_ObjRTree *rt2) {
-    COMPS_HSList *tmplist, *tmp_subnodes;
+    COMPS_HSList *tmplist;
+    COMPS_RNodes *tmp_subnodes;
     COMPS_HSListItem *it;
+    COMPS_ObjRTreeData *rtdata;
+    unsigned int i;
     struct Pair {
-        COMPS_HSList * subnodes;
+        COMPS_RNodes * subnodes;
         char * key;
     } *pair, *parent_pair;
 
@@ -704,31 +803,29 @@ void comps_objrtree_unite(COMPS_ObjRTree *rt1, COMPS_ObjRTree *rt2) {
         //printf("key-part:%s\n", parent_pair->key);
         free(it);
 
-        for (it = tmp_subnodes->first; it != NULL; it=it->next) {
+        for (i = 0; i < tmp_subnodes->len; i++) {
+            rtdata = (COMPS_ObjRTreeData*)tmp_subnodes->nodes[i];
             pair = malloc(sizeof(struct Pair));
-            pair->subnodes = ((COMPS_ObjRTreeData*)it->data)->subnodes;
+            pair->subnodes = rtdata->subnodes;
 
             if (parent_pair->key != NULL) {
                 pair->key = malloc(sizeof(char)
-                               * (strlen(((COMPS_ObjRTreeData*)it->data)->key)
+                               * (strlen(rtdata->key)
                                + strlen(parent_pair->key) + 1));
                 memcpy(pair->key, parent_pair->key,
                        sizeof(char) * strlen(parent_pair->key));
-                memcpy(pair->key + strlen(parent_pair->key),
-                       ((COMPS_ObjRTreeData*)it->data)->key,
-                       sizeof(char)*(strlen(((COMPS_ObjRTreeData*)it->data)->key)+1));
+                memcpy(pair->key + strlen(parent_pair->key), rtdata->key,
+                       sizeof(char)*(strlen(rtdata->key)+1));
             } else {
-                pair->key = malloc(sizeof(char)*
-                                (strlen(((COMPS_ObjRTreeData*)it->data)->key) +1));
-                memcpy(pair->key, ((COMPS_ObjRTreeData*)it->data)->key,
-                       sizeof(char)*(strlen(((COMPS_ObjRTreeData*)it->data)->key)+1));
+                pair->key = malloc(sizeof(char)* (strlen(rtdata->key) +1));
+                memcpy(pair->key, rtdata->key,
+                       sizeof(char)*(strlen(rtdata->key)+1));
             }
             /* current node has data */
-            if (((COMPS_ObjRTreeData*)it->data)->data != NULL) {
-                    comps_objrtree_set(rt1, pair->key,
-                                      (((COMPS_ObjRTreeData*)it->data)->data));
+            if (rtdata->data != NULL) {
+                    comps_objrtree_set(rt1, pair->key, rtdata->data);
             }
-            if (((COMPS_ObjRTreeData*)it->data)->subnodes->first) {
+            if (rtdata->subnodes->len) {
                 comps_hslist_append(tmplist, pair, 0);
             } else {
                 free(pair->key);
@@ -777,5 +874,6 @@ COMPS_ObjectInfo COMPS_ObjRTree_ObjInfo = {
     .constructor = &comps_objrtree_create_u,
     .destructor = &comps_objrtree_destroy_u,
     .copy = &comps_objrtree_copy_u,
-    .obj_cmp = &comps_objrtree_cmp_u
+    .obj_cmp = &comps_objrtree_cmp_u,
+    .digest = &comps_objrtree_digest_u
 };
@@ -18,12 +18,12 @@
  */
 
 #include <stdio.h>
-#include <ctype.h>
 #include <signal.h>
 
 #include "comps_types.h"
 #include "comps_parse.h"
 #include "comps_elem.h"
+#include "comps_scan.h"
 
 #define BUFF_SIZE 1024
 
@@ -32,11 +32,7 @@ void comps_parse_check_attributes(COMPS_Parsed *parsed, COMPS_Elem* elem);
 
 inline unsigned __comps_is_whitespace_only(const char * s, int len)
 {
-    int i;
-    for (i = 0; i<len; i++) {
-        if (!isspace(s[i])) return 0;
-    }
-    return 1;
+    return len <= 0 || comps_scan_space_only(s, (size_t)len);
 }
 COMPS_Parsed* comps_parse_parsed_create() {
     COMPS_Parsed *ret;
@@ -275,8 +271,7 @@ signed char comps_parse_str(COMPS_Parsed *parsed, char *str,
 void comps_parse_end_elem_handler(void *userData, const XML_Char *s) {
     //COMPS_ListItem * item;
     char * alltext = NULL;
-    //size_t item_len;
-    //int index=0;
+    size_t item_len, index = 0;
     void *data;
     #define parser_line XML_GetCurrentLineNumber(((COMPS_Parsed*)userData)->parser)
     #define parser_col XML_GetCurrentColumnNumber(((COMPS_Parsed*)userData)->parser)
@@ -292,11 +287,13 @@ void comps_parse_end_elem_handler(void *userData, const XML_Char *s) {
         }
         alltext[0]=0;
     }
+    /* pieces are appended at known offset, strcat would rescan the text
+     * collected so far for every piece */
     while ((data = comps_hslist_shift(parsed->text_buffer)) != NULL) {
-        //item_len = strlen((char*)data);
-        alltext = strcat(alltext, data);
+        item_len = strlen((char*)data);
+        memcpy(alltext + index, data, item_len);
         free(data);
-        //index += item_len;
+        index += item_len;
     }
     /* set zero char at the end of string */
     if (alltext)
@@ -26,7 +26,7 @@ void comps_rtree_data_destroy(COMPS_RTreeData * rtd) {
     free(rtd->key);
     if ((rtd->data) && (*rtd->data_destructor))
         (*rtd->data_destructor)(rtd->data);
-    comps_hslist_destroy(&rtd->subnodes);
+    comps_rnodes_destroy(&rtd->subnodes);
     free(rtd);
 }
 
@@ -51,8 +51,7 @@ inline COMPS_RTreeData * __comps_rtree_data_create(COMPS_RTree *rt, char *key,
         rtd->is_leaf = 1;
     }
     rtd->data_destructor = &rt->data_destructor;
-    rtd->subnodes = comps_hslist_create();
-    comps_hslist_init(rtd->subnodes, NULL, NULL, &comps_rtree_data_destroy_v);
+    rtd->subnodes = comps_rnodes_create(&comps_rtree_data_destroy_v);
     return rtd;
 }
 
@@ -76,8 +75,7 @@ COMPS_RTree * comps_rtree_create(void* (*data_constructor)(void*),
     COMPS_RTree *ret;
     if ((ret = malloc(sizeof(COMPS_RTree))) == NULL)
         return NULL;
-    ret->subnodes = comps_hslist_create();
-    comps_hslist_init(ret->subnodes, NULL, NULL, &comps_rtree_data_destroy_v);
+    ret->subnodes = comps_rnodes_create(&comps_rtree_data_destroy_v);
     if (ret->subnodes == NULL) {
         free(ret);
         return NULL;
@@ -90,25 +88,28 @@ COMPS_RTree * comps_rtree_create(void* (*data_constructor)(void*),
 
 void comps_rtree_destroy(COMPS_RTree * rt) {
     if (!rt) return;
-    comps_hslist_destroy(&(rt->subnodes));
+    comps_rnodes_destroy(&(rt->subnodes));
     free(rt);
 }
 
-void comps_rtree_print(COMPS_HSList * hl, unsigned  deep) {
-    COMPS_HSListItem * it;
-    for (it = hl->first; it != NULL; it=it->next) {
-        printf("%d %s\n",deep, (((COMPS_RTreeData*)it->data)->key));
-        comps_rtree_print(((COMPS_RTreeData*)it->data)->subnodes, deep+1);
+void comps_rtree_print(COMPS_RNodes * rnodes, unsigned  deep) {
+    unsigned int i;
+    for (i = 0; i < rnodes->len; i++) {
+        printf("%d %s\n",deep, (((COMPS_RTreeData*)rnodes->nodes[i])->key));
+        comps_rtree_print(((COMPS_RTreeData*)rnodes->nodes[i])->subnodes,
+                          deep+1);
     }
 }
 
 COMPS_RTree * comps_rtree_clone(COMPS_RTree *rt) {
 
-    COMPS_HSList *to_clone, *tmplist, *new_subnodes;
+    COMPS_HSList *to_clone;
+    COMPS_RNodes *tmpnodes, *new_subnodes;
     COMPS_RTree *ret;
-    COMPS_HSListItem *it, *it2;
-    COMPS_RTreeData *rtdata;
+    COMPS_HSListItem *it2;
+    COMPS_RTreeData *rtdata, *olddata;
     void *new_data;
+    unsigned int i;
 
     if (!rt) return NULL;
 
@@ -118,17 +119,17 @@ COMPS_RTree * comps_rtree_clone(COMPS_RTree *rt) {
                              rt->data_destructor);
 
 
-    for (it = rt->subnodes->first; it != NULL; it = it->next) {
-        rtdata = comps_rtree_data_create(ret,
-                                      ((COMPS_RTreeData*)it->data)->key, NULL);
-        if (((COMPS_RTreeData*)it->data)->data != NULL)
-            new_data = rt->data_cloner(((COMPS_RTreeData*)it->data)->data);
+    for (i = 0; i < rt->subnodes->len; i++) {
+        olddata = (COMPS_RTreeData*)rt->subnodes->nodes[i];
+        rtdata = comps_rtree_data_create(ret, olddata->key, NULL);
+        if (olddata->data != NULL)
+            new_data = rt->data_cloner(olddata->data);
         else
             new_data = NULL;
-        comps_hslist_destroy(&rtdata->subnodes);
-        rtdata->subnodes = ((COMPS_RTreeData*)it->data)->subnodes;
+        comps_rnodes_destroy(&rtdata->subnodes);
+        rtdata->subnodes = olddata->subnodes;
         rtdata->data = new_data;
-        comps_hslist_append(ret->subnodes, rtdata, 0);
+        comps_rnodes_insert_at(ret->subnodes, i, rtdata->key[0], rtdata);
 
         comps_hslist_append(to_clone, rtdata, 0);
     }
@@ -136,22 +137,21 @@ COMPS_RTree * comps_rtree_clone(COMPS_RTree *rt) {
 
     while (to_clone->first) {
         it2 = to_clone->first;
-        tmplist = ((COMPS_RTreeData*)it2->data)->subnodes;
+        tmpnodes = ((COMPS_RTreeData*)it2->data)->subnodes;
         comps_hslist_remove(to_clone, to_clone->first);
 
-        new_subnodes = comps_hslist_create();
-        comps_hslist_init(new_subnodes, NULL, NULL, &comps_rtree_data_destroy_v);
-        for (it = tmplist->first; it != NULL; it = it->next) {
-            rtdata = comps_rtree_data_create(ret,
-                                      ((COMPS_RTreeData*)it->data)->key, NULL);
-            if (((COMPS_RTreeData*)it->data)->data != NULL)
-                new_data = rt->data_cloner(((COMPS_RTreeData*)it->data)->data);
+        new_subnodes = comps_rnodes_create(&comps_rtree_data_destroy_v);
+        for (i = 0; i < tmpnodes->len; i++) {
+            olddata = (COMPS_RTreeData*)tmpnodes->nodes[i];
+            rtdata = comps_rtree_data_create(ret, olddata->key, NULL);
+            if (olddata->data != NULL)
+                new_data = rt->data_cloner(olddata->data);
             else
                 new_data = NULL;
-            comps_hslist_destroy(&rtdata->subnodes);
-            rtdata->subnodes = ((COMPS_RTreeData*)it->data)->subnodes;
+            comps_rnodes_destroy(&rtdata->subnodes);
+            rtdata->subnodes = olddata->subnodes;
             rtdata->data = new_data;
-            comps_hslist_append(new_subnodes, rtdata, 0);
+            comps_rnodes_insert_at(new_subnodes, i, rtdata->key[0], rtdata);
 
             comps_hslist_append(to_clone, rtdata, 0);
         }
@@ -164,39 +164,83 @@ COMPS_RTree * comps_rtree_clone(COMPS_RTree *rt) {
 
 void comps_rtree_values_walk(COMPS_RTree * rt, void* udata,
                               void (*walk_f)(void*, void*)) {
-    COMPS_HSList *tmplist, *tmp_subnodes;
+    COMPS_HSList *tmplist;
+    COMPS_RNodes *tmp_subnodes;
     COMPS_HSListItem *it;
+    COMPS_RTreeData *rtdata;
+    unsigned int i;
     tmplist = comps_hslist_create();
     comps_hslist_init(tmplist, NULL, NULL, NULL);
     comps_hslist_append(tmplist, rt->subnodes, 0);
     while (tmplist->first != NULL) {
         it = tmplist->first;
         comps_hslist_remove(tmplist, tmplist->first);
-        tmp_subnodes = (COMPS_HSList*)it->data;
-        for (it = tmp_subnodes->first; it != NULL; it=it->next) {
-            if (((COMPS_RTreeData*)it->data)->subnodes->first) {
-                comps_hslist_append(tmplist,
-                                    ((COMPS_RTreeData*)it->data)->subnodes, 0);
+        tmp_subnodes = (COMPS_RNodes*)it->data;
+        free(it);
+        for (i = 0; i < tmp_subnodes->len; i++) {
+            rtdata = (COMPS_RTreeData*)tmp_subnodes->nodes[i];
+            if (rtdata->subnodes->len) {
+                comps_hslist_append(tmplist, rtdata->subnodes, 0);
             }
-            if (((COMPS_RTreeData*)it->data)->data != NULL) {
-               walk_f(udata, ((COMPS_RTreeData*)it->data)->data);
+            if (rtdata->data != NULL) {
+               walk_f(udata, rtdata->data);
             }
         }
     }
     comps_hslist_destroy(&tmplist);
 }
 
+void comps_rtree_prefix_walk(COMPS_RTree *rt, const char *prefix, void *udata,
+                             void (*walk_f)(void*, const char*, void*)) {
+    COMPS_RNodesIt it;
+    COMPS_RNodes *subnodes;
+    COMPS_RTreeData *rtdata;
+    size_t len, seglen;
+    int pos;
+
+    comps_rnodes_it_init(&it, NULL);
+    subnodes = rt->subnodes;
+    len = strlen(prefix);
+    if (len == 0)
+        comps_rnodes_it_push(&it, subnodes, 0, subnodes->len);
+    /* descend to the node where prefix ends, its subtree is the result */
+    while (len) {
+        pos = comps_rnodes_find(subnodes, *prefix);
+        if (pos == -1)
+            break;
+        rtdata = (COMPS_RTreeData*)subnodes->nodes[pos];
+        seglen = strlen(rtdata->key);
+        if (len <= seglen) {
+            if (strncmp(rtdata->key, prefix, len) == 0)
+                comps_rnodes_it_push(&it, subnodes, pos, pos + 1);
+            break;
+        }
+        if (strncmp(rtdata->key, prefix, seglen) != 0
+            || !comps_rnodes_it_append(&it, prefix, seglen))
+            break;
+        prefix += seglen;
+        len -= seglen;
+        subnodes = rtdata->subnodes;
+    }
+    while ((rtdata = comps_rnodes_it_next(&it)) != NULL) {
+        if (!comps_rnodes_it_enter(&it, rtdata->key, rtdata->subnodes))
+            break;
+        if (rtdata->data)
+            walk_f(udata, it.key, rtdata->data);
+    }
+    comps_rnodes_it_destroy(&it);
+}
+
 void __comps_rtree_set(COMPS_RTree * rt, char * key, size_t len, void * data)
 {
-    COMPS_HSListItem *it, *lesser;
-    COMPS_HSList *subnodes;
-    COMPS_RTreeData *rtd;
-    static COMPS_RTreeData *rtdata;
+    COMPS_RNodes *subnodes;
+    COMPS_RTreeData *rtd, *rtdata;
 
     size_t offset=0, _len;
-    unsigned x, found = 0;
+    unsigned x;
+    int pos;
     void *ndata;
-    char ended;//, tmpch;
+    char ended;
 
     if (rt->subnodes == NULL)
         return;
@@ -209,26 +253,13 @@ void __comps_rtree_set(COMPS_RTree * rt, char * key, size_t len, void * data)
     subnodes = rt->subnodes;
     while (offset != len)
     {
-        found = 0;
-        lesser = NULL;
-        for (it = subnodes->first; it != NULL; it=it->next) {
-            if (((COMPS_RTreeData*)it->data)->key[0] == key[offset]) {
-                found = 1;
-                break;
-            } else if (((COMPS_RTreeData*)it->data)->key[0] < key[offset]) {
-                lesser = it;
-            }
-        }
-        if (!found) { // not found in subnodes; create new subnode
-            rtd = comps_rtree_data_create(rt, key+offset, ndata);
-            if (!lesser) {
-                comps_hslist_prepend(subnodes, rtd, 0);
-            } else {
-                comps_hslist_insert_after(subnodes, lesser, rtd, 0);
-            }
+        pos = comps_rnodes_find(subnodes, key[offset]);
+        if (pos == -1) { // not found in subnodes; create new subnode
+            rtd = comps_rtree_data_create_n(rt, key+offset, len-offset, ndata);
+            comps_rnodes_insert(subnodes, key[offset], rtd);
             return;
         } else {
-            rtdata = (COMPS_RTreeData*)it->data;
+            rtdata = (COMPS_RTreeData*)subnodes->nodes[pos];
             ended = 0;
             for (x=1; ;x++) {
                 if (rtdata->key[x] == 0) ended += 1;
@@ -237,17 +268,14 @@ void __comps_rtree_set(COMPS_RTree * rt, char * key, size_t len, void * data)
                 if (key[offset+x] != rtdata->key[x]) break;
             }
             if (ended == 3) { //keys equals; data replacement
-                rt->data_destructor(rtdata->data);
+                if (rt->data_destructor)
+                    rt->data_destructor(rtdata->data);
                 rtdata->data = ndata;
                 return;
             } else if (ended == 2) { //global key ends first; make global leaf
-                comps_hslist_remove(subnodes, it);
-                it->next = NULL;
                 rtd = comps_rtree_data_create_n(rt, key+offset,
                                                 len-offset, ndata);
-                comps_hslist_append(subnodes, rtd, 0);
-                ((COMPS_RTreeData*)subnodes->last->data)->subnodes->last = it;
-                ((COMPS_RTreeData*)subnodes->last->data)->subnodes->first = it;
+                subnodes->nodes[pos] = rtd;
                 _len = len - offset;
 
                 memmove(rtdata->key,rtdata->key + _len,
@@ -255,35 +283,28 @@ void __comps_rtree_set(COMPS_RTree * rt, char * key, size_t len, void * data)
                 rtdata->key[strlen(rtdata->key) - _len] = 0;
                 rtdata->key = realloc(rtdata->key,
                                       sizeof(char)* (strlen(rtdata->key)+1));
+                comps_rnodes_insert(rtd->subnodes, rtdata->key[0], rtdata);
                 return;
             } else if (ended == 1) { //local key ends first; go deeper
                 subnodes = rtdata->subnodes;
                 offset += x;
             } else {
                 void *tmpdata = rtdata->data;
-                COMPS_HSList *tmpnodes = rtdata->subnodes;
+                COMPS_RNodes *tmpnodes = rtdata->subnodes;
 
-                int cmpret = strcmp(key+offset+x, rtdata->key+x);
-                rtdata->subnodes = comps_hslist_create();
-                comps_hslist_init(rtdata->subnodes, NULL, NULL,
-                                  &comps_rtree_data_destroy_v);
+                rtdata->subnodes = comps_rnodes_create(
+                                                &comps_rtree_data_destroy_v);
                 rtdata->data = NULL;
 
-                if (cmpret > 0) {
-                    rtd = comps_rtree_data_create(rt, rtdata->key+x, tmpdata);
-                    comps_hslist_destroy(&rtd->subnodes);
-                    rtd->subnodes = tmpnodes;
-                    comps_hslist_append(rtdata->subnodes, rtd, 0);
-                    rtd = comps_rtree_data_create(rt, key+offset+x, ndata);
-                    comps_hslist_append(rtdata->subnodes, rtd, 0);
-                } else {
-                    rtd = comps_rtree_data_create(rt, key+offset+x, ndata);
-                    comps_hslist_append(rtdata->subnodes, rtd, 0);
-                    rtd = comps_rtree_data_create(rt, rtdata->key+x, tmpdata);
-                    comps_hslist_destroy(&rtd->subnodes);
-                    rtd->subnodes = tmpnodes;
-                    comps_hslist_append(rtdata->subnodes, rtd, 0);
-                }
+                rtd = comps_rtree_data_create(rt, rtdata->key+x, tmpdata);
+                comps_rnodes_destroy(&rtd->subnodes);
+                rtd->subnodes = tmpnodes;
+                comps_rnodes_insert(rtdata->subnodes, rtd->key[0], rtd);
+
+                rtd = comps_rtree_data_create_n(rt, key+offset+x,
+                                                len-offset-x, ndata);
+                comps_rnodes_insert(rtdata->subnodes, rtd->key[0], rtd);
+
                 rtdata->key = realloc(rtdata->key, sizeof(char)*(x+1));
                 rtdata->key[x] = 0;
                 return;
@@ -302,32 +323,26 @@ void comps_rtree_set_n(COMPS_RTree * rt, char * key, size_t keylen, void * data)
 }
 
 void* comps_rtree_get(COMPS_RTree * rt, const char * key) {
-    COMPS_HSList * subnodes;
-    COMPS_HSListItem * it = NULL;
+    COMPS_RNodes * subnodes;
     COMPS_RTreeData * rtdata;
     unsigned int offset, len, x;
-    char found, ended;
+    int pos;
+    char ended;
 
     len = strlen(key);
     offset = 0;
     subnodes = rt->subnodes;
     while (offset != len) {
-        found = 0;
-        for (it = subnodes->first; it != NULL; it=it->next) {
-            if (((COMPS_RTreeData*)it->data)->key[0] == key[offset]) {
-                found = 1;
-                break;
-            }
-        }
-        if (!found) {
+        pos = comps_rnodes_find(subnodes, key[offset]);
+        if (pos == -1) {
             //printf("not found\n");
             return NULL;
         }
-        rtdata = (COMPS_RTreeData*)it->data;
+        rtdata = (COMPS_RTreeData*)subnodes->nodes[pos];
 
         for (x=1; ;x++) {
             ended=0;
-            if (x == strlen(rtdata->key)) ended += 1;
+            if (rtdata->key[x] == 0) ended += 1;
             if (x == len-offset) ended += 2;
             if (ended != 0) break;
             if (key[offset+x] != rtdata->key[x]) break;
@@ -336,45 +351,36 @@ void* comps_rtree_get(COMPS_RTree * rt, const char * key) {
         if (ended == 3) return rtdata->data;
         else if (ended == 1) offset+=x;
         else return NULL;
-        subnodes = ((COMPS_RTreeData*)it->data)->subnodes;
+        subnodes = rtdata->subnodes;
     }
-    if (it != NULL)
-        return ((COMPS_RTreeData*)it->data)->data;
-    else return NULL;
+    return NULL;
 }
 
 void comps_rtree_unset(COMPS_RTree * rt, const char * key) {
-    COMPS_HSList * subnodes;
-    COMPS_HSListItem * it;
+    COMPS_RNodes * subnodes;
     COMPS_RTreeData * rtdata;
-    unsigned int offset, len, x;
-    char found, ended;
-    COMPS_HSList * path;
+    unsigned int offset, len, x, depth;
+    int pos;
+    char ended;
 
     struct Relation {
-        COMPS_HSList * parent_nodes;
-        COMPS_HSListItem * child_it;
-    } *relation;
-
-    path = comps_hslist_create();
-    comps_hslist_init(path, NULL, NULL, &free);
+        COMPS_RNodes * parent_nodes;
+        unsigned int child_pos;
+    } *path;
 
     len = strlen(key);
+    /* every step along the path consumes at least one char of key */
+    if ((path = malloc(sizeof(*path) * (len + 1))) == NULL)
+        return;
     offset = 0;
+    depth = 0;
     subnodes = rt->subnodes;
     while (offset != len) {
-        found = 0;
-        for (it = subnodes->first; it != NULL; it=it->next) {
-            if (((COMPS_RTreeData*)it->data)->key[0] == key[offset]) {
-                found = 1;
-                break;
-            }
-        }
-        if (!found) {
-            comps_hslist_destroy(&path);
-            return;
+        pos = comps_rnodes_find(subnodes, key[offset]);
+        if (pos == -1) {
+            break;
         }
-        rtdata = (COMPS_RTreeData*)it->data;
+        rtdata = (COMPS_RTreeData*)subnodes->nodes[pos];
 
         for (x=1; ;x++) {
             ended=0;
@@ -383,90 +389,55 @@ void comps_rtree_unset(COMPS_RTree * rt, const char * key) {
             if (ended != 0) break;
             if (key[offset+x] != rtdata->key[x]) break;
         }
+        path[depth].parent_nodes = subnodes;
+        path[depth].child_pos = pos;
+        depth++;
+
         if (ended == 3) {
-            /* remove node from tree only if there's no descendant*/
-            if (rtdata->subnodes->last == NULL) {
-                //printf("removing all\n");
-                comps_hslist_remove(subnodes, it);
-                comps_rtree_data_destroy(rtdata);
-                free(it);
-            }
-            else if (rtdata->data_destructor != NULL) {
-                //printf("removing data only\n");
+            if (rtdata->data == NULL)
+                break;
+            if (*rtdata->data_destructor != NULL)
                 (*rtdata->data_destructor)(rtdata->data);
-                rtdata->is_leaf = 0;
-                rtdata->data = NULL;
-            }
-
-            if (path->last == NULL) {
-                comps_hslist_destroy(&path);
-                return;
-            }
-            rtdata = (COMPS_RTreeData*)
-                     ((struct Relation*)path->last->data)->child_it->data;
+            rtdata->is_leaf = 0;
+            rtdata->data = NULL;
 
-            /*remove all predecessor of deleted node (recursive) with no childs*/
-            while (rtdata->subnodes->last == NULL) {
-                //printf("removing '%s'\n", rtdata->key);
-                comps_rtree_data_destroy(rtdata);
-                comps_hslist_remove(
-                            ((struct Relation*)path->last->data)->parent_nodes,
-                            ((struct Relation*)path->last->data)->child_it);
-                free(((struct Relation*)path->last->data)->child_it);
-                it = path->last;
-                comps_hslist_remove(path, path->last);
-                free(it);
+            /*remove deleted node and all its predecessors left without data
+              and descendants*/
+            while (depth--) {
+                subnodes = path[depth].parent_nodes;
                 rtdata = (COMPS_RTreeData*)
-                         ((struct Relation*)path->last->data)->child_it->data;
+                         subnodes->nodes[path[depth].child_pos];
+                if (rtdata->data != NULL || rtdata->subnodes->len != 0)
+                    break;
+                comps_rnodes_remove_at(subnodes, path[depth].child_pos);
+                comps_rtree_data_destroy(rtdata);
             }
-            comps_hslist_destroy(&path);
-            return;
+            break;
         }
         else if (ended == 1) offset+=x;
         else {
-            comps_hslist_destroy(&path);
-            return;
-        }
-        if ((relation = malloc(sizeof(struct Relation))) == NULL) {
-            comps_hslist_destroy(&path);
-            return;
+            break;
         }
-        subnodes = ((COMPS_RTreeData*)it->data)->subnodes;
-        relation->parent_nodes = subnodes;
-        relation->child_it = it;
-        comps_hslist_append(path, (void*)relation, 0);
+        subnodes = rtdata->subnodes;
     }
-    comps_hslist_destroy(&path);
-    return;
+    free(path);
 }
 
 void comps_rtree_clear(COMPS_RTree * rt) {
-    COMPS_HSListItem *it, *oldit;
     if (rt==NULL) return;
     if (rt->subnodes == NULL) return;
-    oldit = rt->subnodes->first;
-    it = (oldit)?oldit->next:NULL;
-    for (;it != NULL; it=it->next) {
-        if (rt->subnodes->data_destructor != NULL)
-            rt->subnodes->data_destructor(oldit->data);
-        free(oldit);
-        oldit = it;
-    }
-    if (oldit) {
-        if (rt->subnodes->data_destructor != NULL)
-            rt->subnodes->data_destructor(oldit->data);
-        free(oldit);
-    }
+    comps_rnodes_clear(rt->subnodes);
 }
 
 inline COMPS_HSList* __comps_rtree_all(COMPS_RTree * rt, char keyvalpair) {
     COMPS_HSList *to_process, *ret;
-    COMPS_HSListItem *hsit, *oldit;
+    COMPS_HSListItem *oldit;
+    COMPS_RTreeData *rtdata;
     size_t x;
     struct Pair {
         char *key;
         void *data;
-        COMPS_HSList *subnodes;
+        COMPS_RNodes *subnodes;
     } *pair, *current_pair=NULL;//, *oldpair=NULL;
     COMPS_RTreePair *rtpair;
 
@@ -481,11 +452,12 @@ inline COMPS_HSList* __comps_rtree_all(COMPS_RTree * rt, char keyvalpair) {
     else
         comps_hslist_init(ret, NULL, NULL, &comps_rtree_pair_destroy_v);
 
-    for (hsit = rt->subnodes->first; hsit != NULL; hsit = hsit->next) {
+    for (x = 0; x < rt->subnodes->len; x++) {
+        rtdata = (COMPS_RTreeData*)rt->subnodes->nodes[x];
         pair = malloc(sizeof(struct Pair));
-        pair->key = __comps_strcpy(((COMPS_RTreeData*)hsit->data)->key);
-        pair->data = ((COMPS_RTreeData*)hsit->data)->data;
-        pair->subnodes = ((COMPS_RTreeData*)hsit->data)->subnodes;
+        pair->key = __comps_strcpy(rtdata->key);
+        pair->data = rtdata->data;
+        pair->subnodes = rtdata->subnodes;
         comps_hslist_append(to_process, pair, 0);
     }
     while (to_process->first) {
@@ -505,13 +477,12 @@ inline COMPS_HSList* __comps_rtree_all(COMPS_RTree * rt, char keyvalpair) {
                 comps_hslist_append(ret, rtpair, 0);
             }
         }
-        for (hsit = current_pair->subnodes->first, x = 0;
-             hsit != NULL; hsit = hsit->next, x++) {
+        for (x = 0; x < current_pair->subnodes->len; x++) {
+            rtdata = (COMPS_RTreeData*)current_pair->subnodes->nodes[x];
             pair = malloc(sizeof(struct Pair));
-            pair->key = __comps_strcat(current_pair->key,
-                                       ((COMPS_RTreeData*)hsit->data)->key);
-            pair->data = ((COMPS_RTreeData*)hsit->data)->data;
-            pair->subnodes = ((COMPS_RTreeData*)hsit->data)->subnodes;
+            pair->key = __comps_strcat(current_pair->key, rtdata->key);
+            pair->data = rtdata->data;
+            pair->subnodes = rtdata->subnodes;
             comps_hslist_insert_at(to_process, x, pair, 0);
         }
         free(current_pair->key);
@@ -524,10 +495,13 @@ inline COMPS_HSList* __comps_rtree_all(COMPS_RTree * rt, char keyvalpair) {
 }
 
 void comps_rtree_unite(COMPS_RTree *rt1, COMPS_RTree *rt2) {
-    COMPS_HSList *tmplist, *tmp_subnodes;
+    COMPS_HSList *tmplist;
+    COMPS_RNodes *tmp_subnodes;
     COMPS_HSListItem *it;
+    COMPS_RTreeData *rtdata;
+    unsigned int i;
     struct Pair {
-        COMPS_HSList * subnodes;
+        COMPS_RNodes * subnodes;
         char * key;
     } *pair, *parent_pair;
 
@@ -546,32 +520,30 @@ void comps_rtree_unite(COMPS_RTree *rt1, COMPS_RTree *rt2) {
         parent_pair = (struct Pair*) it->data;
         free(it);
 
-        for (it = tmp_subnodes->first; it != NULL; it=it->next) {
+        for (i = 0; i < tmp_subnodes->len; i++) {
+            rtdata = (COMPS_RTreeData*)tmp_subnodes->nodes[i];
             pair = malloc(sizeof(struct Pair));
-            pair->subnodes = ((COMPS_RTreeData*)it->data)->subnodes;
+            pair->subnodes = rtdata->subnodes;
 
             if (parent_pair->key != NULL) {
                 pair->key = malloc(sizeof(char)
-                               * (strlen(((COMPS_RTreeData*)it->data)->key)
+                               * (strlen(rtdata->key)
                                + strlen(parent_pair->key) + 1));
                 memcpy(pair->key, parent_pair->key,
                        sizeof(char) * strlen(parent_pair->key));
-                memcpy(pair->key + strlen(parent_pair->key),
-                       ((COMPS_RTreeData*)it->data)->key,
-                       sizeof(char)*(strlen(((COMPS_RTreeData*)it->data)->key)+1));
+                memcpy(pair->key + strlen(parent_pair->key), rtdata->key,
+                       sizeof(char)*(strlen(rtdata->key)+1));
             } else {
-                pair->key = malloc(sizeof(char)*
-                                (strlen(((COMPS_RTreeData*)it->data)->key) +1));
-                memcpy(pair->key, ((COMPS_RTreeData*)it->data)->key,
-                       sizeof(char)*(strlen(((COMPS_RTreeData*)it->data)->key)+1));
+                pair->key = malloc(sizeof(char)* (strlen(rtdata->key) +1));
+                memcpy(pair->key, rtdata->key,
+                       sizeof(char)*(strlen(rtdata->key)+1));
             }
             /* current node has data */
-            if (((COMPS_RTreeData*)it->data)->data != NULL) {
-                    comps_rtree_set(rt1,
-                                    pair->key,
-                        rt2->data_cloner(((COMPS_RTreeData*)it->data)->data));
+            if (rtdata->data != NULL) {
+                    comps_rtree_set(rt1, pair->key,
+                                    rt2->data_cloner(rtdata->data));
             }
-            if (((COMPS_RTreeData*)it->data)->subnodes->first) {
+            if (rtdata->subnodes->len) {
                 comps_hslist_append(tmplist, pair, 0);
             } else {
                 free(pair->key);
@@ -23,17 +23,18 @@
 #include <stdlib.h>
 #include <string.h>
 #include "comps_hslist.h"
+#include "comps_rnodes.h"
 
 typedef struct {
     char * key;
     unsigned is_leaf;
-    COMPS_HSList * subnodes;
+    COMPS_RNodes * subnodes;
     void * data;
     void (**data_destructor)(void*);
 } COMPS_RTreeData;
 
 typedef struct {
-    COMPS_HSList *  subnodes;
+    COMPS_RNodes *  subnodes;
     void* (*data_constructor)(void*);
     void* (*data_cloner)(void*);
     void (*data_destructor)(void*);
@@ -72,6 +73,10 @@ void comps_rtree_clear(COMPS_RTree * rt);
 
 void comps_rtree_values_walk(COMPS_RTree *rt, void* udata,
                                                void (*walk_f)(void*, void*));
+/* call walk_f with key and data of every key starting with prefix, in
+ * ascending order of keys */
+void comps_rtree_prefix_walk(COMPS_RTree *rt, const char *prefix, void *udata,
+                             void (*walk_f)(void*, const char*, void*));
 COMPS_HSList * comps_rtree_values(COMPS_RTree *rt);
 COMPS_HSList* comps_rtree_keys(COMPS_RTree * rt);
 COMPS_HSList* comps_rtree_pairs(COMPS_RTree * rt);
@@ -85,5 +90,5 @@ COMPS_RTreePair * comps_rtree_pair_create(char * key, void * data,
 void comps_rtree_pair_destroy(COMPS_RTreePair * pair);
 void comps_rtree_pair_destroy_v(void * pair);
 
-void comps_rtree_print(COMPS_HSList * hl, unsigned  deep);
+void comps_rtree_print(COMPS_RNodes * rnodes, unsigned  deep);
 #endif
@@ -0,0 +1,246 @@
+/* libcomps - C alternative to yum.comps library
+ * Copyright (C) 2013 Jindrich Luza
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to  Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA
+ */
+
+#include "comps_rnodes.h"
+
+#include <string.h>
+
+#ifdef __SSE2__
+    #include <emmintrin.h>
+#endif
+
+COMPS_RNodes* comps_rnodes_create(void (*data_destructor)(void*)) {
+    COMPS_RNodes *ret;
+    if ((ret = malloc(sizeof(*ret))) == NULL)
+        return NULL;
+    ret->index = NULL;
+    ret->nodes = NULL;
+    ret->len = 0;
+    ret->size = 0;
+    ret->data_destructor = data_destructor;
+    return ret;
+}
+
+void comps_rnodes_clear(COMPS_RNodes *rnodes) {
+    unsigned int i;
+    if (rnodes == NULL)
+        return;
+    if (rnodes->data_destructor) {
+        for (i = 0; i < rnodes->len; i++)
+            rnodes->data_destructor(rnodes->nodes[i]);
+    }
+    rnodes->len = 0;
+}
+
+void comps_rnodes_destroy(COMPS_RNodes **rnodes) {
+    if (*rnodes == NULL)
+        return;
+    comps_rnodes_clear(*rnodes);
+    free((*rnodes)->index);
+    free((*rnodes)->nodes);
+    free(*rnodes);
+    *rnodes = NULL;
+}
+
+static int __comps_rnodes_grow(COMPS_RNodes *rnodes) {
+    unsigned char *index;
+    void **nodes;
+    unsigned int size;
+
+    size = rnodes->size + COMPS_RNODES_STEP;
+    if ((index = realloc(rnodes->index, sizeof(*index) * size)) == NULL)
+        return 0;
+    /* keep padding initialized, whole blocks are loaded in find */
+    memset(index + rnodes->size, 0, COMPS_RNODES_STEP);
+    rnodes->index = index;
+    if ((nodes = realloc(rnodes->nodes, sizeof(*nodes) * size)) == NULL)
+        return 0;
+    rnodes->nodes = nodes;
+    rnodes->size = size;
+    return 1;
+}
+
+int comps_rnodes_find(const COMPS_RNodes *rnodes, char ch) {
+#ifdef __SSE2__
+    __m128i needle, block;
+    unsigned int i, mask;
+
+    needle = _mm_set1_epi8(ch);
+    for (i = 0; i < rnodes->len; i += COMPS_RNODES_STEP) {
+        block = _mm_loadu_si128((const __m128i*)(rnodes->index + i));
+        mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+        if (rnodes->len - i < COMPS_RNODES_STEP)
+            mask &= (1u << (rnodes->len - i)) - 1;
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+    return -1;
+#else
+    unsigned int pos;
+    pos = comps_rnodes_lower_bound(rnodes, ch);
+    if (pos < rnodes->len && rnodes->index[pos] == (unsigned char)ch)
+        return pos;
+    return -1;
+#endif
+}
+
+unsigned int comps_rnodes_lower_bound(const COMPS_RNodes *rnodes, char ch) {
+    unsigned int lo, hi, mid;
+    lo = 0;
+    hi = rnodes->len;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (rnodes->index[mid] < (unsigned char)ch)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+int comps_rnodes_insert_at(COMPS_RNodes *rnodes, unsigned int pos,
+                           char ch, void *node) {
+    if (pos > rnodes->len)
+        return 0;
+    if (rnodes->len == rnodes->size && !__comps_rnodes_grow(rnodes))
+        return 0;
+    memmove(rnodes->index + pos + 1, rnodes->index + pos,
+            sizeof(*rnodes->index) * (rnodes->len - pos));
+    memmove(rnodes->nodes + pos + 1, rnodes->nodes + pos,
+            sizeof(*rnodes->nodes) * (rnodes->len - pos));
+    rnodes->index[pos] = (unsigned char)ch;
+    rnodes->nodes[pos] = node;
+    rnodes->len++;
+    return 1;
+}
+
+int comps_rnodes_insert(COMPS_RNodes *rnodes, char ch, void *node) {
+    return comps_rnodes_insert_at(rnodes, comps_rnodes_lower_bound(rnodes, ch),
+                                  ch, node);
+}
+
+void* comps_rnodes_remove_at(COMPS_RNodes *rnodes, unsigned int pos) {
+    void *ret;
+    if (pos >= rnodes->len)
+        return NULL;
+    ret = rnodes->nodes[pos];
+    rnodes->len--;
+    memmove(rnodes->index + pos, rnodes->index + pos + 1,
+            sizeof(*rnodes->index) * (rnodes->len - pos));
+    memmove(rnodes->nodes + pos, rnodes->nodes + pos + 1,
+            sizeof(*rnodes->nodes) * (rnodes->len - pos));
+    rnodes->index[rnodes->len] = 0;
+    return ret;
+}
+
+void comps_rnodes_it_init(COMPS_RNodesIt *it, const COMPS_RNodes *rnodes) {
+    it->stack = it->stack_buf;
+    it->stack_size = COMPS_RNODES_IT_DEPTH;
+    it->key = it->key_buf;
+    it->key_size = COMPS_RNODES_IT_KEYLEN;
+    it->key[0] = 0;
+    it->keylen = 0;
+    it->depth = 0;
+    it->end_key = NULL;
+    if (rnodes != NULL)
+        comps_rnodes_it_push(it, rnodes, 0, rnodes->len);
+}
+
+void comps_rnodes_it_destroy(COMPS_RNodesIt *it) {
+    if (it->stack != it->stack_buf)
+        free(it->stack);
+    if (it->key != it->key_buf)
+        free(it->key);
+    it->stack = it->stack_buf;
+    it->key = it->key_buf;
+    it->depth = 0;
+}
+
+void* comps_rnodes_it_next(COMPS_RNodesIt *it) {
+    COMPS_RNodesFrame *frame;
+    while (it->depth) {
+        frame = &it->stack[it->depth - 1];
+        if (frame->pos < frame->end) {
+            it->keylen = frame->keylen;
+            return frame->rnodes->nodes[frame->pos++];
+        }
+        it->depth--;
+    }
+    return NULL;
+}
+
+int comps_rnodes_it_push(COMPS_RNodesIt *it, const COMPS_RNodes *rnodes,
+                         unsigned int pos, unsigned int end) {
+    unsigned int stack_size;
+    COMPS_RNodesFrame *tmpstack;
+
+    if (pos >= end)
+        return 1;
+    if (it->depth == it->stack_size) {
+        stack_size = it->stack_size * 2;
+        if (it->stack == it->stack_buf) {
+            tmpstack = malloc(sizeof(*tmpstack) * stack_size);
+            if (tmpstack == NULL)
+                return 0;
+            memcpy(tmpstack, it->stack, sizeof(*tmpstack) * it->depth);
+        } else {
+            tmpstack = realloc(it->stack, sizeof(*tmpstack) * stack_size);
+            if (tmpstack == NULL)
+                return 0;
+        }
+        it->stack = tmpstack;
+        it->stack_size = stack_size;
+    }
+    it->stack[it->depth].rnodes = rnodes;
+    it->stack[it->depth].pos = pos;
+    it->stack[it->depth].end = end;
+    it->stack[it->depth].keylen = it->keylen;
+    it->depth++;
+    return 1;
+}
+
+int comps_rnodes_it_append(COMPS_RNodesIt *it, const char *key, size_t len) {
+    size_t size;
+    char *tmpkey;
+
+    if (it->keylen + len + 1 > it->key_size) {
+        for (size = it->key_size * 2; size < it->keylen + len + 1; size *= 2);
+        if (it->key == it->key_buf) {
+            if ((tmpkey = malloc(sizeof(*tmpkey) * size)) == NULL)
+                return 0;
+            memcpy(tmpkey, it->key, sizeof(*tmpkey) * it->keylen);
+        } else if ((tmpkey = realloc(it->key, sizeof(*tmpkey) * size)) == NULL)
+            return 0;
+        it->key = tmpkey;
+        it->key_size = size;
+    }
+    memcpy(it->key + it->keylen, key, sizeof(*key) * len);
+    it->keylen += len;
+    it->key[it->keylen] = 0;
+    return 1;
+}
+
+int comps_rnodes_it_enter(COMPS_RNodesIt *it, const char *key,
+                          const COMPS_RNodes *subnodes) {
+    if (!comps_rnodes_it_append(it, key, strlen(key)))
+        return 0;
+    if (subnodes == NULL)
+        return 1;
+    return comps_rnodes_it_push(it, subnodes, 0, subnodes->len);
+}
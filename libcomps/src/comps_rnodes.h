@@ -0,0 +1,165 @@
+/* libcomps - C alternative to yum.comps library
+ * Copyright (C) 2013 Jindrich Luza
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to  Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA
+ */
+
+/*! \file comps_rnodes.h
+ * \brief Subnodes of radix tree node.
+ * Children of radix tree node are kept in compact array sorted by first
+ * byte of their key. First bytes are additionaly stored in separate index
+ * vector, so child lookup touches only one small continuous block of memory.
+ **/
+#ifndef COMPS_RNODES_H
+#define COMPS_RNODES_H
+
+#include <stdlib.h>
+
+/** allocation step of index vector and node array. Index vector is always
+ * allocated to multiple of this value, so it can be scanned by whole blocks
+ */
+#define COMPS_RNODES_STEP 16
+
+/** number of tree levels iterator can descend without allocation */
+#define COMPS_RNODES_IT_DEPTH 32
+/** key length iterator can build without allocation */
+#define COMPS_RNODES_IT_KEYLEN 256
+
+typedef struct {
+    unsigned char *index; /**< first byte of every node key, ascending */
+    void **nodes; /**< nodes in the same order as index */
+    unsigned int len; /**< number of nodes */
+    unsigned int size; /**< allocated slots */
+    void (*data_destructor)(void*); /**< nodes destructor */
+} COMPS_RNodes;
+
+typedef struct {
+    const COMPS_RNodes *rnodes;
+    unsigned int pos; /**< next node to visit */
+    unsigned int end; /**< position after last node to visit */
+    size_t keylen; /**< length of key prefix shared by rnodes */
+} COMPS_RNodesFrame;
+
+/** Depth-first cursor over radix tree nodes
+ *
+ * Stack of visited levels and key of current node live inside the structure,
+ * heap is used only for trees deeper than COMPS_RNODES_IT_DEPTH or keys
+ * longer than COMPS_RNODES_IT_KEYLEN. Structure points into itself, so it
+ * must not be copied after initialization.
+ */
+typedef struct {
+    COMPS_RNodesFrame *stack;
+    unsigned int depth;
+    unsigned int stack_size;
+    char *key; /**< key of current node, NUL terminated */
+    size_t keylen;
+    size_t key_size;
+    const char *end_key; /**< if set, iteration stops before this key */
+    COMPS_RNodesFrame stack_buf[COMPS_RNODES_IT_DEPTH];
+    char key_buf[COMPS_RNODES_IT_KEYLEN];
+} COMPS_RNodesIt;
+
+/** Create new empty subnodes array
+ * @param data_destructor destructor called for each node on clear/destroy
+ * @return new COMPS_RNodes or NULL if allocation fails
+ */
+COMPS_RNodes* comps_rnodes_create(void (*data_destructor)(void*));
+
+/** Destroy subnodes array with all nodes and set pointer to NULL */
+void comps_rnodes_destroy(COMPS_RNodes **rnodes);
+
+/** Destroy all nodes in array, keep the array itself */
+void comps_rnodes_clear(COMPS_RNodes *rnodes);
+
+/** Find node which key starts with specified byte
+ * @param rnodes COMPS_RNodes instance
+ * @param ch first byte of searched key
+ * @return position of node or -1 if there's no such node
+ */
+int comps_rnodes_find(const COMPS_RNodes *rnodes, char ch);
+
+/** Return position where node with specified first byte belongs
+ * @param rnodes COMPS_RNodes instance
+ * @param ch first byte of key
+ * @return position of first node with first byte not less than ch
+ */
+unsigned int comps_rnodes_lower_bound(const COMPS_RNodes *rnodes, char ch);
+
+/** Insert node at specified position
+ *
+ * Caller is responsible for keeping array sorted
+ * @return non-zero on success, zero otherwise
+ */
+int comps_rnodes_insert_at(COMPS_RNodes *rnodes, unsigned int pos,
+                           char ch, void *node);
+
+/** Insert node at sorted position
+ * @return non-zero on success, zero otherwise
+ */
+int comps_rnodes_insert(COMPS_RNodes *rnodes, char ch, void *node);
+
+/** Remove node at specified position from array
+ *
+ * Node isn't destroyed
+ * @return removed node or NULL if position is out of range
+ */
+void* comps_rnodes_remove_at(COMPS_RNodes *rnodes, unsigned int pos);
+
+/** Initialize iterator over nodes of tree with specified top-level subnodes
+ * @param it uninitialized iterator
+ * @param rnodes top-level subnodes of tree
+ */
+void comps_rnodes_it_init(COMPS_RNodesIt *it, const COMPS_RNodes *rnodes);
+
+/** Release memory possibly allocated by iterator. Iterator itself isn't
+ * freed
+ */
+void comps_rnodes_it_destroy(COMPS_RNodesIt *it);
+
+/** Return next node in depth-first order
+ *
+ * After return it->keylen holds length of key prefix leading to the node.
+ * Caller has to pass node key part and subnodes to comps_rnodes_it_enter
+ * before next call, otherwise node's subtree is skipped.
+ * @return next node or NULL when there are no more nodes
+ */
+void* comps_rnodes_it_next(COMPS_RNodesIt *it);
+
+/** Schedule nodes [pos, end) of rnodes for visiting
+ *
+ * Nodes share key prefix of length it->keylen currently held by iterator.
+ * Frames pushed later are visited first.
+ * @return non-zero on success, zero if allocation fails
+ */
+int comps_rnodes_it_push(COMPS_RNodesIt *it, const COMPS_RNodes *rnodes,
+                         unsigned int pos, unsigned int end);
+
+/** Append len bytes of key to iterator key
+ * @return non-zero on success, zero if allocation fails
+ */
+int comps_rnodes_it_append(COMPS_RNodesIt *it, const char *key, size_t len);
+
+/** Append key part of node returned by comps_rnodes_it_next to iterator key
+ * and schedule node subnodes for visiting
+ * @param it iterator
+ * @param key key part of current node
+ * @param subnodes subnodes of current node
+ * @return non-zero on success, zero if allocation fails
+ */
+int comps_rnodes_it_enter(COMPS_RNodesIt *it, const char *key,
+                          const COMPS_RNodes *subnodes);
+
+#endif
@@ -0,0 +1,319 @@
+/* libcomps - C alternative to yum.comps library
+ * Copyright (C) 2013 Jindrich Luza
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to  Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA
+ */
+
+#include "comps_scan.h"
+
+#include <pthread.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define COMPS_SCAN_X86
+#include <immintrin.h>
+#endif
+
+typedef struct {
+    COMPS_ScanLevel level;
+    int (*space_only)(const char*, size_t);
+    size_t (*xml_text)(const char*, size_t);
+    size_t (*xml_attr)(const char*, size_t);
+} COMPS_ScanOps;
+
+/* isspace() of C locale without locale table lookup: space or one of
+ * \t \n \v \f \r, which are consecutive */
+static inline int __comps_scan_is_space(unsigned char c) {
+    return c == ' ' || (unsigned char)(c - '\t') <= '\r' - '\t';
+}
+
+static int __comps_scan_space_only_scalar(const char *s, size_t len) {
+    for (; len; s++, len--) {
+        if (!__comps_scan_is_space(*s))
+            return 0;
+    }
+    return 1;
+}
+
+static inline int __comps_scan_is_xml_text(unsigned char c) {
+    return c == '&' || c == '<' || c == '>' || c == '\r';
+}
+
+/* libxml2 escapes also quote, tab and LF in attributes. Non-ASCII bytes
+ * are escaped as character references when writer has no document
+ * encoding, they're left to libxml2 too */
+static inline int __comps_scan_is_xml_attr(unsigned char c) {
+    return __comps_scan_is_xml_text(c) || c == '"' || c == '\t'
+           || c == '\n' || c >= 0x80;
+}
+
+static size_t __comps_scan_xml_text_scalar(const char *s, size_t len) {
+    size_t i;
+    for (i = 0; i < len && !__comps_scan_is_xml_text(s[i]); i++);
+    return i;
+}
+
+static size_t __comps_scan_xml_attr_scalar(const char *s, size_t len) {
+    size_t i;
+    for (i = 0; i < len && !__comps_scan_is_xml_attr(s[i]); i++);
+    return i;
+}
+
+static const COMPS_ScanOps __comps_scan_scalar = {
+    COMPS_SCAN_SCALAR, &__comps_scan_space_only_scalar,
+    &__comps_scan_xml_text_scalar, &__comps_scan_xml_attr_scalar
+};
+
+#ifdef COMPS_SCAN_X86
+
+/* Byte mask of whitespace in v, unsigned c - '\t' <= '\r' - '\t' is
+ * tested as min(c - '\t', '\r' - '\t') == c - '\t' */
+__attribute__((target("sse2")))
+static inline __m128i __comps_scan_space_sse2(__m128i v) {
+    __m128i t = _mm_sub_epi8(v, _mm_set1_epi8('\t'));
+
+    return _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                        _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8('\r'
+                                                                     - '\t')),
+                                       t));
+}
+
+__attribute__((target("sse2")))
+static int __comps_scan_space_only_sse2(const char *s, size_t len) {
+    for (; len >= 16; s += 16, len -= 16) {
+        if (_mm_movemask_epi8(__comps_scan_space_sse2(
+                  _mm_loadu_si128((const __m128i*)s))) != 0xffff)
+            return 0;
+    }
+    return __comps_scan_space_only_scalar(s, len);
+}
+
+__attribute__((target("sse2")))
+static inline int __comps_scan_xml_text_sse2(__m128i v) {
+    return _mm_movemask_epi8(
+               _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('&')),
+                                         _mm_cmpeq_epi8(v, _mm_set1_epi8('<'))),
+                            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('>')),
+                                         _mm_cmpeq_epi8(v,
+                                                        _mm_set1_epi8('\r')))));
+}
+
+/* quote, tab and LF on top of text bits, high bit of byte marks
+ * non-ASCII */
+__attribute__((target("sse2")))
+static inline int __comps_scan_xml_attr_sse2(__m128i v) {
+    return __comps_scan_xml_text_sse2(v) | _mm_movemask_epi8(v)
+           | _mm_movemask_epi8(
+                 _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+                              _mm_or_si128(_mm_cmpeq_epi8(v,
+                                                          _mm_set1_epi8('\t')),
+                                           _mm_cmpeq_epi8(v,
+                                                          _mm_set1_epi8('\n')))));
+}
+
+__attribute__((target("sse2")))
+static size_t __comps_scan_xml_text_span_sse2(const char *s, size_t len) {
+    size_t i;
+    int mask;
+
+    for (i = 0; i + 16 <= len; i += 16) {
+        mask = __comps_scan_xml_text_sse2(_mm_loadu_si128((const __m128i*)
+                                                          (s + i)));
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+    return i + __comps_scan_xml_text_scalar(s + i, len - i);
+}
+
+__attribute__((target("sse2")))
+static size_t __comps_scan_xml_attr_span_sse2(const char *s, size_t len) {
+    size_t i;
+    int mask;
+
+    for (i = 0; i + 16 <= len; i += 16) {
+        mask = __comps_scan_xml_attr_sse2(_mm_loadu_si128((const __m128i*)
+                                                          (s + i)));
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+    return i + __comps_scan_xml_attr_scalar(s + i, len - i);
+}
+
+static const COMPS_ScanOps __comps_scan_sse2 = {
+    COMPS_SCAN_SSE2, &__comps_scan_space_only_sse2,
+    &__comps_scan_xml_text_span_sse2, &__comps_scan_xml_attr_span_sse2
+};
+
+__attribute__((target("avx2")))
+static inline __m256i __comps_scan_space_avx2(__m256i v) {
+    __m256i t = _mm256_sub_epi8(v, _mm256_set1_epi8('\t'));
+
+    return _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                           _mm256_cmpeq_epi8(_mm256_min_epu8(t,
+                                               _mm256_set1_epi8('\r' - '\t')),
+                                             t));
+}
+
+__attribute__((target("avx2")))
+static int __comps_scan_space_only_avx2(const char *s, size_t len) {
+    for (; len >= 32; s += 32, len -= 32) {
+        if (_mm256_movemask_epi8(__comps_scan_space_avx2(
+                  _mm256_loadu_si256((const __m256i*)s))) != -1)
+            return 0;
+    }
+    if (len >= 16) {
+        if (_mm_movemask_epi8(__comps_scan_space_sse2(
+                  _mm_loadu_si128((const __m128i*)s))) != 0xffff)
+            return 0;
+        s += 16;
+        len -= 16;
+    }
+    return __comps_scan_space_only_scalar(s, len);
+}
+
+__attribute__((target("avx2")))
+static inline unsigned __comps_scan_xml_text_avx2(__m256i v) {
+    return (unsigned)_mm256_movemask_epi8(
+               _mm256_or_si256(
+                   _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('&')),
+                                   _mm256_cmpeq_epi8(v, _mm256_set1_epi8('<'))),
+                   _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('>')),
+                                   _mm256_cmpeq_epi8(v,
+                                                     _mm256_set1_epi8('\r')))));
+}
+
+__attribute__((target("avx2")))
+static inline unsigned __comps_scan_xml_attr_avx2(__m256i v) {
+    return __comps_scan_xml_text_avx2(v) | (unsigned)_mm256_movemask_epi8(v)
+           | (unsigned)_mm256_movemask_epi8(
+                 _mm256_or_si256(
+                     _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')),
+                     _mm256_or_si256(_mm256_cmpeq_epi8(v,
+                                                       _mm256_set1_epi8('\t')),
+                                     _mm256_cmpeq_epi8(v,
+                                                       _mm256_set1_epi8('\n')))));
+}
+
+/* Upper halves of YMM registers are cleared before the tail, compiler
+ * doesn't do it before the scalar call and legacy SSE code run with them
+ * dirty (libxml2, libc) is many times slower */
+__attribute__((target("avx2")))
+static size_t __comps_scan_xml_text_span_avx2(const char *s, size_t len) {
+    size_t i;
+    unsigned mask;
+
+    for (i = 0; i + 32 <= len; i += 32) {
+        mask = __comps_scan_xml_text_avx2(_mm256_loadu_si256((const __m256i*)
+                                                             (s + i)));
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+    _mm256_zeroupper();
+    if (i + 16 <= len) {
+        mask = __comps_scan_xml_text_sse2(_mm_loadu_si128((const __m128i*)
+                                                          (s + i)));
+        if (mask)
+            return i + __builtin_ctz(mask);
+        i += 16;
+    }
+    return i + __comps_scan_xml_text_scalar(s + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static size_t __comps_scan_xml_attr_span_avx2(const char *s, size_t len) {
+    size_t i;
+    unsigned mask;
+
+    for (i = 0; i + 32 <= len; i += 32) {
+        mask = __comps_scan_xml_attr_avx2(_mm256_loadu_si256((const __m256i*)
+                                                             (s + i)));
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+    _mm256_zeroupper();
+    if (i + 16 <= len) {
+        mask = __comps_scan_xml_attr_sse2(_mm_loadu_si128((const __m128i*)
+                                                          (s + i)));
+        if (mask)
+            return i + __builtin_ctz(mask);
+        i += 16;
+    }
+    return i + __comps_scan_xml_attr_scalar(s + i, len - i);
+}
+
+static const COMPS_ScanOps __comps_scan_avx2 = {
+    COMPS_SCAN_AVX2, &__comps_scan_space_only_avx2,
+    &__comps_scan_xml_text_span_avx2, &__comps_scan_xml_attr_span_avx2
+};
+
+#endif
+
+static const COMPS_ScanOps *__comps_scan_ops = &__comps_scan_scalar;
+static pthread_once_t __comps_scan_once = PTHREAD_ONCE_INIT;
+
+static const COMPS_ScanOps* __comps_scan_best(COMPS_ScanLevel max) {
+    #ifdef COMPS_SCAN_X86
+    __builtin_cpu_init();
+    if (max >= COMPS_SCAN_AVX2 && __builtin_cpu_supports("avx2"))
+        return &__comps_scan_avx2;
+    if (max >= COMPS_SCAN_SSE2 && __builtin_cpu_supports("sse2"))
+        return &__comps_scan_sse2;
+    #else
+    (void)max;
+    #endif
+    return &__comps_scan_scalar;
+}
+
+static void __comps_scan_init(void) {
+    __comps_scan_ops = __comps_scan_best(COMPS_SCAN_AVX2);
+}
+
+/* Most character data runs are short or end at first byte, which is
+ * decided here without dispatch overhead */
+#define COMPS_SCAN_DIRECT 16
+
+int comps_scan_space_only(const char *s, size_t len) {
+    size_t i;
+
+    for (i = 0; i < len && i < COMPS_SCAN_DIRECT; i++) {
+        if (!__comps_scan_is_space(s[i]))
+            return 0;
+    }
+    if (i == len)
+        return 1;
+    pthread_once(&__comps_scan_once, &__comps_scan_init);
+    return __comps_scan_ops->space_only(s + i, len - i);
+}
+
+size_t comps_scan_xml_text(const char *s, size_t len) {
+    pthread_once(&__comps_scan_once, &__comps_scan_init);
+    return __comps_scan_ops->xml_text(s, len);
+}
+
+size_t comps_scan_xml_attr(const char *s, size_t len) {
+    pthread_once(&__comps_scan_once, &__comps_scan_init);
+    return __comps_scan_ops->xml_attr(s, len);
+}
+
+COMPS_ScanLevel comps_scan_level(void) {
+    pthread_once(&__comps_scan_once, &__comps_scan_init);
+    return __comps_scan_ops->level;
+}
+
+COMPS_ScanLevel comps_scan_set_level(COMPS_ScanLevel level) {
+    pthread_once(&__comps_scan_once, &__comps_scan_init);
+    __comps_scan_ops = __comps_scan_best(level);
+    return __comps_scan_ops->level;
+}
@@ -0,0 +1,130 @@
+/* libcomps - C alternative to yum.comps library
+ * Copyright (C) 2013 Jindrich Luza
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to  Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA
+ */
+
+#include "comps_sha256.h"
+
+#include <string.h>
+
+static const uint32_t __comps_sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void __comps_sha256_block(COMPS_SHA256 *ctx, const unsigned char *p) {
+    uint32_t w[64], s[8], t1, t2;
+    int i;
+
+    for (i = 0; i < 16; i++, p += 4)
+        w[i] = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16
+               | (uint32_t)p[2] << 8 | p[3];
+    for (; i < 64; i++)
+        w[i] = w[i - 16] + w[i - 7]
+               + (ROTR(w[i - 15], 7) ^ ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3))
+               + (ROTR(w[i - 2], 17) ^ ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10));
+    memcpy(s, ctx->state, sizeof(s));
+    for (i = 0; i < 64; i++) {
+        t1 = s[7] + (ROTR(s[4], 6) ^ ROTR(s[4], 11) ^ ROTR(s[4], 25))
+             + ((s[4] & s[5]) ^ (~s[4] & s[6])) + __comps_sha256_k[i] + w[i];
+        t2 = (ROTR(s[0], 2) ^ ROTR(s[0], 13) ^ ROTR(s[0], 22))
+             + ((s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]));
+        memmove(s + 1, s, sizeof(uint32_t) * 7);
+        s[4] += t1;
+        s[0] = t1 + t2;
+    }
+    for (i = 0; i < 8; i++)
+        ctx->state[i] += s[i];
+}
+
+void comps_sha256_init(COMPS_SHA256 *ctx) {
+    static const uint32_t init[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    memcpy(ctx->state, init, sizeof(init));
+    ctx->len = 0;
+}
+
+void comps_sha256_update(COMPS_SHA256 *ctx, const void *data, size_t len) {
+    const unsigned char *p = data;
+    size_t used = ctx->len % 64, n;
+
+    ctx->len += len;
+    if (used) {
+        n = 64 - used < len ? 64 - used : len;
+        memcpy(ctx->block + used, p, n);
+        p += n;
+        len -= n;
+        if (used + n < 64)
+            return;
+        __comps_sha256_block(ctx, ctx->block);
+    }
+    for (; len >= 64; p += 64, len -= 64)
+        __comps_sha256_block(ctx, p);
+    memcpy(ctx->block, p, len);
+}
+
+void comps_sha256_final(COMPS_SHA256 *ctx,
+                        unsigned char digest[COMPS_SHA256_LEN]) {
+    uint64_t bits = ctx->len * 8;
+    size_t used = ctx->len % 64;
+    int i;
+
+    ctx->block[used++] = 0x80;
+    if (used > 56) {
+        memset(ctx->block + used, 0, 64 - used);
+        __comps_sha256_block(ctx, ctx->block);
+        used = 0;
+    }
+    memset(ctx->block + used, 0, 56 - used);
+    for (i = 0; i < 8; i++)
+        ctx->block[56 + i] = (unsigned char)(bits >> (56 - 8 * i));
+    __comps_sha256_block(ctx, ctx->block);
+    for (i = 0; i < 32; i++)
+        digest[i] = (unsigned char)(ctx->state[i / 4] >> (24 - 8 * (i % 4)));
+}
+
+void comps_sha256_final_hex(COMPS_SHA256 *ctx,
+                            char hex[COMPS_SHA256_HEXLEN + 1]) {
+    static const char digits[] = "0123456789abcdef";
+    unsigned char digest[COMPS_SHA256_LEN];
+    int i;
+
+    comps_sha256_final(ctx, digest);
+    for (i = 0; i < COMPS_SHA256_LEN; i++) {
+        hex[2 * i] = digits[digest[i] >> 4];
+        hex[2 * i + 1] = digits[digest[i] & 0xf];
+    }
+    hex[COMPS_SHA256_HEXLEN] = 0;
+}
@@ -0,0 +1,58 @@
+/* libcomps - C alternative to yum.comps library
+ * Copyright (C) 2013 Jindrich Luza
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to  Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA
+ */
+
+/*! \file comps_sha256.h
+ * \brief Incremental SHA-256 (FIPS 180-4).
+ * Data can be passed in chunks of any size, so checksum of stream is
+ * computed while the stream is written without storing it.
+ **/
+#ifndef COMPS_SHA256_H
+#define COMPS_SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** length of binary digest */
+#define COMPS_SHA256_LEN 32
+/** length of hexadecimal digest without terminating NUL */
+#define COMPS_SHA256_HEXLEN 64
+
+typedef struct {
+    uint32_t state[8];
+    uint64_t len; /**< number of bytes hashed so far */
+    unsigned char block[64]; /**< incomplete block */
+} COMPS_SHA256;
+
+/** Initialize context for new checksum */
+void comps_sha256_init(COMPS_SHA256 *ctx);
+
+/** Add len bytes of data to checksum */
+void comps_sha256_update(COMPS_SHA256 *ctx, const void *data, size_t len);
+
+/** Finish checksum and store it to digest, context must be initialized
+ * again before next use */
+void comps_sha256_final(COMPS_SHA256 *ctx,
+                        unsigned char digest[COMPS_SHA256_LEN]);
+
+/** Finish checksum and store it as lowercase hexadecimal NUL terminated
+ * string */
+void comps_sha256_final_hex(COMPS_SHA256 *ctx,
+                            char hex[COMPS_SHA256_HEXLEN + 1]);
+
+#endif
@@ -34,7 +34,9 @@ COMPS_XMLOptions COMPS_XMLDefaultOptions = {
     .default_explicit = false,
     .gid_default_explicit = false,
     .bao_explicit = false,
-    .arch_output = false
+    .arch_output = false,
+    .fragment_cache = false,
+    .nthreads = 0
 };
 
 
@@ -41,6 +41,12 @@ typedef struct COMPS_XMLOptions {
     bool gid_default_explicit;
     bool bao_explicit;
     bool arch_output;
+    bool fragment_cache; /* keep xml of groups, categories and environments
+                            in objects and reuse it in next output until
+                            object changes */
+    unsigned int nthreads; /* threads serializing groups, categories and
+                              environments, below 2 means calling thread
+                              only */
 } COMPS_XMLOptions;
 
 extern COMPS_XMLOptions COMPS_XMLDefaultOptions;
@@ -19,6 +19,8 @@
 
 #include "comps_utils.h"
 #include "comps_log.h"
+#include "comps_radix.h"
+#include "comps_scan.h"
 
 void* __comps_str_clone(void *str) {
     char *ret;
@@ -36,11 +38,72 @@ inline char __comps_strcmp(void *s1, void *s2) {
     return (strcmp((const char*)s1, (const char*)s2) == 0);
 }
 
+static const char* __comps_xml_text_escape(char ch) {
+    switch (ch) {
+        case '&': return "&amp;";
+        case '<': return "&lt;";
+        case '>': return "&gt;";
+        case '\r': return "&#13;";
+        default: return NULL;
+    }
+}
+
+int __comps_xml_text(xmlTextWriterPtr writer, const char *str) {
+    size_t len, span;
+    int ret, count = 0;
+
+    if (str == NULL)
+        return 0;
+    for (len = strlen(str); len; str += span + 1, len -= span + 1) {
+        span = comps_scan_xml_text(str, len);
+        if (span) {
+            ret = xmlTextWriterWriteRawLen(writer, BAD_CAST str, span);
+            if (ret < 0)
+                return -1;
+            count += ret;
+        }
+        if (span == len)
+            break;
+        if ((ret = xmlTextWriterWriteRaw(writer,
+                              BAD_CAST __comps_xml_text_escape(str[span]))) < 0)
+            return -1;
+        count += ret;
+    }
+    return count;
+}
+
+int __comps_xml_attr(xmlTextWriterPtr writer, const char *name,
+                     const char *value) {
+    size_t len = strlen(value);
+    int ret, count;
+
+    if (comps_scan_xml_attr(value, len) != len)
+        return xmlTextWriterWriteAttribute(writer, BAD_CAST name,
+                                           BAD_CAST value);
+    if ((count = xmlTextWriterStartAttribute(writer, BAD_CAST name)) < 0)
+        return -1;
+    if (len) {
+        if ((ret = xmlTextWriterWriteRawLen(writer, BAD_CAST value, len)) < 0)
+            return -1;
+        count += ret;
+    }
+    if ((ret = xmlTextWriterEndAttribute(writer)) < 0)
+        return -1;
+    return count + ret;
+}
+
+void __comps_xml_fragment_destroy(COMPS_XMLFragment *frag) {
+    if (frag == NULL)
+        return;
+    free(frag->xml);
+    free(frag);
+}
+
 inline int __comps_xml_prop(char *key, char *val,
                              xmlTextWriterPtr writer) {
     int retc;
     retc = xmlTextWriterStartElement(writer, BAD_CAST key) >= 0 ? 1 : 0;
-    retc &= xmlTextWriterWriteString(writer, BAD_CAST val) >= 0 ? 1 : 0;
+    retc &= __comps_xml_text(writer, val) >= 0 ? 1 : 0;
     retc &= xmlTextWriterEndElement(writer) >= 0 ? 1 : 0;
     return retc;
 }
@@ -83,6 +146,84 @@ bool __comps_objlist_intersected(COMPS_ObjList *list1, COMPS_ObjList *list2) {
     return false;
 }
 
+COMPS_ArchFilter* comps_archfilter_create(COMPS_ObjList **arches,
+                                          unsigned int count) {
+    COMPS_ArchFilter *filter;
+    COMPS_ObjListIt *it;
+    size_t nbits, bit;
+    unsigned int i;
+    char *name;
+
+    if ((filter = malloc(sizeof(*filter))) == NULL)
+        return NULL;
+    filter->arches = arches;
+    filter->count = count;
+    filter->bits = comps_rtree_create(NULL, NULL, NULL);
+    filter->masks = malloc(sizeof(*filter->masks) * (count + 1));
+    if (filter->bits == NULL || filter->masks == NULL) {
+        comps_archfilter_destroy(filter);
+        return NULL;
+    }
+    nbits = 0;
+    for (i = 0; i < count && filter->masks; i++) {
+        filter->masks[i] = 0;
+        for (it = arches[i] ? arches[i]->first : NULL; it; it = it->next) {
+            if (it->comps_obj->obj_info != &COMPS_Str_ObjInfo)
+                continue;
+            name = ((COMPS_Str*)it->comps_obj)->val;
+            bit = (size_t)comps_rtree_get(filter->bits, name);
+            if (bit == 0) {
+                if (nbits == sizeof(COMPS_ArchMask) * 8 || name[0] == 0) {
+                    free(filter->masks);
+                    filter->masks = NULL;
+                    break;
+                }
+                bit = ++nbits;
+                comps_rtree_set(filter->bits, name, (void*)bit);
+            }
+            filter->masks[i] |= (COMPS_ArchMask)1 << (bit - 1);
+        }
+    }
+    return filter;
+}
+
+void comps_archfilter_destroy(COMPS_ArchFilter *filter) {
+    if (filter == NULL)
+        return;
+    comps_rtree_destroy(filter->bits);
+    free(filter->masks);
+    free(filter);
+}
+
+void comps_archfilter_match(const COMPS_ArchFilter *filter,
+                            COMPS_ObjList *obj_arches, char *keep) {
+    COMPS_ObjListIt *it;
+    COMPS_ArchMask mask;
+    size_t bit;
+    unsigned int i;
+
+    if (obj_arches == NULL || filter->masks == NULL) {
+        for (i = 0; i < filter->count; i++) {
+            keep[i] = obj_arches == NULL
+                      || (filter->arches[i]
+                          && __comps_objlist_intersected(filter->arches[i],
+                                                         obj_arches));
+        }
+        return;
+    }
+    mask = 0;
+    for (it = obj_arches->first; it != NULL; it = it->next) {
+        if (it->comps_obj->obj_info != &COMPS_Str_ObjInfo)
+            continue;
+        bit = (size_t)comps_rtree_get(filter->bits,
+                                      ((COMPS_Str*)it->comps_obj)->val);
+        if (bit)
+            mask |= (COMPS_ArchMask)1 << (bit - 1);
+    }
+    for (i = 0; i < filter->count; i++)
+        keep[i] = (mask & filter->masks[i]) != 0;
+}
+
 char* __comps_xml_arch_str(COMPS_Object *archlist) {
     size_t x, total_len = 0;
     COMPS_ObjListIt *it;
@@ -116,8 +257,7 @@ char* __comps_xml_arch_str(COMPS_Object *archlist) {
 int __comps_xml_arch(COMPS_Object *archlist, xmlTextWriterPtr writer) {
     if (archlist && ((COMPS_ObjList*)archlist)->len != 0) {
         char * str = __comps_xml_arch_str(archlist);
-        int ret = xmlTextWriterWriteAttribute(writer, BAD_CAST "arch",
-                                              BAD_CAST str);
+        int ret = __comps_xml_attr(writer, "arch", str);
         free(str);
         return ret;
     } else return 0; 
@@ -144,3 +284,61 @@ inline int __comps_check_xml_get(int retcode, COMPS_Object * log) {
         return -1;
     } return 0;
 }
+
+char* __comps_obj_keystr(COMPS_Object *obj, char **tofree) {
+    *tofree = NULL;
+    if (obj == NULL)
+        return NULL;
+    if (obj->obj_info == &COMPS_Str_ObjInfo)
+        return ((COMPS_Str*)obj)->val;
+    return *tofree = comps_object_tostr(obj);
+}
+
+void __comps_objlist_unite_by(COMPS_ObjList *dst, COMPS_ObjList *src,
+                              COMPS_Object* (*key_f)(COMPS_Object*)) {
+    static char replaced;
+    COMPS_RTree *keys;
+    COMPS_ObjListIt *it, *last;
+    /* rtree can't hold empty key */
+    void *nokey = NULL, *emptykey = NULL, **special, *found;
+    char *key, *tofree;
+
+    if (dst == NULL || src == NULL)
+        return;
+    keys = comps_rtree_create(NULL, NULL, NULL);
+    for (it = dst->first; it != NULL; it = it->next) {
+        key = __comps_obj_keystr(key_f(it->comps_obj), &tofree);
+        special = (key == NULL) ? &nokey : (key[0] == 0 ? &emptykey : NULL);
+        if (special) {
+            if (*special == NULL)
+                *special = it;
+        } else if (comps_rtree_get(keys, key) == NULL) {
+            comps_rtree_set(keys, key, it);
+        }
+        free(tofree);
+    }
+    /* src may be dst itself, don't visit appended items */
+    last = dst->last;
+    for (it = src->first; it != NULL; it = it->next) {
+        key = __comps_obj_keystr(key_f(it->comps_obj), &tofree);
+        special = (key == NULL) ? &nokey : (key[0] == 0 ? &emptykey : NULL);
+        found = special ? *special : comps_rtree_get(keys, key);
+        if (found == NULL) {
+            comps_objlist_append(dst, it->comps_obj);
+        } else if (found != &replaced) {
+            COMPS_OBJECT_DESTROY(((COMPS_ObjListIt*)found)->comps_obj);
+            ((COMPS_ObjListIt*)found)->comps_obj =
+                                         comps_object_incref(it->comps_obj);
+            if (special)
+                *special = &replaced;
+            else
+                comps_rtree_set(keys, key, &replaced);
+        }
+        free(tofree);
+        if (it == last)
+            break;
+    }
+    /* items were replaced in place */
+    dst->version++;
+    comps_rtree_destroy(keys);
+}
@@ -23,9 +23,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "comps_obj.h"
 #include "comps_objlist.h"
+#include "comps_radix.h"
 #include "comps_set.h"
 
 #include <libxml/encoding.h>
@@ -182,12 +184,68 @@ char __comps_strcmp(void *s1, void *s2);
 char* __comps_strcpy(char *str);
 char* __comps_strcat(char *str1, char *str2);
 void* __comps_str_clone(void *str);
+/* Write element text escaped the same way as libxml2 saves text nodes, that
+ * is only &, <, > and CR are escaped. xmlTextWriterWriteString escapes also
+ * quotes and closes empty element by full end tag. Nothing is written for
+ * empty or NULL string
+ * @return number of written bytes or -1 on error */
+int __comps_xml_text(xmlTextWriterPtr writer, const char *str);
+/* Same output as xmlTextWriterWriteAttribute, values which need no
+ * escaping are written directly without libxml2 copying them
+ * @return number of written bytes or -1 on error */
+int __comps_xml_attr(xmlTextWriterPtr writer, const char *name,
+                     const char *value);
 int __comps_xml_prop(char *key, char *val, xmlTextWriterPtr writer);
+
+/* XML of group, category or environment kept from last output with
+ * fragment_cache option. It's reused while digest of the object and of
+ * output options stay the same */
+typedef struct {
+    char *xml;
+    size_t len;
+    COMPS_Digest digest; /* digest of object when rendered */
+    COMPS_Digest options; /* digest of xml and default options */
+} COMPS_XMLFragment;
+
+void __comps_xml_fragment_destroy(COMPS_XMLFragment *frag);
 char* __comps_num2boolstr(COMPS_Object* obj);
 unsigned int digits_count(unsigned int x);
 bool __comps_objlist_intersected(COMPS_ObjList *list1, COMPS_ObjList *list2);
+
+typedef uint64_t COMPS_ArchMask;
+
+/* Arch lists of arch filter. Arch names of all lists are interned in
+ * registry giving every distinct name one bit, so object arches are tested
+ * against all lists by one lookup per object arch and bitwise and per list
+ * instead of comparing every pair of strings. With more than 64 distinct
+ * names filter falls back to __comps_objlist_intersected() */
+typedef struct {
+    COMPS_ObjList **arches;
+    COMPS_ArchMask *masks; /* mask of every list, NULL on fallback */
+    unsigned int count;
+    COMPS_RTree *bits; /* arch name -> its bit number + 1 */
+} COMPS_ArchFilter;
+
+COMPS_ArchFilter* comps_archfilter_create(COMPS_ObjList **arches,
+                                          unsigned int count);
+void comps_archfilter_destroy(COMPS_ArchFilter *filter);
+/* set keep[i] to whether object with obj_arches passes i-th arch list. NULL
+ * obj_arches passes all, empty obj_arches none */
+void comps_archfilter_match(const COMPS_ArchFilter *filter,
+                            COMPS_ObjList *obj_arches, char *keep);
 char* __comps_xml_arch_str(COMPS_Object *arches);
 int __comps_xml_arch(COMPS_Object *archlist, xmlTextWriterPtr writer);
 
 int __comps_check_xml_get(int retcode, COMPS_Object * log);
+
+/* key string of object used for id/name joins. Returns NULL for NULL object,
+ * non-string objects are converted and result is stored also in *tofree */
+char* __comps_obj_keystr(COMPS_Object *obj, char **tofree);
+
+/* merge src into dst in place the way object union functions merge lists:
+ * first dst item with key of src item is replaced by reference to src item
+ * (once, further src items with that key are dropped), other src items are
+ * appended by reference */
+void __comps_objlist_unite_by(COMPS_ObjList *dst, COMPS_ObjList *src,
+                              COMPS_Object* (*key_f)(COMPS_Object*));
 #endif
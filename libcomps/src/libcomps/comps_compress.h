@@ -0,0 +1,86 @@
+/* libcomps - C alternative to yum.comps library
+ * Copyright (C) 2013 Jindrich Luza
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to  Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA
+ */
+
+/*! \file comps_compress.h
+ * \brief Streaming compression of generated output.
+ * Compressor accepts data in chunks and passes compressed chunks to write
+ * callback as soon as compression library produces them, so neither
+ * uncompressed nor compressed stream is ever held in memory as whole.
+ * gzip is always available, xz and zstd only if libcomps was built with
+ * liblzma or libzstd, see comps_compress_supported().
+ **/
+#ifndef COMPS_COMPRESS_H
+#define COMPS_COMPRESS_H
+
+#include <stddef.h>
+
+/** Compression format */
+typedef enum {
+    COMPS_COMPRESS_NONE,
+    COMPS_COMPRESS_GZIP,
+    COMPS_COMPRESS_XZ,
+    COMPS_COMPRESS_ZSTD
+} COMPS_CompressType;
+
+/** Callback receiving compressed data
+ * @param ctx context passed to comps_compressor_create()
+ * @param buffer chunk of compressed data
+ * @param len length of chunk
+ * @return len on success, -1 on error
+ */
+typedef int (*COMPS_CompressWriteCallback)(void *ctx, const char *buffer,
+                                           int len);
+
+typedef struct COMPS_Compressor COMPS_Compressor;
+
+/** Return non-zero if libcomps was built with support of compression type
+ */
+int comps_compress_supported(COMPS_CompressType type);
+
+/** Return usual file name suffix of compression type (".gz", ".xz",
+ * ".zst"), empty string for COMPS_COMPRESS_NONE
+ */
+const char* comps_compress_suffix(COMPS_CompressType type);
+
+/** Create compressor
+ * @param type compression format, COMPS_COMPRESS_NONE passes data through
+ * @param level compression level of the format, 0 for format default
+ * @param write_cb callback receiving compressed data
+ * @param ctx context passed to write_cb
+ * @return new compressor or NULL if type isn't supported or allocation fails
+ */
+COMPS_Compressor* comps_compressor_create(COMPS_CompressType type, int level,
+                                          COMPS_CompressWriteCallback write_cb,
+                                          void *ctx);
+
+/** Compress len bytes of data
+ * @return 0 on success, -1 if compression or write callback fails
+ */
+int comps_compressor_write(COMPS_Compressor *comp, const char *data,
+                           size_t len);
+
+/** Flush remaining data and write end of compressed stream
+ * @return 0 on success, -1 if compression or write callback fails
+ */
+int comps_compressor_finish(COMPS_Compressor *comp);
+
+/** Destroy compressor, unfinished stream is discarded */
+void comps_compressor_destroy(COMPS_Compressor *comp);
+
+#endif
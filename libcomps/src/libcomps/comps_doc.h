@@ -0,0 +1,729 @@
+/* libcomps - C alternative to yum.comps library
+ * Copyright (C) 2013 Jindrich Luza
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to  Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA
+ */
+
+#ifndef COMPS_DOC_H
+#define COMPS_DOC_H
+
+#include "comps_obj.h"
+#include "comps_objdict.h"
+#include "comps_objlist.h"
+#include "comps_log.h"
+#include "comps_types.h"
+#include "comps_docgroup.h"
+#include "comps_doccategory.h"
+#include "comps_docenv.h"
+#include "comps_validate.h"
+#include "comps_default.h"
+#include "comps_compress.h"
+#include "comps_sha256.h"
+
+/** \file comps_doc.h
+ * \brief COMPS_Doc header file
+ *
+ * COMPS_Doc object support union operation. Read more about
+ * @link doc_unioning Libcomps objects unioning
+ * @endlink
+ * @see COMPS_Doc_getters @see COMPS_Doc_setters @see COMPS_Doc_adders
+ */
+
+/** @cond NOTMET */
+#define COMPS_DOC_GETOBJLIST(OBJS) COMPS_ObjList* CONCAT(comps_doc_, OBJS)\
+                                                           (COMPS_Doc *doc){\
+    COMPS_ObjList *ret;\
+    ret = (COMPS_ObjList*)comps_objdict_get(doc->objects, #OBJS);\
+    if (!ret) {\
+        ret = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);\
+        comps_objdict_set_x(doc->objects, #OBJS, (COMPS_Object*)ret);\
+        ret = (COMPS_ObjList*)comps_object_incref((COMPS_Object*)ret);\
+    }\
+    return ret;\
+}
+/** <@hideinititalizer */
+
+#define HEAD_COMPS_DOC_GETOBJLIST(OBJS) COMPS_ObjList* CONCAT(comps_doc_, OBJS)\
+                                                           (COMPS_Doc *doc);
+/** <@hideinititalizer */
+
+#define COMPS_DOC_SETOBJLIST(OBJS) void CONCAT(comps_doc_set_, OBJS)\
+                                                       (COMPS_Doc *doc,\
+                                                        COMPS_ObjList *list){\
+    comps_objdict_set(doc->objects, #OBJS, (COMPS_Object*)list);\
+}
+/** <@hideinititalizer */
+#define HEAD_COMPS_DOC_SETOBJLIST(OBJS) void CONCAT(comps_doc_set_, OBJS)\
+                                                   (COMPS_Doc *doc,\
+                                                    COMPS_ObjList *list);
+/** <@hideinititalizer */
+
+#define COMPS_DOC_GETOBJDICT(OBJNAME) COMPS_ObjDict* CONCAT(comps_doc_, OBJNAME)\
+                                                           (COMPS_Doc *doc){\
+    COMPS_ObjDict *ret;\
+    ret = (COMPS_ObjDict*)comps_objdict_get(doc->objects, #OBJNAME);\
+    if (!ret) {\
+        ret = COMPS_OBJECT_CREATE(COMPS_ObjDict, NULL);\
+        comps_objdict_set_x(doc->objects, #OBJNAME, (COMPS_Object*)ret);\
+        ret = (COMPS_ObjDict*)comps_object_incref((COMPS_Object*)ret);\
+    }\
+    return ret;\
+}
+/** <@hideinititalizer */
+#define HEAD_COMPS_DOC_GETOBJDICT(OBJNAME) COMPS_ObjDict* CONCAT(comps_doc_, OBJNAME)\
+                                                           (COMPS_Doc *doc);
+/** <@hideinititalizer */
+
+#define COMPS_DOC_GETOBJMDICT(OBJNAME) COMPS_ObjMDict* CONCAT(comps_doc_, OBJNAME)\
+                                                           (COMPS_Doc *doc){\
+    COMPS_ObjMDict *ret;\
+    ret = (COMPS_ObjMDict*)comps_objdict_get(doc->objects, #OBJNAME);\
+    if (!ret) {\
+        ret = COMPS_OBJECT_CREATE(COMPS_ObjMDict, NULL);\
+        comps_objdict_set_x(doc->objects, #OBJNAME, (COMPS_Object*)ret);\
+        ret = (COMPS_ObjMDict*)comps_object_incref((COMPS_Object*)ret);\
+    }\
+    return ret;\
+}
+/** <@hideinititalizer */
+#define HEAD_COMPS_DOC_GETOBJMDICT(OBJNAME) COMPS_ObjMDict* CONCAT(comps_doc_, OBJNAME)\
+                                                           (COMPS_Doc *doc);
+/** <@hideinititalizer */
+
+#define COMPS_DOC_SETOBJDICT(OBJS) void CONCAT(comps_doc_set_, OBJS)\
+                                                       (COMPS_Doc *doc,\
+                                                        COMPS_ObjDict *dict){\
+    comps_objdict_set(doc->objects, #OBJS, (COMPS_Object*)dict);\
+}
+/** <@hideinititalizer */
+#define HEAD_COMPS_DOC_SETOBJDICT(OBJS) void CONCAT(comps_doc_set_, OBJS)\
+                                                   (COMPS_Doc *doc,\
+                                                    COMPS_ObjDict *dict);
+/** <@hideinititalizer */
+
+#define COMPS_DOC_SETOBJMDICT(OBJS) void CONCAT(comps_doc_set_, OBJS)\
+                                                       (COMPS_Doc *doc,\
+                                                        COMPS_ObjMDict *dict){\
+    comps_objdict_set(doc->objects, #OBJS, (COMPS_Object*)dict);\
+}
+/** <@hideinititalizer */
+#define HEAD_COMPS_DOC_SETOBJMDICT(OBJS) void CONCAT(comps_doc_set_, OBJS)\
+                                                   (COMPS_Doc *doc,\
+                                                    COMPS_ObjMDict *dict);
+/** <@hideinititalizer */
+
+
+#define COMPS_DOC_ADDOBJLIST(OBJS, OBJNAME, OBJTYPE) void CONCAT(comps_doc_add_,\
+                                                           OBJNAME)\
+                                                           (COMPS_Doc *doc,\
+                                                            OBJTYPE *obj){\
+    COMPS_ObjList *ret;\
+    ret = (COMPS_ObjList*)comps_objdict_get(doc->objects, #OBJS);\
+    if (!ret) {\
+        ret = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);\
+        comps_objdict_set(doc->objects, #OBJS, (COMPS_Object*)ret);\
+    } else {\
+    }\
+    comps_objlist_append_x(ret, (COMPS_Object*)obj);\
+    COMPS_OBJECT_DESTROY(ret);\
+}
+/** <@hideinititalizer */
+#define HEAD_COMPS_DOC_ADDOBJLIST(OBJNAME, OBJTYPE) void CONCAT(comps_doc_add_,\
+                                                           OBJNAME)\
+                                                           (COMPS_Doc *doc,\
+                                                            OBJTYPE *obj);
+/** <@hideinititalizer */
+
+#define COMPS_DOC_ADDOBJDICT(OBJS, OBJNAME) void CONCAT(comps_doc_add_,\
+                                                           OBJNAME)\
+                                                           (COMPS_Doc *doc,\
+                                                            char *key,\
+                                                            COMPS_Str *obj){\
+    COMPS_ObjDict *ret;\
+    ret = (COMPS_ObjDict*)comps_objdict_get(doc->objects, #OBJS);\
+    if (!ret) {\
+        ret = COMPS_OBJECT_CREATE(COMPS_ObjDict, NULL);\
+        comps_objdict_set(doc->objects, #OBJS, (COMPS_Object*)ret);\
+    }\
+    comps_objdict_set_x(ret, key, (COMPS_Object*)obj);\
+    COMPS_OBJECT_DESTROY(ret);\
+}
+/** <@hideinititalizer */
+#define HEAD_COMPS_DOC_ADDOBJDICT(OBJNAME) void CONCAT(comps_doc_add_,\
+                                                           OBJNAME)\
+                                                           (COMPS_Doc *doc,\
+                                                            char *key,\
+                                                            COMPS_Str *obj);
+/** <@hideinititalizer */
+
+
+#define COMPS_DOC_ADDOBJMDICT(OBJS, OBJNAME) void CONCAT(comps_doc_add_,\
+                                                           OBJNAME)\
+                                                           (COMPS_Doc *doc,\
+                                                            char *key,\
+                                                            COMPS_Str *obj){\
+    COMPS_ObjMDict *ret;\
+    ret = (COMPS_ObjMDict*)comps_objdict_get(doc->objects, #OBJS);\
+    if (!ret) {\
+        ret = COMPS_OBJECT_CREATE(COMPS_ObjMDict, NULL);\
+        comps_objdict_set(doc->objects, #OBJS, (COMPS_Object*)ret);\
+    }\
+    comps_objmdict_set_x(ret, key, (COMPS_Object*)obj);\
+    COMPS_OBJECT_DESTROY(ret);\
+}
+/** <@hideinititalizer */
+#define HEAD_COMPS_DOC_ADDOBJMDICT(OBJNAME) void CONCAT(comps_doc_add_,\
+                                                           OBJNAME)\
+                                                           (COMPS_Doc *doc,\
+                                                            char *key,\
+                                                            COMPS_Str *obj);
+/** <@hideinititalizer */
+
+#define COMPS_DOC_GETPROP(OBJ,TYPE) CONCAT(TYPE,CONCAT(* ,CONCAT(comps_doc_, OBJ)))\
+                                                           (COMPS_Doc *doc){\
+    TYPE *ret;\
+    ret = (COMPS_Str*)comps_objdict_get(doc->objects, #OBJ);\
+    if (!ret) {\
+        ret = COMPS_OBJECT_CREATE(TYPE, NULL);\
+        comps_objdict_set_x(doc->objects, #OBJ, (COMPS_Object*)ret);\
+        ret = (TYPE*)comps_object_incref((COMPS_Object*)ret);\
+    }\
+    return ret;\
+}
+/** <@hideinititalizer */
+
+#define HEAD_COMPS_DOC_GETPROP(OBJ, TYPE) CONCAT(TYPE,CONCAT(*,CONCAT(comps_doc_, OBJS)))\
+                                                           (COMPS_Doc *doc);
+/** <@hideinititalizer */
+
+
+#define COMPS_DOC_SETPROP(OBJ, TYPE) void CONCAT(comps_doc_set_, OBJ)\
+                                                       (COMPS_Doc *doc,\
+                                                        TYPE *value){\
+    comps_objdict_set(doc->objects, #OBJ, (COMPS_Object*)value);\
+}
+
+/** <@hideinititalizer */
+
+
+#define HEAD_COMPS_DOC_SETPROP(OBJ, TYPE) void CONCAT(comps_doc_set_, OBJ)\
+                                                   (COMPS_Doc *doc,\
+                                                    TYPE *value);
+
+/** <@hideinititalizer */
+/** @endcond*/
+
+typedef struct COMPS_DocIndex COMPS_DocIndex;
+
+/** COMPS_Object derivate containing whole comps.xml document.
+ */
+typedef struct {
+    COMPS_Object_HEAD;
+    COMPS_ObjDict *objects; /**< dictionary of comps subobjects */
+    COMPS_Log *log;
+    /**< COMPS_Log object to store log messages evoked
+     * by parsing and xml generating */
+    COMPS_Str *encoding;   /**< comps.xml document encoding */
+    COMPS_Str *doctype_name;
+    COMPS_Str *doctype_sysid;
+    COMPS_Str *doctype_pubid;
+    COMPS_Str *lang;
+    COMPS_DocIndex *index; /**< reverse index, see comps_docindex.h */
+    } COMPS_Doc;
+COMPS_Object_TAIL(COMPS_Doc);
+
+/** Options of comps_doc_union_ex() */
+typedef struct {
+    unsigned int nthreads; /**< number of threads merging objects, values
+                                below 2 merge in calling thread only */
+} COMPS_DocUnionOptions;
+
+//HEAD_COMPS_CREATE_u(doc, COMPS_Doc)  /*comps_utils.h macro*/
+//HEAD_COMPS_COPY_u(doc, COMPS_Doc)  /*comps_utils.h macro*/
+//HEAD_COMPS_DESTROY_u(doc, COMPS_Doc)  /*comps_utils.h macro*/
+
+/** constructor callback for COMPS_Doc object. COMPS_Doc is COMPS_Object
+ * derivate. Use comps_object_create() or COMPS_OBJECT_CREATE for construction
+ * instead
+ *
+ * @param doc allocated COMPS_Doc object
+ * @param args array of constructor arguments. COMPS_Doc constructor accepts
+ * encoding argument as COMPS_Str object only so array need not end with
+ * sentinel item*/
+void comps_doc_create(COMPS_Doc* doc, COMPS_Object **args);
+
+/** copy callback for COMPS_Doc object*/
+void comps_doc_copy(COMPS_Doc *doc_dst, COMPS_Doc *doc_src);
+
+/** destructor callback for COMPS_Doc object. COMPS_Doc is COMPS_Object
+ * derivate. Use comps_object_create() for construction instead*/
+void comps_doc_destroy(COMPS_Doc *doc);
+
+/** comparator callback for COMPS_Doc object */
+signed char comps_doc_cmp_u(COMPS_Object *obj1, COMPS_Object *obj2);
+
+/** Return content digest of document
+ *
+ * Digest is hash tree over document: every group, category, environment,
+ * package and group id is digested separately and their digests are
+ * combined into section digests and those into root digest. Documents with
+ * different digests differ, documents with equal digest serialize to the
+ * same XML up to collisions of 64-bit hash, so digests of two documents can
+ * be compared instead of documents themselves. Missing and empty sections
+ * are equivalent. Digests of property and translation dictionaries are
+ * cached and invalidated by their modification. Packages and group ids are
+ * modified in place without any notification, so they are digested again on
+ * every call. Strings changed in place by comps_str_set() aren't noticed by
+ * cached dictionary digests.
+ * @param doc COMPS_Doc object
+ * @return digest of document content
+ * @see comps_object_digest
+ */
+COMPS_Digest comps_doc_digest(COMPS_Doc *doc);
+
+/** \defgroup COMPS_Doc_getters COMPS_Doc getters
+ * @{
+ */
+
+/** comps group list getter
+ * @param doc COMPS_Doc instance
+ * @return COMPS_ObjList object of COMPS_DocGroup*/
+HEAD_COMPS_DOC_GETOBJLIST(groups) /*comps_doc.h macro*/
+
+/** comps category list getter
+ * @param doc COMPS_Doc instance
+ * @return COMPS_ObjList object of COMPS_DocCategory*/
+HEAD_COMPS_DOC_GETOBJLIST(categories) /*comps_doc.h macro*/
+
+/** comps environment list getter
+ * @param doc COMPS_Doc instance
+ * @return COMPS_ObjList object of COMPS_DocEnv*/
+HEAD_COMPS_DOC_GETOBJLIST(environments) /*comps_doc.h macro*/
+
+/** comps langpack dictionary getter
+ * @param doc COMPS_Doc instance
+ * @return COMPS_ObjDict object of COMPS_Str*/
+HEAD_COMPS_DOC_GETOBJDICT(langpacks) /*comps_doc.h macro*/
+
+/** comps blacklist dictionary getter
+ * @param doc COMPS_Doc instance
+ * @return COMPS_ObjMDict object of COMPS_Str*/
+HEAD_COMPS_DOC_GETOBJMDICT(blacklist) /*comps_doc.h macro*/
+
+/** comps whiteout dictionary getter
+ * @param doc COMPS_Doc instance
+ * @return COMPS_ObjMDict object of COMPS_Str*/
+HEAD_COMPS_DOC_GETOBJMDICT(whiteout) /*comps_doc.h macro*/
+
+/**@}*/
+
+/** \defgroup COMPS_Doc_setters COMPS_Doc setters
+ * @{
+ */
+
+/** comps group list setter
+ * @param doc COMPS_Doc instance
+ * @param list COMPS_ObjList of COMPS_DocGroup items
+ * \warning make sure of correct items type. Setter doesn't provide any
+ * additional control routines
+ */
+HEAD_COMPS_DOC_SETOBJLIST(groups) /*comps_doc.h macro*/
+
+/** comps category list setter
+ * @param doc COMPS_Doc instance
+ * @param list COMPS_ObjList of COMPS_DocCategory items
+ * \warning make sure of correct items type. Setter doesn't provide any
+ * additional control routines
+ */
+HEAD_COMPS_DOC_SETOBJLIST(categories) /*comps_doc.h macro*/
+
+/** comps environments list setter
+ * @param doc COMPS_Doc instance
+ * @param list COMPS_ObjList of COMPS_DocEnv items
+ * \warning make sure of correct items type. Setter doesn't provide any
+ * additional control routines
+ */
+HEAD_COMPS_DOC_SETOBJLIST(environments) /*comps_doc.h macro*/
+
+/** comps lankpack dict setter
+ * @param doc COMPS_Doc instance
+ * @param dict COMPS_ObjDict of COMPS_Str items
+ * \warning make sure of correct items type. Setter doesn't provide any
+ * additional control routines
+ */
+HEAD_COMPS_DOC_SETOBJDICT(langpacks) /*comps_doc.h macro*/
+
+/** comps blacklist multi-dict setter
+ * @param doc COMPS_Doc instance
+ * @param dict COMPS_ObjMDict of COMPS_Str items
+ * \warning make sure of correct items type. Setter doesn't provide any
+ * additional control routines
+ */
+HEAD_COMPS_DOC_SETOBJMDICT(blacklist) /*comps_doc.h macro*/
+
+/** comps whiteout multi-dict setter
+ * @param doc COMPS_Doc instance
+ * @param dict COMPS_ObjMDict of COMPS_Str items
+ * \warning make sure of correct items type. Setter doesn't provide any
+ * additional control routines
+ */
+HEAD_COMPS_DOC_SETOBJMDICT(whiteout) /*comps_doc.h macro*/
+
+/**@}*/
+
+/** \defgroup COMPS_Doc_adders COMPS_Doc adders
+ * @{
+ */
+
+/** COMPS_DocGroup adder to group list in COMPS_Doc
+ * @param doc COMPS_Doc instance
+ * @param obj COMPS_DocGroup object
+ * append COMPS_DocGroup object to group list in COMPS_Doc structure
+ * \warning function doesn't increment COMPS_DocGroup object reference count.
+ */
+HEAD_COMPS_DOC_ADDOBJLIST(group, COMPS_DocGroup) /*comps_doc.h macro*/
+
+/** COMPS_DocCategory adder to category list in COMPS_Doc
+ * @param doc COMPS_Doc instance
+ * @param obj COMPS_DocCategory object
+ * append COMPS_DocCategory object to category list in COMPS_Doc structure
+ * \warning function doesn't increment COMPS_DocCategory object reference count.
+ */
+HEAD_COMPS_DOC_ADDOBJLIST(category, COMPS_DocCategory) /*comps_doc.h macro*/
+
+/** COMPS_DocEnv adder to environment list in COMPS_Doc
+ * @param doc COMPS_Doc instance
+ * @param obj COMPS_DocEnv object
+ * append COMPS_DocEnv object to environment list in COMPS_Doc structure
+ * \warning function doesn't increment COMPS_DocEnv object reference count.
+ */
+HEAD_COMPS_DOC_ADDOBJLIST(environment, COMPS_DocEnv) /*comps_doc.h macro*/
+
+/** Langpack adder to langpack dict in COMPS_Doc
+ * @param doc COMPS_Doc instance
+ * @param key COMPS_Str dictionary key of langpack
+ * @param obj COMPS_Str langpack
+ * add langpack string to langpack dict in COMPS_Doc structure. If There's
+ * allready langpack string with same key, will be overwritten.
+ * \warning function doesn't increment obj param reference count.
+ */
+HEAD_COMPS_DOC_ADDOBJDICT(langpack) /*comps_doc.h macro*/
+
+/** Blacklist adder to blacklist multi-dict in COMPS_Doc
+ * @param doc COMPS_Doc instance
+ * @param key COMPS_Str dictionary key of blacklist
+ * @param obj COMPS_Str blacklist item
+ * append blacklist item object to blacklist in COMPS_Doc structure. Items 
+ * with same key are grouped in COMPS_ObjList object.
+ * \warning function doesn't increment obj param reference count.
+ */
+HEAD_COMPS_DOC_ADDOBJMDICT(blacklist) /*comps_doc.h macro*/
+
+/** whiteout adder to whitetout multi-dict in COMPS_Doc
+ * @param doc COMPS_Doc instance
+ * @param key COMPS_Str dictionary key of whiteout
+ * @param obj COMPS_Str whiteout item
+ * append whiteout item object to blacklist in COMPS_Doc structure. Items 
+ * with same key are grouped in COMPS_ObjList object.
+ * \warning function doesn't increment obj param reference count.
+ */
+HEAD_COMPS_DOC_ADDOBJMDICT(whiteout) /*comps_doc.h macro*/
+
+
+
+/** whiteout adder to whitetout multi-dict in COMPS_Doc
+ * @param doc COMPS_Doc instance
+ * @param obj COMPS_Str language value
+ * Set language to comps object and all subobjects
+ */
+
+HEAD_COMPS_DOC_SETPROP(lang, COMPS_Str) /*comps_doc.h macro*/
+
+/**@}*/
+
+/** \defgroup COMPS_Doc_filters COMPS_Doc filters
+ * @{
+ */
+
+/** Return groups, categories or environments matching fnmatch patterns
+ * Patterns are compiled to COMPS_DocQuery for single use, see
+ * comps_doc_query_create() from comps_docindex.h. Compile query once
+ * when matching the same patterns repeatedly.
+ */
+COMPS_ObjList* comps_doc_get_groups(COMPS_Doc *doc, char *id, char *name,
+                                    char *desc, char *lang, int flags);
+COMPS_ObjList* comps_doc_get_categories(COMPS_Doc *doc, char *id, char *name,
+                                        char *desc, char *lang, int flags);
+COMPS_ObjList* comps_doc_get_envs(COMPS_Doc *doc, char *id, char *name,
+                                  char *desc, char *lang, int flags);
+
+/** Return group with specified id
+ * Groups are looked up through id index of groups list, which is built on
+ * first lookup and rebuilt after list changes, so repeated lookups don't
+ * walk whole list. When more groups have the same id, first one is returned.
+ * @param doc COMPS_Doc object
+ * @param id group id
+ * @return COMPS_DocGroup with incremented reference counter or NULL
+ */
+COMPS_DocGroup* comps_doc_group_by_id(COMPS_Doc *doc, const char *id);
+
+/** Return category with specified id
+ * Same as comps_doc_group_by_id() for categories
+ */
+COMPS_DocCategory* comps_doc_category_by_id(COMPS_Doc *doc, const char *id);
+
+/** Return environment with specified id
+ * Same as comps_doc_group_by_id() for environments
+ */
+COMPS_DocEnv* comps_doc_env_by_id(COMPS_Doc *doc, const char *id);
+
+/**@}*/
+
+//char* comps_doc_xml_str(COMPS_Doc* doc, char *enc, COMPS_Log *log);
+
+
+//static signed char comps_doc_xml(COMPS_Doc *doc, xmlTextWriterPtr writer);
+
+/** Write XML representation to file
+ * @param doc COMPS_Doc object
+ * @param filename filename where to write
+ * @param stdoutredirect in non-zero all warning and error messages will
+ * be redirected to stdout, otherwise will be stored in doc->log only
+ * @return 0 if there wasn't any errors, 1 if there was non-fatal errors
+ * -1 if fatal error emerge during xml generation
+ */
+signed char comps2xml_f(COMPS_Doc * doc, char *filename, char stdoutredirect,
+                        COMPS_XMLOptions *xml_options,
+                        COMPS_DefaultsOptions *def_options);
+
+/** Generate XML string representating COMPS_Doc structure
+ *
+ * XML is written straight into returned string.
+ * @param doc COMPS_Doc object
+ * @return XML string or NULL if fatal error emerge during xml generation
+ */
+char* comps2xml_str(COMPS_Doc *doc, COMPS_XMLOptions *options,
+                    COMPS_DefaultsOptions *def_options);
+
+/** Callback receiving generated XML, same as libxml2 xmlOutputWriteCallback
+ * @param ctx context passed to comps2xml_cb()
+ * @param buffer next chunk of XML, not NUL terminated
+ * @param len length of chunk
+ * @return len on success, -1 on error which aborts xml generation
+ */
+typedef int (*COMPS_XMLWriteCallback)(void *ctx, const char *buffer, int len);
+
+/** Write XML representation to file descriptor
+ *
+ * XML is streamed in chunks as it's generated, descriptor isn't closed.
+ * @param doc COMPS_Doc object
+ * @param fd open file descriptor
+ * @return same as comps2xml_f(), -1 also when write to fd fails
+ */
+signed char comps2xml_fd(COMPS_Doc *doc, int fd,
+                         COMPS_XMLOptions *xml_options,
+                         COMPS_DefaultsOptions *def_options);
+
+/** Pass XML representation to callback in chunks as it's generated
+ * @param doc COMPS_Doc object
+ * @param write_cb callback called for every chunk of output
+ * @param ctx context passed to write_cb
+ * @return same as comps2xml_f(), -1 also when write_cb fails
+ */
+signed char comps2xml_cb(COMPS_Doc *doc, COMPS_XMLWriteCallback write_cb,
+                         void *ctx, COMPS_XMLOptions *xml_options,
+                         COMPS_DefaultsOptions *def_options);
+
+/** Selection of objects written by comps2xml_selected_cb() and friends.
+ * Items of lists are either objects themselves (COMPS_DocGroup,
+ * COMPS_DocCategory or COMPS_DocEnv respectively), for example result of
+ * comps_doc_query_groups(), or COMPS_Str ids of objects in doc, which are
+ * looked up through id index. Ids not found in doc and objects of other
+ * types are skipped. Objects are written in order of lists, NULL list
+ * selects nothing. Objects aren't copied and don't need to belong to doc.
+ */
+typedef struct {
+    COMPS_ObjList *groups; /**< groups or group ids */
+    COMPS_ObjList *categories; /**< categories or category ids */
+    COMPS_ObjList *envs; /**< environments or environment ids */
+    char doc_lists; /**< write langpacks, blacklist and whiteout of doc too
+                         if non-zero */
+} COMPS_XMLSelection;
+
+/** Pass XML document containing only selected objects to callback
+ *
+ * Output is complete comps document, the same as comps2xml_cb() would
+ * produce for doc containing only selected objects, without building
+ * such doc.
+ * @param doc COMPS_Doc object providing doctype, encoding, log and objects
+ * referenced by id
+ * @param selection objects to write
+ * @param write_cb callback called for every chunk of output
+ * @param ctx context passed to write_cb
+ * @return same as comps2xml_cb()
+ */
+signed char comps2xml_selected_cb(COMPS_Doc *doc,
+                                  const COMPS_XMLSelection *selection,
+                                  COMPS_XMLWriteCallback write_cb, void *ctx,
+                                  COMPS_XMLOptions *xml_options,
+                                  COMPS_DefaultsOptions *def_options);
+
+/** Write XML document containing only selected objects to file
+ * @see comps2xml_selected_cb()
+ * @return same as comps2xml_f()
+ */
+signed char comps2xml_selected_f(COMPS_Doc *doc, char *filename,
+                                 const COMPS_XMLSelection *selection,
+                                 COMPS_XMLOptions *xml_options,
+                                 COMPS_DefaultsOptions *def_options);
+
+/** Return XML document containing only selected objects as string
+ * @see comps2xml_selected_cb()
+ * @return same as comps2xml_str()
+ */
+char* comps2xml_selected_str(COMPS_Doc *doc,
+                             const COMPS_XMLSelection *selection,
+                             COMPS_XMLOptions *xml_options,
+                             COMPS_DefaultsOptions *def_options);
+
+/** Options and results of compressed XML output.
+ * type, level and checksums are set by caller, the rest is filled by
+ * comps2xml_compressed_cb() so the values needed by repomd.xml are known
+ * without reading written file again.
+ */
+typedef struct {
+    COMPS_CompressType type; /**< compression format */
+    int level; /**< compression level, 0 for format default */
+    char checksums; /**< compute sha256 of both streams if non-zero */
+
+    size_t open_size; /**< size of uncompressed XML */
+    size_t size; /**< size of compressed XML */
+    char open_sha256[COMPS_SHA256_HEXLEN + 1]; /**< sha256 of uncompressed
+                                                    XML or empty string */
+    char sha256[COMPS_SHA256_HEXLEN + 1]; /**< sha256 of compressed XML or
+                                               empty string */
+} COMPS_XMLCompressOptions;
+
+/** Pass compressed XML representation to callback in chunks
+ *
+ * XML is compressed while it's generated.
+ * @param doc COMPS_Doc object
+ * @param comp_options compression options, filled with sizes and checksums
+ * @param write_cb callback called for every chunk of compressed output
+ * @param ctx context passed to write_cb
+ * @return same as comps2xml_cb(), -1 also when compression type isn't
+ * supported or compression fails
+ */
+signed char comps2xml_compressed_cb(COMPS_Doc *doc,
+                                    COMPS_XMLCompressOptions *comp_options,
+                                    COMPS_XMLWriteCallback write_cb,
+                                    void *ctx,
+                                    COMPS_XMLOptions *xml_options,
+                                    COMPS_DefaultsOptions *def_options);
+
+/** Write compressed XML representation to file
+ * @param doc COMPS_Doc object
+ * @param filename filename where to write, compression suffix isn't
+ * appended automatically, see comps_compress_suffix()
+ * @param comp_options compression options, filled with sizes and checksums
+ * @return same as comps2xml_compressed_cb()
+ */
+signed char comps2xml_compressed_f(COMPS_Doc *doc, char *filename,
+                                   COMPS_XMLCompressOptions *comp_options,
+                                   COMPS_XMLOptions *xml_options,
+                                   COMPS_DefaultsOptions *def_options);
+
+/** Union two COMPS_Doc structures
+ * COMPS_Doc structures are unioned as unioning it's subparts
+ * (group, categories, environments). Object with same 'id' attribute
+ * are regarded as equal and unioned by with each other
+ *
+ * @param c1 COMPS_Doc object
+ * @param c2 COMPS_Doc object
+ */
+COMPS_Doc* comps_doc_union(COMPS_Doc *c1, COMPS_Doc *c2);
+
+/** Union any number of COMPS_Doc structures at once
+ * Result is the same as folding comps_doc_union over docs from left to
+ * right, but inputs are walked only once and objects are copied to result
+ * just once instead of once per intermediate document. With single document
+ * result is its copy with objects of duplicate 'id' dropped.
+ *
+ * @param docs array of COMPS_Doc objects
+ * @param n number of documents in docs
+ * @return new COMPS_Doc object or NULL if n is 0
+ */
+COMPS_Doc* comps_doc_union_many(COMPS_Doc **docs, size_t n);
+
+/** Union two COMPS_Doc structures with options
+ * Result is the same as of comps_doc_union(). With options->nthreads above 1
+ * groups, categories and environments of same 'id' are merged concurrently
+ * by pool of threads, order of objects in result doesn't depend on number
+ * of threads. Inputs are only read, but they must not be modified by other
+ * threads meanwhile.
+ *
+ * @param c1 COMPS_Doc object
+ * @param c2 COMPS_Doc object
+ * @param options union options, NULL for defaults
+ * @return new COMPS_Doc object
+ */
+COMPS_Doc* comps_doc_union_ex(COMPS_Doc *c1, COMPS_Doc *c2,
+                              const COMPS_DocUnionOptions *options);
+
+/** Union second COMPS_Doc into first one in place
+ * dst ends up with the same content comps_doc_union(dst, src) returns.
+ * Objects of dst are merged in place with comps_docgroup_unite,
+ * comps_doccategory_unite and comps_docenv_unite, objects of src are taken
+ * by reference instead of copying. Object of dst referenced from elsewhere
+ * is not modified, merged copy replaces it in dst. Sections comps_doc_union
+ * doesn't merge (blacklist, whiteout) are left untouched in dst.
+ *
+ * @param dst COMPS_Doc object which is modified
+ * @param src COMPS_Doc object
+ */
+void comps_doc_unite(COMPS_Doc *dst, COMPS_Doc *src);
+COMPS_Doc* comps_doc_intersect(COMPS_Doc *c1, COMPS_Doc *c2);
+
+COMPS_Doc* comps_doc_arch_filter(COMPS_Doc *source, COMPS_ObjList *arches);
+
+/** Filter document by several arch lists in one pass
+ *
+ * Result i is the same as comps_doc_arch_filter(source, arches[i]), but
+ * arches of every object are looked up only once for all lists. Arch names
+ * of all lists are interned to bits, so testing object arches against a
+ * list costs one bitwise and.
+ * @param source COMPS_Doc object
+ * @param arches array of count COMPS_ObjList objects of COMPS_Str arches
+ * @param count number of arch lists
+ * @return newly allocated array of count new COMPS_Doc objects or NULL
+ * when count is 0 or allocation fails
+ */
+COMPS_Doc** comps_doc_arch_filter_multi(COMPS_Doc *source,
+                                        COMPS_ObjList **arches,
+                                        unsigned int count);
+
+COMPS_Str* comps_doc_doctype_name_get(COMPS_Doc* doc);
+COMPS_Str* comps_doc_doctype_pubid_get(COMPS_Doc* doc);
+COMPS_Str* comps_doc_doctype_sysid_get(COMPS_Doc* doc);
+void comps_doc_doctype_name_set(COMPS_Doc* doc, COMPS_Str *val);
+void comps_doc_doctype_sysid_set(COMPS_Doc* doc, COMPS_Str *val);
+void comps_doc_doctype_pubid_set(COMPS_Doc* doc, COMPS_Str *val);
+
+//extern COMPS_ObjectInfo COMPS_Doc_ObjInfo;
+extern COMPS_ValRuleGeneric* COMPS_Doc_ValidateRules[];
+
+#endif //COMPS_DOC_H
+
@@ -0,0 +1,139 @@
+/* libcomps - C alternative to yum.comps library
+ * Copyright (C) 2013 Jindrich Luza
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to  Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA
+ */
+
+/** \file comps_docdiff.h
+ * \brief Structural difference of two COMPS_Doc objects
+ *
+ * comps_doc_diff() pairs groups, categories and environments of two
+ * documents by id and items of their lists by name through radix trees, so
+ * both documents are walked once and every object is compared only with
+ * its counterpart. Result is sequence of operations turning old document
+ * into new one, which is applied by comps_doc_patch(). Delta can be stored
+ * as small XML document by comps_docdelta_xml_str() and loaded back by
+ * comps_docdelta_from_xml_str().
+ *
+ * Delta covers groups, categories and environments, their properties,
+ * translations, packages and group ids, and langpacks. Blacklist, whiteout,
+ * encoding and doctype of document aren't part of it.
+ */
+
+#ifndef COMPS_DOCDIFF_H
+#define COMPS_DOCDIFF_H
+
+#include "comps_doc.h"
+
+/** Part of document changed by COMPS_DocDeltaOp */
+typedef enum {
+    COMPS_DELTA_GROUPS,
+    COMPS_DELTA_CATEGORIES,
+    COMPS_DELTA_ENVS,
+    COMPS_DELTA_LANGPACKS
+} COMPS_DocDeltaSection;
+
+/** Kind of COMPS_DocDeltaOp */
+typedef enum {
+    /** new object with id is inserted at pos, its content follows as
+     * other operations */
+    COMPS_DELTA_ADD,
+    /** object with id is removed */
+    COMPS_DELTA_REMOVE,
+    /** objects are reordered, value is COMPS_ObjList of COMPS_Str ids in
+     * new order */
+    COMPS_DELTA_ORDER,
+    /** property key of object (or langpack key) is set to value or unset
+     * when value is NULL */
+    COMPS_DELTA_PROP,
+    /** name translation to language key is set to value or unset */
+    COMPS_DELTA_NAME,
+    /** description translation to language key is set to value or unset */
+    COMPS_DELTA_DESC,
+    /** copy of item value is inserted at pos of list */
+    COMPS_DELTA_ITEM_ADD,
+    /** first item named key is removed from list, all items are removed
+     * when key is NULL */
+    COMPS_DELTA_ITEM_REMOVE,
+    /** first item named as value is replaced by copy of value */
+    COMPS_DELTA_ITEM_SET
+} COMPS_DocDeltaOpType;
+
+/** Single change of document */
+typedef struct {
+    COMPS_DocDeltaOpType type;
+    COMPS_DocDeltaSection section;
+    unsigned int list; /**< list of ITEM operations: 0 for packages of
+                         group, group ids of category and group list of
+                         environment, 1 for option list of environment */
+    char *id; /**< id of changed object, NULL for langpacks and ORDER */
+    char *key; /**< property, language, removed item or langpack name */
+    size_t pos; /**< position of ADD and ITEM_ADD */
+    COMPS_Object *value; /**< new value, NULL for removal */
+} COMPS_DocDeltaOp;
+
+/** Difference of two documents */
+typedef struct {
+    COMPS_DocDeltaOp *ops; /**< operations in order of application */
+    size_t len;
+    size_t size;
+} COMPS_DocDelta;
+
+/** Compute delta turning old document into new one
+ *
+ * Objects are paired by id, items of lists by name. Unchanged objects,
+ * lists and dictionaries are skipped after comparison of their digests
+ * (see comps_object_digest()), changed ones are merged in key order. Item
+ * is changed if any of its attributes written to XML differs, including
+ * arches. Lists with items of duplicate name or with kept
+ * items in different order are replaced as whole. Cost is linear in size
+ * of documents.
+ * @param old_doc original document
+ * @param new_doc changed document
+ * @return new delta, empty for equal documents. NULL if ids of groups,
+ * categories or environments of any document are missing or not unique,
+ * or if allocation fails
+ */
+COMPS_DocDelta* comps_doc_diff(COMPS_Doc *old_doc, COMPS_Doc *new_doc);
+
+/** Apply delta to document in place
+ *
+ * Operation which doesn't fit document (object or item doesn't exist,
+ * position is out of range) is skipped and the rest is still applied.
+ * Objects are looked up by id in radix tree built once per call, items are
+ * found by scan of their list.
+ * @param doc patched document
+ * @param delta delta made by comps_doc_diff() or loaded from XML
+ * @return number of skipped operations, 0 when whole delta was applied
+ */
+int comps_doc_patch(COMPS_Doc *doc, const COMPS_DocDelta *delta);
+
+/** Destroy delta with all its operations */
+void comps_docdelta_destroy(COMPS_DocDelta *delta);
+
+/** Serialize delta to XML
+ * @param delta COMPS_DocDelta
+ * @return newly allocated NUL terminated string or NULL on error
+ */
+char* comps_docdelta_xml_str(const COMPS_DocDelta *delta);
+
+/** Load delta from XML made by comps_docdelta_xml_str()
+ * @param str XML string
+ * @return new delta or NULL if string isn't well formed delta
+ */
+COMPS_DocDelta* comps_docdelta_from_xml_str(const char *str);
+
+#endif
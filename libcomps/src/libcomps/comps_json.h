@@ -0,0 +1,110 @@
+/* libcomps - C alternative to yum.comps library
+ * Copyright (C) 2013 Jindrich Luza
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to  Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA
+ */
+
+/*! \file comps_json.h
+ * \brief JSON export and import of COMPS_Doc
+ *
+ * JSON is written straight from objects in chunks and read straight into
+ * objects, no intermediate tree is built. Output is compact UTF-8 JSON.
+ *
+ * Schema (stable, new keys may be added in future versions):
+ * \code
+ * {
+ *   "groups": [{
+ *     "id": str, "name": str, "desc": str,
+ *     "name_by_lang": {lang: str, ...}, "desc_by_lang": {lang: str, ...},
+ *     "default": bool, "uservisible": bool, "biarchonly": bool,
+ *     "display_order": int, "lang_only": str, "arches": [str, ...],
+ *     "packages": [{"name": str,
+ *                   "type": "mandatory"|"default"|"optional"|"conditional",
+ *                   "requires": str, "basearchonly": bool,
+ *                   "arches": [str, ...]}, ...]
+ *   }, ...],
+ *   "categories": [{
+ *     "id", "name", "desc", "name_by_lang", "desc_by_lang",
+ *     "display_order", "arches" as in groups,
+ *     "group_ids": [{"name": str, "default": bool,
+ *                    "arches": [str, ...]}, ...]
+ *   }, ...],
+ *   "environments": [{
+ *     "id", "name", "desc", "name_by_lang", "desc_by_lang",
+ *     "display_order", "arches" as in groups,
+ *     "group_ids": [group id as in categories, ...],
+ *     "option_ids": [group id as in categories, ...]
+ *   }, ...],
+ *   "langpacks": {name: install, ...},
+ *   "blacklist": [{"name": str, "arch": str}, ...],
+ *   "whiteout": [{"requires": str, "package": str}, ...]
+ * }
+ * \endcode
+ * All top level keys and lists of packages and group ids are always
+ * written. Other members are written only when they're set and non-empty.
+ * On import every key is optional, null value is the same as missing key
+ * and unknown keys are skipped with warning.
+ */
+#ifndef COMPS_JSON_H
+#define COMPS_JSON_H
+
+#include "comps_doc.h"
+#include "comps_parse.h"
+
+/** Callback receiving generated JSON
+ * @param ctx context passed to comps2json_cb()
+ * @param buffer next chunk of JSON, not NUL terminated
+ * @param len length of chunk
+ * @return len on success, -1 on error which aborts generation
+ */
+typedef int (*COMPS_JSONWriteCallback)(void *ctx, const char *buffer, int len);
+
+/** Pass JSON representation of COMPS_Doc to callback in chunks
+ * @param doc COMPS_Doc object
+ * @param write_cb callback called for every chunk of output
+ * @param ctx context passed to write_cb
+ * @return 0 on success, -1 when write_cb fails
+ */
+signed char comps2json_cb(COMPS_Doc *doc, COMPS_JSONWriteCallback write_cb,
+                          void *ctx);
+
+/** Return JSON representation of COMPS_Doc as NUL terminated string
+ * @param doc COMPS_Doc object
+ * @return string which has to be freed by caller, NULL on error
+ */
+char* comps2json_str(COMPS_Doc *doc);
+
+/** Write JSON representation of COMPS_Doc to file
+ * @param doc COMPS_Doc object
+ * @param filename filename where to write
+ * @return 0 on success, -1 if file can't be written
+ */
+signed char comps2json_f(COMPS_Doc *doc, char *filename);
+
+/** Parse JSON representation of COMPS_Doc
+ *
+ * Result is stored in parsed->comps_doc and errors in parsed->log as with
+ * comps_parse_str().
+ * @param parsed initialized COMPS_Parsed structure
+ * @param str JSON, doesn't need to be NUL terminated
+ * @param len length of str
+ * @return 0 on success, 1 if there were non-fatal errors (unknown keys,
+ * package types) and -1 if JSON is malformed
+ */
+signed char comps_parse_json(COMPS_Parsed *parsed, const char *str,
+                             size_t len);
+
+#endif
@@ -0,0 +1,144 @@
+/* libcomps - C alternative to yum.comps library
+ * Copyright (C) 2013 Jindrich Luza
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to  Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA
+ */
+
+#ifndef COMPS_OBJRADIX_H
+#define COMPS_OBJRADIX_H
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "comps_hslist.h"
+#include "comps_rnodes.h"
+#include "comps_obj.h"
+#include "comps_utils.h"
+#include "comps_objlist.h"
+
+typedef struct {
+    char *key;
+    unsigned is_leaf;
+    COMPS_RNodes *subnodes;
+    COMPS_Object *data;
+} COMPS_ObjRTreeData;
+
+typedef struct {
+    COMPS_Object_HEAD;
+    COMPS_RNodes *subnodes;
+    unsigned int len;
+    /* bumped on every change, including replacement of a value */
+    unsigned int version;
+    /* bumped only when a key is added or removed, used to detect
+     * modification during iteration */
+    unsigned int keys_version;
+    /* content digest valid for digest_version, see comps_objrtree_digest */
+    COMPS_Digest digest;
+    unsigned int digest_version;
+    char digest_cached;
+} COMPS_ObjRTree;
+
+typedef COMPS_RNodesIt COMPS_ObjRTreeIt;
+
+typedef struct {
+    char *key;
+    COMPS_Object *data;
+} COMPS_ObjRTreePair;
+
+COMPS_ObjRTreeData * __comps_objrtree_data_create(char *key,
+                                                  size_t keylen,
+                                                  COMPS_Object *data);
+COMPS_HSList* __comps_objrtree_all(COMPS_ObjRTree *rt, char pairorkey);
+
+void comps_objrtree_data_destroy(COMPS_ObjRTreeData *rtd);
+void comps_objrtree_data_destroy_v(void *rtd);
+
+COMPS_ObjRTreeData * comps_objrtree_data_create(char *key, COMPS_Object *data);
+COMPS_ObjRTreeData * comps_objrtree_data_create_n(char *key, size_t keylen,
+                                                  COMPS_Object *data);
+
+
+void comps_objrtree_copy_u(COMPS_Object *rt1, COMPS_Object *rt2);
+void comps_objrtree_copy_shallow(COMPS_ObjRTree *rt1, COMPS_ObjRTree *rt2);
+signed char comps_objrtree_cmp_u(COMPS_Object *ort1, COMPS_Object *ort2);
+
+/** Return content digest of dictionary
+ *
+ * Digest of keys and values in key order. If all values are strings or
+ * numbers, result is cached until the next structural change of tree, so
+ * repeated call on unchanged dictionary costs O(1). Dictionaries with other
+ * values are digested again on every call, because their values can change
+ * without tree noticing.
+ * @see comps_object_digest
+ */
+COMPS_Digest comps_objrtree_digest(COMPS_ObjRTree *rt);
+COMPS_Digest comps_objrtree_digest_u(COMPS_Object *rt);
+void comps_objrtree_create_u(COMPS_Object *rtree, COMPS_Object **args);
+void comps_objrtree_destroy_u(COMPS_Object * rt);
+
+void comps_objrtree_set(COMPS_ObjRTree *rt, char *key, COMPS_Object *data);
+void comps_objrtree_set_x(COMPS_ObjRTree *rt, char *key, COMPS_Object *data);
+void comps_objrtree_set_n(COMPS_ObjRTree *rt, char *key, size_t len,
+                          COMPS_Object *data);
+void comps_objrtree_set_nx(COMPS_ObjRTree *rt, char *key, size_t len,
+                           COMPS_Object *data);
+
+COMPS_Object* comps_objrtree_get(COMPS_ObjRTree * rt, const char * key);
+COMPS_Object* comps_objrtree_get_x(COMPS_ObjRTree * rt, const char * key);
+void comps_objrtree_unset(COMPS_ObjRTree *rt, const char *key);
+void comps_objrtree_clear(COMPS_ObjRTree *rt);
+
+char comps_objrtree_paircmp(void *obj1, void *obj2);
+void comps_objrtree_values_walk(COMPS_ObjRTree * rt, void* udata,
+                                void (*walk_f)(void*, COMPS_Object*));
+COMPS_HSList * comps_objrtree_values(COMPS_ObjRTree * rt);
+COMPS_HSList* comps_objrtree_keys(COMPS_ObjRTree *rt);
+COMPS_HSList* comps_objrtree_pairs(COMPS_ObjRTree * rt);
+COMPS_ObjRTree* comps_objrtree_clone(COMPS_ObjRTree *rt);
+COMPS_ObjRTree* comps_objrtree_union(COMPS_ObjRTree *rt1, COMPS_ObjRTree *rt2);
+void comps_objrtree_unite(COMPS_ObjRTree *rt1, COMPS_ObjRTree *rt2);
+COMPS_ObjRTree* comps_objrtree_union(COMPS_ObjRTree *rt1, COMPS_ObjRTree *rt2);
+
+COMPS_ObjRTreePair* comps_objrtree_pair_create(char *key, void *data,
+                                          void (*data_destructor(void*)));
+void comps_objrtree_pair_destroy(COMPS_ObjRTreePair *pair);
+void comps_objrtree_pair_destroy_v(void *pair);
+
+/* Iterator doesn't allocate for common trees and yields borrowed key and
+ * value. Key is valid until next call of comps_objrtree_it_next. Keys mustn't
+ * be added or removed during iteration, values of existing keys may be
+ * replaced */
+void comps_objrtree_it_init(COMPS_ObjRTreeIt *it, COMPS_ObjRTree *rt);
+int comps_objrtree_it_next(COMPS_ObjRTreeIt *it, const char **key,
+                           COMPS_Object **data);
+void comps_objrtree_it_destroy(COMPS_ObjRTreeIt *it);
+/* iterate only keys starting with prefix */
+void comps_objrtree_it_init_prefix(COMPS_ObjRTreeIt *it, COMPS_ObjRTree *rt,
+                                   const char *prefix);
+/* iterate keys in range [first, last), NULL means unbounded. last must stay
+ * valid during iteration */
+void comps_objrtree_it_init_range(COMPS_ObjRTreeIt *it, COMPS_ObjRTree *rt,
+                                  const char *first, const char *last);
+void comps_objrtree_prefix_walk(COMPS_ObjRTree *rt, const char *prefix,
+                                void *udata,
+                                void (*walk_f)(void*, const char*,
+                                               COMPS_Object*));
+COMPS_HSList* comps_objrtree_keys_with_prefix(COMPS_ObjRTree *rt,
+                                              const char *prefix);
+
+extern COMPS_ObjectInfo COMPS_ObjRTree_ObjInfo;
+
+#endif
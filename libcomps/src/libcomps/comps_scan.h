@@ -0,0 +1,66 @@
+/* libcomps - C alternative to yum.comps library
+ * Copyright (C) 2013 Jindrich Luza
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to  Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA
+ */
+
+/*! \file comps_scan.h
+ * \brief Byte scanning helpers of parser and XML writer.
+ * On x86 with GCC compatible compiler helpers have SSE2 and AVX2 variants
+ * processing 16 or 32 bytes at once. The best variant supported by CPU is
+ * selected at first use, scalar variant is used elsewhere. All variants
+ * return the same results.
+ **/
+#ifndef COMPS_SCAN_H
+#define COMPS_SCAN_H
+
+#include <stddef.h>
+
+/** Implementation level of scanning helpers */
+typedef enum {
+    COMPS_SCAN_SCALAR,
+    COMPS_SCAN_SSE2,
+    COMPS_SCAN_AVX2
+} COMPS_ScanLevel;
+
+/** Return non-zero if all len bytes of s are whitespace as isspace() in
+ * C locale defines it (space, \\t, \\n, \\v, \\f, \\r). Empty input is
+ * whitespace only.
+ */
+int comps_scan_space_only(const char *s, size_t len);
+
+/** Return length of leading part of s which XML writer can output as
+ * element text without escaping, that is position of first &, <, > or \\r
+ * or len if there's none.
+ */
+size_t comps_scan_xml_text(const char *s, size_t len);
+
+/** Same as comps_scan_xml_text() for attribute values. Stops also at ",
+ * \\t, \\n and non-ASCII bytes.
+ */
+size_t comps_scan_xml_attr(const char *s, size_t len);
+
+/** Return level of implementation in use */
+COMPS_ScanLevel comps_scan_level(void);
+
+/** Select implementation level, for tests and benchmarks. Level is lowered
+ * to the best one supported by CPU. Not thread safe, mustn't be called
+ * while other threads scan.
+ * @return level actually selected
+ */
+COMPS_ScanLevel comps_scan_set_level(COMPS_ScanLevel level);
+
+#endif
@@ -0,0 +1,251 @@
+/* libcomps - C alternative to yum.comps library
+ * Copyright (C) 2013 Jindrich Luza
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to  Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA
+ */
+
+#ifndef COMPS_UTILS_H
+#define COMPS_UTILS_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "comps_obj.h"
+#include "comps_objlist.h"
+#include "comps_radix.h"
+#include "comps_set.h"
+
+#include <libxml/encoding.h>
+#include <libxml/xmlwriter.h>
+#include <libxml/tree.h>
+
+
+#define CONCAT(A,B) CONCAT2(A, B)
+#define CONCAT2(A, B) A ## B
+
+#define COMPS_PROP_CMP(OBJNAME, PROPNAME, GETTER)\
+char CONCAT(CONCAT(CONCAT(CONCAT(__comps_, OBJNAME),_),PROPNAME),cmp) (void *obj1,\
+                                                                       void *obj2){\
+    COMPS_Prop *prop1, *prop2;\
+    prop1 = GETTER(obj1, #PROPNAME);\
+    prop2 = GETTER(obj2, #PROPNAME);\
+    if (prop1 == NULL && prop2 == NULL) return 1;\
+    if (prop1 == NULL || prop2 == NULL) return 0;\
+    if (prop1->prop_type != COMPS_PROP_STR ||\
+        prop2->prop_type != COMPS_PROP_STR) return 0;\
+    return __comps_strcmp(prop1->prop.str, prop2->prop.str);\
+}
+
+#define COMPS_STRPROP_SETTER(OBJNAME, OBJTYPE, PROPNAME)\
+inline void CONCAT(CONCAT(CONCAT(comps_doc, OBJNAME), _set_), PROPNAME)(OBJTYPE *OBJNAME,\
+                                                                        char *PROPNAME,\
+                                                                        char copy) {\
+    (void)copy;\
+    if (PROPNAME) {\
+        COMPS_Object *str;\
+        str = (COMPS_Object*)comps_str(PROPNAME);\
+        comps_objdict_set_x(OBJNAME->properties, #PROPNAME, str);\
+    }\
+}
+
+#define HEAD_COMPS_STRPROP_SETTER(OBJNAME, OBJTYPE, PROPNAME)\
+void CONCAT(CONCAT(CONCAT(comps_doc, OBJNAME), _set_), PROPNAME)(OBJTYPE *OBJNAME,\
+                                                                 char *PROPNAME,\
+                                                                 char copy);
+
+#define COMPS_NUMPROP_SETTER(OBJNAME, OBJTYPE, PROPNAME)\
+inline void CONCAT(CONCAT(CONCAT(comps_doc, OBJNAME), _set_), PROPNAME)(OBJTYPE *OBJNAME,\
+                                                                        int PROPNAME,\
+                                                                        bool unset){\
+        if (unset) {\
+            comps_objdict_set_x(OBJNAME->properties, #PROPNAME, NULL);\
+            return;\
+        } \
+        COMPS_Object *num;\
+        num = (COMPS_Object*)comps_num(PROPNAME);\
+        comps_objdict_set_x(OBJNAME->properties, #PROPNAME, num);\
+}
+#define HEAD_COMPS_NUMPROP_SETTER(OBJNAME, OBJTYPE, PROPNAME)\
+void CONCAT(CONCAT(CONCAT(comps_doc, OBJNAME), _set_), PROPNAME)(OBJTYPE *OBJNAME,\
+                                                                 int PROPNAME,\
+                                                                 bool unset);
+
+
+#define COMPS_PROP_GETTER(OBJNAME, OBJTYPE, PROPNAME)\
+inline COMPS_Object* CONCAT(CONCAT(CONCAT(comps_doc, OBJNAME), _get_), PROPNAME)\
+                                                         (OBJTYPE *OBJNAME){\
+    return comps_objdict_get(OBJNAME->properties, #PROPNAME);\
+}
+#define HEAD_COMPS_PROP_GETTER(OBJNAME, OBJTYPE, PROPNAME)\
+COMPS_Object* CONCAT(CONCAT(CONCAT(comps_doc, OBJNAME), _get_), PROPNAME)\
+                                                            (OBJTYPE *OBJNAME);
+#define COMPS_PROP_GETTER_OBJ(OBJNAME, OBJTYPE, PROPNAME)\
+inline COMPS_Object* CONCAT(CONCAT(CONCAT(CONCAT(comps_doc, OBJNAME),\
+                                           _get_), PROPNAME), _obj)\
+                                                      (COMPS_Object *OBJNAME){\
+    return CONCAT(CONCAT(CONCAT(comps_doc, OBJNAME), _get_), PROPNAME)\
+                                                        ((OBJTYPE*)OBJNAME);\
+}
+#define HEAD_COMPS_PROP_GETTER_OBJ(OBJNAME, PROPNAME)\
+COMPS_Object* CONCAT(CONCAT(CONCAT(CONCAT(comps_doc, OBJNAME),\
+                                   _get_), PROPNAME), _obj)\
+                                                        (COMPS_Object *OBJNAME);
+
+
+#define COMPS_CREATE_u(NAME, TYPE) void CONCAT(CONCAT(comps_, NAME), _create_u)\
+                                                        (COMPS_Object *uobj,\
+                                                         COMPS_Object **args) {\
+    CONCAT(CONCAT(comps_, NAME),_create)((TYPE*)uobj, args);\
+}
+#define HEAD_COMPS_CREATE_u(NAME, TYPE) void CONCAT(CONCAT(comps_, NAME), _create_u)\
+                                                        (COMPS_Object *uobj,\
+                                                         COMPS_Object **args);
+
+#define COMPS_COPY_u(NAME, TYPE) void CONCAT(CONCAT(comps_,NAME),_copy_u)\
+                                                            (COMPS_Object* obj_dst,\
+                                                             COMPS_Object* obj_src){\
+    CONCAT(CONCAT(comps_, NAME),_copy) ((TYPE*)obj_dst, (TYPE*)obj_src);\
+}
+#define HEAD_COMPS_COPY_u(NAME, TYPE) void CONCAT(CONCAT(comps_,NAME),_copy_u)\
+                                                        (COMPS_Object* obj_dst,\
+                                                         COMPS_Object* obj_src);
+
+#define COMPS_DESTROY_u(NAME, TYPE)\
+static void CONCAT(CONCAT(comps_, NAME), _destroy_u)(COMPS_Object* obj){\
+    CONCAT(CONCAT(comps_, NAME),_destroy) ((TYPE*)obj);\
+}
+#define HEAD_COMPS_DESTROY_u(NAME, TYPE)\
+static void CONCAT(CONCAT(comps_, NAME), _destroy_u)(COMPS_Object* obj);
+
+#define COMPS_CMP_u(NAME, TYPE) signed char CONCAT(CONCAT(comps_,NAME),_cmp_u)\
+                                                            (COMPS_Object* obj_dst,\
+                                                             COMPS_Object* obj_src){\
+    return CONCAT(CONCAT(comps_, NAME),_cmp) ((TYPE*)obj_dst, (TYPE*)obj_src);\
+}
+#define HEAD_COMPS_CMP_u(NAME, TYPE) void CONCAT(CONCAT(comps_,NAME),_cmp_u)\
+
+
+#define COMPS_DOCOBJ_GETOBJLIST(OBJ, OBJTYPE, MEMBER, OBJS)\
+COMPS_ObjList* CONCAT(CONCAT(CONCAT(comps_, OBJ), _), OBJS) (OBJTYPE *obj){\
+    return obj->MEMBER;\
+}
+#define HEAD_COMPS_DOCOBJ_GETOBJLIST(OBJ, OBJTYPE, MEMBER, OBJS)\
+COMPS_ObjList* CONCAT(CONCAT(CONCAT(comps_, OBJ), _), OBJS) (OBJTYPE *obj);
+
+#define COMPS_DOCOBJ_SETOBJLIST(OBJ, OBJTYPE, MEMBER, OBJS)\
+void CONCAT(CONCAT(CONCAT(comps_, OBJ), _set_), OBJS) (OBJTYPE *obj,\
+                                                   COMPS_ObjList *list){\
+    COMPS_OBJECT_DESTROY(obj->MEMBER);\
+    obj->MEMBER = (COMPS_ObjList*)comps_object_incref((COMPS_Object*)list);\
+}
+#define HEAD_COMPS_DOCOBJ_SETOBJLIST(OBJ, OBJTYPE, MEMBER, OBJS)\
+void CONCAT(CONCAT(CONCAT(comps_, OBJ), _set_), OBJS) (OBJTYPE *obj,\
+                                                   COMPS_ObjList *list);
+
+#define COMPS_DOCOBJ_GETARCHES(OBJ, OBJTYPE)\
+COMPS_ObjList* CONCAT(CONCAT(comps_, OBJ), _arches) (OBJTYPE *obj){\
+    return (COMPS_ObjList*)comps_objdict_get(obj->properties, "arches");\
+}
+#define HEAD_COMPS_DOCOBJ_GETARCHES(OBJ, OBJTYPE)\
+COMPS_ObjList* CONCAT(CONCAT(comps_, OBJ), _arches)(OBJTYPE *obj);
+
+#define COMPS_DOCOBJ_SETARCHES(OBJ, OBJTYPE)\
+void CONCAT(CONCAT(comps_, OBJ), _set_arches)(OBJTYPE *obj,\
+                                              COMPS_ObjList *list){\
+    comps_objdict_set_x(obj->properties, "arches", (COMPS_Object*)list);\
+}
+#define HEAD_COMPS_DOCOBJ_SETARCHES(OBJ, OBJTYPE)\
+void CONCAT(CONCAT(comps_, OBJ), _set_arches)(OBJTYPE *obj,\
+                                              COMPS_ObjList *list);
+
+
+#define COMPS_XMLRET_CHECK(free_code) if (ret == -1) {\
+    free_code;\
+    comps_log_error(log, COMPS_ERR_XMLGEN, 0);\
+    return -1;\
+}
+
+char __comps_strcmp(void *s1, void *s2);
+char* __comps_strcpy(char *str);
+char* __comps_strcat(char *str1, char *str2);
+void* __comps_str_clone(void *str);
+/* Write element text escaped the same way as libxml2 saves text nodes, that
+ * is only &, <, > and CR are escaped. xmlTextWriterWriteString escapes also
+ * quotes and closes empty element by full end tag. Nothing is written for
+ * empty or NULL string
+ * @return number of written bytes or -1 on error */
+int __comps_xml_text(xmlTextWriterPtr writer, const char *str);
+/* Same output as xmlTextWriterWriteAttribute, values which need no
+ * escaping are written directly without libxml2 copying them
+ * @return number of written bytes or -1 on error */
+int __comps_xml_attr(xmlTextWriterPtr writer, const char *name,
+                     const char *value);
+int __comps_xml_prop(char *key, char *val, xmlTextWriterPtr writer);
+
+/* XML of group, category or environment kept from last output with
+ * fragment_cache option. It's reused while digest of the object and of
+ * output options stay the same */
+typedef struct {
+    char *xml;
+    size_t len;
+    COMPS_Digest digest; /* digest of object when rendered */
+    COMPS_Digest options; /* digest of xml and default options */
+} COMPS_XMLFragment;
+
+void __comps_xml_fragment_destroy(COMPS_XMLFragment *frag);
+char* __comps_num2boolstr(COMPS_Object* obj);
+unsigned int digits_count(unsigned int x);
+bool __comps_objlist_intersected(COMPS_ObjList *list1, COMPS_ObjList *list2);
+
+typedef uint64_t COMPS_ArchMask;
+
+/* Arch lists of arch filter. Arch names of all lists are interned in
+ * registry giving every distinct name one bit, so object arches are tested
+ * against all lists by one lookup per object arch and bitwise and per list
+ * instead of comparing every pair of strings. With more than 64 distinct
+ * names filter falls back to __comps_objlist_intersected() */
+typedef struct {
+    COMPS_ObjList **arches;
+    COMPS_ArchMask *masks; /* mask of every list, NULL on fallback */
+    unsigned int count;
+    COMPS_RTree *bits; /* arch name -> its bit number + 1 */
+} COMPS_ArchFilter;
+
+COMPS_ArchFilter* comps_archfilter_create(COMPS_ObjList **arches,
+                                          unsigned int count);
+void comps_archfilter_destroy(COMPS_ArchFilter *filter);
+/* set keep[i] to whether object with obj_arches passes i-th arch list. NULL
+ * obj_arches passes all, empty obj_arches none */
+void comps_archfilter_match(const COMPS_ArchFilter *filter,
+                            COMPS_ObjList *obj_arches, char *keep);
+char* __comps_xml_arch_str(COMPS_Object *arches);
+int __comps_xml_arch(COMPS_Object *archlist, xmlTextWriterPtr writer);
+
+int __comps_check_xml_get(int retcode, COMPS_Object * log);
+
+/* key string of object used for id/name joins. Returns NULL for NULL object,
+ * non-string objects are converted and result is stored also in *tofree */
+char* __comps_obj_keystr(COMPS_Object *obj, char **tofree);
+
+/* merge src into dst in place the way object union functions merge lists:
+ * first dst item with key of src item is replaced by reference to src item
+ * (once, further src items with that key are dropped), other src items are
+ * appended by reference */
+void __comps_objlist_unite_by(COMPS_ObjList *dst, COMPS_ObjList *src,
+                              COMPS_Object* (*key_f)(COMPS_Object*));
+#endif
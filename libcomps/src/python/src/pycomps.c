@@ -24,6 +24,7 @@
  */
 
 #include <stdbool.h>
+#include <libxml/parser.h>
 
 #include "pycomps_macros.h"
 #include "pycomps.h"
@@ -40,7 +41,7 @@ char __pycomps_dict_to_xml_opts(PyObject* pobj, void *cobj) {
                           "empty_optionlist", "uservisible_explicit",
                           "biarchonly_explicit", "default_explicit",
                           "gid_default_explicit", "bao_explicit",
-                          "arch_output", NULL};
+                          "arch_output", "fragment_cache", NULL};
     *options = malloc(sizeof(COMPS_XMLOptions));
     _Bool *props[] = {&(*options)->empty_groups,
                       &(*options)->empty_categories,
@@ -56,7 +57,8 @@ char __pycomps_dict_to_xml_opts(PyObject* pobj, void *cobj) {
                       &(*options)->default_explicit,
                       &(*options)->gid_default_explicit,
                       &(*options)->bao_explicit,
-                      &(*options)->arch_output};
+                      &(*options)->arch_output,
+                      &(*options)->fragment_cache};
     **options = COMPS_XMLDefaultOptions;
 
     if (!PyDict_Check(pobj)) {
@@ -120,6 +122,60 @@ char __pycomps_dict_to_def_opts(PyObject* pobj, void *cobj) {
     return 1;
 }
 
+/* Getters of doc sections add missing section on first access. Readers
+ * running without GIL would modify doc shared with other threads that way,
+ * so sections are added in advance, with GIL held */
+static void __pycomps_doc_sections(COMPS_Doc *doc) {
+    COMPS_OBJECT_DESTROY(comps_doc_groups(doc));
+    COMPS_OBJECT_DESTROY(comps_doc_categories(doc));
+    COMPS_OBJECT_DESTROY(comps_doc_environments(doc));
+    COMPS_OBJECT_DESTROY(comps_doc_langpacks(doc));
+    COMPS_OBJECT_DESTROY(comps_doc_blacklist(doc));
+    COMPS_OBJECT_DESTROY(comps_doc_whiteout(doc));
+}
+
+/* Document sharing content and doctype with doc but having its own log.
+ * Output running without GIL logs there instead of to log of doc, which
+ * other threads may read or clear meanwhile */
+static COMPS_Doc* __pycomps_doc_output_view(COMPS_Doc *doc) {
+    COMPS_Doc *view;
+
+    __pycomps_doc_sections(doc);
+    view = COMPS_OBJECT_CREATE(COMPS_Doc, NULL);
+    COMPS_OBJECT_REPLACE(view->objects, COMPS_ObjDict, doc->objects);
+    COMPS_OBJECT_REPLACE(view->encoding, COMPS_Str, doc->encoding);
+    COMPS_OBJECT_REPLACE(view->doctype_name, COMPS_Str, doc->doctype_name);
+    COMPS_OBJECT_REPLACE(view->doctype_sysid, COMPS_Str, doc->doctype_sysid);
+    COMPS_OBJECT_REPLACE(view->doctype_pubid, COMPS_Str, doc->doctype_pubid);
+    COMPS_OBJECT_REPLACE(view->lang, COMPS_Str, doc->lang);
+    return view;
+}
+
+/* Move messages logged by output through view to log of doc and destroy
+ * view. Must be called with GIL held */
+static void __pycomps_doc_output_done(COMPS_Doc *doc, COMPS_Doc *view) {
+    COMPS_HSListItem *it;
+
+    for (it = view->log->entries->first; it != NULL; it = it->next)
+        comps_hslist_append(doc->log->entries, it->data, 0);
+    view->log->entries->data_destructor = NULL;
+    COMPS_OBJECT_DESTROY(view);
+}
+
+/* Release GIL for output unless it goes through fragment cache. Cached
+ * fragments are stored in the objects themselves, which other threads
+ * may output at the same time */
+static PyThreadState* __pycomps_output_begin(COMPS_XMLOptions *xml_options) {
+    if (xml_options && xml_options->fragment_cache)
+        return NULL;
+    return PyEval_SaveThread();
+}
+
+static void __pycomps_output_end(PyThreadState *save) {
+    if (save)
+        PyEval_RestoreThread(save);
+}
+
 PyObject* PyCOMPS_toxml_f(PyObject *self, PyObject *args, PyObject *kwds) {
     const char *errors = NULL;
     char *tmps, *fname = NULL;
@@ -129,8 +185,9 @@ PyObject* PyCOMPS_toxml_f(PyObject *self, PyObject *args, PyObject *kwds) {
     COMPS_DefaultsOptions *def_options = NULL;
     COMPS_HSListItem *it;
     PyObject *ret, *tmp;
+    PyThreadState *save;
     char* keywords[] = {"fname", "xml_options", "def_options", NULL};
-    PyCOMPS *self_comps = (PyCOMPS*)self;
+    COMPS_Doc *doc = ((PyCOMPS*)self)->comps_doc, *view;
 
 
     if (!PyArg_ParseTupleAndKeywords(args, kwds, "s|O&O&", keywords, &fname,
@@ -142,12 +199,18 @@ PyObject* PyCOMPS_toxml_f(PyObject *self, PyObject *args, PyObject *kwds) {
         return NULL;
     }
 
-    if (!self_comps->comps_doc->encoding)
-       self_comps->comps_doc->encoding = comps_str("UTF-8");
-    comps_hslist_clear(self_comps->comps_doc->log->entries);
-
-    genret = comps2xml_f(self_comps->comps_doc, fname,
-                         0, xml_options, def_options);
+    if (!doc->encoding)
+       doc->encoding = comps_str("UTF-8");
+
+    /* document is referenced so it survives replacing by other thread */
+    doc = (COMPS_Doc*)comps_object_incref((COMPS_Object*)doc);
+    view = __pycomps_doc_output_view(doc);
+    save = __pycomps_output_begin(xml_options);
+    genret = comps2xml_f(view, fname, 0, xml_options, def_options);
+    __pycomps_output_end(save);
+    /* log of doc holds messages of the last output, as before */
+    comps_hslist_clear(doc->log->entries);
+    __pycomps_doc_output_done(doc, view);
     if (xml_options)
         free(xml_options);
     if (def_options)
@@ -157,16 +220,17 @@ PyObject* PyCOMPS_toxml_f(PyObject *self, PyObject *args, PyObject *kwds) {
     }
     //free(fname);
 
-    for (i = 0, it = self_comps->comps_doc->log->entries->first;
+    for (i = 0, it = doc->log->entries->first;
          it != NULL; it = it->next, i++);
     ret = PyList_New(i);
-    for (i = 0, it = self_comps->comps_doc->log->entries->first;
+    for (i = 0, it = doc->log->entries->first;
          it != NULL; it = it->next, i++) {
         tmps = comps_log_entry_str(it->data);
         tmp = PyUnicode_DecodeUTF8(tmps, strlen(tmps), errors);
         PyList_SetItem(ret, i, tmp);
         free(tmps);
     }
+    COMPS_OBJECT_DESTROY(doc);
     return ret;
 }
 
@@ -184,7 +248,16 @@ PyObject* PyCOMPS_toxml_str(PyObject *self, PyObject *args, PyObject *kwds) {
         return NULL;
     }
 
-    char *s = comps2xml_str(((PyCOMPS*)self)->comps_doc, xml_options, def_options);
+    char *s;
+    PyThreadState *save;
+    COMPS_Doc *doc = (COMPS_Doc*)comps_object_incref(
+                                   (COMPS_Object*)((PyCOMPS*)self)->comps_doc);
+    COMPS_Doc *view = __pycomps_doc_output_view(doc);
+    save = __pycomps_output_begin(xml_options);
+    s = comps2xml_str(view, xml_options, def_options);
+    __pycomps_output_end(save);
+    __pycomps_doc_output_done(doc, view);
+    COMPS_OBJECT_DESTROY(doc);
     if (xml_options)
         free(xml_options);
     if (def_options)
@@ -232,7 +305,12 @@ PyObject* PyCOMPS_fromxml_f(PyObject *self, PyObject *args, PyObject* kwds) {
         PyErr_SetString(PyCOMPSExc_ParserError, "Fatal error in comps_parse_parsed_init()");
         return NULL;
     }
+    /* only new objects are touched until parsed document replaces old one */
+    Py_BEGIN_ALLOW_THREADS
     f =  fopen(fname, "r");
+    if (f)
+        parsed_ret = comps_parse_file(parsed, f, options);
+    Py_END_ALLOW_THREADS
     if (!f) {
         PyErr_Format(PyExc_IOError, "Cannot open %s for reading", fname);
         //free(fname);
@@ -241,7 +319,6 @@ PyObject* PyCOMPS_fromxml_f(PyObject *self, PyObject *args, PyObject* kwds) {
             free(options);
         return NULL;
     }
-    parsed_ret = comps_parse_file(parsed, f, options);
     Py_CLEAR(self_comps->p_groups);
     Py_CLEAR(self_comps->p_categories);
     Py_CLEAR(self_comps->p_environments);
@@ -344,7 +421,9 @@ PyObject* PyCOMPS_fromxml_str(PyObject *self, PyObject *args, PyObject *kwds) {
         PyErr_SetString(PyCOMPSExc_ParserError, "Fatal error in comps_parse_parsed_init()");
         return NULL;
     }
+    Py_BEGIN_ALLOW_THREADS
     parsed_ret = comps_parse_str(parsed, tmps, options);
+    Py_END_ALLOW_THREADS
     if (options)
         free(options);
     if (parsed_ret == -1) {
@@ -379,6 +458,65 @@ PyObject* PyCOMPS_fromxml_str(PyObject *self, PyObject *args, PyObject *kwds) {
     return PyLong_FromLong((long)parsed_ret);
 }
 
+PyObject* PyCOMPS_tojson_str(PyObject *self) {
+    PyObject *ret;
+    char *s;
+    COMPS_Doc *doc = (COMPS_Doc*)comps_object_incref(
+                                   (COMPS_Object*)((PyCOMPS*)self)->comps_doc);
+    COMPS_Doc *view = __pycomps_doc_output_view(doc);
+
+    Py_BEGIN_ALLOW_THREADS
+    s = comps2json_str(view);
+    Py_END_ALLOW_THREADS
+    __pycomps_doc_output_done(doc, view);
+    COMPS_OBJECT_DESTROY(doc);
+    if (s == NULL)
+        return PyErr_NoMemory();
+    ret = PyUnicode_DecodeUTF8(s, strlen(s), NULL);
+    free(s);
+    return ret;
+}
+
+PyObject* PyCOMPS_fromjson_str(PyObject *self, PyObject *args) {
+    const char *tmps;
+    signed char parsed_ret;
+    PyCOMPS *self_comps = (PyCOMPS*)self;
+    COMPS_Parsed *parsed;
+
+    if (!PyArg_ParseTuple(args, "s", &tmps))
+        return NULL;
+
+    parsed = comps_parse_parsed_create();
+    if (!comps_parse_parsed_init(parsed, "UTF-8", 0)) {
+        PyErr_SetString(PyCOMPSExc_ParserError, "Fatal error in comps_parse_parsed_init()");
+        return NULL;
+    }
+    Py_BEGIN_ALLOW_THREADS
+    parsed_ret = comps_parse_json(parsed, tmps, strlen(tmps));
+    Py_END_ALLOW_THREADS
+    if (parsed_ret == -1) {
+        comps_parse_parsed_destroy(parsed);
+        PyErr_SetString(PyCOMPSExc_ParserError, "Fatal parser error");
+        return NULL;
+    }
+    Py_CLEAR(self_comps->p_groups);
+    Py_CLEAR(self_comps->p_categories);
+    Py_CLEAR(self_comps->p_environments);
+    Py_CLEAR(self_comps->p_langpacks);
+    Py_CLEAR(self_comps->p_blacklist);
+    Py_CLEAR(self_comps->p_whiteout);
+    COMPS_OBJECT_DESTROY(self_comps->comps_doc);
+
+    self_comps->comps_doc = parsed->comps_doc;
+    COMPS_OBJECT_DESTROY(self_comps->comps_doc->log);
+    self_comps->comps_doc->log = parsed->log;
+    parsed->log = NULL;
+    parsed->comps_doc = NULL;
+    comps_parse_parsed_destroy(parsed);
+
+    return PyLong_FromLong((long)parsed_ret);
+}
+
 PyObject* PyCOMPS_get_(PyCOMPS *self, void *closure) {
     #define _closure_ ((PyCOMPS_GetSetClosure*)closure)
 
@@ -507,9 +645,8 @@ int PyCOMPS_mdset_(PyCOMPS *self, PyObject *val, void *closure) {
 PyObject* PyCOMPS_filter_arches(PyObject *self, PyObject *other) {
     COMPS_ObjList * arches;
     PyCOMPS *doc;
-    COMPS_Doc *comps_doc;
+    COMPS_Doc *comps_doc, *src;
     PyObject *item;
-    char created = 0;
     if ((Py_TYPE(other) != &PyCOMPS_StrSeqType) &&
         (Py_TYPE(other) != &PyList_Type)) {
         PyErr_Format(PyExc_TypeError, "Not %s or %s instance",
@@ -517,7 +654,6 @@ PyObject* PyCOMPS_filter_arches(PyObject *self, PyObject *other) {
         return NULL;
     }
     if (Py_TYPE(other) == &PyList_Type) {
-        created = 1;
         arches = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
         for (Py_ssize_t x=0; x < PyList_Size(other); x++) {
             item = PyList_GetItem(other, x);
@@ -529,16 +665,21 @@ PyObject* PyCOMPS_filter_arches(PyObject *self, PyObject *other) {
             comps_objlist_append_x(arches, (COMPS_Object*)comps_str_x(str));
         }
     } else {
-        arches = ((PyCOMPS_Sequence*)other)->list;
+        arches = (COMPS_ObjList*)comps_object_incref(
+                               (COMPS_Object*)((PyCOMPS_Sequence*)other)->list);
     }
     doc = (PyCOMPS*)PyCOMPS_new(&PyCOMPS_Type, NULL, NULL);
     PyCOMPS_init(doc, NULL, NULL);
     COMPS_OBJECT_DESTROY(doc->comps_doc);
 
-    comps_doc = comps_doc_arch_filter(((PyCOMPS*)self)->comps_doc, arches);
-    if (created) {
-        COMPS_OBJECT_DESTROY(arches);
-    }
+    src = (COMPS_Doc*)comps_object_incref(
+                                   (COMPS_Object*)((PyCOMPS*)self)->comps_doc);
+    __pycomps_doc_sections(src);
+    Py_BEGIN_ALLOW_THREADS
+    comps_doc = comps_doc_arch_filter(src, arches);
+    Py_END_ALLOW_THREADS
+    COMPS_OBJECT_DESTROY(src);
+    COMPS_OBJECT_DESTROY(arches);
     doc->comps_doc = comps_doc;
     return (PyObject*)doc;
 }
@@ -550,14 +691,17 @@ PyObject* PyCOMPS_groups_match(PyObject *self, PyObject *args, PyObject *kwds) {
     char *id = NULL, *name = NULL, *desc = NULL, *lang = NULL;
     char *keywords[] = {"id", "name", "desc", "lang", "flags", NULL};
     COMPS_ObjList * list;
+    COMPS_DocQuery *query;
 
     if (PyArg_ParseTupleAndKeywords(args, kwds, "|ssssi", keywords, &id, &name,
                                     &desc, &lang, &flags)) {
     } else {
         return NULL;
     }
-    list = comps_doc_get_groups(((PyCOMPS*)self)->comps_doc,
-                                id, name, desc, lang, flags);
+    if ((query = comps_doc_query_create(id, name, desc, lang, flags)) == NULL)
+        return PyErr_NoMemory();
+    list = comps_doc_query_groups(((PyCOMPS*)self)->comps_doc, query);
+    comps_doc_query_destroy(query);
     ret = PyCOMPSSeq_new(&PyCOMPS_GroupsType, NULL, NULL);
     Py_TYPE(ret)->tp_init(ret, NULL, NULL);
     COMPS_OBJECT_DESTROY(((PyCOMPS_Sequence*)ret)->list);
@@ -572,14 +716,17 @@ PyObject* PyCOMPS_categories_match(PyObject *self, PyObject *args, PyObject *kwd
     char *id = NULL, *name = NULL, *desc = NULL, *lang = NULL;
     char *keywords[] = {"id", "name", "desc", "lang", "flags", NULL};
     COMPS_ObjList * list;
+    COMPS_DocQuery *query;
 
     if (PyArg_ParseTupleAndKeywords(args, kwds, "|ssssi", keywords, &id, &name,
                                     &desc, &lang, &flags)) {
     } else {
         return NULL;
     }
-    list = comps_doc_get_categories(((PyCOMPS*)self)->comps_doc,
-                                    id, name, desc, lang, flags);
+    if ((query = comps_doc_query_create(id, name, desc, lang, flags)) == NULL)
+        return PyErr_NoMemory();
+    list = comps_doc_query_categories(((PyCOMPS*)self)->comps_doc, query);
+    comps_doc_query_destroy(query);
     ret = PyCOMPSSeq_new(&PyCOMPS_CatsType, NULL, NULL);
     Py_TYPE(ret)->tp_init(ret, NULL, NULL);
     COMPS_OBJECT_DESTROY(((PyCOMPS_Sequence*)ret)->list);
@@ -594,14 +741,17 @@ PyObject* PyCOMPS_envs_match(PyObject *self, PyObject *args, PyObject *kwds) {
     char *id = NULL, *name = NULL, *desc = NULL, *lang = NULL;
     char *keywords[] = {"id", "name", "desc", "lang", "flags", NULL};
     COMPS_ObjList * list;
+    COMPS_DocQuery *query;
 
     if (PyArg_ParseTupleAndKeywords(args, kwds, "|ssssi", keywords, &id, &name,
                                     &desc, &lang, &flags)) {
     } else {
         return NULL;
     }
-    list = comps_doc_get_envs(((PyCOMPS*)self)->comps_doc,
-                              id, name, desc, lang, flags);
+    if ((query = comps_doc_query_create(id, name, desc, lang, flags)) == NULL)
+        return PyErr_NoMemory();
+    list = comps_doc_query_envs(((PyCOMPS*)self)->comps_doc, query);
+    comps_doc_query_destroy(query);
     ret = PyCOMPSSeq_new(&PyCOMPS_EnvsType, NULL, NULL);
     Py_TYPE(ret)->tp_init(ret, NULL, NULL);
     COMPS_OBJECT_DESTROY(((PyCOMPS_Sequence*)ret)->list);
@@ -747,6 +897,21 @@ PyDoc_STRVAR(PyCOMPS_fromxml_str__doc__,
              "          0 if parsing ended without any error\n"
              ":raises libcomps.ParserError: if some fatal error "
              "occured during parsing\n");
+PyDoc_STRVAR(PyCOMPS_tojson_str__doc__,
+             "tojson_str()->str\n"
+             "Generate json representation of Comps object and return it as "
+             "string\n\n"
+             ":return: string containing json output");
+PyDoc_STRVAR(PyCOMPS_fromjson_str__doc__,
+             "fromjson_str(json_str)->int\n"
+             "Load COMPS from json string produced by "
+             ":py:meth:`Comps.tojson_str`\n"
+             "\n"
+             ":param str json_str: string containing comps json representation\n"
+             "\n"
+             ":returns: 1 if some non-fatal error occured during parsing\n\n"
+             "          0 if parsing ended without any error\n"
+             ":raises libcomps.ParserError: if json_str isn't valid json\n");
 PyDoc_STRVAR(PyCOMPS_fromxml_f__doc__,
              "fromxml_f(fname, [def_options])->int\n"
              "Load COMPS from xml file\n"
@@ -794,6 +959,10 @@ static PyMethodDef PyCOMPS_methods[] = {
     PyCOMPS_fromxml_f__doc__},
     {"fromxml_str", (PyCFunction)PyCOMPS_fromxml_str, METH_VARARGS | METH_KEYWORDS,
     PyCOMPS_fromxml_str__doc__},
+    {"tojson_str", (PyCFunction)PyCOMPS_tojson_str, METH_NOARGS,
+    PyCOMPS_tojson_str__doc__},
+    {"fromjson_str", (PyCFunction)PyCOMPS_fromjson_str, METH_VARARGS,
+    PyCOMPS_fromjson_str__doc__},
     {"clear", (PyCFunction)PyCOMPS_clear, METH_NOARGS,
     "Clear Comps"},
     {"get_last_errors", (PyCFunction)PyCOMPS_get_last_errors,
@@ -851,11 +1020,18 @@ static PyObject* PyCOMPS_union(PyObject *self, PyObject *other) {
         return NULL;
     }
 
-    PyCOMPS *self_t = (PyCOMPS *)self;
-    PyCOMPS *other_t = (PyCOMPS *)other;
-
-    COMPS_Doc *un_comps = comps_doc_union(self_t->comps_doc,
-                                          other_t->comps_doc);
+    COMPS_Doc *un_comps;
+    COMPS_Doc *self_doc = (COMPS_Doc*)comps_object_incref(
+                                   (COMPS_Object*)((PyCOMPS*)self)->comps_doc);
+    COMPS_Doc *other_doc = (COMPS_Doc*)comps_object_incref(
+                                  (COMPS_Object*)((PyCOMPS*)other)->comps_doc);
+    __pycomps_doc_sections(self_doc);
+    __pycomps_doc_sections(other_doc);
+    Py_BEGIN_ALLOW_THREADS
+    un_comps = comps_doc_union(self_doc, other_doc);
+    Py_END_ALLOW_THREADS
+    COMPS_OBJECT_DESTROY(self_doc);
+    COMPS_OBJECT_DESTROY(other_doc);
     res = (PyCOMPS*)PyCOMPS_new(&PyCOMPS_Type, NULL, NULL);
     PyCOMPS_init(res, NULL, NULL);
     COMPS_OBJECT_DESTROY(res->comps_doc);
@@ -1000,6 +1176,8 @@ PyMODINIT_FUNC
 PyInit__libpycomps(void)
 {
     PyObject *m;
+    /* libxml2 has to be initialized before threads without GIL use it */
+    xmlInitParser();
     PyCOMPS_GroupType.tp_new = PyCOMPSGroup_new;
     PyCOMPS_Type.tp_new = PyCOMPS_new;
     if (PyType_Ready(&PyCOMPS_Type) < 0) {
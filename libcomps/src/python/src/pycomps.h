@@ -24,6 +24,8 @@
 #include <fnmatch.h>
 
 #include "libcomps/comps_doc.h"
+#include "libcomps/comps_docindex.h"
+#include "libcomps/comps_json.h"
 #include "libcomps/comps_parse.h"
 #include "libcomps/comps_dict.h"
 #include "libcomps/comps_log.h"
@@ -78,7 +80,14 @@ PyCOMPS_GetSetClosure * get_closure(void * closure);
 extern PyTypeObject PyCOMPS_Type;
 
 const char PYCOMPS_DOCU[] = "Comps class is representating comps.xml file"
-" represented in structure form.";
+" represented in structure form.\n\n"
+"Loading from and output to xml or json, union and arch_filter release GIL,"
+" so they run in parallel when called from several threads, also on the same"
+" Comps object. Output with fragment_cache xml option keeps GIL, because it"
+" updates caches kept in groups, categories and environments. Each output"
+" call collects its own log messages and adds them to the log of Comps"
+" object when it finishes. Comps object and its content mustn't be modified"
+" by other thread during these calls.";
 
 
 static PyObject* PyCOMPS_new(PyTypeObject *type, PyObject *args, PyObject *kwds);
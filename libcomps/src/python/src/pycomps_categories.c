@@ -295,6 +295,8 @@ PyCOMPS_ItemInfo PyCOMPS_CatsInfo = {
     .out_convert_func = &comps_cats_out,
     .item_types_len = 1,
     .props_offset = offsetof(COMPS_DocCategory, properties),
+    .id_getter = &__comps_doccategory_id_x,
+    .props_getter = &__comps_doccategory_props_x,
     .pre_checker = &pycomps_category_validate
 };
 
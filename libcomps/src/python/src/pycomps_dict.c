@@ -20,20 +20,21 @@
 #include <Python.h>
 #include "pycomps_dict.h"
 
-PyObject* __pycomps_dict_val_out(COMPS_HSListItem *hsit) {
-    char *str = comps_object_tostr((COMPS_Object*)hsit->data);
+PyObject* __pycomps_dict_val_out(const char *key, COMPS_Object *data) {
+    char *str = comps_object_tostr(data);
     PyObject *ret;
+    (void)key;
     ret = PyUnicode_FromString(str);
     free(str);
     return ret;
 }
 
-PyObject* __pycomps_dict_pair_out(COMPS_HSListItem *hsit) {
+PyObject* __pycomps_dict_pair_out(const char *ckey, COMPS_Object *data) {
     PyObject *key, *val, *tuple;
     char *x;
 
-    key = PyUnicode_FromString((char*) ((COMPS_ObjRTreePair*)hsit->data)->key);
-    x = comps_object_tostr(((COMPS_ObjRTreePair*)hsit->data)->data);
+    key = PyUnicode_FromString(ckey);
+    x = comps_object_tostr(data);
     val = PyUnicode_FromString(x);
     free(x);
     tuple = PyTuple_Pack(2, key, val);
@@ -251,49 +252,58 @@ int PyCOMPSDict_set(PyObject *self, PyObject *key, PyObject *val) {
 PyObject* PyCOMPSDict_keys(PyObject * self, PyObject *args) {
     (void)args;
     PyObject *ret, *item;
-    COMPS_HSList *list = comps_objrtree_keys(_DICT_->dict);
+    COMPS_ObjDictIt it;
+    const char *key;
+    COMPS_Object *data;
 
     ret = PyList_New(0);
-    for (COMPS_HSListItem *it = list->first; it != NULL; it = it->next) {
-        item = PyUnicode_FromString(it->data);
+    comps_objdict_it_init(&it, _DICT_->dict);
+    while (comps_objdict_it_next(&it, &key, &data)) {
+        item = PyUnicode_FromString(key);
         PyList_Append(ret, item);
         Py_DECREF(item);
     }
-    comps_hslist_destroy(&list);
+    comps_objdict_it_destroy(&it);
     return ret;
 }
 
 PyObject* PyCOMPSDict_values(PyObject * self, PyObject *args) {
     (void)args;
     PyObject *ret, *item;
-    COMPS_HSList *list = comps_objrtree_values(_DICT_->dict);
+    COMPS_ObjDictIt it;
+    const char *key;
+    COMPS_Object *data;
 
     ret = PyList_New(0);
-    for (COMPS_HSListItem *it = list->first; it != NULL; it = it->next) {
-        item = _INFO_->out_convert_func(it->data);
+    comps_objdict_it_init(&it, _DICT_->dict);
+    while (comps_objdict_it_next(&it, &key, &data)) {
+        item = _INFO_->out_convert_func((COMPS_Object*)data);
         PyList_Append(ret, item);
         Py_DECREF(item);
     }
-    comps_hslist_destroy(&list);
+    comps_objdict_it_destroy(&it);
     return ret;
 }
 
 PyObject* PyCOMPSDict_items(PyObject * self, PyObject *args) {
     (void)args;
     PyObject *ret, *k, *v, *tp;
-    COMPS_HSList *list = comps_objrtree_pairs(((PyCOMPS_Dict*)self)->dict);
+    COMPS_ObjDictIt it;
+    const char *key;
+    COMPS_Object *data;
 
     ret = PyList_New(0);
-    for (COMPS_HSListItem *it = list->first; it != NULL; it = it->next) {
-        k = PyUnicode_FromString(((COMPS_ObjRTreePair*)it->data)->key);
-        v = _INFO_->out_convert_func(((COMPS_ObjRTreePair*)it->data)->data);
+    comps_objdict_it_init(&it, _DICT_->dict);
+    while (comps_objdict_it_next(&it, &key, &data)) {
+        k = PyUnicode_FromString(key);
+        v = _INFO_->out_convert_func((COMPS_Object*)data);
         tp = PyTuple_Pack(2, k, v);
         Py_DECREF(k);
         Py_DECREF(v);
         PyList_Append(ret, tp);
         Py_DECREF(tp);
     }
-    comps_hslist_destroy(&list);
+    comps_objdict_it_destroy(&it);
     return ret;
 }
 #undef _DICT_
@@ -315,40 +325,34 @@ PyObject* PyCOMPSDict_has_key(PyObject * self, PyObject *key) {
         Py_RETURN_TRUE;
 }
 
-PyObject* PyCOMPSDict_getiter(PyObject *self) {
-    PyObject *res;
-    res = PyCOMPSDictIter_new(&PyCOMPS_DictIterType, NULL, NULL);
-    PyCOMPSDictIter_init((PyCOMPS_DictIter*)res, NULL, NULL);
-    ((PyCOMPS_DictIter*)res)->hslist = comps_objdict_keys(((PyCOMPS_Dict*)self)->dict);
-    ((PyCOMPS_DictIter*)res)->hsit = ((PyCOMPS_DictIter*)res)->hslist->first;
-    ((PyCOMPS_DictIter*)res)->out_func = &__pycomps_dict_key_out;
+static PyObject* __pycomps_dict_iter_new(PyObject *self,
+                  PyObject* (*out_func)(const char *key, COMPS_Object *data)) {
+    PyCOMPS_DictIter *res;
+    res = (PyCOMPS_DictIter*)PyCOMPSDictIter_new(&PyCOMPS_DictIterType,
+                                                 NULL, NULL);
+    if (res == NULL)
+        return NULL;
+    PyCOMPSDictIter_init(res, NULL, NULL);
+    res->dict = (COMPS_ObjDict*)comps_object_incref(
+                                   (COMPS_Object*)((PyCOMPS_Dict*)self)->dict);
+    res->version = res->dict->keys_version;
+    comps_objdict_it_init(&res->it, res->dict);
+    res->out_func = out_func;
     Py_INCREF(self);  /* Hold reference to source dictionary */
-    ((PyCOMPS_DictIter*)res)->source_dict = self;
-    return res;
+    res->source_dict = self;
+    return (PyObject*)res;
+}
+
+PyObject* PyCOMPSDict_getiter(PyObject *self) {
+    return __pycomps_dict_iter_new(self, &__pycomps_dict_key_out);
 }
 
 PyObject* PyCOMPSDict_getiteritems(PyObject *self) {
-    PyObject *res;
-    res = PyCOMPSDictIter_new(&PyCOMPS_DictIterType, NULL, NULL);
-    PyCOMPSDictIter_init((PyCOMPS_DictIter*)res, NULL, NULL);
-    ((PyCOMPS_DictIter*)res)->hslist = comps_objdict_pairs(((PyCOMPS_Dict*)self)->dict);
-    ((PyCOMPS_DictIter*)res)->hsit = ((PyCOMPS_DictIter*)res)->hslist->first;
-    ((PyCOMPS_DictIter*)res)->out_func = &__pycomps_dict_pair_out;
-    Py_INCREF(self);  /* Hold reference to source dictionary */
-    ((PyCOMPS_DictIter*)res)->source_dict = self;
-    return res;
+    return __pycomps_dict_iter_new(self, &__pycomps_dict_pair_out);
 }
 
 PyObject* PyCOMPSDict_getitervalues(PyObject *self) {
-    PyObject *res;
-    res = PyCOMPSDictIter_new(&PyCOMPS_DictIterType, NULL, NULL);
-    PyCOMPSDictIter_init((PyCOMPS_DictIter*)res, NULL, NULL);
-    ((PyCOMPS_DictIter*)res)->hslist = comps_objdict_values(((PyCOMPS_Dict*)self)->dict);
-    ((PyCOMPS_DictIter*)res)->hsit = ((PyCOMPS_DictIter*)res)->hslist->first;
-    ((PyCOMPS_DictIter*)res)->out_func = &__pycomps_dict_val_out;
-    Py_INCREF(self);  /* Hold reference to source dictionary */
-    ((PyCOMPS_DictIter*)res)->source_dict = self;
-    return res;
+    return __pycomps_dict_iter_new(self, &__pycomps_dict_val_out);
 }
 
 PyMappingMethods PyCOMPSDict_mapping = {
@@ -460,30 +464,36 @@ PyObject* PyCOMPSDictIter_new(PyTypeObject *type, PyObject *args, PyObject *kwds
     (void)kwds;
     PyCOMPS_DictIter *self;
     self = (PyCOMPS_DictIter*)type->tp_alloc(type, 0);
-    self->hslist = NULL;
-    self->hsit = NULL;
+    if (self == NULL)
+        return NULL;
+    self->dict = NULL;
     self->source_dict = NULL;
     return (PyObject*) self;
 }
 
 void PyCOMPSDictIter_dealloc(PyCOMPS_DictIter *self)
 {
-    comps_hslist_destroy(&self->hslist);
-    COMPS_OBJECT_DESTROY(self->objlist);
+    if (self->dict) {
+        comps_objdict_it_destroy(&self->it);
+        COMPS_OBJECT_DESTROY(self->dict);
+    }
     Py_XDECREF(self->source_dict);  /* Release reference to source dictionary */
     Py_TYPE(self)->tp_free((PyObject*)self);
 }
 
 PyObject* PyCOMPSDict_iternext(PyObject *iter_o) {
-    void *ret;
-    PyObject *retp;
+    const char *key;
+    COMPS_Object *data;
     PyCOMPS_DictIter *iter = ((PyCOMPS_DictIter*)iter_o);
-    ret = iter->hsit?iter->hsit->data: NULL;
-    if (ret) {
-        retp = iter->out_func(iter->hsit);
-        iter->hsit = iter->hsit->next;
-        return retp;
+    if (iter->dict == NULL)
+        return NULL;
+    if (iter->dict->keys_version != iter->version) {
+        PyErr_SetString(PyExc_RuntimeError,
+                        "dictionary changed during iteration");
+        return NULL;
     }
+    if (comps_objdict_it_next(&iter->it, &key, &data))
+        return iter->out_func(key, (COMPS_Object*)data);
     return NULL;
 }
 
@@ -491,10 +501,7 @@ int PyCOMPSDictIter_init(PyCOMPS_DictIter *self, PyObject *args, PyObject *kwds)
 {
     (void)args;
     (void)kwds;
-    self->hsit = NULL;
-    self->hslist = NULL;
-    self->objlist = NULL;
-    self->it = NULL;
+    self->dict = NULL;
     self->source_dict = NULL;
     return 0;
 }
@@ -315,6 +315,8 @@ PyCOMPS_ItemInfo PyCOMPS_EnvsInfo = {
     .out_convert_func = &comps_envs_out,
     .item_types_len = 1,
     .props_offset = offsetof(COMPS_DocEnv, properties),
+    .id_getter = &__comps_docenv_id_x,
+    .props_getter = &__comps_docenv_props_x,
     .pre_checker = &pycomps_env_validate
 };
 
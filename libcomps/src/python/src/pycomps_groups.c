@@ -367,6 +367,8 @@ PyCOMPS_ItemInfo PyCOMPS_GroupsInfo = {
     .out_convert_func = &comps_groups_out,
     .item_types_len = 1,
     .props_offset = offsetof(COMPS_DocGroup, properties),
+    .id_getter = &__comps_docgroup_id_x,
+    .props_getter = &__comps_docgroup_props_x,
     .pre_checker = &pycomps_group_validate
 };
 
@@ -628,6 +630,7 @@ PyCOMPS_ItemInfo PyCOMPS_PkgsInfo = {
     .out_convert_func = &comps_pkgs_out,
     .item_types_len = 1,
     .props_offset = offsetof(COMPS_DocGroupPackage, name),
+    .id_getter = &__comps_docpackage_name_x,
     .pre_checker = &pycomps_package_validate,
 };
 
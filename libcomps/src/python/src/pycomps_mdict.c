@@ -20,26 +20,25 @@
 #include <Python.h>
 #include "pycomps_mdict.h"
 
-PyObject* __pycomps_mdict_val_out(COMPS_HSListItem *hsit) {
+PyObject* __pycomps_mdict_val_out(const char *key, COMPS_Object *data) {
     PyObject *ret;
+    (void)key;
 
     ret = PyCOMPSSeq_new(&PyCOMPS_StrSeqType, NULL, NULL);
     PyCOMPSStrSeq_init((PyCOMPS_Sequence*)ret, NULL, NULL);
     COMPS_OBJECT_DESTROY(((PyCOMPS_Sequence*)ret)->list);
-    ((PyCOMPS_Sequence*)ret)->list = (COMPS_ObjList*)comps_object_incref(
-                       (COMPS_Object*)((COMPS_ObjMRTreePair*)hsit->data)->data);
+    ((PyCOMPS_Sequence*)ret)->list = (COMPS_ObjList*)comps_object_incref(data);
     return ret;
 }
 
-PyObject* __pycomps_mdict_pair_out(COMPS_HSListItem *hsit) {
+PyObject* __pycomps_mdict_pair_out(const char *ckey, COMPS_Object *data) {
     PyObject *key, *val, *tuple;
 
-    key = PyUnicode_FromString((char*) ((COMPS_ObjRTreePair*)hsit->data)->key);
+    key = PyUnicode_FromString(ckey);
     val = PyCOMPSSeq_new(&PyCOMPS_StrSeqType, NULL, NULL);
     PyCOMPSStrSeq_init((PyCOMPS_Sequence*)val, NULL, NULL);
     COMPS_OBJECT_DESTROY(((PyCOMPS_Sequence*)val)->list);
-    ((PyCOMPS_Sequence*)val)->list = (COMPS_ObjList*)comps_object_incref(
-                       (COMPS_Object*)((COMPS_ObjMRTreePair*)hsit->data)->data);
+    ((PyCOMPS_Sequence*)val)->list = (COMPS_ObjList*)comps_object_incref(data);
     tuple = PyTuple_Pack(2, key, val);
     Py_DECREF(key);
     Py_DECREF(val);
@@ -273,49 +272,58 @@ int PyCOMPSMDict_set(PyObject *self, PyObject *key, PyObject *val) {
 PyObject* PyCOMPSMDict_keys(PyObject * self, PyObject *args) {
     (void)args;
     PyObject *ret, *item;
-    COMPS_HSList *list = comps_objmrtree_keys(_DICT_->dict);
+    COMPS_ObjMDictIt it;
+    const char *key;
+    COMPS_ObjList *data;
 
     ret = PyList_New(0);
-    for (COMPS_HSListItem *it = list->first; it != NULL; it = it->next) {
-        item = PyUnicode_FromString(it->data);
+    comps_objmdict_it_init(&it, _DICT_->dict);
+    while (comps_objmdict_it_next(&it, &key, &data)) {
+        item = PyUnicode_FromString(key);
         PyList_Append(ret, item);
         Py_DECREF(item);
     }
-    comps_hslist_destroy(&list);
+    comps_objmdict_it_destroy(&it);
     return ret;
 }
 
 PyObject* PyCOMPSMDict_values(PyObject * self, PyObject *args) {
     (void)args;
     PyObject *ret, *item;
-    COMPS_HSList *list = comps_objmrtree_values(_DICT_->dict);
+    COMPS_ObjMDictIt it;
+    const char *key;
+    COMPS_ObjList *data;
 
     ret = PyList_New(0);
-    for (COMPS_HSListItem *it = list->first; it != NULL; it = it->next) {
-        item = _INFO_->out_convert_func(it->data);
+    comps_objmdict_it_init(&it, _DICT_->dict);
+    while (comps_objmdict_it_next(&it, &key, &data)) {
+        item = _INFO_->out_convert_func((COMPS_Object*)data);
         PyList_Append(ret, item);
         Py_DECREF(item);
     }
-    comps_hslist_destroy(&list);
+    comps_objmdict_it_destroy(&it);
     return ret;
 }
 
 PyObject* PyCOMPSMDict_items(PyObject * self, PyObject *args) {
     (void)args;
     PyObject *ret, *k, *v, *tp;
-    COMPS_HSList *list = comps_objrtree_pairs(((PyCOMPS_Dict*)self)->dict);
+    COMPS_ObjMDictIt it;
+    const char *key;
+    COMPS_ObjList *data;
 
     ret = PyList_New(0);
-    for (COMPS_HSListItem *it = list->first; it != NULL; it = it->next) {
-        k = PyUnicode_FromString(((COMPS_ObjRTreePair*)it->data)->key);
-        v = _INFO_->out_convert_func(((COMPS_ObjRTreePair*)it->data)->data);
+    comps_objmdict_it_init(&it, _DICT_->dict);
+    while (comps_objmdict_it_next(&it, &key, &data)) {
+        k = PyUnicode_FromString(key);
+        v = _INFO_->out_convert_func((COMPS_Object*)data);
         tp = PyTuple_Pack(2, k, v);
         Py_DECREF(k);
         Py_DECREF(v);
         PyList_Append(ret, tp);
         Py_DECREF(tp);
     }
-    comps_hslist_destroy(&list);
+    comps_objmdict_it_destroy(&it);
     return ret;
 }
 
@@ -334,40 +342,34 @@ PyObject* PyCOMPSMDict_has_key(PyObject * self, PyObject *key) {
         Py_RETURN_TRUE;
 }
 
-PyObject* PyCOMPSMDict_getiter(PyObject *self) {
-    PyObject *res;
-    res = PyCOMPSMDictIter_new(&PyCOMPS_MDictIterType, NULL, NULL);
-    PyCOMPSMDictIter_init((PyCOMPS_MDictIter*)res, NULL, NULL);
-    ((PyCOMPS_MDictIter*)res)->hslist = comps_objmdict_keys(((PyCOMPS_MDict*)self)->dict);
-    ((PyCOMPS_MDictIter*)res)->hsit = ((PyCOMPS_MDictIter*)res)->hslist->first;
-    ((PyCOMPS_MDictIter*)res)->out_func = &__pycomps_dict_key_out;
+static PyObject* __pycomps_mdict_iter_new(PyObject *self,
+                  PyObject* (*out_func)(const char *key, COMPS_Object *data)) {
+    PyCOMPS_MDictIter *res;
+    res = (PyCOMPS_MDictIter*)PyCOMPSMDictIter_new(&PyCOMPS_MDictIterType,
+                                                 NULL, NULL);
+    if (res == NULL)
+        return NULL;
+    PyCOMPSMDictIter_init(res, NULL, NULL);
+    res->dict = (COMPS_ObjMDict*)comps_object_incref(
+                                   (COMPS_Object*)((PyCOMPS_MDict*)self)->dict);
+    res->version = res->dict->version;
+    comps_objmdict_it_init(&res->it, res->dict);
+    res->out_func = out_func;
     Py_INCREF(self);  /* Hold reference to source dictionary */
-    ((PyCOMPS_MDictIter*)res)->source_dict = self;
-    return res;
+    res->source_dict = self;
+    return (PyObject*)res;
+}
+
+PyObject* PyCOMPSMDict_getiter(PyObject *self) {
+    return __pycomps_mdict_iter_new(self, &__pycomps_dict_key_out);
 }
 
 PyObject* PyCOMPSMDict_getiteritems(PyObject *self) {
-    PyObject *res;
-    res = PyCOMPSMDictIter_new(&PyCOMPS_MDictIterType, NULL, NULL);
-    PyCOMPSMDictIter_init((PyCOMPS_MDictIter*)res, NULL, NULL);
-    ((PyCOMPS_MDictIter*)res)->hslist = comps_objmdict_pairs(((PyCOMPS_MDict*)self)->dict);
-    ((PyCOMPS_MDictIter*)res)->hsit = ((PyCOMPS_MDictIter*)res)->hslist->first;
-    ((PyCOMPS_MDictIter*)res)->out_func = &__pycomps_mdict_pair_out;
-    Py_INCREF(self);  /* Hold reference to source dictionary */
-    ((PyCOMPS_MDictIter*)res)->source_dict = self;
-    return res;
+    return __pycomps_mdict_iter_new(self, &__pycomps_mdict_pair_out);
 }
 
 PyObject* PyCOMPSMDict_getitervalues(PyObject *self) {
-    PyObject *res;
-    res = PyCOMPSMDictIter_new(&PyCOMPS_MDictIterType, NULL, NULL);
-    PyCOMPSMDictIter_init((PyCOMPS_MDictIter*)res, NULL, NULL);
-    ((PyCOMPS_MDictIter*)res)->hslist = comps_objmdict_values(((PyCOMPS_MDict*)self)->dict);
-    ((PyCOMPS_MDictIter*)res)->hsit = ((PyCOMPS_MDictIter*)res)->hslist->first;
-    ((PyCOMPS_MDictIter*)res)->out_func = &__pycomps_mdict_val_out;
-    Py_INCREF(self);  /* Hold reference to source dictionary */
-    ((PyCOMPS_MDictIter*)res)->source_dict = self;
-    return res;
+    return __pycomps_mdict_iter_new(self, &__pycomps_mdict_val_out);
 }
 
 PyMappingMethods PyCOMPSMDict_mapping = {
@@ -524,30 +526,36 @@ PyObject* PyCOMPSMDictIter_new(PyTypeObject *type, PyObject *args, PyObject *kwd
     (void)kwds;
     PyCOMPS_MDictIter *self;
     self = (PyCOMPS_MDictIter*)type->tp_alloc(type, 0);
-    self->hslist = NULL;
-    self->hsit = NULL;
+    if (self == NULL)
+        return NULL;
+    self->dict = NULL;
     self->source_dict = NULL;
     return (PyObject*) self;
 }
 
 void PyCOMPSMDictIter_dealloc(PyCOMPS_MDictIter *self)
 {
-    comps_hslist_destroy(&self->hslist);
-    COMPS_OBJECT_DESTROY(self->objlist);
+    if (self->dict) {
+        comps_objmdict_it_destroy(&self->it);
+        COMPS_OBJECT_DESTROY(self->dict);
+    }
     Py_XDECREF(self->source_dict);  /* Release reference to source dictionary */
     Py_TYPE(self)->tp_free((PyObject*)self);
 }
 
 PyObject* PyCOMPSMDict_iternext(PyObject *iter_o) {
-    void *ret;
-    PyObject *retp;
+    const char *key;
+    COMPS_ObjList *data;
     PyCOMPS_MDictIter *iter = ((PyCOMPS_MDictIter*)iter_o);
-    ret = iter->hsit?iter->hsit->data: NULL;
-    if (ret) {
-        retp = iter->out_func(iter->hsit);
-        iter->hsit = iter->hsit->next;
-        return retp;
+    if (iter->dict == NULL)
+        return NULL;
+    if (iter->dict->version != iter->version) {
+        PyErr_SetString(PyExc_RuntimeError,
+                        "dictionary changed during iteration");
+        return NULL;
     }
+    if (comps_objmdict_it_next(&iter->it, &key, &data))
+        return iter->out_func(key, (COMPS_Object*)data);
     return NULL;
 }
 
@@ -555,10 +563,7 @@ int PyCOMPSMDictIter_init(PyCOMPS_MDictIter *self, PyObject *args, PyObject *kwd
 {
     (void)args;
     (void)kwds;
-    self->hsit = NULL;
-    self->hslist = NULL;
-    self->objlist = NULL;
-    self->it = NULL;
+    self->dict = NULL;
     self->source_dict = NULL;
     return 0;
 }
@@ -51,7 +51,7 @@ inline PyObject* list_getitem_byid(PyObject *self, PyObject *id) {
     #define _seq_ ((PyCOMPS_Sequence*)self)
     char *strid=NULL;
     COMPS_ObjListIt *it;
-    COMPS_Object *props, *oid;
+    COMPS_Object *props, *oid, *obj;
     PyObject *ret = NULL;
     COMPS_Object *tmpstr;
 
@@ -63,21 +63,30 @@ inline PyObject* list_getitem_byid(PyObject *self, PyObject *id) {
     } else if (PyBytes_Check(id)){
         strid = PyBytes_AsString(id);
     }
-    tmpstr = (COMPS_Object*)comps_str(strid);
-    for (it = ((PyCOMPS_Sequence*)self)->list->first; it != NULL;
-         it = it->next) {
-        props = (COMPS_Object*)GET_FROM(it->comps_obj,
-                                         _seq_->it_info->props_offset);
-        if (props->obj_info == &COMPS_ObjDict_ObjInfo) {
-            oid = comps_objdict_get_x((COMPS_ObjDict*)props, "id");
-        } else {
-            oid = props;
+    if (_seq_->it_info->id_getter) {
+        obj = comps_objlist_find_by_x(_seq_->list, _seq_->it_info->id_getter,
+                                      _seq_->it_info->props_getter, strid);
+        if (obj) {
+            comps_object_incref(obj);
+            ret = _seq_->it_info->out_convert_func(obj);
         }
-        if (comps_object_cmp(oid, tmpstr)) {
-            comps_object_incref(it->comps_obj);
-            ret = ((PyCOMPS_Sequence*)self)->it_info->out_convert_func(it->comps_obj);
-            break;
+    } else {
+        tmpstr = (COMPS_Object*)comps_str(strid);
+        for (it = _seq_->list->first; it != NULL; it = it->next) {
+            props = (COMPS_Object*)GET_FROM(it->comps_obj,
+                                             _seq_->it_info->props_offset);
+            if (props->obj_info == &COMPS_ObjDict_ObjInfo) {
+                oid = comps_objdict_get_x((COMPS_ObjDict*)props, "id");
+            } else {
+                oid = props;
+            }
+            if (comps_object_cmp(oid, tmpstr)) {
+                comps_object_incref(it->comps_obj);
+                ret = ((PyCOMPS_Sequence*)self)->it_info->out_convert_func(it->comps_obj);
+                break;
+            }
         }
+        COMPS_OBJECT_DESTROY(tmpstr);
     }
     if (!ret) {
         PyErr_Format(PyExc_KeyError, "Object with id '%s' is not in list", strid);
@@ -85,7 +94,6 @@ inline PyObject* list_getitem_byid(PyObject *self, PyObject *id) {
     if (PyUnicode_Check(id)) {
         free(strid);
     }
-    COMPS_OBJECT_DESTROY(tmpstr);
     return ret;
     #undef _seq_
 }
@@ -349,6 +357,7 @@ int list_set_slice(PyObject *self, PyObject *key, PyObject *val) {
                     }
                     COMPS_OBJECT_DESTROY(it->comps_obj);
                     it->comps_obj = comps_object_incref(it2->comps_obj);
+                    _seq_->list->version++;
                     clen += 1;
                     it2 = it2->next;
                     for (i=0 ; i<istep && it != NULL; it=it->next,  i++);
@@ -363,6 +372,7 @@ int list_set_slice(PyObject *self, PyObject *key, PyObject *val) {
                        it2 = it2->next, it = it->next, i++) {
                     COMPS_OBJECT_DESTROY(it->comps_obj);
                     it->comps_obj = comps_object_incref(it2->comps_obj);
+                    _seq_->list->version++;
                 }
                 if (it == NULL) {
                     for (;it2 != NULL; it2 = it2->next) {
@@ -33,6 +33,11 @@ typedef struct PyCOMPS_ItemInfo {
     int (*pre_checker)(COMPS_Object*);
     unsigned item_types_len;
     size_t props_offset;
+    /* id of item without incref, when set items are looked up by id through
+     * list index */
+    COMPS_Object* (*id_getter)(COMPS_Object*);
+    /* properties dict id_getter reads id from, NULL if it reads a field */
+    COMPS_Object* (*props_getter)(COMPS_Object*);
 } PyCOMPS_ItemInfo;
 
 typedef struct PyCOMPS_Sequence {
@@ -61,21 +66,19 @@ typedef struct PyCOMPS_MDict {
 
 typedef struct PyCOMPS_DictIter{
     PyObject_HEAD
-    COMPS_ObjListIt *it;
-    COMPS_HSListItem *hsit;
-    COMPS_ObjList *objlist;
-    COMPS_HSList *hslist;
-    PyObject* (*out_func)(COMPS_HSListItem *hsit);
+    COMPS_ObjDictIt it;
+    COMPS_ObjDict *dict;
+    unsigned int version;
+    PyObject* (*out_func)(const char *key, COMPS_Object *data);
     PyObject* source_dict;
 } PyCOMPS_DictIter;
 
 typedef struct PyCOMPS_MDictIter{
     PyObject_HEAD
-    COMPS_ObjListIt *it;
-    COMPS_HSListItem *hsit;
-    COMPS_ObjList *objlist;
-    COMPS_HSList *hslist;
-    PyObject* (*out_func)(COMPS_HSListItem *hsit);
+    COMPS_ObjMDictIt it;
+    COMPS_ObjMDict *dict;
+    unsigned int version;
+    PyObject* (*out_func)(const char *key, COMPS_Object *data);
     PyObject* source_dict;
 } PyCOMPS_MDictIter;
 
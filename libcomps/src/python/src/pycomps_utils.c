@@ -23,8 +23,9 @@
 
 #include "pycomps_utils.h"
 
-PyObject* __pycomps_dict_key_out(COMPS_HSListItem *hsit) {
-    return PyUnicode_FromString((char*)hsit->data);
+PyObject* __pycomps_dict_key_out(const char *key, COMPS_Object *data) {
+    (void)data;
+    return PyUnicode_FromString(key);
 }
 
 COMPS_Object* __pycomps_unicode_in(PyObject *obj) {
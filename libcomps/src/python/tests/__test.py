@@ -29,6 +29,8 @@ import tempfile
 import os
 import traceback
 import inspect
+import json
+import threading
 
 import utest
 
@@ -498,6 +500,16 @@ class BaseListTestClass(object):
             index += 1
         self.assertRaises(KeyError, listobj1.__getitem__, "notid")
 
+        # lookup follows changes of list and of item ids
+        key = self.items_data[1][attr]
+        setattr(listobj1[1], attr, "renamed")
+        self.assertRaises(KeyError, listobj1.__getitem__, key)
+        self.assertTrue(listobj1["renamed"] == listobj1[1])
+        del listobj1[1]
+        self.assertRaises(KeyError, listobj1.__getitem__, "renamed")
+        listobj1.append(self.item_type(**self.items_data[1]))
+        self.assertTrue(listobj1[key] == listobj1[-1])
+
 #@unittest.skip(" ")
 class CategoryList_Test(unittest.TestCase, BaseListTestClass):
     list_type = libcomps.CategoryList
@@ -655,6 +667,20 @@ class DictTest(unittest.TestCase):
             _values.append(v)
         self.assertTrue(set(_values) == set(_values2))
 
+    def test_modify_during_iteration(self):
+        _dict = libcomps.StrDict()
+        _dict["cs"] = "Ahoj svete"
+        _dict["en"] = "Hello world"
+        for k in _dict:
+            _dict[k] = k.upper()
+        self.assertTrue(_dict["cs"] == "CS")
+        self.assertTrue(_dict["en"] == "EN")
+
+        def add_key():
+            for k in _dict:
+                _dict[k + "x"] = k
+        self.assertRaises(RuntimeError, add_key)
+
     def test_keyerror(self):
         _dict = libcomps.StrDict()
         self.assertTrue(_dict.get("notindict") == None)
@@ -769,6 +795,98 @@ class COMPSTest(unittest.TestCase):
         comps2.fromxml_f("fed2.xml")
         self.assertTrue(comps == comps2)
 
+    def test_fragment_cache(self):
+        comps = libcomps.Comps()
+        comps.fromxml_f("comps/fedora_comps.xml")
+        cached = {"fragment_cache": True}
+        s = comps.toxml_str()
+        self.assertEqual(comps.toxml_str(xml_options=cached), s)
+        self.assertEqual(comps.toxml_str(xml_options=cached), s)
+        comps.groups[0].name = "Changed"
+        comps.groups[1].packages.append(libcomps.Package("added"))
+        s = comps.toxml_str()
+        self.assertTrue("added" in s)
+        self.assertEqual(comps.toxml_str(xml_options=cached), s)
+        cached["arch_output"] = True
+        self.assertEqual(comps.toxml_str(xml_options=cached),
+                         comps.toxml_str(xml_options={"arch_output": True}))
+
+    def test_json(self):
+        comps = libcomps.Comps()
+        comps.fromxml_f("comps/fedora_comps.xml")
+        s = comps.tojson_str()
+        data = json.loads(s)
+        self.assertEqual(len(data["groups"]), len(comps.groups))
+        self.assertEqual(data["groups"][0]["id"], comps.groups[0].id)
+        comps2 = libcomps.Comps()
+        self.assertEqual(comps2.fromjson_str(s), 0)
+        self.assertTrue(comps == comps2)
+        self.assertEqual(comps2.toxml_str(), comps.toxml_str())
+        self.assertEqual(comps2.fromjson_str('{"groups": [], "x": 1}'), 1)
+        self.assertEqual(len(comps2.groups), 0)
+        self.assertRaises(libcomps.ParserError, comps2.fromjson_str, '{"groups"')
+
+    def test_threads(self):
+        with open("comps/fedora_comps.xml") as f:
+            xml = f.read()
+        shared = libcomps.Comps()
+        shared.fromxml_f("comps/main_comps2.xml")
+        expected = libcomps.Comps()
+        expected.fromxml_str(xml)
+        expected = ((expected + shared).arch_filter(["x86_64"]).xml_str(),
+                    expected.tojson_str())
+        results = []
+
+        def work():
+            comps = libcomps.Comps()
+            comps.fromxml_str(xml)
+            for i in range(3):
+                res = ((comps + shared).arch_filter(["x86_64"]).xml_str(),
+                       comps.tojson_str())
+            results.append(res)
+
+        threads = [threading.Thread(target=work) for i in range(4)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        self.assertEqual(len(results), 4)
+        for res in results:
+            self.assertEqual(res, expected)
+
+        # output of one changed document, also through fragment cache,
+        # each call reporting only its own log messages
+        comps = libcomps.Comps()
+        comps.fromxml_str(xml)
+        cached = {"fragment_cache": True}
+        comps.xml_str(xml_options=cached)
+        comps.groups[0].name = "Changed"
+        (h, fname) = tempfile.mkstemp()
+        os.close(h)
+        expected = (comps.xml_str(), comps.xml_str(xml_options=cached),
+                    comps.tojson_str(), comps.xml_f(fname))
+        results = []
+
+        def output():
+            (h, fname) = tempfile.mkstemp()
+            os.close(h)
+            for i in range(3):
+                res = (comps.xml_str(), comps.xml_str(xml_options=cached),
+                       comps.tojson_str(), comps.xml_f(fname))
+            os.remove(fname)
+            results.append(res)
+
+        threads = [threading.Thread(target=output) for i in range(4)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        os.remove(fname)
+        self.assertEqual(len(results), 4)
+        for res in results:
+            self.assertEqual(res, expected)
+        self.assertTrue(expected[3])
+
     #@unittest.skip("skip")
     def test_sample(self):
         comps = libcomps.Comps()
@@ -1178,6 +1296,16 @@ class COMPSTest(unittest.TestCase):
         self.assertTrue(ret != -1)
         self.assertTrue(len(comps.groups_match(id="base")) == 0)
         self.assertTrue(len(comps.groups_match(id="base-x")) == 1)
+        self.assertTrue(len(comps.groups_match(id="BASE-X")) == 0)
+        self.assertTrue(len(comps.groups_match(id="BASE-X",
+                                    flags=libcomps.MATCH_IGNORECASE)) == 1)
+        prefixed = [g.id for g in comps.groups if g.id.startswith("kde")]
+        self.assertTrue(len(prefixed) > 1)
+        self.assertEqual([g.id for g in comps.groups_match(id="kde*")],
+                         prefixed)
+        self.assertEqual([g.id for g in comps.groups_match(id="KdE*",
+                                    flags=libcomps.MATCH_IGNORECASE)],
+                         prefixed)
         self.assertTrue(len(comps.groups_match(name="base-x")) == 1)
         self.assertTrue(len(comps.groups_match(desc="Local X.org display server")) == 1)
         self.assertTrue(len(comps.groups_match(id="base-x", name="base-x")) == 1)
@@ -0,0 +1,196 @@
+/* libcomps - C alternative to yum.comps library
+ * Copyright (C) 2013 Jindrich Luza
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to  Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA
+ */
+
+/* Benchmark of byte scanning on parse path. Character data runs expat
+ * reports for bundled XML files are recorded and comps_scan_space_only is
+ * timed over them with every implementation level the CPU supports, next
+ * to the former isspace() loop. Then whole comps_parse_str is timed with
+ * every level.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <expat.h>
+
+#include "../src/comps_parse.h"
+#include "../src/comps_scan.h"
+
+#define BENCH_REPEAT 5
+#define BENCH_SCAN_LOOPS 200
+
+static const char *files[] = {"fedora_comps.xml", "f21-rawhide-comps.xml",
+                              "sample_comps.xml", "main_comps2.xml",
+                              "main_arches.xml", NULL};
+static const char *level_names[] = {"scalar", "sse2", "avx2"};
+
+typedef struct {
+    char *data;
+    size_t *offsets; /* runs[i] is data[offsets[i]..offsets[i + 1]) */
+    size_t count;
+    size_t size;
+    size_t data_len;
+} Runs;
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static char* slurp(const char *fname) {
+    FILE *fp;
+    long len;
+    char *ret;
+
+    if ((fp = fopen(fname, "r")) == NULL) {
+        fprintf(stderr, "can't open %s\n", fname);
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    ret = malloc(len + 1);
+    if (fread(ret, 1, len, fp) != (size_t)len) {
+        free(ret);
+        ret = NULL;
+    } else {
+        ret[len] = 0;
+    }
+    fclose(fp);
+    return ret;
+}
+
+static void record_run(void *userData, const XML_Char *s, int len) {
+    Runs *runs = userData;
+
+    if (runs->count + 2 > runs->size) {
+        runs->size *= 2;
+        runs->offsets = realloc(runs->offsets,
+                                sizeof(size_t) * runs->size);
+    }
+    runs->data = realloc(runs->data, runs->data_len + len);
+    memcpy(runs->data + runs->data_len, s, len);
+    runs->data_len += len;
+    runs->offsets[++runs->count] = runs->data_len;
+}
+
+/* former implementation of __comps_is_whitespace_only */
+static unsigned isspace_only(const char *s, int len) {
+    int i;
+    for (i = 0; i < len; i++) {
+        if (!isspace(s[i])) return 0;
+    }
+    return 1;
+}
+
+static double scan_runs(const Runs *runs, int use_isspace, size_t *spaces) {
+    double start, best = 0;
+    size_t i, found = 0;
+    int r, l;
+
+    for (r = 0; r < BENCH_REPEAT; r++) {
+        found = 0;
+        start = now_ms();
+        for (l = 0; l < BENCH_SCAN_LOOPS; l++) {
+            for (i = 0; i < runs->count; i++) {
+                if (use_isspace)
+                    found += isspace_only(runs->data + runs->offsets[i],
+                                          runs->offsets[i + 1]
+                                          - runs->offsets[i]);
+                else
+                    found += comps_scan_space_only(
+                                 runs->data + runs->offsets[i],
+                                 runs->offsets[i + 1] - runs->offsets[i]);
+            }
+        }
+        start = (now_ms() - start) / BENCH_SCAN_LOOPS;
+        if (r == 0 || start < best)
+            best = start;
+    }
+    *spaces = found / BENCH_SCAN_LOOPS;
+    return best;
+}
+
+static double parse(char *xml) {
+    COMPS_Parsed *parsed;
+    double start, best = 0;
+    int r;
+
+    for (r = 0; r < BENCH_REPEAT; r++) {
+        parsed = comps_parse_parsed_create();
+        comps_parse_parsed_init(parsed, "UTF-8", 0);
+        start = now_ms();
+        comps_parse_str(parsed, xml, NULL);
+        start = now_ms() - start;
+        comps_parse_parsed_destroy(parsed);
+        if (r == 0 || start < best)
+            best = start;
+    }
+    return best;
+}
+
+int main(int argc, char *argv[]) {
+    XML_Parser parser;
+    Runs runs;
+    COMPS_ScanLevel level, best_level;
+    char *xml;
+    size_t spaces;
+    int i;
+
+    (void)argc;
+    (void)argv;
+    best_level = comps_scan_level();
+    for (i = 0; files[i]; i++) {
+        if ((xml = slurp(files[i])) == NULL)
+            return 1;
+        memset(&runs, 0, sizeof(runs));
+        runs.size = 1024;
+        runs.offsets = calloc(runs.size, sizeof(size_t));
+        parser = XML_ParserCreate("UTF-8");
+        XML_SetUserData(parser, &runs);
+        XML_SetCharacterDataHandler(parser, &record_run);
+        XML_Parse(parser, xml, strlen(xml), 1);
+        XML_ParserFree(parser);
+
+        printf("%s: %zu bytes, %zu character data runs of %zu bytes\n",
+               files[i], strlen(xml), runs.count, runs.data_len);
+        printf("  scan  %-7s %9.4f ms", "isspace",
+               scan_runs(&runs, 1, &spaces));
+        printf("  (%zu whitespace only)\n", spaces);
+        for (level = COMPS_SCAN_SCALAR; level <= best_level; level++) {
+            comps_scan_set_level(level);
+            printf("  scan  %-7s %9.4f ms\n", level_names[level],
+                   scan_runs(&runs, 0, &spaces));
+        }
+        for (level = COMPS_SCAN_SCALAR; level <= best_level; level++) {
+            comps_scan_set_level(level);
+            printf("  parse %-7s %9.3f ms\n", level_names[level], parse(xml));
+        }
+        fflush(stdout);
+        free(runs.data);
+        free(runs.offsets);
+        free(xml);
+    }
+    return 0;
+}
@@ -0,0 +1,186 @@
+/* libcomps - C alternative to yum.comps library
+ * Copyright (C) 2013 Jindrich Luza
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to  Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA
+ */
+
+/* Benchmark of comps_doc_union, comps_doc_union_ex with BENCH_THREADS
+ * threads and comps_doc_unite. Merges fedora_comps.xml with
+ * f21-rawhide-comps.xml and synthetic documents made of these two files
+ * replicated 10 and 100 times (replicas get id suffix, so every replica is
+ * distinct object).
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/comps_doc.h"
+#include "../src/comps_parse.h"
+
+#define BENCH_REPEAT 5
+#define BENCH_THREADS 4
+
+/* wall clock time in ms, clock() would sum time of all threads */
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static COMPS_Doc* load(const char *fname) {
+    COMPS_Parsed *parsed;
+    COMPS_Doc *doc;
+    FILE *fp;
+
+    if ((fp = fopen(fname, "r")) == NULL) {
+        fprintf(stderr, "can't open %s\n", fname);
+        return NULL;
+    }
+    parsed = comps_parse_parsed_create();
+    comps_parse_parsed_init(parsed, "UTF-8", 0);
+    comps_parse_file(parsed, fp, NULL);
+    doc = (COMPS_Doc*)comps_object_incref((COMPS_Object*)parsed->comps_doc);
+    comps_parse_parsed_destroy(parsed);
+    return doc;
+}
+
+static char* replica_id(COMPS_ObjDict *properties, int n) {
+    COMPS_Object *id;
+    char *str, *ret;
+
+    id = comps_objdict_get_x(properties, "id");
+    str = id ? comps_object_tostr(id) : NULL;
+    if (str == NULL)
+        return NULL;
+    ret = malloc(strlen(str) + 12);
+    sprintf(ret, "%s-%d", str, n);
+    free(str);
+    return ret;
+}
+
+static COMPS_Doc* replicate(COMPS_Doc *doc, int times) {
+    COMPS_Doc *ret;
+    COMPS_ObjList *list;
+    COMPS_ObjListIt *it;
+    COMPS_DocGroup *group;
+    COMPS_DocCategory *cat;
+    COMPS_DocEnv *env;
+    char *id;
+    int i;
+
+    ret = COMPS_OBJECT_CREATE(COMPS_Doc, (COMPS_Object*[]){(COMPS_Object*)
+                                                           doc->encoding});
+    for (i = 0; i < times; i++) {
+        list = comps_doc_groups(doc);
+        for (it = list ? list->first : NULL; it; it = it->next) {
+            group = (COMPS_DocGroup*)comps_object_copy(it->comps_obj);
+            id = replica_id(group->properties, i);
+            comps_docgroup_set_id(group, id, 0);
+            free(id);
+            comps_doc_add_group(ret, group);
+        }
+        COMPS_OBJECT_DESTROY(list);
+        list = comps_doc_categories(doc);
+        for (it = list ? list->first : NULL; it; it = it->next) {
+            cat = (COMPS_DocCategory*)comps_object_copy(it->comps_obj);
+            id = replica_id(cat->properties, i);
+            comps_doccategory_set_id(cat, id, 0);
+            free(id);
+            comps_doc_add_category(ret, cat);
+        }
+        COMPS_OBJECT_DESTROY(list);
+        list = comps_doc_environments(doc);
+        for (it = list ? list->first : NULL; it; it = it->next) {
+            env = (COMPS_DocEnv*)comps_object_copy(it->comps_obj);
+            id = replica_id(env->properties, i);
+            comps_docenv_set_id(env, id, 0);
+            free(id);
+            comps_doc_add_environment(ret, env);
+        }
+        COMPS_OBJECT_DESTROY(list);
+    }
+    return ret;
+}
+
+static void bench(const char *name, COMPS_Doc *d1, COMPS_Doc *d2) {
+    COMPS_Doc *res;
+    COMPS_ObjList *groups;
+    COMPS_DocUnionOptions options = {BENCH_THREADS};
+    double start, best_union, best_ex, best_unite;
+    int i;
+    size_t len = 0;
+
+    best_union = best_ex = best_unite = 0;
+    for (i = 0; i < BENCH_REPEAT; i++) {
+        start = now_ms();
+        res = comps_doc_union(d1, d2);
+        start = now_ms() - start;
+        if (i == 0 || start < best_union)
+            best_union = start;
+        groups = comps_doc_groups(res);
+        len = groups ? groups->len : 0;
+        COMPS_OBJECT_DESTROY(groups);
+        COMPS_OBJECT_DESTROY(res);
+
+        start = now_ms();
+        res = comps_doc_union_ex(d1, d2, &options);
+        start = now_ms() - start;
+        if (i == 0 || start < best_ex)
+            best_ex = start;
+        COMPS_OBJECT_DESTROY(res);
+
+        res = (COMPS_Doc*)comps_object_copy((COMPS_Object*)d1);
+        start = now_ms();
+        comps_doc_unite(res, d2);
+        start = now_ms() - start;
+        if (i == 0 || start < best_unite)
+            best_unite = start;
+        COMPS_OBJECT_DESTROY(res);
+    }
+    printf("%-8s %8zu groups  union %10.3f ms  union_ex(%d) %10.3f ms"
+           "  unite %10.3f ms\n", name, len, best_union, BENCH_THREADS,
+           best_ex, best_unite);
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[]) {
+    COMPS_Doc *d1, *d2, *r1, *r2;
+    int scales[] = {10, 100};
+    char name[16];
+    unsigned i;
+
+    (void)argc;
+    (void)argv;
+    d1 = load("fedora_comps.xml");
+    d2 = load("f21-rawhide-comps.xml");
+    if (d1 == NULL || d2 == NULL)
+        return 1;
+    bench("1x", d1, d2);
+    for (i = 0; i < sizeof(scales) / sizeof(scales[0]); i++) {
+        r1 = replicate(d1, scales[i]);
+        r2 = replicate(d2, scales[i]);
+        sprintf(name, "%dx", scales[i]);
+        bench(name, r1, r2);
+        COMPS_OBJECT_DESTROY(r1);
+        COMPS_OBJECT_DESTROY(r2);
+    }
+    COMPS_OBJECT_DESTROY(d1);
+    COMPS_OBJECT_DESTROY(d2);
+    return 0;
+}
@@ -0,0 +1,94 @@
+/* libcomps - C alternative to yum.comps library
+ * Copyright (C) 2013 Jindrich Luza
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to  Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA
+ */
+
+/* Benchmark of XML serialization. Serializes fedora_comps.xml with
+ * comps2xml_str and default options, with every implementation level of
+ * scanning for characters which need escaping the CPU supports.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/comps_doc.h"
+#include "../src/comps_parse.h"
+#include "../src/comps_scan.h"
+
+#define BENCH_REPEAT 10
+
+static const char *level_names[] = {"scalar", "sse2", "avx2"};
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static COMPS_Doc* load(const char *fname) {
+    COMPS_Parsed *parsed;
+    COMPS_Doc *doc;
+    FILE *fp;
+
+    if ((fp = fopen(fname, "r")) == NULL) {
+        fprintf(stderr, "can't open %s\n", fname);
+        return NULL;
+    }
+    parsed = comps_parse_parsed_create();
+    comps_parse_parsed_init(parsed, "UTF-8", 0);
+    comps_parse_file(parsed, fp, NULL);
+    doc = (COMPS_Doc*)comps_object_incref((COMPS_Object*)parsed->comps_doc);
+    comps_parse_parsed_destroy(parsed);
+    return doc;
+}
+
+int main(int argc, char *argv[]) {
+    COMPS_Doc *doc;
+    COMPS_ScanLevel level, best_level;
+    double start, elapsed, best;
+    size_t len = 0;
+    char *xml;
+    int r;
+
+    (void)argc;
+    (void)argv;
+    if ((doc = load("fedora_comps.xml")) == NULL)
+        return 1;
+    best_level = comps_scan_level();
+    for (level = COMPS_SCAN_SCALAR; level <= best_level; level++) {
+        comps_scan_set_level(level);
+        best = 0;
+        for (r = 0; r < BENCH_REPEAT; r++) {
+            start = now_ms();
+            xml = comps2xml_str(doc, NULL, NULL);
+            elapsed = now_ms() - start;
+            len = strlen(xml);
+            free(xml);
+            if (r == 0 || elapsed < best)
+                best = elapsed;
+        }
+        printf("comps2xml_str %-7s %8.3f ms (%zu bytes)\n",
+               level_names[level], best, len);
+    }
+    comps_scan_set_level(best_level);
+    COMPS_OBJECT_DESTROY(doc);
+    return 0;
+}
@@ -18,9 +18,17 @@
  */
 
 #include <check.h>
+#include <fcntl.h>
+#include <fnmatch.h>
 #include <stdio.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <zlib.h>
 
 #include "../src/comps_doc.h"
+#include "../src/comps_docdiff.h"
+#include "../src/comps_docindex.h"
+#include "../src/comps_json.h"
 #include "../src/comps_parse.h"
 #include "../src/comps_validate.h"
 
@@ -568,6 +576,1270 @@ START_TEST(test_comps_doc_union)
     COMPS_OBJECT_DESTROY(doc3);
 }END_TEST
 
+START_TEST(test_comps_doc_union_many)
+{
+    COMPS_Parsed *parsed;
+    COMPS_Doc *docs[4], *folded, *tmp, *many;
+    FILE *fp;
+    char *files[] = {"sample_comps.xml", "f21-rawhide-comps.xml",
+                     "fedora_comps.xml", "sample_comps.xml"};
+    char *str1, *str2;
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        parsed = comps_parse_parsed_create();
+        fail_if(comps_parse_parsed_init(parsed, "UTF-8", 0) == 0);
+        fp = fopen(files[i], "r");
+        comps_parse_file(parsed, fp, NULL);
+        docs[i] = parsed->comps_doc;
+        parsed->comps_doc = NULL;
+        comps_parse_parsed_destroy(parsed);
+    }
+    folded = comps_doc_union(docs[0], docs[1]);
+    for (i = 2; i < 4; i++) {
+        tmp = comps_doc_union(folded, docs[i]);
+        COMPS_OBJECT_DESTROY(folded);
+        folded = tmp;
+    }
+    many = comps_doc_union_many(docs, 4);
+    str1 = comps2xml_str(folded, NULL, NULL);
+    str2 = comps2xml_str(many, NULL, NULL);
+    fail_if(strcmp(str1, str2) != 0,
+            "comps_doc_union_many differs from pairwise union");
+    free(str1);
+    free(str2);
+    COMPS_OBJECT_DESTROY(folded);
+    COMPS_OBJECT_DESTROY(many);
+
+    fail_if(comps_doc_union_many(docs, 0) != NULL);
+    for (i = 0; i < 4; i++)
+        COMPS_OBJECT_DESTROY(docs[i]);
+}END_TEST
+
+static COMPS_Doc* load_doc(char *fname) {
+    COMPS_Parsed *parsed;
+    COMPS_Doc *doc;
+    FILE *fp;
+
+    parsed = comps_parse_parsed_create();
+    comps_parse_parsed_init(parsed, "UTF-8", 0);
+    fp = fopen(fname, "r");
+    comps_parse_file(parsed, fp, NULL);
+    doc = parsed->comps_doc;
+    parsed->comps_doc = NULL;
+    comps_parse_parsed_destroy(parsed);
+    return doc;
+}
+
+START_TEST(test_comps_doc_unite)
+{
+    COMPS_Doc *dst, *src, *uni;
+    COMPS_ObjMDict *bl, *wo;
+    char *pairs[][2] = {{"sample_comps.xml", "f21-rawhide-comps.xml"},
+                        {"f21-rawhide-comps.xml", "sample_comps.xml"},
+                        {"fedora_comps.xml", "main_comps2.xml"},
+                        {"sample_comps.xml", "sample_comps.xml"}};
+    char *expected, *result, *src_before, *src_after;
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        dst = load_doc(pairs[i][0]);
+        src = load_doc(pairs[i][1]);
+        uni = comps_doc_union(dst, src);
+        /* sections union doesn't merge stay untouched in dst */
+        bl = comps_doc_blacklist(dst);
+        wo = comps_doc_whiteout(dst);
+        comps_doc_set_blacklist(uni, bl);
+        comps_doc_set_whiteout(uni, wo);
+        COMPS_OBJECT_DESTROY(bl);
+        COMPS_OBJECT_DESTROY(wo);
+        expected = comps2xml_str(uni, NULL, NULL);
+        src_before = comps2xml_str(src, NULL, NULL);
+
+        comps_doc_unite(dst, src);
+        result = comps2xml_str(dst, NULL, NULL);
+        src_after = comps2xml_str(src, NULL, NULL);
+        fail_if(strcmp(expected, result) != 0,
+                "comps_doc_unite(%s, %s) differs from union", pairs[i][0],
+                pairs[i][1]);
+        fail_if(strcmp(src_before, src_after) != 0,
+                "comps_doc_unite modified source %s", pairs[i][1]);
+        free(expected);
+        free(result);
+        free(src_before);
+        free(src_after);
+        COMPS_OBJECT_DESTROY(uni);
+        COMPS_OBJECT_DESTROY(dst);
+        COMPS_OBJECT_DESTROY(src);
+    }
+}END_TEST
+
+START_TEST(test_comps_doc_union_ex)
+{
+    COMPS_Doc *d1, *d2, *uni, *par;
+    COMPS_DocUnionOptions options;
+    char *pairs[][2] = {{"sample_comps.xml", "f21-rawhide-comps.xml"},
+                        {"fedora_comps.xml", "f21-rawhide-comps.xml"},
+                        {"fedora_comps.xml", "main_comps2.xml"},
+                        {"sample_comps.xml", "sample_comps.xml"}};
+    unsigned int threads[] = {0, 2, 4, 16};
+    char *expected, *result;
+    int i, j;
+
+    for (i = 0; i < 4; i++) {
+        d1 = load_doc(pairs[i][0]);
+        d2 = load_doc(pairs[i][1]);
+        uni = comps_doc_union(d1, d2);
+        expected = comps2xml_str(uni, NULL, NULL);
+        for (j = 0; j < 4; j++) {
+            options.nthreads = threads[j];
+            par = comps_doc_union_ex(d1, d2, &options);
+            result = comps2xml_str(par, NULL, NULL);
+            fail_if(strcmp(expected, result) != 0,
+                    "comps_doc_union_ex(%s, %s) with %u threads differs from"
+                    " union", pairs[i][0], pairs[i][1], threads[j]);
+            free(result);
+            COMPS_OBJECT_DESTROY(par);
+        }
+        par = comps_doc_union_ex(d1, d2, NULL);
+        result = comps2xml_str(par, NULL, NULL);
+        fail_if(strcmp(expected, result) != 0);
+        free(result);
+        free(expected);
+        COMPS_OBJECT_DESTROY(par);
+        COMPS_OBJECT_DESTROY(uni);
+        COMPS_OBJECT_DESTROY(d1);
+        COMPS_OBJECT_DESTROY(d2);
+    }
+}END_TEST
+
+START_TEST(test_comps_doc_by_id)
+{
+    COMPS_Doc *doc;
+    COMPS_ObjList *list;
+    COMPS_ObjListIt *it;
+    COMPS_DocGroup *g, *g2, *g3;
+    COMPS_DocCategory *c;
+    COMPS_DocEnv *e;
+    COMPS_DocGroupPackage *pkg;
+    COMPS_Object *id;
+    char *str;
+
+    doc = load_doc("f21-rawhide-comps.xml");
+    list = comps_doc_groups(doc);
+    for (it = list->first; it != NULL; it = it->next) {
+        id = comps_docgroup_get_id((COMPS_DocGroup*)it->comps_obj);
+        str = comps_object_tostr(id);
+        g = comps_doc_group_by_id(doc, str);
+        fail_if(g != (COMPS_DocGroup*)it->comps_obj,
+                "group %s not found by id", str);
+        COMPS_OBJECT_DESTROY(g);
+        free(str);
+        COMPS_OBJECT_DESTROY(id);
+    }
+    fail_if(comps_doc_group_by_id(doc, "no-such-group") != NULL);
+    fail_if(comps_doc_group_by_id(doc, NULL) != NULL);
+
+    /* index follows list changes */
+    g = comps_doc_group_by_id(doc, "core");
+    fail_if(g == NULL);
+    comps_objlist_remove(list, (COMPS_Object*)g);
+    fail_if(comps_doc_group_by_id(doc, "core") != NULL);
+    comps_objlist_insert_at(list, 0, (COMPS_Object*)g);
+    g2 = comps_doc_group_by_id(doc, "core");
+    fail_if(g2 != g);
+    COMPS_OBJECT_DESTROY(g2);
+
+    /* and id changes of indexed objects */
+    comps_docgroup_set_id(g, "core-renamed", 1);
+    fail_if(comps_doc_group_by_id(doc, "core") != NULL);
+    g2 = comps_doc_group_by_id(doc, "core-renamed");
+    fail_if(g2 != g);
+    COMPS_OBJECT_DESTROY(g2);
+    fail_if(comps_doc_group_by_id(doc, "core") != NULL);
+    comps_docgroup_set_id(g, "core", 1);
+    g2 = comps_doc_group_by_id(doc, "core");
+    fail_if(g2 != g);
+    COMPS_OBJECT_DESTROY(g2);
+
+    /* earlier item renamed to id of later one after index was built */
+    g3 = (COMPS_DocGroup*)comps_objlist_get_x(list, 1);
+    id = comps_docgroup_get_id(g3);
+    str = comps_object_tostr(id);
+    g2 = comps_doc_group_by_id(doc, str);
+    fail_if(g2 != g3);
+    COMPS_OBJECT_DESTROY(g2);
+    comps_docgroup_set_id(g, str, 1);
+    g2 = comps_doc_group_by_id(doc, str);
+    fail_if(g2 != g, "first group with id %s not found", str);
+    COMPS_OBJECT_DESTROY(g2);
+    comps_docgroup_set_id(g, "core", 1);
+    free(str);
+    COMPS_OBJECT_DESTROY(id);
+
+    /* without properties dict, key objects themselves are tracked */
+    pkg = (COMPS_DocGroupPackage*)comps_objlist_get_x(g->packages, 0);
+    fail_if(comps_objlist_find_by_x(g->packages, &__comps_docpackage_name_x,
+                                    NULL, "no-such-package") != NULL);
+    comps_docpackage_set_name(pkg, "no-such-package", 1);
+    fail_if(comps_objlist_find_by_x(g->packages, &__comps_docpackage_name_x,
+                                    NULL, "no-such-package")
+            != (COMPS_Object*)pkg);
+    COMPS_OBJECT_DESTROY(g);
+    COMPS_OBJECT_DESTROY(list);
+
+    c = comps_doc_category_by_id(doc, "gnome-desktop-environment");
+    fail_if(c == NULL);
+    id = comps_doccategory_get_id(c);
+    fail_if(strcmp(((COMPS_Str*)id)->val, "gnome-desktop-environment") != 0);
+    COMPS_OBJECT_DESTROY(id);
+    COMPS_OBJECT_DESTROY(c);
+    fail_if(comps_doc_category_by_id(doc, "no-such-category") != NULL);
+
+    e = comps_doc_env_by_id(doc, "gnome-desktop-environment");
+    fail_if(e == NULL);
+    COMPS_OBJECT_DESTROY(e);
+    fail_if(comps_doc_env_by_id(doc, "no-such-env") != NULL);
+    COMPS_OBJECT_DESTROY(doc);
+}END_TEST
+
+static COMPS_ObjList* scan_owners(COMPS_ObjList *owners, size_t *offsets,
+                                  int nlists, COMPS_Object* (*key_f)(COMPS_Object*),
+                                  const char *key) {
+    COMPS_ObjList *ret, *sub;
+    COMPS_ObjListIt *it, *subit;
+    int i, found;
+    char *str;
+
+    ret = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+    for (it = owners ? owners->first : NULL; it != NULL; it = it->next) {
+        found = 0;
+        for (i = 0; i < nlists && !found; i++) {
+            sub = *(COMPS_ObjList**)((char*)it->comps_obj + offsets[i]);
+            for (subit = sub ? sub->first : NULL; subit && !found;
+                 subit = subit->next) {
+                str = comps_object_tostr(key_f(subit->comps_obj));
+                found = strcmp(str, key) == 0;
+                free(str);
+            }
+        }
+        if (found)
+            comps_objlist_append(ret, it->comps_obj);
+    }
+    return ret;
+}
+
+static int same_objects(COMPS_ObjList *l1, COMPS_ObjList *l2) {
+    COMPS_ObjListIt *it1, *it2;
+
+    if (l1->len != l2->len)
+        return 0;
+    for (it1 = l1->first, it2 = l2->first; it1; it1 = it1->next,
+                                                it2 = it2->next) {
+        if (it1->comps_obj != it2->comps_obj)
+            return 0;
+    }
+    return 1;
+}
+
+START_TEST(test_comps_doc_reverse_index)
+{
+    COMPS_Doc *doc;
+    COMPS_ObjList *groups, *cats, *envs, *res, *exp;
+    COMPS_ObjListIt *it, *pit;
+    COMPS_DocGroup *g;
+    COMPS_DocGroupPackage *pkg;
+    COMPS_PackageType *types;
+    size_t pkg_off[] = {offsetof(COMPS_DocGroup, packages)};
+    size_t cat_off[] = {offsetof(COMPS_DocCategory, group_ids)};
+    size_t env_off[] = {offsetof(COMPS_DocEnv, group_list),
+                        offsetof(COMPS_DocEnv, option_list)};
+    char *name;
+    int n;
+
+    doc = load_doc("f21-rawhide-comps.xml");
+    groups = comps_doc_groups(doc);
+    cats = comps_doc_categories(doc);
+    envs = comps_doc_environments(doc);
+    for (n = 0, it = groups->first; it != NULL && n < 40; it = it->next, n++) {
+        g = (COMPS_DocGroup*)it->comps_obj;
+        pit = g->packages ? g->packages->first : NULL;
+        for (; pit != NULL; pit = pit->next) {
+            name = comps_object_tostr(__comps_docpackage_name_x(pit->comps_obj));
+            res = comps_doc_package_groups(doc, name, &types);
+            exp = scan_owners(groups, pkg_off, 1, &__comps_docpackage_name_x,
+                              name);
+            fail_if(!same_objects(res, exp), "groups of %s differ", name);
+            fail_if(types == NULL);
+            COMPS_OBJECT_DESTROY(res);
+            COMPS_OBJECT_DESTROY(exp);
+            free(types);
+            free(name);
+        }
+        name = comps_object_tostr(__comps_docgroup_id_x(it->comps_obj));
+        res = comps_doc_group_categories(doc, name);
+        exp = scan_owners(cats, cat_off, 1, &__comps_docgroupid_name_x, name);
+        fail_if(!same_objects(res, exp), "categories of %s differ", name);
+        COMPS_OBJECT_DESTROY(res);
+        COMPS_OBJECT_DESTROY(exp);
+        res = comps_doc_group_envs(doc, name);
+        exp = scan_owners(envs, env_off, 2, &__comps_docgroupid_name_x, name);
+        fail_if(!same_objects(res, exp), "environments of %s differ", name);
+        COMPS_OBJECT_DESTROY(res);
+        COMPS_OBJECT_DESTROY(exp);
+        free(name);
+    }
+    res = comps_doc_package_groups(doc, "no-such-package", &types);
+    fail_if(res->len != 0 || types != NULL);
+    COMPS_OBJECT_DESTROY(res);
+
+    /* index follows changes of document */
+    g = (COMPS_DocGroup*)comps_object_create(&COMPS_DocGroup_ObjInfo, NULL);
+    comps_docgroup_set_id(g, "new-group", 0);
+    pkg = (COMPS_DocGroupPackage*)
+          comps_object_create(&COMPS_DocGroupPackage_ObjInfo, NULL);
+    comps_docpackage_set_name(pkg, "new-package", 0);
+    comps_docpackage_set_type(pkg, COMPS_PACKAGE_OPTIONAL, false);
+    comps_docgroup_add_package(g, pkg);
+    comps_doc_add_group(doc, g);
+    res = comps_doc_package_groups(doc, "new-package", &types);
+    fail_if(res->len != 1 || res->first->comps_obj != (COMPS_Object*)g);
+    fail_if(types[0] != COMPS_PACKAGE_OPTIONAL);
+    COMPS_OBJECT_DESTROY(res);
+    free(types);
+    comps_objlist_remove_at(g->packages, 0);
+    res = comps_doc_package_groups(doc, "new-package", NULL);
+    fail_if(res->len != 0);
+    COMPS_OBJECT_DESTROY(res);
+
+    COMPS_OBJECT_DESTROY(groups);
+    COMPS_OBJECT_DESTROY(cats);
+    COMPS_OBJECT_DESTROY(envs);
+    COMPS_OBJECT_DESTROY(doc);
+}END_TEST
+
+static int arch_match(COMPS_ObjList *obj_arches, COMPS_ObjList *arches) {
+    COMPS_ObjListIt *it, *it2;
+
+    if (arches == NULL || obj_arches == NULL)
+        return 1;
+    for (it = arches->first; it != NULL; it = it->next) {
+        for (it2 = obj_arches->first; it2 != NULL; it2 = it2->next) {
+            if (comps_object_cmp(it->comps_obj, it2->comps_obj))
+                return 1;
+        }
+    }
+    return 0;
+}
+
+/* straightforward expansion comps_doc_env_resolve is checked against */
+static COMPS_ObjList* resolve_scan(COMPS_Doc *doc, COMPS_DocEnv *env,
+                                   int flags, COMPS_ObjList *arches) {
+    COMPS_ObjList *ret, *groups, *lists[2];
+    COMPS_ObjListIt *it, *git, *pit, *rit;
+    COMPS_DocGroupId *gid;
+    COMPS_DocGroup *g;
+    COMPS_DocGroupPackage *pkg;
+    int i;
+
+    ret = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+    groups = comps_doc_groups(doc);
+    lists[0] = env->group_list;
+    lists[1] = (flags & COMPS_RESOLVE_OPTIONS) ? env->option_list : NULL;
+    for (i = 0; i < 2; i++) {
+        for (it = lists[i] ? lists[i]->first : NULL; it; it = it->next) {
+            gid = (COMPS_DocGroupId*)it->comps_obj;
+            if (!arch_match(gid->arches, arches))
+                continue;
+            for (git = groups->first; git != NULL; git = git->next) {
+                if (comps_object_cmp(__comps_docgroup_id_x(git->comps_obj),
+                                     (COMPS_Object*)gid->name))
+                    break;
+            }
+            if (git == NULL)
+                continue;
+            g = (COMPS_DocGroup*)git->comps_obj;
+            if (!arch_match((COMPS_ObjList*)comps_objdict_get_x(g->properties,
+                                                                "arches"),
+                            arches))
+                continue;
+            for (pit = g->packages->first; pit != NULL; pit = pit->next) {
+                pkg = (COMPS_DocGroupPackage*)pit->comps_obj;
+                if (!(flags & (1 << pkg->type))
+                    || !arch_match(pkg->arches, arches))
+                    continue;
+                for (rit = ret->first; rit != NULL; rit = rit->next) {
+                    if (comps_object_cmp(__comps_docpackage_name_x(
+                                            rit->comps_obj),
+                                         (COMPS_Object*)pkg->name))
+                        break;
+                }
+                if (rit == NULL)
+                    comps_objlist_append(ret, (COMPS_Object*)pkg);
+            }
+        }
+    }
+    COMPS_OBJECT_DESTROY(groups);
+    return ret;
+}
+
+START_TEST(test_comps_doc_env_resolve)
+{
+    COMPS_Doc *doc;
+    COMPS_ObjList *envs, *arches, *res, *exp;
+    COMPS_ObjListIt *it;
+    COMPS_DocEnv *env;
+    COMPS_DocGroup *g;
+    int flags[] = {COMPS_RESOLVE_MANDATORY | COMPS_RESOLVE_DEFAULT,
+                   COMPS_RESOLVE_MANDATORY | COMPS_RESOLVE_DEFAULT
+                   | COMPS_RESOLVE_OPTIONAL | COMPS_RESOLVE_CONDITIONAL
+                   | COMPS_RESOLVE_OPTIONS};
+    COMPS_ObjList *archsets[2];
+    char *id;
+    size_t total = 0;
+    int i, j, k;
+
+    doc = load_doc("f21-rawhide-comps.xml");
+    arches = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+    comps_objlist_append_x(arches, (COMPS_Object*)comps_str("x86_64"));
+    archsets[0] = NULL;
+    archsets[1] = arches;
+    envs = comps_doc_environments(doc);
+    fail_if(envs->len == 0);
+    /* twice, second round is served from memoized expansions */
+    for (k = 0; k < 2; k++) {
+        for (it = envs->first; it != NULL; it = it->next) {
+            env = (COMPS_DocEnv*)it->comps_obj;
+            id = comps_object_tostr(__comps_docenv_id_x(it->comps_obj));
+            for (i = 0; i < 2; i++) {
+                for (j = 0; j < 2; j++) {
+                    res = comps_doc_env_resolve(doc, id, flags[i],
+                                                archsets[j]);
+                    exp = resolve_scan(doc, env, flags[i], archsets[j]);
+                    fail_if(res == NULL);
+                    total += res->len;
+                    fail_if(!same_objects(res, exp),
+                            "resolve of %s differs", id);
+                    COMPS_OBJECT_DESTROY(res);
+                    COMPS_OBJECT_DESTROY(exp);
+                }
+            }
+            free(id);
+        }
+    }
+    fail_if(total == 0);
+    fail_if(comps_doc_env_resolve(doc, "no-such-env", flags[0], NULL) != NULL);
+
+    /* memoized expansion follows change of group */
+    env = (COMPS_DocEnv*)envs->first->comps_obj;
+    id = comps_object_tostr(__comps_docenv_id_x((COMPS_Object*)env));
+    g = comps_doc_group_by_id(doc, ((COMPS_DocGroupId*)
+                                    env->group_list->first->comps_obj)
+                                   ->name->val);
+    fail_if(g == NULL);
+    comps_objlist_remove_at(g->packages, 0);
+    res = comps_doc_env_resolve(doc, id, flags[1], NULL);
+    exp = resolve_scan(doc, env, flags[1], NULL);
+    fail_if(!same_objects(res, exp));
+    COMPS_OBJECT_DESTROY(res);
+    COMPS_OBJECT_DESTROY(exp);
+    COMPS_OBJECT_DESTROY(g);
+    free(id);
+
+    COMPS_OBJECT_DESTROY(envs);
+    COMPS_OBJECT_DESTROY(arches);
+    COMPS_OBJECT_DESTROY(doc);
+}END_TEST
+
+/* plain fnmatch scan of groups with semantics of comps_doc_get_groups */
+static COMPS_ObjList* match_scan(COMPS_Doc *doc, const char *id,
+                                 const char *name, const char *lang,
+                                 int flags) {
+    COMPS_ObjList *groups, *ret;
+    COMPS_ObjListIt *it;
+    COMPS_DocGroup *g;
+    COMPS_Object *prop;
+
+    ret = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+    groups = comps_doc_groups(doc);
+    for (it = groups->first; it != NULL; it = it->next) {
+        g = (COMPS_DocGroup*)it->comps_obj;
+        prop = comps_objdict_get_x(g->properties, "id");
+        if (id && (!prop || fnmatch(id, ((COMPS_Str*)prop)->val, flags)))
+            continue;
+        prop = lang ? comps_objdict_get_x(g->name_by_lang, lang)
+                    : comps_objdict_get_x(g->properties, "name");
+        if (name && (!prop || fnmatch(name, ((COMPS_Str*)prop)->val, flags)))
+            continue;
+        comps_objlist_append(ret, it->comps_obj);
+    }
+    COMPS_OBJECT_DESTROY(groups);
+    return ret;
+}
+
+START_TEST(test_comps_doc_query)
+{
+    COMPS_Doc *doc;
+    COMPS_ObjList *res, *exp;
+    COMPS_DocGroup *g;
+    COMPS_DocQuery *query;
+    struct {
+        const char *id, *name, *lang;
+        int flags;
+    } queries[] = {
+        {"core", NULL, NULL, 0}, {"CORE", NULL, NULL, FNM_CASEFOLD},
+        {"CORE", NULL, NULL, 0}, {"base*", NULL, NULL, 0},
+        {"BASE**", NULL, NULL, FNM_CASEFOLD}, {"*", NULL, NULL, 0},
+        {"", NULL, NULL, 0}, {"*-tools", NULL, NULL, 0},
+        {"g?ome-*", NULL, NULL, 0}, {"\\c\\ore", NULL, NULL, 0},
+        {"\\c\\ore", NULL, NULL, FNM_NOESCAPE}, {"no-such*", NULL, NULL, 0},
+        {"gnome*", NULL, NULL, FNM_PATHNAME | FNM_PERIOD},
+        {NULL, "Admin*", NULL, 0}, {NULL, "*", "cs", 0},
+        {"a*", "*e*", NULL, FNM_CASEFOLD}, {NULL, NULL, NULL, 0}
+    };
+    size_t i;
+
+    doc = load_doc("f21-rawhide-comps.xml");
+    for (i = 0; i < sizeof(queries) / sizeof(queries[0]); i++) {
+        res = comps_doc_get_groups(doc, (char*)queries[i].id,
+                                   (char*)queries[i].name, NULL,
+                                   (char*)queries[i].lang, queries[i].flags);
+        exp = match_scan(doc, queries[i].id, queries[i].name,
+                         queries[i].lang, queries[i].flags);
+        fail_if(!same_objects(res, exp), "query %zu differs", i);
+        COMPS_OBJECT_DESTROY(res);
+        COMPS_OBJECT_DESTROY(exp);
+    }
+
+    /* compiled query follows id changes */
+    query = comps_doc_query_create("core*", NULL, NULL, NULL, 0);
+    res = comps_doc_query_groups(doc, query);
+    fail_if(res->len != 1);
+    g = (COMPS_DocGroup*)comps_objlist_get(res, 0);
+    COMPS_OBJECT_DESTROY(res);
+    comps_docgroup_set_id(g, "renamed-core", 1);
+    res = comps_doc_query_groups(doc, query);
+    fail_if(res->len != 0);
+    COMPS_OBJECT_DESTROY(res);
+    comps_docgroup_set_id(g, "core-renamed", 1);
+    res = comps_doc_query_groups(doc, query);
+    fail_if(res->len != 1 || res->first->comps_obj != (COMPS_Object*)g);
+    COMPS_OBJECT_DESTROY(res);
+    COMPS_OBJECT_DESTROY(g);
+    comps_doc_query_destroy(query);
+
+    res = comps_doc_get_envs(doc, "gnome-desktop-environment", NULL, NULL,
+                             NULL, 0);
+    fail_if(res->len != 1);
+    COMPS_OBJECT_DESTROY(res);
+    res = comps_doc_get_categories(doc, "GNOME-*", NULL, NULL, NULL,
+                                   FNM_CASEFOLD);
+    fail_if(res->len == 0);
+    COMPS_OBJECT_DESTROY(res);
+    COMPS_OBJECT_DESTROY(doc);
+}END_TEST
+
+static int has_object(COMPS_ObjList *list, COMPS_Object *obj) {
+    COMPS_ObjListIt *it;
+
+    for (it = list->first; it != NULL; it = it->next) {
+        if (it->comps_obj == obj)
+            return 1;
+    }
+    return 0;
+}
+
+START_TEST(test_comps_doc_search)
+{
+    COMPS_Doc *doc;
+    COMPS_ObjList *res, *limited;
+    COMPS_DocGroup *g;
+    COMPS_Object *name;
+
+    doc = load_doc("f21-rawhide-comps.xml");
+    g = comps_doc_group_by_id(doc, "gnome-desktop");
+    fail_if(g == NULL);
+
+    res = comps_doc_search(doc, "Gnome", NULL, 0);
+    fail_if(!has_object(res, (COMPS_Object*)g));
+    /* names matching whole word rank first */
+    name = comps_objdict_get_x(((COMPS_DocGroup*)res->first->comps_obj)
+                               ->properties, "name");
+    fail_if(name == NULL || strstr(((COMPS_Str*)name)->val, "GNOME") == NULL);
+    limited = comps_doc_search(doc, "Gnome", NULL, 2);
+    fail_if(limited->len != 2 || res->len <= 2);
+    fail_if(limited->first->comps_obj != res->first->comps_obj
+            || limited->last->comps_obj != res->first->next->comps_obj);
+    COMPS_OBJECT_DESTROY(limited);
+    COMPS_OBJECT_DESTROY(res);
+
+    /* all words have to match, as prefixes */
+    res = comps_doc_search(doc, "intuit  FRIENDLY envir", NULL, 0);
+    fail_if(!has_object(res, (COMPS_Object*)g));
+    COMPS_OBJECT_DESTROY(res);
+    res = comps_doc_search(doc, "intuit nosuchword", NULL, 0);
+    fail_if(res->len != 0);
+    COMPS_OBJECT_DESTROY(res);
+    res = comps_doc_search(doc, " ,. ", NULL, 0);
+    fail_if(res->len != 0);
+    COMPS_OBJECT_DESTROY(res);
+
+    /* translations */
+    res = comps_doc_search(doc, "přívětivé", "cs", 0);
+    fail_if(!has_object(res, (COMPS_Object*)g));
+    COMPS_OBJECT_DESTROY(res);
+    res = comps_doc_search(doc, "přívětivé", NULL, 0);
+    fail_if(!has_object(res, (COMPS_Object*)g));
+    COMPS_OBJECT_DESTROY(res);
+    res = comps_doc_search(doc, "přívětivé", "de", 0);
+    fail_if(has_object(res, (COMPS_Object*)g));
+    COMPS_OBJECT_DESTROY(res);
+
+    /* index follows name changes */
+    comps_docgroup_set_name(g, "Zyxwvut Workstation", 1);
+    res = comps_doc_search(doc, "zyxw", NULL, 0);
+    fail_if(res->len != 1 || res->first->comps_obj != (COMPS_Object*)g);
+    COMPS_OBJECT_DESTROY(res);
+
+    COMPS_OBJECT_DESTROY(g);
+    COMPS_OBJECT_DESTROY(doc);
+}END_TEST
+
+/* compare sections covered by delta, missing ones are created empty */
+static int delta_sections_equal(COMPS_Doc *doc1, COMPS_Doc *doc2) {
+    COMPS_Object *sects[2][4];
+    int i, j, ret;
+
+    for (i = 0; i < 2; i++) {
+        sects[i][0] = (COMPS_Object*)comps_doc_groups(i ? doc2 : doc1);
+        sects[i][1] = (COMPS_Object*)comps_doc_categories(i ? doc2 : doc1);
+        sects[i][2] = (COMPS_Object*)comps_doc_environments(i ? doc2 : doc1);
+        sects[i][3] = (COMPS_Object*)comps_doc_langpacks(i ? doc2 : doc1);
+    }
+    ret = 1;
+    for (j = 0; j < 4; j++) {
+        ret = ret && comps_object_cmp(sects[0][j], sects[1][j]);
+        COMPS_OBJECT_DESTROY(sects[0][j]);
+        COMPS_OBJECT_DESTROY(sects[1][j]);
+    }
+    return ret;
+}
+
+/* patch copy of doc and check it's equal to expected */
+static int patch_equals(COMPS_Doc *doc, COMPS_DocDelta *delta,
+                        COMPS_Doc *expected) {
+    COMPS_Doc *patched;
+    int ret;
+
+    patched = (COMPS_Doc*)comps_object_copy((COMPS_Object*)doc);
+    ret = comps_doc_patch(patched, delta) == 0
+          && delta_sections_equal(patched, expected);
+    COMPS_OBJECT_DESTROY(patched);
+    return ret;
+}
+
+START_TEST(test_comps_doc_diff)
+{
+    COMPS_Doc *doc1, *doc2, *changed, *empty;
+    COMPS_DocDelta *delta, *loaded;
+    COMPS_DocGroup *g;
+    COMPS_DocCategory *c;
+    COMPS_DocGroupPackage *p;
+    COMPS_ObjList *list;
+    char *xml, *full;
+    size_t i;
+    int types[COMPS_DELTA_ITEM_SET + 1] = {0};
+
+    doc1 = load_doc("fedora_comps.xml");
+    doc2 = load_doc("f21-rawhide-comps.xml");
+
+    /* unrelated documents */
+    delta = comps_doc_diff(doc1, doc2);
+    fail_if(delta == NULL || delta->len == 0);
+    fail_if(!patch_equals(doc1, delta, doc2));
+    xml = comps_docdelta_xml_str(delta);
+    fail_if(xml == NULL);
+    loaded = comps_docdelta_from_xml_str(xml);
+    fail_if(loaded == NULL || loaded->len != delta->len);
+    fail_if(!patch_equals(doc1, loaded, doc2));
+    free(xml);
+    comps_docdelta_destroy(loaded);
+    comps_docdelta_destroy(delta);
+
+    /* from and to empty document */
+    empty = (COMPS_Doc*)comps_object_create(&COMPS_Doc_ObjInfo,
+                        (COMPS_Object*[]){(COMPS_Object*)doc2->encoding});
+    delta = comps_doc_diff(empty, doc2);
+    fail_if(!patch_equals(empty, delta, doc2));
+    comps_docdelta_destroy(delta);
+    delta = comps_doc_diff(doc2, empty);
+    fail_if(!patch_equals(doc2, delta, empty));
+    comps_docdelta_destroy(delta);
+
+    delta = comps_doc_diff(doc2, doc2);
+    fail_if(delta == NULL || delta->len != 0);
+    comps_docdelta_destroy(delta);
+
+    /* few changes make few operations */
+    changed = (COMPS_Doc*)comps_object_copy((COMPS_Object*)doc2);
+    g = comps_doc_group_by_id(changed, "gnome-desktop");
+    comps_docgroup_set_name(g, "GNOME Workstation", 1);
+    comps_objdict_set_x(g->name_by_lang, "eo",
+                        (COMPS_Object*)comps_str("GNOME laborstacio"));
+    comps_objdict_unset(g->desc_by_lang, "cs");
+    p = (COMPS_DocGroupPackage*)comps_objlist_get_x(g->packages, 0);
+    p->type = COMPS_PACKAGE_OPTIONAL;
+    comps_objlist_remove_at(g->packages, 1);
+    p = COMPS_OBJECT_CREATE(COMPS_DocGroupPackage, NULL);
+    comps_docpackage_set_name(p, "gnome-new-app", 1);
+    comps_docpackage_set_type(p, COMPS_PACKAGE_CONDITIONAL, false);
+    comps_docpackage_set_requires(p, "gnome-shell", 1);
+    comps_objlist_insert_at_x(g->packages, 3, (COMPS_Object*)p);
+    COMPS_OBJECT_DESTROY(g);
+    c = comps_doc_category_by_id(changed, "development");
+    list = comps_doc_categories(changed);
+    comps_objlist_remove(list, (COMPS_Object*)c);
+    COMPS_OBJECT_DESTROY(list);
+    COMPS_OBJECT_DESTROY(c);
+    g = COMPS_OBJECT_CREATE(COMPS_DocGroup, NULL);
+    comps_docgroup_set_id(g, "new-group", 1);
+    comps_docgroup_set_name(g, "New group", 1);
+    comps_doc_add_group(changed, g);
+    comps_doc_add_langpack(changed, "new-pkg", comps_str("new-pkg-%s"));
+
+    delta = comps_doc_diff(doc2, changed);
+    fail_if(delta == NULL);
+    for (i = 0; i < delta->len; i++)
+        types[delta->ops[i].type]++;
+    fail_if(types[COMPS_DELTA_ADD] != 1 || types[COMPS_DELTA_REMOVE] != 1);
+    fail_if(types[COMPS_DELTA_ORDER] != 0);
+    /* name of changed group, name of new one and langpack */
+    fail_if(types[COMPS_DELTA_PROP] != 3);
+    fail_if(types[COMPS_DELTA_NAME] != 1 || types[COMPS_DELTA_DESC] != 1);
+    fail_if(types[COMPS_DELTA_ITEM_ADD] != 1
+            || types[COMPS_DELTA_ITEM_REMOVE] != 1
+            || types[COMPS_DELTA_ITEM_SET] != 1);
+    fail_if(!patch_equals(doc2, delta, changed));
+    xml = comps_docdelta_xml_str(delta);
+    full = comps2xml_str(changed, NULL, NULL);
+    fail_if(strlen(xml) * 100 > strlen(full));
+    loaded = comps_docdelta_from_xml_str(xml);
+    fail_if(loaded == NULL || !patch_equals(doc2, loaded, changed));
+    comps_docdelta_destroy(loaded);
+    free(full);
+    free(xml);
+
+    /* delta doesn't fit document, rest is still applied */
+    fail_if(comps_doc_patch(changed, delta) != 4);
+
+    fail_if(comps_docdelta_from_xml_str("<compsdelta><bogus/>"
+                                        "</compsdelta>") != NULL);
+    fail_if(comps_docdelta_from_xml_str("<compsdelta><remove section="
+                                        "\"group\"/></compsdelta>") != NULL);
+    fail_if(comps_docdelta_from_xml_str("<compsdelta>") != NULL);
+
+    comps_docdelta_destroy(delta);
+    COMPS_OBJECT_DESTROY(changed);
+    COMPS_OBJECT_DESTROY(empty);
+    COMPS_OBJECT_DESTROY(doc1);
+    COMPS_OBJECT_DESTROY(doc2);
+}END_TEST
+
+START_TEST(test_comps_doc_digest)
+{
+    COMPS_Doc *doc, *doc2, *copy, *empty;
+    COMPS_DocGroup *g;
+    COMPS_DocGroupPackage *p;
+    COMPS_DocDelta *delta;
+    COMPS_ObjList *list;
+    COMPS_Str *str;
+    COMPS_Digest digest;
+
+    /* digest mustn't depend on host or build */
+    str = comps_str("abc");
+    fail_if(comps_object_digest((COMPS_Object*)str) != 0xb94b09e22d65b449ULL);
+    fail_if(comps_object_digest(NULL) != 0);
+    COMPS_OBJECT_DESTROY(str);
+
+    doc = load_doc("f21-rawhide-comps.xml");
+    doc2 = load_doc("f21-rawhide-comps.xml");
+    digest = comps_doc_digest(doc);
+    fail_if(digest != comps_doc_digest(doc));
+    fail_if(digest != comps_doc_digest(doc2));
+    copy = (COMPS_Doc*)comps_object_copy((COMPS_Object*)doc);
+    fail_if(digest != comps_object_digest((COMPS_Object*)copy));
+
+    /* cached digest of translations follows modifications */
+    g = comps_doc_group_by_id(copy, "gnome-desktop");
+    comps_objdict_set_x(g->name_by_lang, "eo",
+                        (COMPS_Object*)comps_str("GNOME laborstacio"));
+    fail_if(digest == comps_doc_digest(copy));
+    comps_objdict_unset(g->name_by_lang, "eo");
+    fail_if(digest != comps_doc_digest(copy));
+
+    /* packages changed in place */
+    p = (COMPS_DocGroupPackage*)comps_objlist_get_x(g->packages, 0);
+    p->type = COMPS_PACKAGE_OPTIONAL;
+    fail_if(digest == comps_doc_digest(copy));
+    COMPS_OBJECT_DESTROY(copy);
+
+    /* arches are ignored by comparison, but not by digest and diff */
+    copy = (COMPS_Doc*)comps_object_copy((COMPS_Object*)doc);
+    COMPS_OBJECT_DESTROY(g);
+    g = comps_doc_group_by_id(copy, "gnome-desktop");
+    p = (COMPS_DocGroupPackage*)comps_objlist_get_x(g->packages, 0);
+    list = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+    comps_objlist_append_x(list, (COMPS_Object*)comps_str("x86_64"));
+    comps_docpackage_set_arches(p, list);
+    fail_if(!comps_object_cmp((COMPS_Object*)doc, (COMPS_Object*)copy));
+    fail_if(digest == comps_doc_digest(copy));
+    delta = comps_doc_diff(doc, copy);
+    fail_if(delta == NULL || delta->len != 1
+            || delta->ops[0].type != COMPS_DELTA_ITEM_SET);
+    fail_if(comps_doc_patch(doc2, delta) != 0);
+    fail_if(comps_doc_digest(doc2) != comps_doc_digest(copy));
+    comps_docdelta_destroy(delta);
+
+    /* missing and empty sections are the same */
+    empty = (COMPS_Doc*)comps_object_create(&COMPS_Doc_ObjInfo,
+                        (COMPS_Object*[]){(COMPS_Object*)doc->encoding});
+    digest = comps_doc_digest(empty);
+    list = comps_doc_groups(empty);
+    COMPS_OBJECT_DESTROY(list);
+    fail_if(digest != comps_doc_digest(empty));
+
+    COMPS_OBJECT_DESTROY(g);
+    COMPS_OBJECT_DESTROY(empty);
+    COMPS_OBJECT_DESTROY(copy);
+    COMPS_OBJECT_DESTROY(doc2);
+    COMPS_OBJECT_DESTROY(doc);
+}END_TEST
+
+typedef struct {
+    char *buf;
+    size_t len;
+    int calls;
+} XMLSink;
+
+static int xml_sink_write(void *ctx, const char *buffer, int len) {
+    XMLSink *sink = ctx;
+    sink->buf = realloc(sink->buf, sink->len + len + 1);
+    memcpy(sink->buf + sink->len, buffer, len);
+    sink->len += len;
+    sink->buf[sink->len] = 0;
+    sink->calls++;
+    return len;
+}
+
+static int xml_sink_fail(void *ctx, const char *buffer, int len) {
+    (void)ctx;
+    (void)buffer;
+    (void)len;
+    return -1;
+}
+
+START_TEST(test_comps_doc_xml_stream)
+{
+    COMPS_Doc *doc;
+    XMLSink sink = {NULL, 0, 0};
+    char *expected, *buf;
+    FILE *fp;
+    size_t len;
+    int fd;
+
+    doc = load_doc("fedora_comps.xml");
+    expected = comps2xml_str(doc, NULL, NULL);
+    fail_if(expected == NULL);
+    /* text is escaped as by libxml2 tree save */
+    fail_if(strstr(expected, "\"Kritischen Pfad\"") == NULL);
+    fail_if(strstr(expected, "<packagereq></packagereq>") != NULL);
+
+    fail_if(comps2xml_cb(doc, &xml_sink_write, &sink, NULL, NULL) == -1);
+    fail_if(sink.buf == NULL || strcmp(sink.buf, expected) != 0);
+    fail_if(sink.calls < 2);
+    free(sink.buf);
+
+    fd = open("stream.xml", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    fail_if(fd < 0);
+    fail_if(comps2xml_fd(doc, fd, NULL, NULL) == -1);
+    close(fd);
+    fp = fopen("stream.xml", "r");
+    fail_if(fp == NULL);
+    len = strlen(expected);
+    buf = malloc(len + 2);
+    fail_if(fread(buf, 1, len + 1, fp) != (size_t)len);
+    buf[len] = 0;
+    fail_if(strcmp(buf, expected) != 0);
+    free(buf);
+    fclose(fp);
+
+    fail_if(comps2xml_cb(doc, &xml_sink_fail, NULL, NULL, NULL) != -1);
+    fail_if(comps2xml_f(doc, "no-such-dir/comps.xml", 0, NULL, NULL) != -1);
+
+    free(expected);
+    COMPS_OBJECT_DESTROY(doc);
+}END_TEST
+
+static int log_len(COMPS_Log *log) {
+    COMPS_HSListItem *it;
+    int len = 0;
+
+    for (it = log->entries->first; it != NULL; it = it->next)
+        len++;
+    return len;
+}
+
+START_TEST(test_comps_doc_xml_threaded)
+{
+    COMPS_Doc *doc;
+    COMPS_XMLOptions opts = COMPS_XMLDefaultOptions;
+    char *expected, *str;
+    int logged, threaded_logged;
+    unsigned int n;
+
+    doc = load_doc("fedora_comps.xml");
+    opts.arch_output = true;
+    logged = log_len(doc->log);
+    expected = comps2xml_str(doc, &opts, NULL);
+    logged = log_len(doc->log) - logged;
+    /* some groups are skipped with warning */
+    fail_if(logged == 0);
+    for (n = 2; n <= 16; n *= 2) {
+        opts.nthreads = n;
+        threaded_logged = log_len(doc->log);
+        str = comps2xml_str(doc, &opts, NULL);
+        threaded_logged = log_len(doc->log) - threaded_logged;
+        fail_if(str == NULL || strcmp(str, expected) != 0,
+                "output with %u threads differs", n);
+        ck_assert_int_eq(threaded_logged, logged);
+        free(str);
+    }
+    free(expected);
+    COMPS_OBJECT_DESTROY(doc);
+}END_TEST
+
+START_TEST(test_comps_doc_xml_fragment_cache)
+{
+    COMPS_Doc *doc;
+    COMPS_XMLOptions opts = COMPS_XMLDefaultOptions;
+    COMPS_ObjList *groups;
+    COMPS_DocGroup *g;
+    COMPS_DocGroupPackage *p;
+    COMPS_XMLSelection sel = {NULL, NULL, NULL, 0};
+    COMPS_ObjListIt *it;
+    char *expected, *str;
+    int logged, i;
+
+    doc = load_doc("fedora_comps.xml");
+    expected = comps2xml_str(doc, NULL, NULL);
+    opts.fragment_cache = true;
+    str = comps2xml_str(doc, &opts, NULL);
+    ck_assert_str_eq(str, expected);
+    free(str);
+    groups = comps_doc_groups(doc);
+    g = (COMPS_DocGroup*)groups->first->comps_obj;
+    fail_if(g->xml_cache == NULL);
+    /* groups without packages are skipped and warned about every time */
+    logged = log_len(doc->log);
+    str = comps2xml_str(doc, &opts, NULL);
+    ck_assert_str_eq(str, expected);
+    free(str);
+    logged = log_len(doc->log) - logged;
+    fail_if(logged == 0);
+
+    comps_docgroup_set_name(g, "Changed", 0);
+    p = (COMPS_DocGroupPackage*)
+        comps_object_create(&COMPS_DocGroupPackage_ObjInfo, NULL);
+    comps_docpackage_set_name(p, "added-package", 0);
+    comps_docgroup_add_package((COMPS_DocGroup*)groups->first->next->comps_obj,
+                               p);
+    free(expected);
+    expected = comps2xml_str(doc, NULL, NULL);
+    fail_if(strstr(expected, "added-package") == NULL);
+    str = comps2xml_str(doc, &opts, NULL);
+    ck_assert_str_eq(str, expected);
+    free(str);
+    opts.nthreads = 4;
+    str = comps2xml_str(doc, &opts, NULL);
+    ck_assert_str_eq(str, expected);
+    free(str);
+
+    /* object selected twice is rendered by two workers at once */
+    sel.groups = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+    for (it = groups->first; it != NULL; it = it->next) {
+        comps_objlist_append(sel.groups, it->comps_obj);
+        comps_objlist_append(sel.groups, it->comps_obj);
+    }
+    opts.fragment_cache = false;
+    free(expected);
+    expected = comps2xml_selected_str(doc, &sel, &opts, NULL);
+    opts.fragment_cache = true;
+    for (i = 0; i < 3; i++) {
+        str = comps2xml_selected_str(doc, &sel, &opts, NULL);
+        ck_assert_str_eq(str, expected);
+        free(str);
+    }
+    COMPS_OBJECT_DESTROY(sel.groups);
+
+    /* different options don't reuse fragments */
+    opts.default_explicit = true;
+    free(expected);
+    expected = comps2xml_str(doc, &opts, NULL);
+    opts.fragment_cache = false;
+    str = comps2xml_str(doc, &opts, NULL);
+    ck_assert_str_eq(str, expected);
+    free(str);
+
+    free(expected);
+    COMPS_OBJECT_DESTROY(groups);
+    COMPS_OBJECT_DESTROY(doc);
+}END_TEST
+
+START_TEST(test_comps_doc_xml_selected)
+{
+    COMPS_Doc *doc, *slice;
+    COMPS_XMLSelection sel = {NULL, NULL, NULL, 0};
+    COMPS_ObjList *groups, *categories;
+    COMPS_Object *enc;
+    char *expected, *str;
+
+    doc = load_doc("fedora_comps.xml");
+    groups = comps_doc_groups(doc);
+    categories = comps_doc_categories(doc);
+
+    /* the way slices were made so far */
+    enc = (COMPS_Object*)comps_str("UTF-8");
+    slice = COMPS_OBJECT_CREATE(COMPS_Doc, (COMPS_Object*[]){enc});
+    COMPS_OBJECT_DESTROY(enc);
+    COMPS_OBJECT_REPLACE(slice->doctype_name, COMPS_Str, doc->doctype_name);
+    COMPS_OBJECT_REPLACE(slice->doctype_pubid, COMPS_Str, doc->doctype_pubid);
+    COMPS_OBJECT_REPLACE(slice->doctype_sysid, COMPS_Str, doc->doctype_sysid);
+    comps_doc_add_group(slice, (COMPS_DocGroup*)comps_object_copy(
+                                 groups->first->next->comps_obj));
+    comps_doc_add_group(slice, (COMPS_DocGroup*)comps_object_copy(
+                                 groups->last->comps_obj));
+    comps_doc_add_category(slice, (COMPS_DocCategory*)comps_object_copy(
+                                    categories->first->comps_obj));
+    expected = comps2xml_str(slice, NULL, NULL);
+
+    sel.groups = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+    sel.categories = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+    comps_objlist_append_x(sel.groups, (COMPS_Object*)comps_str(
+        ((COMPS_Str*)comps_objdict_get_x(
+            ((COMPS_DocGroup*)groups->first->next->comps_obj)->properties,
+            "id"))->val));
+    comps_objlist_append_x(sel.groups, (COMPS_Object*)comps_str("no-such"));
+    comps_objlist_append(sel.groups, groups->last->comps_obj);
+    comps_objlist_append(sel.categories, categories->first->comps_obj);
+    str = comps2xml_selected_str(doc, &sel, NULL, NULL);
+    ck_assert_str_eq(str, expected);
+    free(str);
+
+    /* doc lists come from doc */
+    sel.doc_lists = 1;
+    str = comps2xml_selected_str(doc, &sel, NULL, NULL);
+    fail_if(strstr(str, "<blacklist>") == NULL);
+    fail_if(strstr(expected, "<blacklist>") != NULL);
+    free(str);
+
+    /* empty selection is still a valid document */
+    sel.doc_lists = 0;
+    COMPS_OBJECT_DESTROY(sel.groups);
+    COMPS_OBJECT_DESTROY(sel.categories);
+    sel.groups = sel.categories = NULL;
+    str = comps2xml_selected_str(doc, &sel, NULL, NULL);
+    fail_if(strstr(str, "<comps/>") == NULL && strstr(str, "</comps>") == NULL);
+    fail_if(strstr(str, "<group>") != NULL);
+    free(str);
+
+    free(expected);
+    COMPS_OBJECT_DESTROY(slice);
+    COMPS_OBJECT_DESTROY(groups);
+    COMPS_OBJECT_DESTROY(categories);
+    COMPS_OBJECT_DESTROY(doc);
+}END_TEST
+
+START_TEST(test_comps_sha256)
+{
+    COMPS_SHA256 ctx;
+    char hex[COMPS_SHA256_HEXLEN + 1];
+    const char *msg = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    size_t i;
+
+    comps_sha256_init(&ctx);
+    comps_sha256_final_hex(&ctx, hex);
+    ck_assert_str_eq(hex, "e3b0c44298fc1c149afbf4c8996fb924"
+                          "27ae41e4649b934ca495991b7852b855");
+    comps_sha256_init(&ctx);
+    comps_sha256_update(&ctx, "abc", 3);
+    comps_sha256_final_hex(&ctx, hex);
+    ck_assert_str_eq(hex, "ba7816bf8f01cfea414140de5dae2223"
+                          "b00361a396177a9cb410ff61f20015ad");
+    /* two blocks fed byte by byte */
+    comps_sha256_init(&ctx);
+    for (i = 0; msg[i]; i++)
+        comps_sha256_update(&ctx, msg + i, 1);
+    comps_sha256_final_hex(&ctx, hex);
+    ck_assert_str_eq(hex, "248d6a61d20638b8e5c026930c3e6039"
+                          "a33ce45964ff2167f6ecedd419db06c1");
+}END_TEST
+
+START_TEST(test_comps_doc_xml_compressed)
+{
+    COMPS_Doc *doc;
+    COMPS_XMLCompressOptions opts = {COMPS_COMPRESS_GZIP, 0, 1};
+    COMPS_SHA256 ctx;
+    XMLSink sink = {NULL, 0, 0};
+    char hex[COMPS_SHA256_HEXLEN + 1];
+    char *expected, *buf;
+    z_stream zs;
+    size_t len;
+
+    doc = load_doc("fedora_comps.xml");
+    expected = comps2xml_str(doc, NULL, NULL);
+    len = strlen(expected);
+
+    fail_if(comps2xml_compressed_cb(doc, &opts, &xml_sink_write, &sink,
+                                    NULL, NULL) == -1);
+    ck_assert_int_eq(opts.open_size, len);
+    ck_assert_int_eq(opts.size, sink.len);
+    fail_if(opts.size >= len);
+    comps_sha256_init(&ctx);
+    comps_sha256_update(&ctx, expected, len);
+    comps_sha256_final_hex(&ctx, hex);
+    ck_assert_str_eq(opts.open_sha256, hex);
+    comps_sha256_init(&ctx);
+    comps_sha256_update(&ctx, sink.buf, sink.len);
+    comps_sha256_final_hex(&ctx, hex);
+    ck_assert_str_eq(opts.sha256, hex);
+
+    buf = malloc(len + 1);
+    memset(&zs, 0, sizeof(zs));
+    fail_if(inflateInit2(&zs, 15 + 16) != Z_OK);
+    zs.next_in = (Bytef*)sink.buf;
+    zs.avail_in = sink.len;
+    zs.next_out = (Bytef*)buf;
+    zs.avail_out = len + 1;
+    ck_assert_int_eq(inflate(&zs, Z_FINISH), Z_STREAM_END);
+    ck_assert_int_eq(zs.total_out, len);
+    inflateEnd(&zs);
+    buf[len] = 0;
+    fail_if(strcmp(buf, expected) != 0);
+    free(buf);
+    free(sink.buf);
+
+    fail_if(comps2xml_compressed_f(doc, "comps.xml.gz", &opts,
+                                   NULL, NULL) == -1);
+    ck_assert_int_eq(opts.open_size, len);
+    ck_assert_str_eq(opts.sha256, hex);
+
+    opts.checksums = 0;
+    sink.buf = NULL;
+    sink.len = 0;
+    fail_if(comps2xml_compressed_cb(doc, &opts, &xml_sink_write, &sink,
+                                    NULL, NULL) == -1);
+    ck_assert_str_eq(opts.sha256, "");
+    free(sink.buf);
+
+    fail_if(comps2xml_compressed_cb(doc, &opts, &xml_sink_fail, NULL,
+                                    NULL, NULL) != -1);
+    opts.type = COMPS_COMPRESS_XZ;
+    if (comps_compress_supported(COMPS_COMPRESS_XZ)) {
+        sink.buf = NULL;
+        sink.len = 0;
+        fail_if(comps2xml_compressed_cb(doc, &opts, &xml_sink_write, &sink,
+                                        NULL, NULL) == -1);
+        /* xz stream magic */
+        fail_if(sink.len < 6 || memcmp(sink.buf, "\xfd" "7zXZ", 6) != 0);
+        ck_assert_int_eq(opts.open_size, len);
+        free(sink.buf);
+    } else {
+        fail_if(comps2xml_compressed_cb(doc, &opts, &xml_sink_write, &sink,
+                                        NULL, NULL) != -1);
+    }
+
+    free(expected);
+    COMPS_OBJECT_DESTROY(doc);
+}END_TEST
+
+START_TEST(test_comps_doc_json)
+{
+    COMPS_Doc *doc;
+    COMPS_Parsed *parsed;
+    COMPS_ObjList *groups;
+    COMPS_DocGroup *g;
+    char *json, *json2, *xml, *xml2;
+    const char *escaped = "{\"groups\":[{\"id\":\"a\\\"b\\\\c\\n\\u00e9"
+                          "\\ud83d\\ude00\",\"packages\":[]}]}";
+    const char *unknown = "{\"groups\":[{\"id\":\"g\",\"color\":[1,{}],"
+                          "\"packages\":[{\"name\":\"p\","
+                          "\"type\":\"weird\"}]}],\"whiteout\":null}";
+    const char *nul = "{\"groups\":[{\"id\":\"a\\u0000b\",\"packages\":[]}]}";
+
+    doc = load_doc("fedora_comps.xml");
+    xml = comps2xml_str(doc, NULL, NULL);
+    json = comps2json_str(doc);
+    fail_if(json == NULL);
+
+    parsed = comps_parse_parsed_create();
+    comps_parse_parsed_init(parsed, "UTF-8", 0);
+    ck_assert_int_eq(comps_parse_json(parsed, json, strlen(json)), 0);
+    fail_if(!comps_object_cmp((COMPS_Object*)doc,
+                              (COMPS_Object*)parsed->comps_doc));
+    xml2 = comps2xml_str(parsed->comps_doc, NULL, NULL);
+    ck_assert_str_eq(xml2, xml);
+    json2 = comps2json_str(parsed->comps_doc);
+    ck_assert_str_eq(json2, json);
+    free(xml2);
+    free(json2);
+    free(xml);
+
+    /* escapes are decoded to UTF-8 and encoded back only where needed */
+    ck_assert_int_eq(comps_parse_json(parsed, escaped, strlen(escaped)), 0);
+    groups = comps_doc_groups(parsed->comps_doc);
+    g = (COMPS_DocGroup*)groups->first->comps_obj;
+    ck_assert_str_eq(((COMPS_Str*)comps_objdict_get_x(g->properties,
+                                                      "id"))->val,
+                     "a\"b\\c\n\xc3\xa9\xf0\x9f\x98\x80");
+    COMPS_OBJECT_DESTROY(groups);
+    json2 = comps2json_str(parsed->comps_doc);
+    fail_if(strstr(json2, "\"a\\\"b\\\\c\\n\xc3\xa9\xf0\x9f\x98\x80\"")
+            == NULL);
+    free(json2);
+    comps_parse_parsed_destroy(parsed);
+
+    /* unknown keys and package types are skipped with warning */
+    parsed = comps_parse_parsed_create();
+    comps_parse_parsed_init(parsed, "UTF-8", 0);
+    ck_assert_int_eq(comps_parse_json(parsed, unknown, strlen(unknown)), 1);
+    ck_assert_int_eq(log_len(parsed->log), 2);
+    groups = comps_doc_groups(parsed->comps_doc);
+    ck_assert_int_eq(groups->len, 1);
+    COMPS_OBJECT_DESTROY(groups);
+    comps_parse_parsed_destroy(parsed);
+
+    /* truncated document */
+    parsed = comps_parse_parsed_create();
+    comps_parse_parsed_init(parsed, "UTF-8", 0);
+    ck_assert_int_eq(comps_parse_json(parsed, json, strlen(json) / 2), -1);
+    ck_assert_int_eq(log_len(parsed->log), 1);
+    comps_parse_parsed_destroy(parsed);
+
+    /* NUL can't be stored in string */
+    parsed = comps_parse_parsed_create();
+    comps_parse_parsed_init(parsed, "UTF-8", 0);
+    ck_assert_int_eq(comps_parse_json(parsed, nul, strlen(nul)), -1);
+    ck_assert_int_eq(log_len(parsed->log), 1);
+    comps_parse_parsed_destroy(parsed);
+
+    fail_if(comps2json_cb(doc, &xml_sink_fail, NULL) != -1);
+    fail_if(comps2json_f(doc, "comps.json") != 0);
+    fail_if(comps2json_f(doc, "no-such-dir/comps.json") != -1);
+
+    free(json);
+    COMPS_OBJECT_DESTROY(doc);
+}END_TEST
+
 START_TEST(test_doc_defaults) {
     COMPS_DocGroup *g;
     COMPS_Doc * doc, *doc2;
@@ -611,6 +1883,73 @@ START_TEST(test_doc_defaults) {
 
 }END_TEST
 
+static void check_objlist_links(COMPS_ObjList *list) {
+    COMPS_ObjListIt *it;
+    unsigned int i = 0;
+    for (it = list->first; it != NULL; it = it->next, i++) {
+        ck_assert(comps_objlist_get_x(list, i) == it->comps_obj);
+        ck_assert(comps_objlist_get_it(list, i) == it);
+        if (it->next == NULL)
+            ck_assert(list->last == it);
+    }
+    ck_assert_msg(i == list->len, "%u != %zu", i, list->len);
+    ck_assert(comps_objlist_get_x(list, i) == NULL);
+}
+
+START_TEST(test_objlist) {
+    COMPS_ObjList *list, *list2;
+    COMPS_Object *obj;
+    int i;
+
+    list = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+    for (i = 0; i < 2000; i++)
+        comps_objlist_append_x(list, (COMPS_Object*)comps_num(i));
+    check_objlist_links(list);
+    ck_assert(((COMPS_Num*)comps_objlist_get_x(list, 1500))->val == 1500);
+
+    /* remove every odd item from the end, so positions stay valid */
+    for (i = 1999; i >= 0; i--) {
+        if (i % 2)
+            ck_assert(comps_objlist_remove_at(list, i) == 1);
+    }
+    check_objlist_links(list);
+    ck_assert(list->len == 1000);
+    ck_assert(((COMPS_Num*)comps_objlist_get_x(list, 999))->val == 1998);
+
+    /* removed item slots are reused */
+    obj = (COMPS_Object*)comps_num(-1);
+    ck_assert(comps_objlist_insert_at(list, 0, obj) == 1);
+    ck_assert(comps_objlist_insert_at(list, list->len, obj) == 1);
+    ck_assert(comps_objlist_insert_at(list, 500, obj) == 1);
+    ck_assert(comps_objlist_insert_at(list, list->len + 1, obj) == -1);
+    check_objlist_links(list);
+    ck_assert(comps_objlist_get_x(list, 500) == obj);
+    ck_assert(comps_objlist_index(list, obj) == 0);
+    ck_assert(comps_objlist_remove(list, obj) == 1);
+    ck_assert(comps_objlist_index(list, obj) == 499);
+    COMPS_OBJECT_DESTROY(obj);
+
+    obj = (COMPS_Object*)comps_num(20);
+    ck_assert(comps_objlist_set(list, 10, obj) == 0);
+    ck_assert(comps_objlist_set(list, list->len, obj) == -1);
+    ck_assert(comps_objlist_get_x(list, 10) == obj);
+    COMPS_OBJECT_DESTROY(obj);
+
+    list2 = (COMPS_ObjList*)comps_object_copy((COMPS_Object*)list);
+    check_objlist_links(list2);
+    ck_assert(comps_object_cmp((COMPS_Object*)list, (COMPS_Object*)list2));
+    ck_assert(comps_objlist_remove_at(list2, list2->len - 1) == 1);
+    ck_assert(!comps_object_cmp((COMPS_Object*)list, (COMPS_Object*)list2));
+
+    comps_objlist_clear(list2);
+    check_objlist_links(list2);
+    comps_objlist_append_x(list2, (COMPS_Object*)comps_num(1));
+    check_objlist_links(list2);
+
+    COMPS_OBJECT_DESTROY(list2);
+    COMPS_OBJECT_DESTROY(list);
+} END_TEST
+
 Suite* basic_suite (void)
 {
     Suite *s = suite_create ("Basic Tests");
@@ -620,7 +1959,25 @@ Suite* basic_suite (void)
     tcase_add_test (tc_core, test_comps_doc_xml);
     tcase_add_test (tc_core, test_comps_doc_setfeats);
     tcase_add_test (tc_core, test_comps_doc_union);
+    tcase_add_test (tc_core, test_comps_doc_union_many);
+    tcase_add_test (tc_core, test_comps_doc_unite);
+    tcase_add_test (tc_core, test_comps_doc_union_ex);
+    tcase_add_test (tc_core, test_comps_doc_by_id);
+    tcase_add_test (tc_core, test_comps_doc_reverse_index);
+    tcase_add_test (tc_core, test_comps_doc_env_resolve);
+    tcase_add_test (tc_core, test_comps_doc_query);
+    tcase_add_test (tc_core, test_comps_doc_search);
+    tcase_add_test (tc_core, test_comps_doc_diff);
+    tcase_add_test (tc_core, test_comps_doc_digest);
+    tcase_add_test (tc_core, test_comps_doc_xml_stream);
+    tcase_add_test (tc_core, test_comps_doc_xml_threaded);
+    tcase_add_test (tc_core, test_comps_doc_xml_fragment_cache);
+    tcase_add_test (tc_core, test_comps_doc_xml_selected);
+    tcase_add_test (tc_core, test_comps_sha256);
+    tcase_add_test (tc_core, test_comps_doc_xml_compressed);
+    tcase_add_test (tc_core, test_comps_doc_json);
     tcase_add_test (tc_core, test_doc_defaults);
+    tcase_add_test (tc_core, test_objlist);
     suite_add_tcase (s, tc_core);
     return s;
 }
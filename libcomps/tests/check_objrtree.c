@@ -168,12 +168,181 @@ START_TEST(test_objrtree) {
     COMPS_OBJECT_DESTROY(tree);
 } END_TEST
 
+START_TEST(test_objrtree_sorted) {
+    char* test_keys[] = {"kde-desktop", "gnome", "kde", "base-x", "kde-apps",
+                         "gnome-desktop", "xfce", "base", "Kde", NULL};
+    char* sorted_keys[] = {"Kde", "base", "base-x", "gnome", "gnome-desktop",
+                           "kde", "kde-apps", "kde-desktop", "xfce", NULL};
+    char* remove_keys[] = {"kde-apps", "base", "xfce", NULL};
+    char* remain_keys[] = {"Kde", "base-x", "gnome", "gnome-desktop",
+                           "kde", "kde-desktop", NULL};
+    COMPS_ObjRTree *tree;
+    COMPS_HSList *keys;
+    COMPS_HSListItem *it;
+    COMPS_Object *val;
+    int x;
+
+    tree = (COMPS_ObjRTree*)comps_object_create(&COMPS_ObjRTree_ObjInfo, NULL);
+    for (x=0; test_keys[x] != NULL; x++) {
+        comps_objrtree_set_x(tree, test_keys[x], (COMPS_Object*)comps_num(x));
+    }
+    keys = comps_objrtree_keys(tree);
+    for (it = keys->first, x = 0; it != NULL; it = it->next, x++) {
+        ck_assert_msg(sorted_keys[x] != NULL, "too many keys");
+        ck_assert_msg(strcmp(it->data, sorted_keys[x]) == 0,
+                      "%s != %s", (char*)it->data, sorted_keys[x]);
+    }
+    ck_assert(sorted_keys[x] == NULL);
+    comps_hslist_destroy(&keys);
+
+    for (x=0; remove_keys[x] != NULL; x++) {
+        comps_objrtree_unset(tree, remove_keys[x]);
+        val = comps_objrtree_get(tree, remove_keys[x]);
+        ck_assert(val == NULL);
+    }
+    keys = comps_objrtree_keys(tree);
+    for (it = keys->first, x = 0; it != NULL; it = it->next, x++) {
+        ck_assert_msg(remain_keys[x] != NULL, "too many keys");
+        ck_assert_msg(strcmp(it->data, remain_keys[x]) == 0,
+                      "%s != %s", (char*)it->data, remain_keys[x]);
+    }
+    ck_assert(remain_keys[x] == NULL);
+    comps_hslist_destroy(&keys);
+    COMPS_OBJECT_DESTROY(tree);
+} END_TEST
+
+START_TEST(test_objrtree_it) {
+    COMPS_ObjRTree *tree;
+    COMPS_ObjRTreeIt it;
+    COMPS_HSList *keys, *values;
+    COMPS_HSListItem *kit, *vit;
+    COMPS_Object *val;
+    const char *key;
+    char longkey[1024];
+    int x, count;
+
+    tree = (COMPS_ObjRTree*)comps_object_create(&COMPS_ObjRTree_ObjInfo, NULL);
+    comps_objrtree_it_init(&it, tree);
+    ck_assert(comps_objrtree_it_next(&it, &key, &val) == 0);
+    comps_objrtree_it_destroy(&it);
+
+    /* deep chain of nodes and keys longer than iterator buffers */
+    memset(longkey, 'k', sizeof(longkey));
+    for (x = 1; x < 100; x++) {
+        longkey[x] = 0;
+        comps_objrtree_set_x(tree, longkey, (COMPS_Object*)comps_num(x));
+        longkey[x] = 'k';
+    }
+    longkey[sizeof(longkey) - 1] = 0;
+    comps_objrtree_set_x(tree, longkey, (COMPS_Object*)comps_num(0));
+    comps_objrtree_set_x(tree, "a", (COMPS_Object*)comps_num(0));
+    comps_objrtree_set_x(tree, "kz", (COMPS_Object*)comps_num(0));
+
+    keys = comps_objrtree_keys(tree);
+    values = comps_objrtree_values(tree);
+    kit = keys->first;
+    vit = values->first;
+    count = 0;
+    comps_objrtree_it_init(&it, tree);
+    while (comps_objrtree_it_next(&it, &key, &val)) {
+        ck_assert(kit != NULL);
+        ck_assert_msg(strcmp(key, kit->data) == 0, "%s != %s",
+                      key, (char*)kit->data);
+        ck_assert(val == vit->data);
+        kit = kit->next;
+        vit = vit->next;
+        count++;
+    }
+    comps_objrtree_it_destroy(&it);
+    ck_assert(kit == NULL);
+    ck_assert_msg(count == 102, "%d != 102", count);
+    comps_hslist_destroy(&keys);
+    comps_hslist_destroy(&values);
+    COMPS_OBJECT_DESTROY(tree);
+} END_TEST
+
+static void check_prefix_walk(void *udata, const char *key,
+                              COMPS_Object *data) {
+    (void)data;
+    ck_assert(strncmp(key, "kde-", 4) == 0);
+    (*(int*)udata)++;
+}
+
+START_TEST(test_objrtree_prefix) {
+    char* test_keys[] = {"kde", "kde-apps", "kde-desktop", "kde-media",
+                         "kdevelop", "gnome", "gnome-desktop", "base",
+                         "base-x", "libreoffice", "libreoffice-cs",
+                         "libreoffice-de", "k", "", NULL};
+    char* prefixes[] = {"", "k", "kde", "kde-", "kde-d", "libreoffice-",
+                        "gnome-desktop", "gnome-desktopx", "x", "kdf", NULL};
+    char* ranges[][2] = {{NULL, NULL}, {"kde", "kde."}, {"kd", "kdz"},
+                         {"a", "c"}, {"base-", NULL}, {NULL, "gnome"},
+                         {"kde-b", "kde-e"}, {"kde-apps", "kde-apps"},
+                         {"gnome-a", "kde"}, {"z", NULL}};
+    COMPS_ObjRTree *tree;
+    COMPS_ObjRTreeIt it;
+    COMPS_HSList *keys, *matched;
+    COMPS_HSListItem *kit, *mit;
+    COMPS_Object *val;
+    const char *key;
+    int x, count;
+
+    tree = (COMPS_ObjRTree*)comps_object_create(&COMPS_ObjRTree_ObjInfo, NULL);
+    for (x=0; test_keys[x] != NULL; x++) {
+        comps_objrtree_set_x(tree, test_keys[x], (COMPS_Object*)comps_num(x));
+    }
+    keys = comps_objrtree_keys(tree);
+
+    for (x = 0; prefixes[x] != NULL; x++) {
+        matched = comps_objrtree_keys_with_prefix(tree, prefixes[x]);
+        mit = matched->first;
+        for (kit = keys->first; kit != NULL; kit = kit->next) {
+            if (strncmp(kit->data, prefixes[x], strlen(prefixes[x])))
+                continue;
+            ck_assert_msg(mit != NULL, "missing %s for prefix %s",
+                          (char*)kit->data, prefixes[x]);
+            ck_assert_msg(strcmp(kit->data, mit->data) == 0, "%s != %s",
+                          (char*)kit->data, (char*)mit->data);
+            mit = mit->next;
+        }
+        ck_assert_msg(mit == NULL, "extra key for prefix %s", prefixes[x]);
+        comps_hslist_destroy(&matched);
+    }
+
+    for (x = 0; x < (int)(sizeof(ranges) / sizeof(ranges[0])); x++) {
+        comps_objrtree_it_init_range(&it, tree, ranges[x][0], ranges[x][1]);
+        for (kit = keys->first; kit != NULL; kit = kit->next) {
+            if (ranges[x][0] && strcmp(kit->data, ranges[x][0]) < 0)
+                continue;
+            if (ranges[x][1] && strcmp(kit->data, ranges[x][1]) >= 0)
+                continue;
+            ck_assert_msg(comps_objrtree_it_next(&it, &key, &val),
+                          "missing %s in range %d", (char*)kit->data, x);
+            ck_assert_msg(strcmp(kit->data, key) == 0, "%s != %s",
+                          (char*)kit->data, key);
+        }
+        ck_assert_msg(comps_objrtree_it_next(&it, &key, &val) == 0,
+                      "extra key %s in range %d", key, x);
+        comps_objrtree_it_destroy(&it);
+    }
+
+    count = 0;
+    comps_objrtree_prefix_walk(tree, "kde-", &count, &check_prefix_walk);
+    ck_assert_msg(count == 3, "%d != 3", count);
+
+    comps_hslist_destroy(&keys);
+    COMPS_OBJECT_DESTROY(tree);
+} END_TEST
+
 Suite* basic_suite (void)
 {
     Suite *s = suite_create ("Basic Tests");
     /* Core test case */
     TCase *tc_core = tcase_create ("Core");
     tcase_add_test (tc_core, test_objrtree);
+    tcase_add_test (tc_core, test_objrtree_sorted);
+    tcase_add_test (tc_core, test_objrtree_it);
+    tcase_add_test (tc_core, test_objrtree_prefix);
     suite_add_tcase (s, tc_core);
     return s;
 }
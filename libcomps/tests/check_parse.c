@@ -18,11 +18,14 @@
  */
 
 #include <check.h>
+#include <ctype.h>
 #include <stdio.h>
 
 #include "../src/comps_doc.h"
 #include "../src/comps_parse.h"
 #include "../src/comps_docpackage.h"
+#include "../src/comps_scan.h"
+#include "../src/comps_utils.h"
 
 void print_all_str(COMPS_RTree *rt) {
     COMPS_HSList *pairlist;
@@ -636,6 +639,218 @@ START_TEST(test_arch)
 }
 END_TEST
 
+/* object without arches or with arches intersecting requested ones */
+static int ref_arch_match(COMPS_ObjList *arches, COMPS_Object *obj_arches) {
+    return obj_arches == NULL
+           || __comps_objlist_intersected(arches, (COMPS_ObjList*)obj_arches);
+}
+
+/* copy of list items passing arch filter, items are packages or group ids
+ * which share layout of name and arches */
+static COMPS_ObjList* ref_filter_items(COMPS_ObjList *items,
+                                       COMPS_ObjList *arches, int groupids) {
+    COMPS_ObjList *ret;
+    COMPS_ObjListIt *it;
+    COMPS_Object *obj_arches;
+
+    ret = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+    for (it = items->first; it != NULL; it = it->next) {
+        obj_arches = groupids
+             ? (COMPS_Object*)((COMPS_DocGroupId*)it->comps_obj)->arches
+             : (COMPS_Object*)((COMPS_DocGroupPackage*)it->comps_obj)->arches;
+        if (ref_arch_match(arches, obj_arches))
+            comps_objlist_append(ret, it->comps_obj);
+    }
+    return ret;
+}
+
+/* check filtered list of objects against plain pairwise arch comparison */
+static void check_arch_filtered(COMPS_ObjList *src, COMPS_ObjList *res,
+                                COMPS_ObjList *arches, size_t *offsets,
+                                int nlists, int groupids) {
+    COMPS_ObjListIt *it, *rit;
+    COMPS_ObjList *exp;
+    COMPS_ObjDict *props;
+    int i;
+
+    rit = res->first;
+    for (it = src->first; it != NULL; it = it->next) {
+        props = *(COMPS_ObjDict**)((char*)it->comps_obj + offsets[0]);
+        if (!ref_arch_match(arches, comps_objdict_get_x(props, "arches")))
+            continue;
+        ck_assert(rit != NULL);
+        ck_assert(comps_object_cmp(
+                      comps_objdict_get_x(props, "id"),
+                      comps_objdict_get_x(*(COMPS_ObjDict**)
+                                          ((char*)rit->comps_obj
+                                           + offsets[0]), "id")));
+        for (i = 1; i <= nlists; i++) {
+            exp = ref_filter_items(*(COMPS_ObjList**)((char*)it->comps_obj
+                                                      + offsets[i]),
+                                   arches, groupids);
+            ck_assert(comps_object_cmp((COMPS_Object*)exp,
+                                       *(COMPS_Object**)
+                                       ((char*)rit->comps_obj + offsets[i])));
+            COMPS_OBJECT_DESTROY(exp);
+        }
+        rit = rit->next;
+    }
+    ck_assert(rit == NULL);
+}
+
+START_TEST(test_arch_multi)
+{
+    COMPS_Parsed *parsed;
+    COMPS_Doc **docs, *doc;
+    COMPS_ObjList *arches[6], *src, *res;
+    const char *names[6][3] = {{"x86", NULL, NULL}, {"x86_64", NULL, NULL},
+                               {"s390", "ppc64", NULL},
+                               {"x86", "x86_64", NULL}, {NULL, NULL, NULL},
+                               {"x86", NULL, NULL}};
+    size_t group_offs[] = {offsetof(COMPS_DocGroup, properties),
+                           offsetof(COMPS_DocGroup, packages)};
+    size_t cat_offs[] = {offsetof(COMPS_DocCategory, properties),
+                         offsetof(COMPS_DocCategory, group_ids)};
+    size_t env_offs[] = {offsetof(COMPS_DocEnv, properties),
+                         offsetof(COMPS_DocEnv, group_list),
+                         offsetof(COMPS_DocEnv, option_list)};
+    const char *files[] = {"main_arches.xml", "f21-rawhide-comps.xml"};
+    char name[16];
+    FILE *fp;
+    int f, i, j;
+
+    fprintf(stderr, "## Running test_parse arch_multi\n");
+    for (i = 0; i < 6; i++) {
+        arches[i] = COMPS_OBJECT_CREATE(COMPS_ObjList, NULL);
+        for (j = 0; j < 3 && names[i][j]; j++)
+            comps_objlist_append_x(arches[i],
+                                   (COMPS_Object*)comps_str(names[i][j]));
+    }
+    /* more arch names than bits of mask */
+    for (j = 0; j < 70; j++) {
+        sprintf(name, "arch%d", j);
+        comps_objlist_append_x(arches[5], (COMPS_Object*)comps_str(name));
+    }
+    for (f = 0; f < 2; f++) {
+        parsed = comps_parse_parsed_create();
+        fail_if(comps_parse_parsed_init(parsed, "UTF-8", 0) == 0);
+        fp = fopen(files[f], "r");
+        comps_parse_file(parsed, fp, NULL);
+        doc = parsed->comps_doc;
+
+        docs = comps_doc_arch_filter_multi(doc, arches, 6);
+        fail_if(docs == NULL);
+        for (i = 0; i < 6; i++) {
+            src = comps_doc_groups(doc);
+            res = comps_doc_groups(docs[i]);
+            check_arch_filtered(src, res, arches[i], group_offs, 1, 0);
+            COMPS_OBJECT_DESTROY(src);
+            COMPS_OBJECT_DESTROY(res);
+            src = comps_doc_categories(doc);
+            res = comps_doc_categories(docs[i]);
+            check_arch_filtered(src, res, arches[i], cat_offs, 1, 1);
+            COMPS_OBJECT_DESTROY(src);
+            COMPS_OBJECT_DESTROY(res);
+            src = comps_doc_environments(doc);
+            res = comps_doc_environments(docs[i]);
+            check_arch_filtered(src, res, arches[i], env_offs, 2, 1);
+            COMPS_OBJECT_DESTROY(src);
+            COMPS_OBJECT_DESTROY(res);
+        }
+        /* single list filter gives the same documents */
+        for (i = 0; i < 6; i++) {
+            doc = comps_doc_arch_filter(parsed->comps_doc, arches[i]);
+            fail_if(!comps_object_cmp((COMPS_Object*)doc,
+                                      (COMPS_Object*)docs[i]));
+            COMPS_OBJECT_DESTROY(doc);
+            COMPS_OBJECT_DESTROY(docs[i]);
+        }
+        free(docs);
+        comps_parse_parsed_destroy(parsed);
+    }
+    fail_if(comps_doc_arch_filter_multi(NULL, arches, 0) != NULL);
+    for (i = 0; i < 6; i++)
+        COMPS_OBJECT_DESTROY(arches[i]);
+}
+END_TEST
+
+START_TEST(test_scan_space_only)
+{
+    const char spaces[] = " \t\n\v\f\r";
+    /* bytes around whitespace range and with high bit set */
+    const unsigned char others[] = {'a', 0x08, 0x0e, 0x1f, 0x21, 0x00,
+                                    0x80, 0x89, 0xa0, 0xff};
+    char buf[100];
+    COMPS_ScanLevel level, best;
+    size_t len, off, i, j;
+
+    best = comps_scan_level();
+    for (level = COMPS_SCAN_SCALAR; level <= best; level++) {
+        ck_assert_int_eq(comps_scan_set_level(level), level);
+        for (off = 0; off < 4; off++) {
+            for (len = 0; len + off <= 80; len++) {
+                for (i = 0; i < len; i++)
+                    buf[off + i] = spaces[(i + len) % 6];
+                fail_if(!comps_scan_space_only(buf + off, len),
+                        "level %d len %zu", level, len);
+                for (i = 0; i < len; i++) {
+                    j = (i + off) % sizeof(others);
+                    buf[off + i] = (char)others[j];
+                    ck_assert_int_eq(isspace(others[j]) != 0, 0);
+                    fail_if(comps_scan_space_only(buf + off, len),
+                            "level %d len %zu pos %zu", level, len, i);
+                    buf[off + i] = ' ';
+                }
+            }
+        }
+    }
+    comps_scan_set_level(best);
+}
+END_TEST
+
+START_TEST(test_scan_xml_escape)
+{
+    const char text[] = "&<>\r";
+    /* escaped by libxml2 in attributes only */
+    const unsigned char attr[] = {'"', '\t', '\n', 0x80, 0xc3, 0xff};
+    char buf[100];
+    COMPS_ScanLevel level, best;
+    size_t len, off, i, j;
+
+    best = comps_scan_level();
+    for (level = COMPS_SCAN_SCALAR; level <= best; level++) {
+        comps_scan_set_level(level);
+        for (off = 0; off < 4; off++) {
+            for (len = 0; len + off <= 80; len++) {
+                for (i = 0; i < len; i++)
+                    buf[off + i] = "a-Z. '=/09"[(i + len) % 10];
+                ck_assert_int_eq(comps_scan_xml_text(buf + off, len), len);
+                ck_assert_int_eq(comps_scan_xml_attr(buf + off, len), len);
+                for (i = 0; i < len; i++) {
+                    /* only first special byte counts */
+                    if (i + 1 < len)
+                        buf[off + len - 1] = '&';
+                    buf[off + i] = text[(i + off) % 4];
+                    fail_if(comps_scan_xml_text(buf + off, len) != i,
+                            "level %d len %zu pos %zu", level, len, i);
+                    fail_if(comps_scan_xml_attr(buf + off, len) != i,
+                            "level %d len %zu pos %zu", level, len, i);
+                    buf[off + len - 1] = 'a';
+                    j = (i + off) % sizeof(attr);
+                    buf[off + i] = (char)attr[j];
+                    fail_if(comps_scan_xml_text(buf + off, len) != len,
+                            "level %d len %zu pos %zu", level, len, i);
+                    fail_if(comps_scan_xml_attr(buf + off, len) != i,
+                            "level %d len %zu pos %zu", level, len, i);
+                    buf[off + i] = 'a';
+                }
+            }
+        }
+    }
+    comps_scan_set_level(best);
+}
+END_TEST
+
 Suite* basic_suite (void)
 {
     Suite *s = suite_create ("Basic Tests");
@@ -650,6 +865,9 @@ Suite* basic_suite (void)
 
     tcase_add_test (tc_core, test_main2);
     tcase_add_test (tc_core, test_arch);
+    tcase_add_test (tc_core, test_arch_multi);
+    tcase_add_test (tc_core, test_scan_space_only);
+    tcase_add_test (tc_core, test_scan_xml_escape);
 
     tcase_set_timeout(tc_core, 15);
     suite_add_tcase (s, tc_core);